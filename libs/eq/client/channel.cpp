@@ -24,6 +24,7 @@
 #include "compositor.h"
 #include "config.h"
 #include "configEvent.h"
+#include "deltaCache.h"
 #include "error.h"
 #include "frame.h"
 #include "frameData.h"
@@ -37,8 +38,12 @@
 #include "nodePackets.h"
 #include "pipe.h"
 #include "pixelData.h"
+#include "pixelDataWriter.h"
 #include "server.h"
+#include "shmTransport.h"
 #include "systemWindow.h"
+#include "transmitCostModel.h"
+#include "transmitShaper.h"
 #include "windowPackets.h"
 
 #include <eq/util/accum.h>
@@ -51,6 +56,8 @@
 #include <co/connectionDescription.h>
 #include <co/exception.h>
 #include <co/queueSlave.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/omp.h>
 #include <lunchbox/rng.h>
 #include <lunchbox/scopedMutex.h>
 
@@ -85,7 +92,7 @@ void Channel::attach( const UUID& id, const uint32_t instanceID )
     Super::attach( id, instanceID );
     co::CommandQueue* queue = getPipeThreadQueue();
     co::CommandQueue* commandQ = getCommandThreadQueue();
-    co::CommandQueue* tmitQ = &getNode()->transmitter.getQueue();
+    co::CommandQueue* tmitQ = getNode()->getTransmitQueue();
     co::CommandQueue* transferQ = getPipe()->getTransferThreadQueue();
 
     registerCommand( fabric::CMD_CHANNEL_CONFIG_INIT, 
@@ -990,6 +997,7 @@ void Channel::drawStatistics()
                   }
 
                   case Statistic::WINDOW_FPS:
+                  case Statistic::NODE_PIXEL_POOL:
                     continue;
 
                   case Statistic::CHANNEL_ASYNC_READBACK:
@@ -1071,6 +1079,7 @@ void Channel::drawStatistics()
                 {
                   case Statistic::PIPE_IDLE:
                   case Statistic::WINDOW_FPS:
+                  case Statistic::NODE_PIXEL_POOL:
                     continue;
 
                   case Statistic::CHANNEL_ASYNC_READBACK:
@@ -1121,6 +1130,12 @@ void Channel::drawStatistics()
                         data.compressors.insert( stat.plugins[1] );
                     break;
 
+                  case Statistic::CHANNEL_FRAME_TRANSMIT:
+                    // compound depth and input frame position
+                    text << 0xffffu - ( stat.priority >> 16 ) << '.'
+                         << ( stat.priority & 0xffffu );
+                    break;
+
                   case Statistic::CHANNEL_READBACK:
                   case Statistic::CHANNEL_ASYNC_READBACK:
                     text << unsigned( 100.f * stat.ratio ) << '%';
@@ -1255,7 +1270,8 @@ void Channel::drawStatistics()
         const Statistic::Type type = static_cast< Statistic::Type >( i );
         if( type == Statistic::CHANNEL_DRAW_FINISH ||
             type == Statistic::PIPE_IDLE || type == Statistic::WINDOW_FPS ||
-            type == Statistic::CHANNEL_ASYNC_READBACK )
+            type == Statistic::CHANNEL_ASYNC_READBACK ||
+            type == Statistic::NODE_PIXEL_POOL )
         {
             continue;
         }
@@ -1571,6 +1587,25 @@ void Channel::_frameReadback( const uint128_t& frameID, uint32_t nFrames,
     _resetOutputFrames();
 }
 
+namespace
+{
+// Images smaller than this are transmitted in batches of up to _maxBatchSize
+// bytes, which saves the per-packet overhead of small regions of interest
+static const uint64_t _maxBatchImageSize = 64 * 1024;
+static const uint64_t _maxBatchSize = 1024 * 1024;
+
+/** @return the size of the uncompressed buffers of an image. */
+uint64_t _getRawSize( const Image* image )
+{
+    uint64_t size = 0;
+    if( image->hasPixelData( Frame::BUFFER_COLOR ))
+        size += image->getPixelDataSize( Frame::BUFFER_COLOR );
+    if( image->hasPixelData( Frame::BUFFER_DEPTH ))
+        size += image->getPixelDataSize( Frame::BUFFER_DEPTH );
+    return size;
+}
+}
+
 bool Channel::_asyncFinishReadback( const std::vector< size_t >& imagePos )
 {
     LB_TS_THREAD( _pipeThread );
@@ -1593,10 +1628,39 @@ bool Channel::_asyncFinishReadback( const std::vector< size_t >& imagePos )
         const Eye eye = getEye();
         const std::vector< uint128_t >& nodes = frame->getInputNodes( eye );
         const std::vector< uint128_t >& netNodes = frame->getInputNetNodes(eye);
+        const std::vector< uint32_t >& priorities =
+            frame->getInputPriorities( eye );
+        const std::vector< uint32_t >& rates = frame->getInputRates( eye );
+
+        // consecutive small images are transmitted in one packet, unless they
+        // are delta-encoded individually
+        const bool batch = !frameData->getDeltaEncoding();
+        size_t nBatched = 0;
+        uint64_t batchSize = 0;
 
         for( size_t j = imagePos[i]; j < nImages; ++j )
         {
-            if( images[j]->hasAsyncReadback( )) // finish async readback
+            Image* image = images[j];
+            if( !image->hasAsyncReadback( ))
+                frameData->cropImage( image, frameNumber );
+
+            const uint64_t size = _getRawSize( image );
+            const bool batchable = batch && !image->hasAsyncReadback() &&
+                                   size < _maxBatchImageSize;
+            if( nBatched > 0 && ( !batchable || batchSize >= _maxBatchSize ))
+            {
+                _asyncTransmit( frameData, frameNumber, j - nBatched, nBatched,
+                                nodes, netNodes, priorities, rates,
+                                getTaskID( ));
+                nBatched = 0;
+                batchSize = 0;
+            }
+            if( batchable )
+            {
+                ++nBatched;
+                batchSize += size;
+            }
+            else if( image->hasAsyncReadback( )) // finish async readback
             {
                 LBCHECK( getPipe()->startTransferThread( ));
 
@@ -1612,12 +1676,18 @@ bool Channel::_asyncFinishReadback( const std::vector< size_t >& imagePos )
 
                 std::vector< uint128_t > ids = nodes;
                 ids.insert( ids.end(), netNodes.begin(), netNodes.end( ));
+                for( size_t k = 0; k < priorities.size(); ++k )
+                    ids.push_back( uint128_t( rates[k], priorities[k] ));
                 send( getLocalNode(), packet, ids );
             }
             else // transmit images asynchronously
-                _asyncTransmit( frameData, frameNumber, j, nodes, netNodes,
-                                getTaskID( ));
+                _asyncTransmit( frameData, frameNumber, j, 1, nodes, netNodes,
+                                priorities, rates, getTaskID( ));
         }
+        if( nBatched > 0 )
+            _asyncTransmit( frameData, frameNumber, nImages - nBatched,
+                            nBatched, nodes, netNodes, priorities, rates,
+                            getTaskID( ));
     }
     return hasAsyncReadback;
 }
@@ -1638,6 +1708,7 @@ void Channel::_finishReadback( const ChannelFinishReadbackPacket* packet )
 
     image->finishReadback( frameData->getZoom(), glewContext );
     LBASSERT( !image->hasAsyncReadback( ));
+    frameData->cropImage( image, packet->frameNumber );
 
     // schedule async image tranmission
     std::vector< uint128_t > nodes;
@@ -1645,31 +1716,43 @@ void Channel::_finishReadback( const ChannelFinishReadbackPacket* packet )
     nodes.insert( nodes.end(), packet->IDs, packet->IDs + packet->nNodes );
     netNodes.insert( netNodes.end(), packet->IDs + packet->nNodes,
                      packet->IDs + 2 * packet->nNodes );
+    std::vector< uint32_t > priorities;
+    std::vector< uint32_t > rates;
+    for( uint32_t i = 2 * packet->nNodes; i < 3 * packet->nNodes; ++i )
+    {
+        priorities.push_back( uint32_t( packet->IDs[i].low( )));
+        rates.push_back( uint32_t( packet->IDs[i].high( )));
+    }
 
-    _asyncTransmit( frameData, packet->frameNumber, packet->imageIndex, nodes,
-                    netNodes, packet->taskID );
+    _asyncTransmit( frameData, packet->frameNumber, packet->imageIndex, 1,
+                    nodes, netNodes, priorities, rates, packet->taskID );
 }
 
 void Channel::_asyncTransmit( FrameDataPtr frame, const uint32_t frameNumber,
-                              const size_t image,
+                              const size_t image, const size_t nImages,
                               const std::vector<uint128_t>& nodes,
                               const std::vector< uint128_t >& netNodes,
+                              const std::vector< uint32_t >& priorities,
+                              const std::vector< uint32_t >& rates,
                               const uint32_t taskID )
 {
     LBASSERT( nodes.size() == netNodes.size( ));
-    std::vector< uint128_t >::const_iterator j = netNodes.begin();
-    for( std::vector< uint128_t >::const_iterator i = nodes.begin();
-         i != nodes.end(); ++i, ++j )
+    LBASSERT( nodes.size() == priorities.size( ));
+    LBASSERT( nodes.size() == rates.size( ));
+    for( size_t i = 0; i < nodes.size(); ++i )
     {
         _refFrame( frameNumber );
 
         ChannelFrameTransmitImagePacket packet;
         packet.frameData = frame;
-        packet.netNodeID = *j;
-        packet.nodeID = *i;
+        packet.netNodeID = netNodes[i];
+        packet.nodeID = nodes[i];
         packet.frameNumber = frameNumber;
         packet.imageIndex = image;
+        packet.nImages = uint32_t( nImages );
         packet.taskID = taskID;
+        packet.priority = priorities[i];
+        packet.rate = rates[i];
 
         LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Start transmit " << &packet
                                         << std::endl;
@@ -1677,6 +1760,103 @@ void Channel::_asyncTransmit( FrameDataPtr frame, const uint32_t frameNumber,
     }
 }
 
+namespace
+{
+// Sends of less than this only fill the socket buffers and don't measure the
+// link speed
+static const uint64_t _minTransmitSample = 1024 * 1024;
+
+// Images larger than this are compressed and streamed in strips of about
+// _streamStripSize bytes, which the destination decompresses and composites
+// while the remaining strips arrive
+static const uint64_t _minStreamSize = 4 * 1024 * 1024;
+static const uint64_t _streamStripSize = 1024 * 1024;
+
+/** @return the size of the, possibly compressed, pixels of a buffer. */
+uint64_t _getDataSize( const PixelData& data )
+{
+    if( !data.isCompressed )
+        return uint64_t( data.pvp.getArea( )) * data.pixelSize;
+
+    uint64_t size = 0;
+    for( size_t i = 0; i < data.compressedSize.size(); ++i )
+        size += data.compressedSize[i];
+    return size;
+}
+
+/** @return the number of strips to compress an image of the given size. */
+uint32_t _getNStrips( const uint64_t size )
+{
+    const uint64_t nStrips = LB_MIN( uint64_t( lunchbox::OMP::getNThreads( )),
+                                     size / _streamStripSize );
+    return uint32_t( LB_MAX( uint64_t( 1 ), nStrips ));
+}
+
+/**
+ * Compress the buffers of an image.
+ *
+ * Each buffer uses the compressor with the fastest estimated transfer to the
+ * destination node, unless one is set explicitly. Buffers compressed in
+ * several strips have to be written strip by strip, see
+ * PixelDataWriter::add().
+ *
+ * @return the size of the uncompressed buffers.
+ */
+uint64_t _compressImage( Image* image, FrameDataPtr frameData,
+                         const uint128_t& node, const int32_t bandwidth,
+                         const uint32_t nStrips, uint32_t& buffers,
+                         std::vector< const PixelData* >& pixelDatas,
+                         std::vector< float >& qualities,
+                         Statistic& statistic )
+{
+    detail::TransmitCostModel& costModel =
+        detail::TransmitCostModel::getInstance();
+    const Frame::Buffer names[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    uint64_t rawSize = 0;
+
+    for( unsigned j = 0; j < 2; ++j )
+    {
+        const Frame::Buffer buffer = names[j];
+        if( !image->hasPixelData( buffer ))
+            continue;
+
+        const uint64_t size = image->getPixelDataSize( buffer );
+        uint32_t name = frameData->getCompressor( buffer );
+        if( name == EQ_COMPRESSOR_AUTO )
+        {
+            co::CompressorInfos infos;
+            image->findCompressors( buffer, infos );
+            name = costModel.choose( node, bandwidth, infos, size );
+        }
+
+        const bool compressed = image->hasCompressedPixelData( buffer ) &&
+            image->getCompressedPixelData( buffer ).compressorName == name;
+        lunchbox::Clock clock;
+        const PixelData& data = image->compressPixelData( buffer, name,
+                                                          nStrips );
+        const float time = clock.getTimef();
+        pixelDatas.push_back( &data );
+        qualities.push_back( image->getQuality( buffer ));
+
+        if( data.isCompressed )
+        {
+            const uint32_t nElements = uint32_t( data.compressedSize.size( ));
+            uint64_t compressedSize = 0;
+            for( uint32_t k = 0 ; k < nElements; ++k )
+                compressedSize += data.compressedSize[ k ];
+            statistic.plugins[j] = data.compressorName;
+            if( !compressed )
+                costModel.addCompress( data.compressorName, size,
+                                       compressedSize, time );
+        }
+
+        buffers |= buffer;
+        rawSize += size;
+    }
+    return rawSize;
+}
+}
+
 void Channel::_transmitImage( const ChannelFrameTransmitImagePacket* request )
 {
     LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Transmit " << request << std::endl;
@@ -1693,16 +1873,21 @@ void Channel::_transmitImage( const ChannelFrameTransmitImagePacket* request )
     ChannelStatistics transmitEvent( Statistic::CHANNEL_FRAME_TRANSMIT, this,
                                      request->frameNumber );
     transmitEvent.event.data.statistic.task = request->taskID;
+    transmitEvent.event.data.statistic.priority = request->priority;
 
     const Images& images = frameData->getImages();
-    Image* image = images[ request->imageIndex ];
-    LBASSERT( images.size() > request->imageIndex );
+    const bool isBatch = request->nImages > 1;
+    LBASSERT( images.size() >= request->imageIndex + request->nImages );
 
-    if( image->getStorageType() == Frame::TYPE_TEXTURE )
+    for( size_t i = 0; i < request->nImages; ++i )
     {
-        LBWARN << "Can't transmit image of type TEXTURE" << std::endl;
-        LBUNIMPLEMENTED;
-        return;
+        if( images[ request->imageIndex + i ]->getStorageType() ==
+            Frame::TYPE_TEXTURE )
+        {
+            LBWARN << "Can't transmit image of type TEXTURE" << std::endl;
+            LBUNIMPLEMENTED;
+            return;
+        }
     }
 
     co::LocalNodePtr localNode = getLocalNode();
@@ -1717,152 +1902,249 @@ void Channel::_transmitImage( const ChannelFrameTransmitImagePacket* request )
     co::ConnectionPtr connection = toNode->getConnection();
     co::ConstConnectionDescriptionPtr description =connection->getDescription();
 
-    // use compression on links up to 2 GBit/s
-    const bool useCompression = ( description->bandwidth <= 262144 );
+    // Other transmit threads may send the same image to other nodes. Batched
+    // images are locked while they are copied, see _writeImages().
+    Image* image = images[ request->imageIndex ];
+    lunchbox::ScopedWrite imageMutex( isBatch ? 0 :
+                                      &image->getTransmitLock( ));
+
+    detail::TransmitCostModel& costModel =
+        detail::TransmitCostModel::getInstance();
 
     NodeFrameDataTransmitPacket packet;
     const uint64_t packetSize = sizeof( packet ) - 8 * sizeof( uint8_t );
 
     packet.objectID    = request->nodeID;
+    packet.sourceID    = getNode()->getID();
     packet.frameData   = request->frameData;
     packet.frameNumber = request->frameNumber;
+    packet.imageIndex  = request->imageIndex;
+
+    // same-host destinations use shared memory once they acknowledged a token
+    detail::ShmTransport& shm = detail::ShmTransport::getInstance();
+    NodeShmProbePacket probe;
+    if( shm.probe( request->netNodeID, probe.token ))
+    {
+        probe.objectID = request->nodeID;
+        probe.sourceID = packet.sourceID;
+        toNode->send( probe );
+    }
 
+    detail::PixelDataWriter writer;
     std::vector< const PixelData* > pixelDatas;
     std::vector< float > qualities;
+    std::vector< int32_t > rows; // of the strips of a streamed image
 
-    packet.size = packetSize;
     packet.buffers = Frame::BUFFER_NONE;
-    packet.pvp = image->getPixelViewport();
-    packet.useAlpha = image->getAlphaUsage();
-    packet.zoom = image->getZoom();
-    LBASSERT( packet.pvp.isValid( ));
-
+    const bool useDelta = !isBatch && frameData->getDeltaEncoding();
+    if( isBatch )
+    {
+        _writeImages( request, frameData, description->bandwidth, writer,
+                      packet );
+        if( packet.nImages == 0 )
+            return;
+    }
+    else
     {
-        uint64_t rawSize( 0 );
+        packet.pvp = image->getPixelViewport();
+        packet.useAlpha = image->getAlphaUsage();
+        packet.zoom = image->getZoom();
+        LBASSERT( packet.pvp.isValid( ));
+
+        // send only the changed blocks if the destination has the previous
+        // image
+        const bool isDelta = useDelta &&
+            frameData->getDeltaCache().encode( request->netNodeID,
+                                               request->imageIndex, image,
+                                               writer, packet );
+
         ChannelStatistics compressEvent( Statistic::CHANNEL_FRAME_COMPRESS, 
-                                         this, request->frameNumber,
-                                         useCompression ? AUTO : OFF );
-        compressEvent.event.data.statistic.task = request->taskID;
-        compressEvent.event.data.statistic.ratio = 1.0f;
-        compressEvent.event.data.statistic.plugins[0] = EQ_COMPRESSOR_NONE;
-        compressEvent.event.data.statistic.plugins[1] = EQ_COMPRESSOR_NONE;
-
-        // Prepare image pixel data
-        Frame::Buffer buffers[] = {Frame::BUFFER_COLOR,Frame::BUFFER_DEPTH};
-
-        // for each image attachment
-        for( unsigned j = 0; j < 2; ++j )
+                                         this, request->frameNumber );
+        Statistic& statistic = compressEvent.event.data.statistic;
+        statistic.task = request->taskID;
+        statistic.ratio = 1.0f;
+        statistic.plugins[0] = EQ_COMPRESSOR_NONE;
+        statistic.plugins[1] = EQ_COMPRESSOR_NONE;
+
+        // Delta references are sent as a whole. Large images are compressed
+        // in strips, which are sent as separate images with their own
+        // chunks.
+        const uint64_t rawSize = _getRawSize( image );
+        const bool stream = !useDelta && rawSize >= _minStreamSize;
+        if( !isDelta )
         {
-            Frame::Buffer buffer = buffers[j];
-            if( image->hasPixelData( buffer ))
+            _compressImage( image, frameData, request->netNodeID,
+                            description->bandwidth,
+                            stream ? _getNStrips( rawSize ) : 1,
+                            packet.buffers, pixelDatas, qualities, statistic );
+            if( stream && !pixelDatas.empty() &&
+                ( pixelDatas.front()->pvp.h != packet.pvp.h ||
+                  !detail::PixelDataWriter::getStripRows( pixelDatas,
+                                                          _streamStripSize,
+                                                          rows )))
             {
-                // format, type, nChunks, compressor name
-                packet.size += sizeof( FrameData::ImageHeader ); 
-
-                const PixelData& data = useCompression ?
-                    image->compressPixelData( buffer ) : 
-                    image->getPixelData( buffer );
-                pixelDatas.push_back( &data );
-                qualities.push_back( image->getQuality( buffer ));
-
-                if( data.isCompressed )
-                {
-                    const uint32_t nElements = 
-                        uint32_t( data.compressedSize.size( ));
-                    for( uint32_t k = 0 ; k < nElements; ++k )
-                    {
-                        packet.size += sizeof( uint64_t );
-                        packet.size += data.compressedSize[ k ];
-                    }
-                    compressEvent.event.data.statistic.plugins[j] =
-                        data.compressorName;
-                }
-                else
-                {
-                    packet.size += sizeof( uint64_t );
-                    packet.size += image->getPixelDataSize( buffer );
-                }
-
-                packet.buffers |= buffer;
-                rawSize += image->getPixelDataSize( buffer );
+                // buffers without common strips are sent as a whole
+                rows.clear();
+                pixelDatas.clear();
+                qualities.clear();
+                packet.buffers = Frame::BUFFER_NONE;
+                _compressImage( image, frameData, request->netNodeID,
+                                description->bandwidth, 1, packet.buffers,
+                                pixelDatas, qualities, statistic );
             }
+            if( rows.empty( ))
+                for( size_t i = 0; i < pixelDatas.size(); ++i )
+                    writer.add( *pixelDatas[i], qualities[i] );
         }
 
         if( rawSize > 0 )
-            compressEvent.event.data.statistic.ratio =
-            static_cast< float >( packet.size ) /
-            static_cast< float >( rawSize );
-    }
+        {
+            uint64_t size = packetSize + writer.getSize();
+            for( size_t i = 0; i < pixelDatas.size() && !rows.empty(); ++i )
+                size += _getDataSize( *pixelDatas[i] );
+            statistic.ratio = float( size ) / float( rawSize );
+        }
 
-    if( pixelDatas.empty( ))
-        return;
+        if( packet.buffers == Frame::BUFFER_NONE )
+            return;
+        if( useDelta && !isDelta )
+            frameData->getDeltaCache().setReference( request->netNodeID,
+                                                     request->imageIndex,
+                                                     image, packet );
+    }
 
-    // send image pixel data packet
+    // Send the image, or each strip as a separate image
+    const PixelViewport pvp = packet.pvp;
+    const size_t nImages = rows.empty() ? 1 : rows.size() - 1;
     co::LocalNode::SendToken token;
-    if( getIAttribute( IATTR_HINT_SENDTOKEN ) == ON )
+    bool hasToken = false;
+    for( size_t i = 0; i < nImages; ++i )
     {
-        ChannelStatistics waitEvent( Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN,
-                                     this, request->frameNumber );
-        waitEvent.event.data.statistic.task = request->taskID;
-        token = getLocalNode()->acquireSendToken( toNode );
-    }
-
-    connection->lockSend();
-    connection->send( &packet, packetSize, true );
-#ifndef NDEBUG
-    size_t sentBytes = packetSize;
-#endif
+        detail::PixelDataWriter stripWriter;
+        if( !rows.empty( ))
+        {
+            const int32_t h = rows[ i + 1 ] - rows[i];
+            for( size_t j = 0; j < pixelDatas.size(); ++j )
+                stripWriter.add( *pixelDatas[j], qualities[j], rows[i], h );
+            packet.pvp = PixelViewport( pvp.x, pvp.y + rows[i], pvp.w, h );
+        }
+        const detail::PixelDataWriter& imageWriter = rows.empty() ? writer :
+                                                                   stripWriter;
+
+        // same-host destinations read the pixel data from shared memory
+        const uint64_t dataSize = imageWriter.getSize();
+        uint8_t* shmData = shm.acquire( request->netNodeID, dataSize,
+                                        packet.shmRing, packet.shmSlot );
+        if( shmData )
+        {
+            lunchbox::Clock clock;
+            imageWriter.copy( shmData );
+            packet.size = packetSize;
+            if( !toNode->send( packet ))
+                shm.cancel( request->netNodeID, packet.shmSlot );
+            else if( dataSize >= _minTransmitSample )
+                costModel.addTransmit( request->netNodeID, dataSize,
+                                       clock.getTimef( ));
+            continue;
+        }
+        packet.shmSlot = LB_UNDEFINED_UINT32;
+        packet.size = packetSize + dataSize;
 
-    for( uint32_t j=0; j < pixelDatas.size(); ++j )
-    {
-#ifndef NDEBUG
-        sentBytes += sizeof( FrameData::ImageHeader );
-#endif
-        const PixelData* data = pixelDatas[j];
-        const FrameData::ImageHeader header =
-              { data->internalFormat, data->externalFormat,
-                data->pixelSize, data->pvp,
-                useCompression ? data->compressorName : EQ_COMPRESSOR_NONE,
-                data->compressorFlags, 
-                data->isCompressed ? uint32_t( data->compressedSize.size()) : 1,
-                qualities[ j ] };
-
-        connection->send( &header, sizeof( header ), true );
-
-        if( data->isCompressed )
+        // pace to this node's share of the destination link
+        if( request->rate > 0 )
         {
-            for( uint32_t k = 0 ; k < data->compressedSize.size(); ++k )
-            {
-                const uint64_t dataSize = data->compressedSize[k];
-                connection->send( &dataSize, sizeof( dataSize ), true );
-                if( dataSize > 0 )
-                    connection->send( data->compressedData[k], 
-                                      dataSize, true );
-#ifndef NDEBUG
-                sentBytes += sizeof( dataSize ) + dataSize;
-#endif
-            }
+            ChannelStatistics waitEvent(
+                Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN, this,
+                request->frameNumber );
+            waitEvent.event.data.statistic.task = request->taskID;
+            detail::TransmitShaper::getInstance().wait( request->netNodeID,
+                                                        request->rate,
+                                                        packet.size );
         }
-        else
+
+        // send image pixel data packet
+        if( !hasToken && getIAttribute( IATTR_HINT_SENDTOKEN ) == ON )
         {
-            const uint64_t dataSize = data->pvp.getArea() * 
-                data->pixelSize;
-            connection->send( &dataSize, sizeof( dataSize ), true );
-            connection->send( data->pixels, dataSize, true );
-#ifndef NDEBUG
-            sentBytes += sizeof( dataSize ) + dataSize;
-#endif
+            ChannelStatistics waitEvent(
+                Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN, this,
+                request->frameNumber );
+            waitEvent.event.data.statistic.task = request->taskID;
+            token = getLocalNode()->acquireSendToken( toNode );
+            hasToken = true;
         }
-    }
-#ifndef NDEBUG
-    LBASSERTINFO( sentBytes == packet.size,
-        sentBytes << " != " << packet.size );
-#endif
 
-    connection->unlockSend();
+        connection->lockSend();
+        lunchbox::Clock clock;
+        imageWriter.send( connection, &packet, packetSize );
+        const float time = clock.getTimef();
+        connection->unlockSend();
+        if( packet.size >= _minTransmitSample )
+            costModel.addTransmit( request->netNodeID, packet.size, time );
+    }
     getLocalNode()->releaseSendToken( token );
 }
 
+void Channel::_writeImages( const ChannelFrameTransmitImagePacket* request,
+                            FrameDataPtr frameData, const int32_t bandwidth,
+                            detail::PixelDataWriter& writer,
+                            NodeFrameDataTransmitPacket& packet )
+{
+    ChannelStatistics compressEvent( Statistic::CHANNEL_FRAME_COMPRESS, this,
+                                     request->frameNumber );
+    compressEvent.event.data.statistic.task = request->taskID;
+    compressEvent.event.data.statistic.ratio = 1.0f;
+    compressEvent.event.data.statistic.plugins[0] = EQ_COMPRESSOR_NONE;
+    compressEvent.event.data.statistic.plugins[1] = EQ_COMPRESSOR_NONE;
+
+    // Each image is a packet without the command header, padded to eight
+    // bytes. The images are small and copied, which releases them for other
+    // transmit threads before the batch is sent.
+    const Images& images = frameData->getImages();
+    uint64_t rawSize = 0;
+
+    packet.nImages = 0;
+    for( uint32_t i = 0; i < request->nImages; ++i )
+    {
+        const uint32_t index = uint32_t( request->imageIndex ) + i;
+        Image* image = images[ index ];
+        lunchbox::ScopedWrite mutex( image->getTransmitLock( ));
+
+        NodeFrameDataTransmitPacket imagePacket;
+        imagePacket.objectID    = packet.objectID;
+        imagePacket.sourceID    = packet.sourceID;
+        imagePacket.frameData   = packet.frameData;
+        imagePacket.frameNumber = packet.frameNumber;
+        imagePacket.imageIndex  = index;
+        imagePacket.buffers     = Frame::BUFFER_NONE;
+        imagePacket.pvp         = image->getPixelViewport();
+        imagePacket.useAlpha    = image->getAlphaUsage();
+        imagePacket.zoom        = image->getZoom();
+        LBASSERT( imagePacket.pvp.isValid( ));
+
+        detail::PixelDataWriter imageWriter;
+        std::vector< const PixelData* > pixelDatas;
+        std::vector< float > qualities;
+        rawSize += _compressImage( image, frameData, request->netNodeID,
+                                   bandwidth, 1, imagePacket.buffers,
+                                   pixelDatas, qualities,
+                                   compressEvent.event.data.statistic );
+        if( imagePacket.buffers == Frame::BUFFER_NONE )
+            continue;
+        for( size_t j = 0; j < pixelDatas.size(); ++j )
+            imageWriter.add( *pixelDatas[j], qualities[j] );
+
+        writer.addImage( imagePacket, imageWriter );
+        ++packet.nImages;
+    }
+
+    const uint64_t packetSize = sizeof( packet ) - 8 * sizeof( uint8_t );
+    packet.size = packetSize + writer.getSize();
+    if( rawSize > 0 )
+        compressEvent.event.data.statistic.ratio =
+            static_cast< float >( packet.size ) /
+            static_cast< float >( rawSize );
+}
+
 void Channel::_setReady( const bool async, detail::RBStat* stat )
 {
     const Frames& frames = getOutputFrames();
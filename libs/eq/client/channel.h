@@ -27,13 +27,14 @@
 
 namespace eq
 {
-namespace detail { class Channel; struct RBStat; }
+namespace detail { class Channel; class PixelDataWriter; struct RBStat; }
 
     struct ChannelFinishReadbackPacket;
     struct ChannelFrameSetReadyNodePacket;
     struct ChannelFrameSetReadyPacket;
     struct ChannelFrameTilesPacket;
     struct ChannelFrameTransmitImagePacket;
+    struct NodeFrameDataTransmitPacket;
 
     /**
      * A channel represents a two-dimensional viewport within a Window.
@@ -588,8 +589,14 @@ namespace detail { class Channel; struct RBStat; }
         /** Check for and send frame finish reply. */
         void _unrefFrame( const uint32_t frameNumber );
 
-        /** Transmit one image of a frame to one node. */
+        /** Transmit one image or a batch of images of a frame to one node. */
         void _transmitImage( const ChannelFrameTransmitImagePacket* packet );
+
+        /** Add a batch of images as separate packets to the writer. */
+        void _writeImages( const ChannelFrameTransmitImagePacket* request,
+                           FrameDataPtr frameData, const int32_t bandwidth,
+                           detail::PixelDataWriter& writer,
+                           NodeFrameDataTransmitPacket& packet );
         
         void _frameReadback( const uint128_t& frameID, uint32_t nFrames,
                              co::ObjectVersion* frames );
@@ -598,9 +605,11 @@ namespace detail { class Channel; struct RBStat; }
         bool _asyncFinishReadback( const std::vector< size_t >& imagePos );
 
         void _asyncTransmit( FrameDataPtr frame, const uint32_t frameNumber,
-                             const size_t image,
+                             const size_t image, const size_t nImages,
                              const std::vector<uint128_t>& nodes,
                              const std::vector< uint128_t >& netNodes,
+                             const std::vector< uint32_t >& priorities,
+                             const std::vector< uint32_t >& rates,
                              const uint32_t taskID );
 
         void _setReady( const bool async, detail::RBStat* stat );
@@ -207,6 +207,9 @@ namespace detail { struct RBStat; }
         uint64_t           imageIndex;
         uint32_t           frameNumber;
         uint32_t           taskID;
+        uint32_t           priority; //!< lower values are sent first
+        uint32_t           rate;     //!< maximum rate in KB/s, 0 if unlimited
+        uint32_t           nImages;  //!< consecutive images from imageIndex
     };
 
     struct ChannelFrameSetReadyPacket : public ChannelPacket
@@ -255,6 +258,7 @@ namespace detail { struct RBStat; }
         uint32_t           frameNumber;
         uint32_t           taskID;
         uint32_t           nNodes;
+        /** nNodes node IDs, net node IDs and rates (high) and priorities */
         LB_ALIGN8( uint128_t IDs[1] );
     };
 
@@ -333,7 +337,9 @@ namespace detail { struct RBStat; }
                                  const ChannelFrameTransmitImagePacket* packet )
     {
         os << (co::ObjectPacket*)packet << " frame data " << packet->frameData
-           << " receiver " << packet->nodeID << " on " << packet->netNodeID;
+           << " receiver " << packet->nodeID << " on " << packet->netNodeID
+           << " priority " << packet->priority << " images "
+           << packet->imageIndex << "+" << packet->nImages;
         return os;
     }
     inline std::ostream& operator << ( std::ostream& os, 
@@ -23,16 +23,19 @@
 #include "channelStatistics.h"
 #include "client.h"
 #include "compositor.h"
+#include "compositorKernels.h"
 #include "config.h"
 #include "exception.h"
 #include "frameData.h"
 #include "gl.h"
 #include "image.h"
 #include "log.h"
+#include "pixelBufferPool.h"
 #include "pixelData.h"
 #include "server.h"
 #include "window.h"
 #include "windowSystem.h"
+#include "compressor/compressorSpan.h"
 
 #include <eq/util/accum.h>
 #include <eq/util/frameBufferObject.h>
@@ -52,6 +55,8 @@
 #  define bzero( ptr, size ) { memset( ptr, 0, size ); }
 #endif
 
+#include <algorithm>
+
 using lunchbox::Monitor;
 
 namespace eq
@@ -70,7 +75,112 @@ static const char* depthDBKey  = shaderDBKey + 2;
 // Image used for CPU-based assembly
 static lunchbox::PerThread< Image > _resultImage;
 
-static bool _useCPUAssembly( const Frames& frames, Channel* channel,
+// Destination tile size for the CPU merge: 512 pixel wide rows, and as many
+// rows as fit the color and depth of one tile into a typical 256 KB L2 cache.
+static const int32_t _tileWidth = 512;
+static const uint32_t _tileCacheSize = 256 * 1024;
+
+/** The common pixel format of all images merged on the CPU. */
+struct MergeFormat
+{
+    MergeFormat() : colorInternal( 0 ), colorExternal( 0 ), colorPixelSize( 0 )
+                  , depthInternal( 0 ), depthExternal( 0 ) {}
+
+    uint32_t colorInternal;
+    uint32_t colorExternal;
+    uint32_t colorPixelSize;
+    uint32_t depthInternal;
+    uint32_t depthExternal;
+};
+
+/**
+ * @return true if the image can be merged on the CPU using the given format,
+ *         which is initialized by the first image.
+ */
+static bool _isCPUMergeable( const Image* image, const bool blendAlpha,
+                             MergeFormat& format )
+{
+    if( image->getStorageType() != Frame::TYPE_MEMORY )
+        return false;
+
+    const bool hasColor = image->hasPixelData( Frame::BUFFER_COLOR );
+    const bool hasDepth = image->hasPixelData( Frame::BUFFER_DEPTH );
+
+    if( // Not an alpha-blending compositing
+        ( !blendAlpha || !hasColor || !image->hasAlpha( )) &&
+        // and not a depth-sorting compositing
+        ( !hasColor || !hasDepth ))
+    {
+        return false;
+    }
+
+    if( format.colorInternal == 0 && format.colorExternal == 0 )
+    {
+        format.colorInternal =
+            image->getInternalFormat( Frame::BUFFER_COLOR );
+        format.colorExternal =
+            image->getExternalFormat( Frame::BUFFER_COLOR );
+        format.colorPixelSize = image->getPixelSize( Frame::BUFFER_COLOR );
+
+        switch( format.colorExternal )
+        {
+            case EQ_COMPRESSOR_DATATYPE_RGB10_A2:
+            case EQ_COMPRESSOR_DATATYPE_BGR10_A2:
+                if( !hasDepth )
+                    // blending of RGB10A2 not implemented
+                    return false;
+                break;
+
+            case EQ_COMPRESSOR_DATATYPE_RGBA:
+            case EQ_COMPRESSOR_DATATYPE_BGRA:
+                break;
+
+            default:
+                return false;
+        }
+    }
+    else if( format.colorInternal !=
+             image->getInternalFormat( Frame::BUFFER_COLOR ) ||
+             format.colorExternal !=
+             image->getExternalFormat( Frame::BUFFER_COLOR ))
+    {
+        return false;
+    }
+
+    if( hasDepth &&
+        ( format.depthInternal !=
+          image->getInternalFormat( Frame::BUFFER_DEPTH ) ||
+          format.depthExternal !=
+          image->getExternalFormat( Frame::BUFFER_DEPTH )))
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @return true if all images of the ready frame can be merged on the CPU
+ *         using the given format, which is initialized by the first image.
+ */
+static bool _isCPUMergeable( const Frame* frame, const bool blendAlpha,
+                             MergeFormat& format )
+{
+#ifdef EQ_2_0_API
+    if( frame->getFrameData()->getZoom() != Zoom::NONE )
+        return false;
+#else
+    if( frame->getData()->getZoom() != Zoom::NONE )
+        return false;
+#endif
+
+    const Images& images = frame->getImages();
+    for( ImagesCIter i = images.begin(); i != images.end(); ++i )
+        if( !_isCPUMergeable( *i, blendAlpha, format ))
+            return false;
+    return true;
+}
+
+static bool _useCPUAssembly( const Frames& frames,
                              const bool blendAlpha = false )
 {
     // It doesn't make sense to use CPU-assembly for only one frame
@@ -85,6 +195,7 @@ static bool _useCPUAssembly( const Frames& frames, Channel* channel,
     const uint32_t desiredBuffers = blendAlpha ? Frame::BUFFER_COLOR :
                                     Frame::BUFFER_COLOR | Frame::BUFFER_DEPTH;
     size_t nFrames = 0;
+    bool useDepth = false;
     for( Frames::const_iterator i = frames.begin(); i != frames.end(); ++i )
     {
         const Frame* frame = *i;
@@ -97,114 +208,479 @@ static bool _useCPUAssembly( const Frames& frames, Channel* channel,
 
         if( frame->getBuffers() == desiredBuffers )
             ++nFrames;
+        if( frame->getBuffers() & Frame::BUFFER_DEPTH )
+            useDepth = true;
     }
     if( nFrames < 2 )
         return false;
 
-    // Now wait for all images to be ready and test if our assumption was
-    // correct, that there are enough images to make a CPU-based assembly
-    // worthwhile and all other preconditions for our CPU-based assembly code
-    // are true.
-    size_t   nImages        = 0;
-    uint32_t colorInternalFormat = 0;
-    uint32_t colorExternalFormat = 0;
-    uint32_t depthInternalFormat = 0;
-    uint32_t depthExternalFormat = 0;
-    const uint32_t timeout = channel->getConfig()->getTimeout();
-
-    for( FramesCIter i = frames.begin(); i != frames.end(); ++i )
+    // Test the images of the frames which are ready already. Unlike before the
+    // progressive assembly, this does not wait for the other frames: their
+    // images are tested by assembleFramesCPU() when they arrive, which falls
+    // back to GPU-based assembly for the frames it can't merge.
+    MergeFormat format;
+    if( useDepth )
+    {
+        format.depthInternal = EQ_COMPRESSOR_DATATYPE_DEPTH;
+        format.depthExternal = EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT;
+    }
+    for( Frames::const_iterator i = frames.begin(); i != frames.end(); ++i )
     {
         const Frame* frame = *i;
+        if( frame->isReady() && !_isCPUMergeable( frame, blendAlpha, format ))
+            return false;
+    }
+    return true;
+}
+
+/** The progress of each frame during progressive CPU-based assembly. */
+enum MergeState
+{
+    STATE_WAITING,
+    STATE_READY,
+    STATE_MERGED
+};
+
+/** Intermediate buffers used for progressive CPU-based assembly. */
+struct MergeBuffers
+{
+    detail::PixelBuffer color;
+    detail::PixelBuffer depth;
+};
+static lunchbox::PerThread< MergeBuffers > _mergeBuffers;
+
+/** Allocate and clear the destination buffers of progressive assembly. */
+static void _clearMergeBuffers( MergeBuffers* buffers, const MergeFormat& format,
+                                const PixelViewport& destPVP,
+                                const bool useDepth,
+                                void*& destColor, void*& destDepth )
+{
+    const size_t area = destPVP.getArea();
+    buffers->color.resize( area * format.colorPixelSize );
+    destColor = buffers->color.getData();
+    bzero( destColor, buffers->color.getSize( ));
+    if( format.colorPixelSize == 4 &&
+        ( format.colorExternal == EQ_COMPRESSOR_DATATYPE_RGBA ||
+          format.colorExternal == EQ_COMPRESSOR_DATATYPE_BGRA ))
+    {
+        uint8_t* data = buffers->color.getData();
+        for( size_t i = 3; i < area * 4; i += 4 )
+            data[i] = 255;
+    }
+
+    if( useDepth )
+    {
+        buffers->depth.resize( area * sizeof( uint32_t ));
+        destDepth = buffers->depth.getData();
+        memset( destDepth, 0xFF, buffers->depth.getSize( ));
+    }
+}
+
+/** Add the color images of a frame not merged yet to the merge inputs. */
+static void _addMergeInputs( const Frame* frame, const Images& images,
+                             Images& mergedImages,
+                             std::vector< std::pair< const Frame*,
+                                                     const Image* > >& inputs )
+{
+    for( ImagesCIter i = images.begin(); i != images.end(); ++i )
+    {
+        const Image* image = *i;
+        if( std::find( mergedImages.begin(), mergedImages.end(), image ) !=
+            mergedImages.end( ))
         {
-            ChannelStatistics event( Statistic::CHANNEL_FRAME_WAIT_READY,
-                                     channel );
-            frame->waitReady( timeout );
+            continue;
         }
 
-#ifdef EQ_2_0_API
-        if( frame->getFrameData()->getZoom() != Zoom::NONE )
-            return false;
+        mergedImages.push_back( *i );
+        if( image->hasPixelData( Frame::BUFFER_COLOR ))
+            inputs.push_back( std::make_pair( frame, image ));
+    }
+}
+
+/** Compact the rows of region within a buffer of the given row length. */
+static void* _compact( detail::PixelBuffer& buffer, const int32_t rowLength,
+                       const PixelViewport& region, const size_t pixelSize )
+{
+    uint8_t* data = buffer.getData();
+    uint8_t* const start = data + ( region.y * rowLength + region.x ) *
+                                  pixelSize;
+    if( region.w == rowLength )
+        return start;
+
+    // in-place: each destination row starts before its source row
+    const size_t rowSize = region.w * pixelSize;
+    for( int32_t y = 0; y < region.h; ++y )
+        memmove( data + y * rowSize, start + y * rowLength * pixelSize,
+                 rowSize );
+    return data;
+}
+
+//----------------------------------------------------------------------
+// Compressed-domain merging of span-compressed images
+//----------------------------------------------------------------------
+// Pixels processed at once by the span merge operations
+static const uint32_t _spanBlock = 256;
+
+/** @return true if the buffer is span-compressed, see CompressorSpan. */
+static bool _hasSpanData( const Image* image, const Frame::Buffer buffer )
+{
+    return image->hasCompressedPixelData( buffer ) &&
+           plugin::CompressorSpan::isSpanCompressor(
+               image->getCompressedPixelData( buffer ).compressorName );
+}
+
+/** @return the pixel data format, without decompressing the pixels. */
+static const PixelData& _getFormat( const Image* image,
+                                    const Frame::Buffer buffer )
+{
+    if( image->hasCompressedPixelData( buffer ))
+        return image->getCompressedPixelData( buffer );
+    return image->getPixelData( buffer );
+}
+
+/** @return true if the image can be merged in the compressed domain. */
+static bool _isSpanMergeable( const Image* image, const bool blendAlpha )
+{
+#ifdef EQ_USE_PARACOMP
+    return false;
 #else
-        if( frame->getData()->getZoom() != Zoom::NONE )
-            return false;
+    if( image->hasPixelData( Frame::BUFFER_DEPTH ))
+        return _hasSpanData( image, Frame::BUFFER_DEPTH ) ||
+               _hasSpanData( image, Frame::BUFFER_COLOR );
+
+    // blending of a compressed image uses the decompress-then-merge fallback
+    return !( blendAlpha && image->hasAlpha( )) &&
+           _hasSpanData( image, Frame::BUFFER_COLOR );
 #endif
+}
 
-        const Images& images = frame->getImages();
-        for( Images::const_iterator j = images.begin();
-             j != images.end(); ++j )
-        {
-            const Image* image = *j;
+/** Reads the pixels of a plain or span-compressed buffer in order. */
+class SpanSource
+{
+public:
+    SpanSource( const Image* image, const Frame::Buffer buffer )
+        : _pixels( 0 ), _data( 0 ), _chunk( 0 ), _chunkEnd( 0 )
+        , _literal( 0 ), _literalStart( 0 ), _recordEnd( 0 )
+    {
+        if( _hasSpanData( image, buffer ))
+            _data = &image->getCompressedPixelData( buffer );
+        else
+            _pixels = reinterpret_cast< const uint32_t* >(
+                image->getPixelPointer( buffer ));
+    }
 
-            const bool hasColor = image->hasPixelData( Frame::BUFFER_COLOR );
-            const bool hasDepth = image->hasPixelData( Frame::BUFFER_DEPTH );
+    /**
+     * @return n pixels starting at pos, either in place or copied to scratch.
+     *         Consecutive calls have to use increasing positions.
+     */
+    const uint32_t* read( const uint64_t pos, const uint32_t n,
+                          uint32_t* scratch )
+    {
+        if( _pixels )
+            return _pixels + pos;
+
+        uint32_t done = 0;
+        while( done < n )
+        {
+            const uint64_t current = pos + done;
+            while( current >= _recordEnd )
+                _nextRecord( current );
 
-            if( // Not an alpha-blending compositing
-                ( !blendAlpha || !hasColor || !image->hasAlpha( )) &&
-                // and not a depth-sorting compositing
-                ( !hasColor || !hasDepth ))
+            const uint32_t left = n - done;
+            if( current < _literalStart )
             {
-                return false;
+                const uint32_t count = uint32_t(
+                    LB_MIN( uint64_t( left ), _literalStart - current ));
+                const uint32_t background = _reader.getBackground();
+                for( uint32_t i = 0; i < count; ++i )
+                    scratch[ done + i ] = background;
+                done += count;
+                continue;
             }
 
-            if( colorInternalFormat == 0 && colorExternalFormat == 0 )
-            {
-                colorInternalFormat =
-                    image->getInternalFormat( Frame::BUFFER_COLOR );
-                colorExternalFormat =
-                    image->getExternalFormat( Frame::BUFFER_COLOR );
+            const uint32_t count = uint32_t(
+                LB_MIN( uint64_t( left ), _recordEnd - current ));
+            const uint32_t* literal = _literal + ( current - _literalStart );
+            if( count == n )
+                return literal;
 
-                switch( colorExternalFormat )
-                {
-                    case EQ_COMPRESSOR_DATATYPE_RGB10_A2:
-                    case EQ_COMPRESSOR_DATATYPE_BGR10_A2:
-                        if( !hasDepth )
-                            // blending of RGB10A2 not implemented
-                            return false;
-                        break;
+            memcpy( scratch + done, literal, count * sizeof( uint32_t ));
+            done += count;
+        }
+        return scratch;
+    }
 
-                    case EQ_COMPRESSOR_DATATYPE_RGBA:
-                    case EQ_COMPRESSOR_DATATYPE_BGRA:
-                        break;
+private:
+    const uint32_t* _pixels;
+    const PixelData* _data;
 
-                    default:
-                        return false;
-                }
+    plugin::SpanReader _reader;
+    unsigned _chunk;
+    uint64_t _chunkEnd;
+    const uint32_t* _literal;
+    uint64_t _literalStart;
+    uint64_t _recordEnd;
 
-            }
-            else if( colorInternalFormat !=
-                     image->getInternalFormat( Frame::BUFFER_COLOR ) ||
-                     colorExternalFormat !=
-                     image->getExternalFormat( Frame::BUFFER_COLOR ))
+    void _nextRecord( const uint64_t pos )
+    {
+        if( pos >= _chunkEnd ) // jump to the chunk containing pos
+        {
+            const unsigned nChunks = unsigned( _data->compressedSize.size( ));
+            const uint64_t nPixels = _data->pvp.getArea();
+            uint64_t start = 0;
+            while( true )
             {
-                return false;
+                start = plugin::CompressorSpan::getChunkStart( _chunk, nChunks,
+                                                               nPixels );
+                _chunkEnd = plugin::CompressorSpan::getChunkStart( _chunk + 1,
+                                                                   nChunks,
+                                                                   nPixels );
+                if( pos < _chunkEnd )
+                    break;
+                ++_chunk;
+                LBASSERT( _chunk < nChunks );
             }
-            if( hasDepth )
+
+            _reader = plugin::SpanReader( _data->compressedData[ _chunk ],
+                                          _data->compressedSize[ _chunk ]);
+            _recordEnd = start;
+        }
+
+        LBCHECK( _reader.next( ));
+        _literalStart = _recordEnd + _reader.getNBackground();
+        _literal = _reader.getLiteral();
+        _recordEnd = _literalStart + _reader.getNLiteral();
+    }
+};
+
+/** Maps the pixels of an image to rows of the destination buffer. */
+struct SpanTarget
+{
+    SpanTarget( const Image* image, const Vector2i& offset,
+                const PixelViewport& destPVP )
+        : width( image->getPixelViewport().w )
+        , destX( offset.x() + image->getPixelViewport().x - destPVP.x )
+        , destY( offset.y() + image->getPixelViewport().y - destPVP.y )
+        , destWidth( destPVP.w )
+        , area( 0, 0, destPVP.w, destPVP.h )
+    {}
+
+    const int32_t width;
+    const int32_t destX;
+    const int32_t destY;
+    const int32_t destWidth;
+    const PixelViewport area;
+};
+
+/**
+ * Call op( pos, dest, n ) for each row segment of the n pixels starting at
+ * pos which is visible in the destination buffer.
+ */
+template< class Op >
+static void _forEachRow( const SpanTarget& target, uint64_t pos, uint64_t n,
+                         Op& op )
+{
+    while( n > 0 )
+    {
+        const int32_t x = int32_t( pos % target.width );
+        const int32_t y = int32_t( pos / target.width ) + target.destY;
+        const int32_t length = int32_t( LB_MIN( n,
+                                                uint64_t( target.width - x )));
+        const int32_t start = target.destX + x;
+        const int32_t x0 = LB_MAX( start, target.area.x );
+        const int32_t x1 = LB_MIN( start + length, target.area.getXEnd( ));
+
+        if( y >= target.area.y && y < target.area.getYEnd() && x1 > x0 )
+            op( pos + x0 - start, size_t( y ) * target.destWidth + x0,
+                uint32_t( x1 - x0 ));
+
+        pos += length;
+        n -= length;
+    }
+}
+
+/** Depth-composites spans of literal or constant depth. */
+class MergeDBSpan
+{
+public:
+    MergeDBSpan( void* destColor, void* destDepth, SpanSource& color )
+        : _destColor( reinterpret_cast< uint32_t* >( destColor ))
+        , _destDepth( reinterpret_cast< uint32_t* >( destDepth ))
+        , _color( color )
+        , _depth( 0 )
+        , _depthStart( 0 )
+        , _mergeRow( detail::getMergeDBRow( ))
+    {
+        for( uint32_t i = 0; i < _spanBlock; ++i )
+            _constant[i] = 0xffffffffu;
+    }
+
+    /** Use the given depth values for the following spans. */
+    void setDepth( const uint32_t* depth, const uint64_t start )
+        { _depth = depth; _depthStart = start; }
+
+    /** Use a constant depth value for the following spans. */
+    void setDepth( const uint32_t depth )
+    {
+        _depth = 0;
+        if( _constant[0] == depth )
+            return;
+        for( uint32_t i = 0; i < _spanBlock; ++i )
+            _constant[i] = depth;
+    }
+
+    void operator()( uint64_t pos, size_t dest, uint32_t n )
+    {
+        while( n > 0 )
+        {
+            const uint32_t count = LB_MIN( n, _spanBlock );
+            const uint32_t* color = _color.read( pos, count, _scratch );
+            const uint32_t* depth = _depth ? _depth + ( pos - _depthStart ) :
+                                             _constant;
+            _mergeRow( _destColor + dest, _destDepth + dest, color, depth,
+                       count );
+            pos += count;
+            dest += count;
+            n -= count;
+        }
+    }
+
+private:
+    uint32_t* const _destColor;
+    uint32_t* const _destDepth;
+    SpanSource& _color;
+    const uint32_t* _depth;
+    uint64_t _depthStart;
+    const detail::MergeDBRowFunc _mergeRow;
+    uint32_t _scratch[ _spanBlock ];
+    uint32_t _constant[ _spanBlock ];
+};
+
+/** Copies spans of literal or constant color. */
+class Merge2DSpan
+{
+public:
+    Merge2DSpan( void* destColor, void* destDepth )
+        : _destColor( reinterpret_cast< uint32_t* >( destColor ))
+        , _destDepth( reinterpret_cast< uint32_t* >( destDepth ))
+        , _color( 0 )
+        , _colorStart( 0 )
+        , _constant( 0 )
+    {}
+
+    void setColor( const uint32_t* color, const uint64_t start )
+        { _color = color; _colorStart = start; }
+    void setColor( const uint32_t color ) { _color = 0; _constant = color; }
+
+    void operator()( const uint64_t pos, const size_t dest, const uint32_t n )
+    {
+        uint32_t* out = _destColor + dest;
+        if( _color )
+            memcpy( out, _color + ( pos - _colorStart ),
+                    n * sizeof( uint32_t ));
+        else
+            for( uint32_t i = 0; i < n; ++i )
+                out[i] = _constant;
+
+        // clear depth, for depth-assembly into existing FB
+        if( _destDepth )
+            bzero( _destDepth + dest, n * sizeof( uint32_t ));
+    }
+
+private:
+    uint32_t* const _destColor;
+    uint32_t* const _destDepth;
+    const uint32_t* _color;
+    uint64_t _colorStart;
+    uint32_t _constant;
+};
+
+/**
+ * Merge an image with span-compressed color and/or depth data without
+ * decompressing it. Background spans of the far depth value can't pass the
+ * depth test and are skipped. The chunks of the compressed data are merged in
+ * parallel.
+ */
+static void _mergeSpanImage( void* destColor, void* destDepth,
+                             const PixelViewport& destPVP, const Image* image,
+                             const Vector2i& offset )
+{
+    LBVERB << "CPU-Span assembly" << std::endl;
+
+    const SpanTarget target( image, offset, destPVP );
+    const uint64_t nPixels = image->getPixelViewport().getArea();
+    const bool useDepth = image->hasPixelData( Frame::BUFFER_DEPTH );
+    const Frame::Buffer buffer = useDepth ? Frame::BUFFER_DEPTH :
+                                            Frame::BUFFER_COLOR;
+    const bool isCompressed = _hasSpanData( image, buffer );
+    const PixelData* data = isCompressed ?
+                            &image->getCompressedPixelData( buffer ) : 0;
+    const uint32_t* pixels = isCompressed ? 0 :
+        reinterpret_cast< const uint32_t* >( image->getPixelPointer( buffer ));
+    const unsigned nChunks = isCompressed ?
+                             unsigned( data->compressedSize.size( )) :
+                             unsigned( LB_MAX( 1, image->getPixelViewport().h /
+                                                  64 ));
+
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( nChunks ); ++i )
+    {
+        const uint64_t start = plugin::CompressorSpan::getChunkStart( i,
+                                                        nChunks, nPixels );
+        const uint64_t end = plugin::CompressorSpan::getChunkStart( i + 1,
+                                                        nChunks, nPixels );
+        if( start == end )
+            continue;
+
+        if( useDepth )
+        {
+            LBASSERT( destDepth );
+            SpanSource color( image, Frame::BUFFER_COLOR );
+            MergeDBSpan merge( destColor, destDepth, color );
+            if( !isCompressed ) // only the color is compressed
             {
-                if( depthInternalFormat == 0 && depthExternalFormat == 0 )
-                {
-                    depthInternalFormat =
-                        image->getInternalFormat( Frame::BUFFER_DEPTH );
-                    depthExternalFormat =
-                        image->getExternalFormat( Frame::BUFFER_DEPTH );
+                merge.setDepth( pixels, 0 );
+                _forEachRow( target, start, end - start, merge );
+                continue;
+            }
 
-                    if( depthExternalFormat !=
-                        EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT )
-                    {
-                        return false;
-                    }
-                }
-                else if( depthInternalFormat !=
-                         image->getInternalFormat(Frame::BUFFER_DEPTH ) ||
-                         depthExternalFormat !=
-                         image->getExternalFormat(  Frame::BUFFER_DEPTH ))
+            plugin::SpanReader reader( data->compressedData[i],
+                                       data->compressedSize[i] );
+            const uint32_t background = reader.getBackground();
+            merge.setDepth( background );
+
+            for( uint64_t pos = start; reader.next(); )
+            {
+                const uint32_t nBackground = reader.getNBackground();
+                if( background != 0xffffffffu ) // else fails depth test
                 {
-                    return false;
+                    merge.setDepth( background );
+                    _forEachRow( target, pos, nBackground, merge );
                 }
+                pos += nBackground;
+
+                merge.setDepth( reader.getLiteral(), pos );
+                _forEachRow( target, pos, reader.getNLiteral(), merge );
+                pos += reader.getNLiteral();
             }
-            ++nImages;
+            continue;
+        }
+
+        LBASSERT( isCompressed );
+        Merge2DSpan merge( destColor, destDepth );
+        plugin::SpanReader reader( data->compressedData[i],
+                                   data->compressedSize[i] );
+        for( uint64_t pos = start; reader.next(); )
+        {
+            merge.setColor( reader.getBackground( ));
+            _forEachRow( target, pos, reader.getNBackground(), merge );
+            pos += reader.getNBackground();
+
+            merge.setColor( reader.getLiteral(), pos );
+            _forEachRow( target, pos, reader.getNLiteral(), merge );
+            pos += reader.getNLiteral();
         }
     }
-    return (nImages > 1);
 }
 }
 
@@ -214,7 +690,7 @@ uint32_t Compositor::assembleFrames( const Frames& frames,
     if( frames.empty( ))
         return 0;
 
-    if( _useCPUAssembly( frames, channel ))
+    if( _useCPUAssembly( frames ))
         return assembleFramesCPU( frames, channel );
 
     // else
@@ -288,7 +764,7 @@ uint32_t Compositor::assembleFramesSorted( const Frames& frames,
     }
 
     uint32_t count = 0;
-    if( _useCPUAssembly( frames, channel, blendAlpha ))
+    if( _useCPUAssembly( frames, blendAlpha ))
         count |= assembleFramesCPU( frames, channel, blendAlpha );
     else
     {
@@ -434,10 +910,16 @@ public:
             for( FramesCIter i = left.begin(); i != left.end(); ++i )
                 (*i)->removeListener( monitor );
             left.clear();
+            for( std::vector< FrameDataPtr >::const_iterator i =
+                     imageSources.begin(); i != imageSources.end(); ++i )
+            {
+                (*i)->removeImageListener( monitor );
+            }
         }
 
     lunchbox::Monitor< uint32_t > monitor;
     Frames left;
+    std::vector< FrameDataPtr > imageSources; //!< see addImageListener()
     Channel* const channel;
     uint32_t processed;
 };
@@ -460,6 +942,18 @@ Frame* Compositor::waitFrame( WaitHandle* handle )
         return 0;
     }
 
+    _waitEvent( handle );
+    Frame* frame = _getReadyFrame( handle );
+    if( frame )
+        return frame;
+
+    LBASSERTINFO( false, "Unreachable code" );
+    delete handle;
+    return 0;
+}
+
+void Compositor::_waitEvent( WaitHandle* handle )
+{
     ChannelStatistics event( Statistic::CHANNEL_FRAME_WAIT_READY,
                              handle->channel );
     Config* config = handle->channel->getConfig();
@@ -490,7 +984,10 @@ Frame* Compositor::waitFrame( WaitHandle* handle )
             }
         }
     }
+}
 
+Frame* Compositor::_getReadyFrame( WaitHandle* handle )
+{
     for( FramesIter i = handle->left.begin(); i != handle->left.end(); ++i )
     {
         Frame* frame = *i;
@@ -501,9 +998,6 @@ Frame* Compositor::waitFrame( WaitHandle* handle )
         handle->left.erase( i );
         return frame;
     }
-
-    LBASSERTINFO( false, "Unreachable code" );
-    delete handle;
     return 0;
 }
 
@@ -513,30 +1007,259 @@ uint32_t Compositor::assembleFramesCPU( const Frames& frames, Channel* channel,
     if( frames.empty( ))
         return 0;
 
-    LBVERB << "Sorted CPU assembly" << std::endl;
+    LBVERB << "Progressive CPU assembly" << std::endl;
     // Assembles images from DB and 2D compounds using the CPU and then
     // assembles the result image. Does not yet support Pixel or Eye
     // compounds.
 
-    const Image* result = mergeFramesCPU( frames, blendAlpha,
-                                          channel->getConfig()->getTimeout( ));
-    if( !result )
-        return 0;
-
-    // assemble result on dest channel
-    ImageOp operation;
-    operation.channel = channel;
-    operation.buffers = Frame::BUFFER_COLOR | Frame::BUFFER_DEPTH;
-    assembleImage( result, operation );
+    Frames left;
+    const Image* result = _mergeFramesProgressive( frames, channel,
+                                                   blendAlpha, left );
+    uint32_t count = 0;
+    if( result )
+    {
+        // assemble result on dest channel
+        ImageOp operation;
+        operation.channel = channel;
+        operation.buffers = Frame::BUFFER_COLOR | Frame::BUFFER_DEPTH;
+        assembleImage( result, operation );
+        count = 1;
 
 #if 0
-    static uint32_t counter = 0;
-    ostringstream stringstream;
-    stringstream << "Image_" << ++counter;
-    result->writeImages( stringstream.str( ));
+        static uint32_t counter = 0;
+        ostringstream stringstream;
+        stringstream << "Image_" << ++counter;
+        result->writeImages( stringstream.str( ));
 #endif
+    }
+
+    // Frames the CPU compositor can't handle, in order. These follow all
+    // order-sensitive frames merged above, see _mergeFramesProgressive().
+    const uint32_t timeout = channel->getConfig()->getTimeout();
+    for( FramesCIter i = left.begin(); i != left.end(); ++i )
+    {
+        Frame* frame = *i;
+        {
+            ChannelStatistics event( Statistic::CHANNEL_FRAME_WAIT_READY,
+                                     channel );
+            frame->waitReady( timeout );
+        }
 
-    return 1;
+        if( !frame->getImages().empty( ))
+        {
+            count = 1;
+            assembleFrame( frame, channel );
+        }
+    }
+    return count;
+}
+
+const Image* Compositor::_mergeFramesProgressive( const Frames& frames,
+                                                  Channel* channel,
+                                                  const bool blendAlpha,
+                                                  Frames& left )
+{
+    // Each input frame is merged as soon as it is ready, which overlaps the
+    // compositing with the reception of the remaining frames. Depth-composited
+    // frames are merged in the order they arrive, like in
+    // assembleFramesUnsorted(). Frames with color-only images (2D or blend)
+    // depend on the order and are only merged after all preceding frames.
+    //
+    // The final destination area is not known before all images arrived. The
+    // frames are therefore merged into a buffer covering the channel, and the
+    // result image is cropped to the merged area.
+    const PixelViewport& channelPVP = channel->getPixelViewport();
+    const PixelViewport destPVP( 0, 0, channelPVP.w, channelPVP.h );
+    const size_t nFrames = frames.size();
+
+    std::vector< MergeState > states( nFrames, STATE_WAITING );
+    std::vector< bool > ordered( nFrames, false );
+
+    MergeFormat format;
+    bool useDepth = false;
+    for( size_t i = 0; i < nFrames; ++i )
+    {
+        if( frames[i]->getBuffers() & Frame::BUFFER_DEPTH )
+            useDepth = true;
+        // Frames with depth may still deliver color-only images. Merging these
+        // after depth images of later frames is equivalent for 2D images, but
+        // not for alpha-blended images.
+        if( !( frames[i]->getBuffers() & Frame::BUFFER_DEPTH ) || blendAlpha )
+            ordered[i] = true;
+    }
+    if( useDepth )
+    {
+        format.depthInternal = EQ_COMPRESSOR_DATATYPE_DEPTH;
+        format.depthExternal = EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT;
+    }
+
+    if( !_mergeBuffers )
+        _mergeBuffers = new MergeBuffers;
+    MergeBuffers* buffers = _mergeBuffers.get();
+    void* destColor = 0;
+    void* destDepth = 0;
+    PixelViewport merged;
+    bool failed = false;
+
+    // Large images arrive as independently decoded strips. The decoded strips
+    // of depth-composited frames are merged before their frame is ready, and
+    // the images merged so far are skipped once it is.
+    std::vector< Images > mergedImages( nFrames );
+    std::vector< bool > partial( nFrames, false );
+
+    WaitHandle* handle = startWaitFrames( frames, channel );
+    for( size_t i = 0; i < nFrames; ++i )
+    {
+        if( ordered[i] )
+            continue;
+
+        FrameDataPtr frameData = frames[i]->getFrameData();
+        frameData->addImageListener( handle->monitor );
+        handle->imageSources.push_back( frameData );
+        partial[i] = true;
+    }
+
+    while( !handle->left.empty( ))
+    {
+        // wakes up for each ready frame and for each decoded image
+        _waitEvent( handle );
+        Frame* frame = _getReadyFrame( handle );
+        if( frame )
+        {
+            const size_t index = std::find( frames.begin(), frames.end(),
+                                            frame ) - frames.begin();
+            LBASSERT( index < nFrames );
+            states[ index ] = STATE_READY;
+
+            const Images& images = frame->getImages();
+            for( ImagesCIter i = images.begin(); i != images.end(); ++i )
+                if( !(*i)->hasPixelData( Frame::BUFFER_DEPTH ))
+                    ordered[ index ] = true;
+        }
+
+        // merge all frames and decoded images which became mergeable
+        FrameImages inputs;
+        bool prefixMerged = true;
+        bool unorderedBefore = true;
+        for( size_t i = 0; i < nFrames && !failed; ++i )
+        {
+            if( states[i] == STATE_MERGED )
+                continue;
+
+            const Frame* input = frames[i];
+            const bool mergeable = prefixMerged ||
+                                   ( unorderedBefore && !ordered[i] );
+            if( states[i] == STATE_READY && mergeable )
+            {
+                if( !_isCPUMergeable( input, blendAlpha, format ))
+                {
+                    failed = true;
+                    break;
+                }
+
+                _addMergeInputs( input, input->getImages(), mergedImages[i],
+                                 inputs );
+                states[i] = STATE_MERGED;
+                continue;
+            }
+
+            if( states[i] == STATE_WAITING && mergeable && partial[i] )
+            {
+                Images decoded;
+                frames[i]->getFrameData()->getDecodedImages( decoded );
+                for( size_t j = 0; j < decoded.size(); ++j )
+                {
+                    // the frame is merged when ready if this image is not
+                    // depth-composited or not mergeable
+                    MergeFormat imageFormat = format;
+                    if( !decoded[j]->hasPixelData( Frame::BUFFER_DEPTH ) ||
+                        !_isCPUMergeable( decoded[j], blendAlpha, imageFormat ))
+                    {
+                        partial[i] = false;
+                        decoded.resize( j );
+                        break;
+                    }
+                    format = imageFormat;
+                }
+                _addMergeInputs( input, decoded, mergedImages[i], inputs );
+            }
+
+            prefixMerged = false;
+            if( ordered[i] )
+                unorderedBefore = false;
+        }
+
+        if( !inputs.empty( ))
+        {
+            if( !destColor && format.colorPixelSize > 0 )
+                _clearMergeBuffers( buffers, format, destPVP, useDepth,
+                                    destColor, destDepth );
+            if( destColor )
+            {
+                _mergeImages( inputs, blendAlpha, destColor, destDepth,
+                              destPVP );
+
+                for( FrameImages::const_iterator i = inputs.begin();
+                     i != inputs.end(); ++i )
+                {
+                    PixelViewport pvp = i->second->getPixelViewport() +
+                                        i->first->getOffset();
+                    pvp.intersect( destPVP );
+                    merged.merge( pvp );
+                }
+            }
+        }
+
+        if( failed )
+            break;
+    }
+
+    // deregisters the monitor from all frames still outstanding
+    delete handle;
+
+    if( failed )
+    {
+        // The frames not merged yet are assembled on the GPU. They are either
+        // depth-composited or follow all merged order-sensitive frames. Strips
+        // merged before are depth-composited again, which does not change the
+        // result.
+        LBLOG( LOG_ASSEMBLY ) << "Frame not suitable for CPU compositing, "
+                              << "using GPU fallback" << std::endl;
+        for( size_t i = 0; i < nFrames; ++i )
+            if( states[i] != STATE_MERGED )
+                left.push_back( frames[i] );
+    }
+
+    if( !merged.hasArea( ))
+        return 0;
+
+    // prepare output image
+    if( !_resultImage )
+        _resultImage = new Image;
+    Image* result = _resultImage.get();
+    result->setPixelViewport( merged );
+
+    PixelData colorPixels;
+    colorPixels.internalFormat = format.colorInternal;
+    colorPixels.externalFormat = format.colorExternal;
+    colorPixels.pixelSize      = format.colorPixelSize;
+    colorPixels.pvp            = merged;
+    colorPixels.pixels         = _compact( buffers->color, destPVP.w, merged,
+                                           format.colorPixelSize );
+    result->setPixelData( Frame::BUFFER_COLOR, colorPixels );
+
+    if( destDepth )
+    {
+        PixelData depthPixels;
+        depthPixels.internalFormat = format.depthInternal;
+        depthPixels.externalFormat = format.depthExternal;
+        depthPixels.pixelSize      = sizeof( uint32_t );
+        depthPixels.pvp            = merged;
+        depthPixels.pixels         = _compact( buffers->depth, destPVP.w,
+                                               merged, sizeof( uint32_t ));
+        result->setPixelData( Frame::BUFFER_DEPTH, depthPixels );
+    }
+    return result;
 }
 
 const Image* Compositor::mergeFramesCPU( const Frames& frames,
@@ -642,13 +1365,13 @@ bool Compositor::_collectOutputData(
 
             destPVP.merge( image->getPixelViewport() + frame->getOffset( ));
 
-            _collectOutputData( image->getPixelData( Frame::BUFFER_COLOR ),
+            _collectOutputData( _getFormat( image, Frame::BUFFER_COLOR ),
                                 colorInternalFormat, colorPixelSize,
                                 colorExternalFormat );
 
             if( image->hasPixelData( Frame::BUFFER_DEPTH ))
             {
-                _collectOutputData( image->getPixelData( Frame::BUFFER_DEPTH ),
+                _collectOutputData( _getFormat( image, Frame::BUFFER_DEPTH ),
                                     depthInternalFormat,
                                     depthPixelSize, depthExternalFormat );
             }
@@ -764,6 +1487,14 @@ void Compositor::_mergeFrames( const Frames& frames, const bool blendAlpha,
                                void* colorBuffer, void* depthBuffer,
                                const PixelViewport& destPVP )
 {
+    // Single-pass, tiled merge: the destination is split into cache-sized
+    // tiles, and each thread composites all overlapping input images into one
+    // tile before moving to the next. The inputs are applied in frame and
+    // image order within each tile, which keeps the ordered semantics of 2D,
+    // DB and blend merging while streaming the destination only once.
+    // Span-compressed images interrupt the tiled pass, since they are merged
+    // in the compressed domain, see _mergeSpanImage().
+    FrameImages inputs;
     for( Frames::const_iterator i = frames.begin(); i != frames.end(); ++i)
     {
         const Frame* frame = *i;
@@ -771,27 +1502,98 @@ void Compositor::_mergeFrames( const Frames& frames, const bool blendAlpha,
         for( Images::const_iterator j = images.begin(); j != images.end(); ++j )
         {
             const Image* image = *j;
+            if( image->hasPixelData( Frame::BUFFER_COLOR ))
+                inputs.push_back( FrameImage( frame, image ));
+        }
+    }
+    _mergeImages( inputs, blendAlpha, colorBuffer, depthBuffer, destPVP );
+}
 
-            if( !image->hasPixelData( Frame::BUFFER_COLOR ))
-                continue;
+void Compositor::_mergeImages( const FrameImages& inputs,
+                               const bool blendAlpha,
+                               void* colorBuffer, void* depthBuffer,
+                               const PixelViewport& destPVP )
+{
+    const PixelViewport destArea( 0, 0, destPVP.w, destPVP.h );
+    for( size_t begin = 0; begin < inputs.size(); )
+    {
+        const FrameImage& input = inputs[ begin ];
+        if( _isSpanMergeable( input.second, blendAlpha ))
+        {
+            _mergeSpanImage( colorBuffer, depthBuffer, destPVP, input.second,
+                             input.first->getOffset( ));
+            ++begin;
+            continue;
+        }
 
+        size_t end = begin;
+        for( ; end < inputs.size() &&
+                 !_isSpanMergeable( inputs[ end ].second, blendAlpha ); ++end )
+        {
+            // decompress before the parallel merge, see Image::setPixelData
+            const Image* image = inputs[ end ].second;
+            image->getPixelData( Frame::BUFFER_COLOR );
             if( image->hasPixelData( Frame::BUFFER_DEPTH ))
-                _mergeDBImage( colorBuffer, depthBuffer, destPVP,
-                               image, frame->getOffset( ));
-            else if( blendAlpha && image->hasAlpha( ))
-                _mergeBlendImage( colorBuffer, destPVP,
-                                  image, frame->getOffset( ));
-            else
-                _merge2DImage( colorBuffer, depthBuffer, destPVP,
-                               image, frame->getOffset());
+                image->getPixelData( Frame::BUFFER_DEPTH );
+        }
+
+#ifdef EQ_USE_PARACOMP
+        // Paracomp only composites full images
+        const int32_t tileW = destPVP.w;
+        const int32_t tileH = destPVP.h;
+#else
+        const Image* first = input.second;
+        const uint32_t pixelSize = first->getPixelSize( Frame::BUFFER_COLOR ) +
+                                   ( depthBuffer ? sizeof( uint32_t ) : 0 );
+        const int32_t tileW = LB_MIN( destPVP.w, _tileWidth );
+        const int32_t tileH = LB_MAX( 1, int32_t( _tileCacheSize /
+                                                  ( tileW * pixelSize )));
+#endif
+        const int32_t nTilesX = ( destPVP.w + tileW - 1 ) / tileW;
+        const int32_t nTilesY = ( destPVP.h + tileH - 1 ) / tileH;
+        const int32_t nTiles = nTilesX * nTilesY;
+
+#pragma omp parallel for schedule( dynamic )
+        for( int32_t i = 0; i < nTiles; ++i )
+        {
+            PixelViewport tile( ( i % nTilesX ) * tileW,
+                                ( i / nTilesX ) * tileH, tileW, tileH );
+            tile.intersect( destArea );
+
+            for( size_t j = begin; j < end; ++j )
+            {
+                const Frame* frame = inputs[j].first;
+                const Image* image = inputs[j].second;
+                const Vector2i& offset = frame->getOffset();
+
+                // area covered by the image in destination buffer coordinates
+                PixelViewport region = image->getPixelViewport() + offset;
+                region.x -= destPVP.x;
+                region.y -= destPVP.y;
+                region.intersect( tile );
+                if( !region.hasArea( ))
+                    continue;
+
+                if( image->hasPixelData( Frame::BUFFER_DEPTH ))
+                    _mergeDBImage( colorBuffer, depthBuffer, destPVP,
+                                   image, offset, region );
+                else if( blendAlpha && image->hasAlpha( ))
+                    _mergeBlendImage( colorBuffer, destPVP, image, offset,
+                                      region );
+                else
+                    _merge2DImage( colorBuffer, depthBuffer, destPVP,
+                                   image, offset, region );
+            }
         }
+        begin = end;
     }
 }
 
 void Compositor::_mergeDBImage( void* destColor, void* destDepth,
                                 const PixelViewport& destPVP,
                                 const Image* image,
-                                const Vector2i& offset )
+                                const Vector2i& offset,
+                                const PixelViewport& region )
 {
     LBASSERT( destColor && destDepth );
 
@@ -821,35 +1623,23 @@ void Compositor::_mergeDBImage( void* destColor, void* destDepth,
     const uint32_t* depth = reinterpret_cast< const uint32_t* >
         ( image->getPixelPointer( Frame::BUFFER_DEPTH ));
 
-#pragma omp parallel for
-    for( int32_t y = 0; y < pvp.h; ++y )
-    {
-        const uint32_t skip =  (destY + y) * destPVP.w + destX;
-        uint32_t* destColorIt = destC + skip;
-        uint32_t* destDepthIt = destD + skip;
-        const uint32_t* colorIt = color + y * pvp.w;
-        const uint32_t* depthIt = depth + y * pvp.w;
+    // SSE2/AVX2/NEON depth test and blend, selected at runtime
+    const detail::MergeDBRowFunc mergeRow = detail::getMergeDBRow();
 
-        for( int32_t x = 0; x < pvp.w; ++x )
-        {
-            if( *destDepthIt > *depthIt )
-            {
-                *destColorIt = *colorIt;
-                *destDepthIt = *depthIt;
-            }
-
-            ++destColorIt;
-            ++destDepthIt;
-            ++colorIt;
-            ++depthIt;
-        }
+    for( int32_t y = region.y; y < region.getYEnd(); ++y )
+    {
+        const uint32_t skip = y * destPVP.w + region.x;
+        const uint32_t srcSkip = ( y - destY ) * pvp.w + region.x - destX;
+        mergeRow( destC + skip, destD + skip,
+                  color + srcSkip, depth + srcSkip, region.w );
     }
 }
 
 void Compositor::_merge2DImage( void* destColor, void* destDepth,
                                 const eq::PixelViewport& destPVP,
                                 const Image* image,
-                                const Vector2i& offset )
+                                const Vector2i& offset,
+                                const PixelViewport& region )
 {
     // This is mostly copy&paste code from _mergeDBImage :-/
     LBVERB << "CPU-2D assembly" << std::endl;
@@ -865,13 +1655,14 @@ void Compositor::_merge2DImage( void* destColor, void* destDepth,
 
     const uint8_t*   color = image->getPixelPointer( Frame::BUFFER_COLOR );
     const size_t pixelSize = image->getPixelSize( Frame::BUFFER_COLOR );
-    const size_t rowLength = pvp.w * pixelSize;
+    const size_t rowLength = region.w * pixelSize;
 
-#pragma omp parallel for
-    for( int32_t y = 0; y < pvp.h; ++y )
+    for( int32_t y = region.y; y < region.getYEnd(); ++y )
     {
-        const size_t skip = ( (destY + y) * destPVP.w + destX ) * pixelSize;
-        memcpy( destC + skip, color + y * pvp.w * pixelSize, rowLength);
+        const size_t skip = ( y * destPVP.w + region.x ) * pixelSize;
+        const size_t srcSkip = (( y - destY ) * pvp.w + region.x - destX ) *
+                               pixelSize;
+        memcpy( destC + skip, color + srcSkip, rowLength );
         // clear depth, for depth-assembly into existing FB
         if( destD )
         {
@@ -883,11 +1674,12 @@ void Compositor::_merge2DImage( void* destColor, void* destDepth,
 
 void Compositor::_mergeBlendImage( void* dest, const eq::PixelViewport& destPVP,
                                    const Image* image,
-                                   const Vector2i& offset )
+                                   const Vector2i& offset,
+                                   const PixelViewport& region )
 {
     LBVERB << "CPU-Blend assembly"<< std::endl;
 
-    int32_t* destColor = reinterpret_cast< int32_t* >( dest );
+    uint32_t* destColor = reinterpret_cast< uint32_t* >( dest );
 
     const PixelViewport&  pvp    = image->getPixelViewport();
     const int32_t         destX  = offset.x() + pvp.x - destPVP.x;
@@ -909,7 +1701,7 @@ void Compositor::_mergeBlendImage( void* dest, const eq::PixelViewport& destPVP,
     }
 #endif
 
-    const int32_t* color = reinterpret_cast< const int32_t* >
+    const uint32_t* color = reinterpret_cast< const uint32_t* >
                                ( image->getPixelPointer( Frame::BUFFER_COLOR ));
 
     // Blending of two slices, none of which is on final image (i.e. result
@@ -921,28 +1713,12 @@ void Compositor::_mergeBlendImage( void* dest, const eq::PixelViewport& destPVP,
     // because we accumulate light which is go through (= 1-Alpha) and we
     // already have colors as Alpha*Color
 
-    int32_t* destColorStart = destColor + destY*destPVP.w + destX;
-    const uint32_t step = sizeof( int32_t );
-
-#pragma omp parallel for
-    for( int32_t y = 0; y < pvp.h; ++y )
-    {
-        const unsigned char* src =
-            reinterpret_cast< const uint8_t* >( color + pvp.w * y );
-        unsigned char*       dst =
-            reinterpret_cast< uint8_t* >( destColorStart + destPVP.w * y );
-
-        for( int32_t x = 0; x < pvp.w; ++x )
-        {
-            dst[0] = LB_MIN( src[0] + (src[3]*dst[0] >> 8), 255 );
-            dst[1] = LB_MIN( src[1] + (src[3]*dst[1] >> 8), 255 );
-            dst[2] = LB_MIN( src[2] + (src[3]*dst[2] >> 8), 255 );
-            dst[3] =                   src[3]*dst[3] >> 8;
+    // SSE2/AVX2/NEON blending, bit-exact with the scalar integer formula
+    const detail::MergeBlendRowFunc mergeRow = detail::getMergeBlendRow();
 
-            src += step;
-            dst += step;
-        }
-    }
+    for( int32_t y = region.y; y < region.getYEnd(); ++y )
+        mergeRow( destColor + y * destPVP.w + region.x,
+                  color + ( y - destY ) * pvp.w + region.x - destX, region.w );
 }
 
 #ifdef EQ_USE_PARACOMP
@@ -115,6 +115,11 @@ namespace eq
          * glBlendFunc( GL_ONE, GL_SRC_ALPHA )
          * into the current framebuffer.
          *
+         * The frames are merged progressively as they become ready.
+         * Depth-composited frames are merged in arrival order, all other
+         * frames after all their predecessors. Frames which can't be merged on
+         * the CPU are assembled afterwards using assembleFrame().
+         *
          * @param frames the frames to assemble.
          * @param channel the destination channel.
          * @param blendAlpha blend color-only images if they have an alpha
@@ -269,6 +274,13 @@ namespace eq
 
       private:
         typedef std::pair< const Frame*, const Image* > FrameImage;
+        typedef std::vector< FrameImage > FrameImages;
+
+        /** Wait for the next event of a wait handle, throws on timeout. */
+        static void _waitEvent( WaitHandle* handle );
+
+        /** @return the next ready frame of a wait handle, or 0. */
+        static Frame* _getReadyFrame( WaitHandle* handle );
 
         static bool _isSubPixelDecomposition( const Frames& frames );
         static const Frames _extractOneSubPixel( Frames& frames );
@@ -289,25 +301,48 @@ namespace eq
                                         uint32_t& pixelSize, 
                                         uint32_t& externalFormat );
 
+        /**
+         * Merge the frames into a channel-sized image as they become ready.
+         * Frames not merged are appended in order to left.
+         * @return the merged image, or 0 if nothing was merged.
+         */
+        static const Image* _mergeFramesProgressive( const Frames& frames,
+                                                     Channel* channel,
+                                                     const bool blendAlpha,
+                                                     Frames& left );
+
         static void _mergeFrames( const Frames& frames,
                                   const bool blendAlpha, 
                                   void* colorBuffer, void* depthBuffer,
                                   const PixelViewport& destPVP );
+
+        /** Merge the images in order, see _mergeFrames(). */
+        static void _mergeImages( const FrameImages& inputs,
+                                  const bool blendAlpha,
+                                  void* colorBuffer, void* depthBuffer,
+                                  const PixelViewport& destPVP );
                                   
+        /**
+         * The per-image merge functions composite the part of the input
+         * covered by region, given in destination buffer coordinates.
+         */
         static void _mergeDBImage( void* destColor, void* destDepth,
                                    const PixelViewport& destPVP, 
                                    const Image* image, 
-                                   const Vector2i& offset );
+                                   const Vector2i& offset,
+                                   const PixelViewport& region );
                                      
         static void _merge2DImage( void* destColor, void* destDepth,
                                    const PixelViewport& destPVP,
                                    const Image* input,
-                                   const Vector2i& offset );
+                                   const Vector2i& offset,
+                                   const PixelViewport& region );
                                      
         static void _mergeBlendImage( void* dest, 
                                       const PixelViewport& destPVP, 
                                       const Image* input,
-                                      const Vector2i& offset );
+                                      const Vector2i& offset,
+                                      const PixelViewport& region );
         static bool _mergeImage_PC( int operation, void* destColor, 
                                     void* destDepth, const Image* source );
         /** 
@@ -0,0 +1,592 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compositorKernels.h"
+
+#include <lunchbox/debug.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#  define EQ_KERNELS_X86
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#  include <emmintrin.h>
+#  if defined(_MSC_VER) && _MSC_VER >= 1700
+#    define EQ_KERNELS_AVX2
+#  elif defined(__clang__) || \
+    ( defined(__GNUC__) && ( __GNUC__ > 4 || \
+                             ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 )))
+#    define EQ_KERNELS_AVX2
+#  endif
+#  ifdef EQ_KERNELS_AVX2
+#    include <immintrin.h>
+#  endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#  define EQ_KERNELS_NEON
+#  include <arm_neon.h>
+#endif
+
+// Per-function instruction set selection, so that the library itself can be
+// compiled for the baseline architecture and the kernels are only used after
+// the CPU has been checked at runtime.
+#if defined(__GNUC__) || defined(__clang__)
+#  define EQ_TARGET_SSE2 __attribute__((target("sse2")))
+#  define EQ_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#  define EQ_TARGET_SSE2
+#  define EQ_TARGET_AVX2
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+//----------------------------------------------------------------------
+// Scalar reference kernels
+//----------------------------------------------------------------------
+void _mergeDBRowScalar( uint32_t* destColor, uint32_t* destDepth,
+                        const uint32_t* color, const uint32_t* depth,
+                        const int32_t nPixels )
+{
+    for( int32_t x = 0; x < nPixels; ++x )
+    {
+        if( *destDepth > *depth )
+        {
+            *destColor = *color;
+            *destDepth = *depth;
+        }
+
+        ++destColor;
+        ++destDepth;
+        ++color;
+        ++depth;
+    }
+}
+
+void _mergeBlendRowScalar( uint32_t* dest, const uint32_t* color,
+                           const int32_t nPixels )
+{
+    const uint8_t* src = reinterpret_cast< const uint8_t* >( color );
+    uint8_t* dst = reinterpret_cast< uint8_t* >( dest );
+
+    for( int32_t x = 0; x < nPixels; ++x )
+    {
+        dst[0] = LB_MIN( src[0] + (src[3]*dst[0] >> 8), 255 );
+        dst[1] = LB_MIN( src[1] + (src[3]*dst[1] >> 8), 255 );
+        dst[2] = LB_MIN( src[2] + (src[3]*dst[2] >> 8), 255 );
+        dst[3] =                   src[3]*dst[3] >> 8;
+
+        src += 4;
+        dst += 4;
+    }
+}
+
+bool _hasForegroundScalar( const uint32_t* pixels, const int32_t nPixels,
+                           const uint32_t background, const uint32_t mask )
+{
+    for( int32_t x = 0; x < nPixels; ++x )
+        if(( pixels[x] ^ background ) & mask )
+            return true;
+    return false;
+}
+
+#ifdef EQ_KERNELS_X86
+//----------------------------------------------------------------------
+// SSE2 kernels
+//----------------------------------------------------------------------
+EQ_TARGET_SSE2
+void _mergeDBRowSSE2( uint32_t* destColor, uint32_t* destDepth,
+                      const uint32_t* color, const uint32_t* depth,
+                      const int32_t nPixels )
+{
+    // SSE2 has only signed 32 bit compares: flipping the sign bit of both
+    // operands maps the unsigned order onto the signed order.
+    const __m128i sign = _mm_set1_epi32( 0x80000000 );
+    int32_t x = 0;
+
+    for( ; x + 4 <= nPixels; x += 4 )
+    {
+        __m128i* destC = reinterpret_cast< __m128i* >( destColor + x );
+        __m128i* destD = reinterpret_cast< __m128i* >( destDepth + x );
+        const __m128i* srcC = reinterpret_cast< const __m128i* >( color + x );
+        const __m128i* srcD = reinterpret_cast< const __m128i* >( depth + x );
+
+        const __m128i dstDepth = _mm_loadu_si128( destD );
+        const __m128i srcDepth = _mm_loadu_si128( srcD );
+        const __m128i mask = _mm_cmpgt_epi32( _mm_xor_si128( dstDepth, sign ),
+                                              _mm_xor_si128( srcDepth, sign ));
+        if( _mm_movemask_epi8( mask ) == 0 )
+            continue;
+
+        const __m128i dstColor = _mm_loadu_si128( destC );
+        const __m128i srcColor = _mm_loadu_si128( srcC );
+        _mm_storeu_si128( destD,
+                          _mm_or_si128( _mm_and_si128( mask, srcDepth ),
+                                        _mm_andnot_si128( mask, dstDepth )));
+        _mm_storeu_si128( destC,
+                          _mm_or_si128( _mm_and_si128( mask, srcColor ),
+                                        _mm_andnot_si128( mask, dstColor )));
+    }
+
+    _mergeDBRowScalar( destColor + x, destDepth + x, color + x, depth + x,
+                       nPixels - x );
+}
+
+/** @return src.a * dst >> 8 for the four 8 bit channels of two pixels. */
+EQ_TARGET_SSE2
+inline __m128i _blendMulSSE2( const __m128i src16, const __m128i dst16 )
+{
+    // broadcast the alpha channel of each pixel to its four 16 bit lanes
+    const __m128i alpha = _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16( src16, _MM_SHUFFLE( 3, 3, 3, 3 )),
+        _MM_SHUFFLE( 3, 3, 3, 3 ));
+
+    // 255 * 255 fits into an unsigned 16 bit lane
+    return _mm_srli_epi16( _mm_mullo_epi16( alpha, dst16 ), 8 );
+}
+
+EQ_TARGET_SSE2
+void _mergeBlendRowSSE2( uint32_t* dest, const uint32_t* color,
+                         const int32_t nPixels )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colorMask = _mm_set1_epi32( 0x00ffffff );
+    int32_t x = 0;
+
+    for( ; x + 4 <= nPixels; x += 4 )
+    {
+        __m128i* dstPtr = reinterpret_cast< __m128i* >( dest + x );
+        const __m128i src =
+            _mm_loadu_si128( reinterpret_cast< const __m128i* >( color + x ));
+        const __m128i dst = _mm_loadu_si128( dstPtr );
+
+        const __m128i lo = _blendMulSSE2( _mm_unpacklo_epi8( src, zero ),
+                                          _mm_unpacklo_epi8( dst, zero ));
+        const __m128i hi = _blendMulSSE2( _mm_unpackhi_epi8( src, zero ),
+                                          _mm_unpackhi_epi8( dst, zero ));
+
+        // color: saturated src + product, alpha: product only
+        const __m128i product = _mm_packus_epi16( lo, hi );
+        _mm_storeu_si128( dstPtr,
+                          _mm_adds_epu8( _mm_and_si128( src, colorMask ),
+                                         product ));
+    }
+
+    _mergeBlendRowScalar( dest + x, color + x, nPixels - x );
+}
+
+EQ_TARGET_SSE2
+bool _hasForegroundSSE2( const uint32_t* pixels, const int32_t nPixels,
+                         const uint32_t background, const uint32_t mask )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bg = _mm_set1_epi32( int32_t( background ));
+    const __m128i bits = _mm_set1_epi32( int32_t( mask ));
+    int32_t x = 0;
+
+    for( ; x + 4 <= nPixels; x += 4 )
+    {
+        const __m128i src =
+            _mm_loadu_si128( reinterpret_cast< const __m128i* >( pixels + x ));
+        const __m128i diff = _mm_and_si128( _mm_xor_si128( src, bg ), bits );
+        if( _mm_movemask_epi8( _mm_cmpeq_epi32( diff, zero )) != 0xffff )
+            return true;
+    }
+
+    return _hasForegroundScalar( pixels + x, nPixels - x, background, mask );
+}
+
+#  ifdef EQ_KERNELS_AVX2
+//----------------------------------------------------------------------
+// AVX2 kernels
+//----------------------------------------------------------------------
+EQ_TARGET_AVX2
+void _mergeDBRowAVX2( uint32_t* destColor, uint32_t* destDepth,
+                      const uint32_t* color, const uint32_t* depth,
+                      const int32_t nPixels )
+{
+    const __m256i sign = _mm256_set1_epi32( 0x80000000 );
+    int32_t x = 0;
+
+    for( ; x + 8 <= nPixels; x += 8 )
+    {
+        __m256i* destC = reinterpret_cast< __m256i* >( destColor + x );
+        __m256i* destD = reinterpret_cast< __m256i* >( destDepth + x );
+        const __m256i* srcC = reinterpret_cast< const __m256i* >( color + x );
+        const __m256i* srcD = reinterpret_cast< const __m256i* >( depth + x );
+
+        const __m256i dstDepth = _mm256_loadu_si256( destD );
+        const __m256i srcDepth = _mm256_loadu_si256( srcD );
+        const __m256i mask =
+            _mm256_cmpgt_epi32( _mm256_xor_si256( dstDepth, sign ),
+                                _mm256_xor_si256( srcDepth, sign ));
+        if( _mm256_testz_si256( mask, mask ))
+            continue;
+
+        const __m256i dstColor = _mm256_loadu_si256( destC );
+        const __m256i srcColor = _mm256_loadu_si256( srcC );
+        _mm256_storeu_si256( destD,
+                             _mm256_blendv_epi8( dstDepth, srcDepth, mask ));
+        _mm256_storeu_si256( destC,
+                             _mm256_blendv_epi8( dstColor, srcColor, mask ));
+    }
+
+    _mergeDBRowScalar( destColor + x, destDepth + x, color + x, depth + x,
+                       nPixels - x );
+}
+EQ_TARGET_AVX2
+inline __m256i _blendMulAVX2( const __m256i src16, const __m256i dst16 )
+{
+    const __m256i alpha = _mm256_shufflehi_epi16(
+        _mm256_shufflelo_epi16( src16, _MM_SHUFFLE( 3, 3, 3, 3 )),
+        _MM_SHUFFLE( 3, 3, 3, 3 ));
+
+    return _mm256_srli_epi16( _mm256_mullo_epi16( alpha, dst16 ), 8 );
+}
+
+EQ_TARGET_AVX2
+void _mergeBlendRowAVX2( uint32_t* dest, const uint32_t* color,
+                         const int32_t nPixels )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i colorMask = _mm256_set1_epi32( 0x00ffffff );
+    int32_t x = 0;
+
+    // unpack and pack operate per 128 bit lane and thus cancel out
+    for( ; x + 8 <= nPixels; x += 8 )
+    {
+        __m256i* dstPtr = reinterpret_cast< __m256i* >( dest + x );
+        const __m256i src = _mm256_loadu_si256(
+            reinterpret_cast< const __m256i* >( color + x ));
+        const __m256i dst = _mm256_loadu_si256( dstPtr );
+
+        const __m256i lo = _blendMulAVX2( _mm256_unpacklo_epi8( src, zero ),
+                                          _mm256_unpacklo_epi8( dst, zero ));
+        const __m256i hi = _blendMulAVX2( _mm256_unpackhi_epi8( src, zero ),
+                                          _mm256_unpackhi_epi8( dst, zero ));
+
+        const __m256i product = _mm256_packus_epi16( lo, hi );
+        _mm256_storeu_si256( dstPtr,
+                             _mm256_adds_epu8(
+                                 _mm256_and_si256( src, colorMask ),
+                                 product ));
+    }
+
+    _mergeBlendRowScalar( dest + x, color + x, nPixels - x );
+}
+
+EQ_TARGET_AVX2
+bool _hasForegroundAVX2( const uint32_t* pixels, const int32_t nPixels,
+                         const uint32_t background, const uint32_t mask )
+{
+    const __m256i bg = _mm256_set1_epi32( int32_t( background ));
+    const __m256i bits = _mm256_set1_epi32( int32_t( mask ));
+    int32_t x = 0;
+
+    for( ; x + 8 <= nPixels; x += 8 )
+    {
+        const __m256i src = _mm256_loadu_si256(
+            reinterpret_cast< const __m256i* >( pixels + x ));
+        const __m256i diff = _mm256_and_si256( _mm256_xor_si256( src, bg ),
+                                               bits );
+        if( !_mm256_testz_si256( diff, diff ))
+            return true;
+    }
+
+    return _hasForegroundScalar( pixels + x, nPixels - x, background, mask );
+}
+#  endif // EQ_KERNELS_AVX2
+#endif // EQ_KERNELS_X86
+
+#ifdef EQ_KERNELS_NEON
+//----------------------------------------------------------------------
+// NEON kernels
+//----------------------------------------------------------------------
+void _mergeDBRowNEON( uint32_t* destColor, uint32_t* destDepth,
+                      const uint32_t* color, const uint32_t* depth,
+                      const int32_t nPixels )
+{
+    int32_t x = 0;
+    for( ; x + 4 <= nPixels; x += 4 )
+    {
+        const uint32x4_t dstDepth = vld1q_u32( destDepth + x );
+        const uint32x4_t srcDepth = vld1q_u32( depth + x );
+        const uint32x4_t mask = vcgtq_u32( dstDepth, srcDepth );
+
+        vst1q_u32( destDepth + x, vbslq_u32( mask, srcDepth, dstDepth ));
+        vst1q_u32( destColor + x, vbslq_u32( mask, vld1q_u32( color + x ),
+                                             vld1q_u32( destColor + x )));
+    }
+
+    _mergeDBRowScalar( destColor + x, destDepth + x, color + x, depth + x,
+                       nPixels - x );
+}
+
+void _mergeBlendRowNEON( uint32_t* dest, const uint32_t* color,
+                         const int32_t nPixels )
+{
+    int32_t x = 0;
+    for( ; x + 8 <= nPixels; x += 8 )
+    {
+        uint8_t* dst = reinterpret_cast< uint8_t* >( dest + x );
+        const uint8x8x4_t s =
+            vld4_u8( reinterpret_cast< const uint8_t* >( color + x ));
+        uint8x8x4_t d = vld4_u8( dst );
+
+        for( size_t i = 0; i < 3; ++i )
+            d.val[i] = vqadd_u8( s.val[i],
+                                 vshrn_n_u16( vmull_u8( s.val[3], d.val[i] ),
+                                              8 ));
+        d.val[3] = vshrn_n_u16( vmull_u8( s.val[3], d.val[3] ), 8 );
+        vst4_u8( dst, d );
+    }
+
+    _mergeBlendRowScalar( dest + x, color + x, nPixels - x );
+}
+
+bool _hasForegroundNEON( const uint32_t* pixels, const int32_t nPixels,
+                         const uint32_t background, const uint32_t mask )
+{
+    const uint32x4_t bg = vdupq_n_u32( background );
+    const uint32x4_t bits = vdupq_n_u32( mask );
+    int32_t x = 0;
+
+    for( ; x + 4 <= nPixels; x += 4 )
+    {
+        const uint32x4_t diff = vandq_u32( veorq_u32( vld1q_u32( pixels + x ),
+                                                      bg ), bits );
+        const uint32x2_t any = vorr_u32( vget_low_u32( diff ),
+                                         vget_high_u32( diff ));
+        if( vget_lane_u32( any, 0 ) | vget_lane_u32( any, 1 ))
+            return true;
+    }
+
+    return _hasForegroundScalar( pixels + x, nPixels - x, background, mask );
+}
+#endif // EQ_KERNELS_NEON
+
+bool _cpuSupports( const SIMDLevel level )
+{
+    switch( level )
+    {
+      case SIMD_NONE:
+          return true;
+
+#ifdef EQ_KERNELS_X86
+      case SIMD_SSE2:
+#  if defined(__x86_64__) || defined(_M_X64)
+          return true; // part of the x86-64 baseline
+#  elif defined(_MSC_VER)
+      {
+          int info[4];
+          __cpuid( info, 1 );
+          return ( info[3] & ( 1 << 26 )) != 0;
+      }
+#  else
+          return __builtin_cpu_supports( "sse2" );
+#  endif
+
+#  ifdef EQ_KERNELS_AVX2
+      case SIMD_AVX2:
+#    ifdef _MSC_VER
+      {
+          int info[4];
+          __cpuid( info, 0 );
+          if( info[0] < 7 )
+              return false;
+
+          __cpuid( info, 1 );
+          const bool osxsave = ( info[2] & ( 1 << 27 )) != 0;
+          const bool avx     = ( info[2] & ( 1 << 28 )) != 0;
+          if( !osxsave || !avx )
+              return false;
+
+          // OS saves YMM registers on context switch
+          if(( _xgetbv( 0 ) & 0x6 ) != 0x6 )
+              return false;
+
+          __cpuidex( info, 7, 0 );
+          return ( info[1] & ( 1 << 5 )) != 0;
+      }
+#    else
+          return __builtin_cpu_supports( "avx2" );
+#    endif
+#  endif
+#endif
+
+#ifdef EQ_KERNELS_NEON
+      case SIMD_NEON:
+          return true; // compiled for NEON, i.e., the target has it
+#endif
+
+      default:
+          return false;
+    }
+}
+
+SIMDLevel _detectSIMDLevel()
+{
+    SIMDLevel best = SIMD_NONE;
+    for( int i = SIMD_NONE; i < SIMD_ALL; ++i )
+    {
+        const SIMDLevel level = SIMDLevel( i );
+        if( _cpuSupports( level ))
+            best = level;
+    }
+
+    const char* env = ::getenv( "EQ_COMPOSITOR_SIMD" );
+    if( !env )
+        return best;
+
+    for( int i = SIMD_NONE; i < SIMD_ALL; ++i )
+    {
+        const SIMDLevel level = SIMDLevel( i );
+        if( ::strcmp( env, getSIMDName( level )) == 0 && _cpuSupports( level ))
+            return level;
+    }
+    return best;
+}
+}
+
+const char* getSIMDName( const SIMDLevel level )
+{
+    switch( level )
+    {
+      case SIMD_NONE: return "none";
+      case SIMD_SSE2: return "sse2";
+      case SIMD_AVX2: return "avx2";
+      case SIMD_NEON: return "neon";
+      default:        return "unknown";
+    }
+}
+
+bool hasSIMDLevel( const SIMDLevel level )
+{
+    return getMergeDBRow( level ) != 0;
+}
+
+SIMDLevel getSIMDLevel()
+{
+    static const SIMDLevel level = _detectSIMDLevel();
+    return level;
+}
+
+MergeDBRowFunc getMergeDBRow( const SIMDLevel level )
+{
+    if( !_cpuSupports( level ))
+        return 0;
+
+    switch( level )
+    {
+      case SIMD_NONE:
+          return _mergeDBRowScalar;
+#ifdef EQ_KERNELS_X86
+      case SIMD_SSE2:
+          return _mergeDBRowSSE2;
+#  ifdef EQ_KERNELS_AVX2
+      case SIMD_AVX2:
+          return _mergeDBRowAVX2;
+#  endif
+#endif
+#ifdef EQ_KERNELS_NEON
+      case SIMD_NEON:
+          return _mergeDBRowNEON;
+#endif
+      default:
+          return 0;
+    }
+}
+
+MergeDBRowFunc getMergeDBRow()
+{
+    static const MergeDBRowFunc func = getMergeDBRow( getSIMDLevel( ));
+    return func;
+}
+
+MergeBlendRowFunc getMergeBlendRow( const SIMDLevel level )
+{
+    if( !_cpuSupports( level ))
+        return 0;
+
+    switch( level )
+    {
+      case SIMD_NONE:
+          return _mergeBlendRowScalar;
+#ifdef EQ_KERNELS_X86
+      case SIMD_SSE2:
+          return _mergeBlendRowSSE2;
+#  ifdef EQ_KERNELS_AVX2
+      case SIMD_AVX2:
+          return _mergeBlendRowAVX2;
+#  endif
+#endif
+#ifdef EQ_KERNELS_NEON
+      case SIMD_NEON:
+          return _mergeBlendRowNEON;
+#endif
+      default:
+          return 0;
+    }
+}
+
+MergeBlendRowFunc getMergeBlendRow()
+{
+    static const MergeBlendRowFunc func = getMergeBlendRow( getSIMDLevel( ));
+    return func;
+}
+
+HasForegroundFunc getHasForeground( const SIMDLevel level )
+{
+    if( !_cpuSupports( level ))
+        return 0;
+
+    switch( level )
+    {
+      case SIMD_NONE:
+          return _hasForegroundScalar;
+#ifdef EQ_KERNELS_X86
+      case SIMD_SSE2:
+          return _hasForegroundSSE2;
+#  ifdef EQ_KERNELS_AVX2
+      case SIMD_AVX2:
+          return _hasForegroundAVX2;
+#  endif
+#endif
+#ifdef EQ_KERNELS_NEON
+      case SIMD_NEON:
+          return _hasForegroundNEON;
+#endif
+      default:
+          return 0;
+    }
+}
+
+HasForegroundFunc getHasForeground()
+{
+    static const HasForegroundFunc func = getHasForeground( getSIMDLevel( ));
+    return func;
+}
+
+}
+}
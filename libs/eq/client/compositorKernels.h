@@ -0,0 +1,109 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_COMPOSITORKERNELS_H
+#define EQ_COMPOSITORKERNELS_H
+
+#include <eq/client/api.h>
+#include <lunchbox/types.h>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * The instruction sets used by the CPU compositing kernels.
+ *
+ * The scalar kernels are always available and are the reference
+ * implementation all other kernels have to match bit by bit.
+ */
+enum SIMDLevel
+{
+    SIMD_NONE,  //!< Portable scalar code
+    SIMD_SSE2,  //!< x86 SSE2, 128 bit
+    SIMD_AVX2,  //!< x86 AVX2, 256 bit
+    SIMD_NEON,  //!< ARM NEON, 128 bit
+    SIMD_ALL    //!< @internal
+};
+
+/** @return the name of the given SIMD level. */
+EQ_API const char* getSIMDName( const SIMDLevel level );
+
+/** @return true if the kernels for the level are compiled in and usable. */
+EQ_API bool hasSIMDLevel( const SIMDLevel level );
+
+/**
+ * @return the fastest SIMD level supported by the build and the CPU.
+ *
+ * The level is detected once. It can be lowered by setting the environment
+ * variable EQ_COMPOSITOR_SIMD to 'none', 'sse2', 'avx2' or 'neon'.
+ */
+EQ_API SIMDLevel getSIMDLevel();
+
+/**
+ * Depth-composite one row of 32 bit color and 32 bit unsigned depth pixels.
+ *
+ * For each pixel where depth < destDepth, color and depth are copied to the
+ * destination.
+ */
+typedef void (*MergeDBRowFunc)( uint32_t* destColor, uint32_t* destDepth,
+                                const uint32_t* color, const uint32_t* depth,
+                                const int32_t nPixels );
+
+/** @return the depth-compositing kernel for the level, or 0 if unusable. */
+EQ_API MergeDBRowFunc getMergeDBRow( const SIMDLevel level );
+
+/** @return the depth-compositing kernel for the current CPU. */
+EQ_API MergeDBRowFunc getMergeDBRow();
+
+/**
+ * Alpha-blend one row of premultiplied 8 bit RGBA or BGRA pixels.
+ *
+ * Implements glBlendFuncSeparate( GL_ONE, GL_SRC_ALPHA, GL_ZERO, GL_SRC_ALPHA )
+ * with integer arithmetic, i.e., for each color channel
+ * dest = min( src + (src.a * dest >> 8), 255 ) and for alpha
+ * dest.a = src.a * dest.a >> 8.
+ */
+typedef void (*MergeBlendRowFunc)( uint32_t* dest, const uint32_t* color,
+                                   const int32_t nPixels );
+
+/** @return the alpha-blending kernel for the level, or 0 if unusable. */
+EQ_API MergeBlendRowFunc getMergeBlendRow( const SIMDLevel level );
+
+/** @return the alpha-blending kernel for the current CPU. */
+EQ_API MergeBlendRowFunc getMergeBlendRow();
+
+/**
+ * Test a row of 32 bit pixels against a background value.
+ *
+ * Used to find the regions of interest of images in main memory.
+ *
+ * @return true if any pixel differs from background in the bits of mask.
+ */
+typedef bool (*HasForegroundFunc)( const uint32_t* pixels,
+                                   const int32_t nPixels,
+                                   const uint32_t background,
+                                   const uint32_t mask );
+
+/** @return the foreground test kernel for the level, or 0 if unusable. */
+EQ_API HasForegroundFunc getHasForeground( const SIMDLevel level );
+
+/** @return the foreground test kernel for the current CPU. */
+EQ_API HasForegroundFunc getHasForeground();
+}
+}
+
+#endif // EQ_COMPOSITORKERNELS_H
@@ -0,0 +1,202 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PLUGIN_BITSTREAM
+#define EQ_PLUGIN_BITSTREAM
+
+#include <lunchbox/types.h>
+
+namespace eq
+{
+namespace plugin
+{
+/**
+ * @name Block-adaptive bit packing of prediction residuals.
+ *
+ * Residuals are mapped to unsigned values by interleaving positive and
+ * negative values, and stored in blocks of 32 values. Each block starts with
+ * the six bit width of its largest value, followed by all values using this
+ * width:
+ * @code
+ * ( nBits:6 value:nBits[ 32 ] )*
+ * @endcode
+ * The last block of a stream may have fewer values. The bit stream is
+ * little-endian, i.e., it starts in the lowest bit of the first byte. Blocks of
+ * zero residuals cost six bits.
+ */
+//@{
+/** @return the residual mapped to 0, -1, 1, -2, 2, ... -> 0, 1, 2, 3, 4 */
+inline uint32_t encodeResidual( const uint32_t residual )
+{
+    return ( residual << 1 ) ^ uint32_t( int32_t( residual ) >> 31 );
+}
+
+/** @return the residual of a value returned by encodeResidual(). */
+inline uint32_t decodeResidual( const uint32_t value )
+{
+    return ( value >> 1 ) ^ ( 0u - ( value & 1u ));
+}
+
+/** Writes unsigned values of up to 32 bits to a bit stream. */
+class BitWriter
+{
+public:
+    explicit BitWriter( uint8_t* out ) : _out( out ), _bits( 0 ), _nBits( 0 ) {}
+
+    /** Append the lowest nBits of value, which must not have other bits. */
+    void put( const uint32_t value, const uint32_t nBits )
+    {
+        _bits |= uint64_t( value ) << _nBits;
+        _nBits += nBits;
+        while( _nBits >= 8 )
+        {
+            *_out++ = uint8_t( _bits );
+            _bits >>= 8;
+            _nBits -= 8;
+        }
+    }
+
+    /** Write the pending bits. @return the end of the written data. */
+    uint8_t* flush()
+    {
+        if( _nBits > 0 )
+            *_out++ = uint8_t( _bits );
+        _bits = 0;
+        _nBits = 0;
+        return _out;
+    }
+
+private:
+    uint8_t* _out;
+    uint64_t _bits;
+    uint32_t _nBits;
+};
+
+/** Reads the values written by a BitWriter. */
+class BitReader
+{
+public:
+    BitReader( const uint8_t* in, const uint8_t* end )
+        : _in( in ), _end( end ), _bits( 0 ), _nBits( 0 ) {}
+
+    /** @return the next value of nBits bits, zero past the end. */
+    uint32_t get( const uint32_t nBits )
+    {
+        while( _nBits < nBits )
+        {
+            if( _in < _end )
+                _bits |= uint64_t( *_in++ ) << _nBits;
+            _nBits += 8;
+        }
+
+        const uint32_t value =
+            uint32_t( _bits & (( uint64_t( 1 ) << nBits ) - 1 ));
+        _bits >>= nBits;
+        _nBits -= nBits;
+        return value;
+    }
+
+private:
+    const uint8_t* _in;
+    const uint8_t* const _end;
+    uint64_t _bits;
+    uint32_t _nBits;
+};
+
+/** Writes encoded residuals in blocks sharing one bit width. */
+class BlockWriter
+{
+public:
+    explicit BlockWriter( uint8_t* out ) : _writer( out ), _nValues( 0 ) {}
+
+    /** @return the maximum size in bytes needed for nValues values. */
+    static uint64_t getMaxSize( const uint64_t nValues )
+        { return nValues * sizeof( uint32_t ) + nValues / _blockSize + 2; }
+
+    /** Append an encoded residual. */
+    void put( const uint32_t value )
+    {
+        _block[ _nValues++ ] = value;
+        if( _nValues == _blockSize )
+            _putBlock();
+    }
+
+    /** Write the pending values. @return the end of the written data. */
+    uint8_t* flush()
+    {
+        if( _nValues > 0 )
+            _putBlock();
+        return _writer.flush();
+    }
+
+private:
+    static const uint32_t _blockSize = 32;
+    static const uint32_t _widthBits = 6; // for bit widths [0,32]
+
+    BitWriter _writer;
+    uint32_t _block[ _blockSize ];
+    uint32_t _nValues;
+
+    void _putBlock()
+    {
+        uint32_t all = 0;
+        for( uint32_t i = 0; i < _nValues; ++i )
+            all |= _block[i];
+
+        uint32_t nBits = 0;
+        for( ; all; all >>= 1 )
+            ++nBits;
+
+        _writer.put( nBits, _widthBits );
+        if( nBits > 0 )
+            for( uint32_t i = 0; i < _nValues; ++i )
+                _writer.put( _block[i], nBits );
+        _nValues = 0;
+    }
+};
+
+/** Reads the encoded residuals written by a BlockWriter. */
+class BlockReader
+{
+public:
+    BlockReader( const uint8_t* in, const uint8_t* end )
+        : _reader( in, end ), _nBits( 0 ), _nValues( 0 ) {}
+
+    /** @return the next encoded residual. */
+    uint32_t get()
+    {
+        if( _nValues == 0 )
+        {
+            _nBits = _reader.get( _widthBits );
+            _nValues = _blockSize;
+        }
+        --_nValues;
+        return _nBits ? _reader.get( _nBits ) : 0;
+    }
+
+private:
+    static const uint32_t _blockSize = 32;
+    static const uint32_t _widthBits = 6;
+
+    BitReader _reader;
+    uint32_t _nBits;
+    uint32_t _nValues;
+};
+//@}
+}
+}
+
+#endif // EQ_PLUGIN_BITSTREAM
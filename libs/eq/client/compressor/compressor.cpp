@@ -18,6 +18,9 @@
 
 #include "compressor.h"
 
+#include <cstdlib>
+#include <cstring>
+
 namespace eq
 {
 namespace plugin
@@ -27,6 +30,14 @@ namespace
     typedef std::vector< Compressor::Functions > Compressors;
     static Compressors* _functions;
 
+    void* _allocSystem( eq_uint64_t& size )
+        { return ::malloc( size_t( size )); }
+    void _freeSystem( void* data, const eq_uint64_t )
+        { ::free( data ); }
+
+    static Compressor::Alloc_t _alloc = &_allocSystem;
+    static Compressor::Free_t _free = &_freeSystem;
+
     const Compressor::Functions& _findFunctions( const unsigned name )
     {
         for( Compressors::const_iterator i = _functions->begin();
@@ -53,6 +64,45 @@ Compressor::~Compressor()
     _results.clear();
 }
 
+void Compressor::setAllocator( Alloc_t allocFunc, Free_t freeFunc )
+{
+    _alloc = allocFunc;
+    _free = freeFunc;
+}
+
+Compressor::Result::~Result()
+{
+    if( _data )
+        _free( _data, _capacity );
+}
+
+uint8_t* Compressor::Result::resize( const eq_uint64_t size )
+{
+    // keep the memory unless it is more than four times too large
+    if( _data && size <= _capacity && size * 4 > _capacity )
+    {
+        _size = size;
+        return _data;
+    }
+
+    eq_uint64_t capacity = size;
+    uint8_t* data = static_cast< uint8_t* >( _alloc( capacity ));
+    assert( data );
+    if( !data )
+        return _data;
+
+    if( _data )
+    {
+        ::memcpy( data, _data, size_t( LB_MIN( size, _size )));
+        _free( _data, _capacity );
+    }
+
+    _data = data;
+    _size = size;
+    _capacity = capacity;
+    return _data;
+}
+
 Compressor::Functions::Functions( const unsigned name_,
                                   CompressorGetInfo_t getInfo_,
                                   NewCompressor_t newCompressor_,
@@ -120,12 +170,13 @@ void EqCompressorCompress( void* const ptr, const unsigned name,
 {
     assert( ptr );
     const bool useAlpha = !(flags & EQ_COMPRESSOR_IGNORE_ALPHA);
-    const eq_uint64_t nPixels = (flags & EQ_COMPRESSOR_DATA_1D) ?
-                                  inDims[1]: inDims[1] * inDims[3];
-
     eq::plugin::Compressor* compressor = 
         reinterpret_cast< eq::plugin::Compressor* >( ptr );
-    compressor->compress( in, nPixels, useAlpha );
+
+    if( flags & EQ_COMPRESSOR_DATA_1D )
+        compressor->compress( in, inDims[1], useAlpha );
+    else
+        compressor->compress2D( in, inDims[1], inDims[3], useAlpha );
 }
 
 unsigned EqCompressorGetNumResults( void* const ptr,
@@ -73,7 +73,69 @@ namespace plugin
                                const eq_uint64_t nPixels, 
                                const bool useAlpha ) { LBDONTCALL; };
 
-        typedef lunchbox::Bufferb Result;
+        /**
+         * Compress two-dimensional data.
+         *
+         * The default implementation compresses the rows as one-dimensional
+         * data.
+         *
+         * @param inData data to compress.
+         * @param width the number of pixels per row.
+         * @param height the number of rows.
+         * @param useAlpha use alpha channel in compression.
+         */
+        virtual void compress2D( const void* const inData,
+                                 const eq_uint64_t width,
+                                 const eq_uint64_t height,
+                                 const bool useAlpha )
+            { compress( inData, width * height, useAlpha ); }
+
+        /**
+         * Allocates the memory of compressed chunks.
+         *
+         * @param size the requested size, set to the usable size on return.
+         * @return the memory, or 0 if out of memory.
+         */
+        typedef void* (*Alloc_t)( eq_uint64_t& size );
+
+        /** Releases memory of the usable size returned by Alloc_t. */
+        typedef void (*Free_t)( void* data, const eq_uint64_t size );
+
+        /**
+         * Set the allocator of the compressed chunks of all compressors.
+         *
+         * The default uses malloc() and free(). Equalizer sets its node-wide
+         * pixel memory pool during eq::init().
+         */
+        static void setAllocator( Alloc_t allocFunc, Free_t freeFunc );
+
+        /** A compressed chunk, using the memory of the allocator. */
+        class Result
+        {
+        public:
+            Result() : _data( 0 ), _size( 0 ), _capacity( 0 ) {}
+            ~Result();
+
+            /** Resize, retaining the content up to the new size. */
+            uint8_t* resize( const eq_uint64_t size );
+
+            /** Set the used size, which has to fit the allocated memory. */
+            void setSize( const eq_uint64_t size )
+                { LBASSERT( size <= _capacity ); _size = size; }
+
+            uint8_t* getData() { return _data; }
+            const uint8_t* getData() const { return _data; }
+            eq_uint64_t getSize() const { return _size; }
+            eq_uint64_t getMaxSize() const { return _capacity; }
+
+        private:
+            Result( const Result& );
+            Result& operator = ( const Result& );
+
+            uint8_t* _data;
+            eq_uint64_t _size;
+            eq_uint64_t _capacity;
+        };
         typedef std::vector< Result* > Results;
 
         /** @return the vector containing the result data. */
@@ -0,0 +1,187 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compressorPredict.h"
+
+#include "bitStream.h"
+
+#include <lunchbox/omp.h>
+
+namespace eq
+{
+namespace plugin
+{
+namespace
+{
+// Pixels per strip, enough to amortize the strip setup
+static const eq_uint64_t _chunkSize = 64 * 1024;
+
+static void _getInfo( EqCompressorInfo* const info )
+{
+    info->version         = EQ_COMPRESSOR_VERSION;
+    info->name            = EQ_COMPRESSOR_PREDICT_DEPTH_UNSIGNED_INT;
+    info->capabilities    = EQ_COMPRESSOR_DATA_1D | EQ_COMPRESSOR_DATA_2D;
+    info->tokenType       = EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT;
+    info->outputTokenType = EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT;
+    info->outputTokenSize = 4;
+    info->quality         = 1.f;
+    info->ratio           = .25f;
+    info->speed           = .5f;
+}
+
+static bool _register()
+{
+    Compressor::registerEngine(
+        Compressor::Functions( EQ_COMPRESSOR_PREDICT_DEPTH_UNSIGNED_INT,
+                               _getInfo,
+                               CompressorPredict::getNewCompressor,
+                               CompressorPredict::getNewDecompressor,
+                               CompressorPredict::decompress, 0 ));
+    return true;
+}
+
+static bool _initialized = _register();
+
+/** @return the first row of the given strip. */
+static inline eq_uint64_t _getStartRow( const eq_uint64_t strip,
+                                        const eq_uint64_t nStrips,
+                                        const eq_uint64_t height )
+{
+    return height * strip / nStrips;
+}
+
+/** @return the planar prediction of pixel x, up is 0 in the first row. */
+static inline uint32_t _predict( const uint32_t* const row,
+                                 const uint32_t* const up, const eq_uint64_t x )
+{
+    if( !up )
+        return x > 0 ? row[ x - 1 ] : 0;
+    if( x == 0 )
+        return up[0];
+    return row[ x - 1 ] + up[ x ] - up[ x - 1 ];
+}
+
+static void _compressChunk( const uint32_t* const in, const eq_uint64_t width,
+                            const eq_uint64_t height,
+                            Compressor::Result* result )
+{
+    result->resize( sizeof( uint32_t ) +
+                    BlockWriter::getMaxSize( width * height ));
+
+    uint8_t* const start = reinterpret_cast< uint8_t* >( result->getData( ));
+    const uint32_t rowSize = uint32_t( width );
+    memcpy( start, &rowSize, sizeof( rowSize ));
+
+    BlockWriter writer( start + sizeof( rowSize ));
+    for( eq_uint64_t y = 0; y < height; ++y )
+    {
+        const uint32_t* const row = in + y * width;
+        const uint32_t* const up = y > 0 ? row - width : 0;
+        for( eq_uint64_t x = 0; x < width; ++x )
+            writer.put( encodeResidual( row[x] - _predict( row, up, x )));
+    }
+    result->setSize( writer.flush() - start );
+}
+
+static void _decompressChunk( const void* const inData,
+                              const eq_uint64_t inSize, uint32_t* const out,
+                              const eq_uint64_t width,
+                              const eq_uint64_t height )
+{
+    const uint8_t* const in = reinterpret_cast< const uint8_t* >( inData );
+    BlockReader reader( in + sizeof( uint32_t ), in + inSize );
+
+    for( eq_uint64_t y = 0; y < height; ++y )
+    {
+        uint32_t* const row = out + y * width;
+        const uint32_t* const up = y > 0 ? row - width : 0;
+        for( eq_uint64_t x = 0; x < width; ++x )
+            row[x] = decodeResidual( reader.get( )) + _predict( row, up, x );
+    }
+}
+}
+
+CompressorPredict::CompressorPredict( const unsigned name )
+        : Compressor()
+{}
+
+CompressorPredict::~CompressorPredict()
+{}
+
+void CompressorPredict::compress( const void* const inData,
+                                  const eq_uint64_t nPixels,
+                                  const bool useAlpha )
+{
+    compress2D( inData, nPixels, 1, useAlpha );
+}
+
+void CompressorPredict::compress2D( const void* const inData,
+                                    const eq_uint64_t width,
+                                    const eq_uint64_t height,
+                                    const bool useAlpha )
+{
+    const eq_uint64_t nPixels = width * height;
+    const unsigned maxChunks = lunchbox::OMP::getNThreads() * 4;
+    const unsigned nChunks = unsigned( LB_MAX( 1u, LB_MIN( maxChunks,
+                                    LB_MIN( height, nPixels / _chunkSize ))));
+
+    while( _results.size() < nChunks )
+        _results.push_back( new Result );
+    _nResults = nChunks;
+
+    const uint32_t* const in = reinterpret_cast< const uint32_t* >( inData );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nChunks ); ++i )
+    {
+        const eq_uint64_t start = _getStartRow( i, nChunks, height );
+        const eq_uint64_t end = _getStartRow( i + 1, nChunks, height );
+        if( start == end || width == 0 )
+            _results[i]->setSize( 0 );
+        else
+            _compressChunk( in + start * width, width, end - start,
+                            _results[i] );
+    }
+}
+
+void CompressorPredict::decompress( const void* const* inData,
+                                    const eq_uint64_t* const inSizes,
+                                    const unsigned nInputs,
+                                    void* const outData,
+                                    const eq_uint64_t nPixels,
+                                    const bool useAlpha )
+{
+    uint32_t* const out = reinterpret_cast< uint32_t* >( outData );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nInputs ); ++i )
+    {
+        if( inSizes[i] < sizeof( uint32_t ))
+            continue;
+
+        uint32_t width = 0;
+        memcpy( &width, inData[i], sizeof( width ));
+        if( width == 0 )
+            continue;
+
+        const eq_uint64_t height = nPixels / width;
+        const eq_uint64_t start = _getStartRow( i, nInputs, height );
+        const eq_uint64_t end = _getStartRow( i + 1, nInputs, height );
+        _decompressChunk( inData[i], inSizes[i], out + start * width, width,
+                          end - start );
+    }
+}
+
+}
+}
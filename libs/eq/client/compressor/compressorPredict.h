@@ -0,0 +1,74 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PLUGIN_COMPRESSORPREDICT
+#define EQ_PLUGIN_COMPRESSORPREDICT
+
+#include "compressor.h"
+
+/** Built-in lossless depth compressor, following the span compressor names. */
+#define EQ_COMPRESSOR_PREDICT_DEPTH_UNSIGNED_INT   0xe0000004u
+
+namespace eq
+{
+namespace plugin
+{
+
+/**
+ * Lossless predictive compressor for 24 and 32 bit depth buffers.
+ *
+ * The rows are split into strips, which are compressed in parallel. Each pixel
+ * is predicted from its left, upper and upper-left neighbour in the strip,
+ * which is exact for planar surfaces since window-space depth is linear in
+ * screen space. The residuals are stored in blocks of 32, each block using the
+ * bit width of its largest residual:
+ * @code
+ * width ( nBits:6 residual:nBits[ 32 ] )*
+ * @endcode
+ * The width is a 32 bit word in host byte order, followed by a little-endian
+ * bit stream. Residuals are mapped to unsigned values by interleaving positive
+ * and negative values. Constant and planar areas cost six bits per block.
+ */
+class CompressorPredict : public Compressor
+{
+public:
+    CompressorPredict( const unsigned name );
+    virtual ~CompressorPredict();
+
+    virtual void compress( const void* const inData,
+                           const eq_uint64_t nPixels,
+                           const bool        useAlpha );
+
+    virtual void compress2D( const void* const inData,
+                             const eq_uint64_t width,
+                             const eq_uint64_t height,
+                             const bool        useAlpha );
+
+    static void decompress( const void* const* inData,
+                            const eq_uint64_t* const inSizes,
+                            const unsigned nInputs, void* const outData,
+                            const eq_uint64_t nPixels, const bool useAlpha );
+
+    static void* getNewCompressor( const unsigned name )
+        { return new CompressorPredict( name ); }
+
+    static void* getNewDecompressor( const unsigned name ) { return 0; }
+};
+
+}
+}
+
+#endif // EQ_PLUGIN_COMPRESSORPREDICT
@@ -0,0 +1,192 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compressorSpan.h"
+
+#include <lunchbox/omp.h>
+
+namespace eq
+{
+namespace plugin
+{
+namespace
+{
+// Background runs shorter than this are stored as literals, since a record
+// header costs two pixels.
+static const uint32_t _minBackground = 3;
+
+// Pixels per chunk, enough to amortize the chunk setup
+static const eq_uint64_t _chunkSize = 64 * 1024;
+
+#define REGISTER_ENGINE( type_ )                                        \
+    static void _getInfo ## type_( EqCompressorInfo* const info )       \
+    {                                                                   \
+        info->version         = EQ_COMPRESSOR_VERSION;                  \
+        info->name            = EQ_COMPRESSOR_SPAN_ ## type_;           \
+        info->capabilities    = EQ_COMPRESSOR_DATA_1D |                 \
+                                EQ_COMPRESSOR_DATA_2D;                  \
+        info->tokenType       = EQ_COMPRESSOR_DATATYPE_ ## type_;       \
+        info->outputTokenType = EQ_COMPRESSOR_DATATYPE_ ## type_;       \
+        info->outputTokenSize = 4;                                      \
+        info->quality         = 1.f;                                    \
+        info->ratio           = .5f;                                    \
+        info->speed           = 1.f;                                    \
+    }                                                                   \
+                                                                        \
+    static bool _register ## type_()                                    \
+    {                                                                   \
+        Compressor::registerEngine(                                     \
+            Compressor::Functions( EQ_COMPRESSOR_SPAN_ ## type_,        \
+                                   _getInfo ## type_,                   \
+                                   CompressorSpan::getNewCompressor,    \
+                                   CompressorSpan::getNewDecompressor,  \
+                                   CompressorSpan::decompress, 0 ));    \
+        return true;                                                    \
+    }                                                                   \
+                                                                        \
+    static bool _initialized ## type_ = _register ## type_();
+
+REGISTER_ENGINE( RGBA );
+REGISTER_ENGINE( BGRA );
+REGISTER_ENGINE( DEPTH_UNSIGNED_INT );
+
+/** @return the number of background pixels starting at in, up to max. */
+static inline uint32_t _countBackground( const uint32_t* in, const uint32_t max,
+                                         const uint32_t background )
+{
+    uint32_t n = 0;
+    while( n < max && in[n] == background )
+        ++n;
+    return n;
+}
+
+static void _compressChunk( const uint32_t* const in, const eq_uint64_t size,
+                            Compressor::Result* result )
+{
+    // worst case: each record after the first starts with _minBackground
+    // background pixels
+    result->resize( ( 1 + size + 2 * ( size / _minBackground + 2 )) *
+                    sizeof( uint32_t ));
+    uint32_t* const start = reinterpret_cast< uint32_t* >( result->getData( ));
+    uint32_t* out = start;
+    const uint32_t background = in[0];
+    *out++ = background;
+
+    eq_uint64_t i = 0;
+    while( i < size )
+    {
+        const uint32_t left = uint32_t( LB_MIN( size - i, 0xffffffffull ));
+        const uint32_t nBackground = _countBackground( in + i, left,
+                                                       background );
+        i += nBackground;
+
+        // literals up to the next background run worth a record
+        const eq_uint64_t literalStart = i;
+        while( i < size )
+        {
+            if( in[i] != background )
+            {
+                ++i;
+                continue;
+            }
+
+            const uint32_t max = uint32_t( LB_MIN( size - i, _minBackground ));
+            const uint32_t n = _countBackground( in + i, max, background );
+            if( n == _minBackground || i + n == size )
+                break;
+            i += n;
+        }
+
+        const uint32_t nLiteral = uint32_t( i - literalStart );
+        *out++ = nBackground;
+        *out++ = nLiteral;
+        memcpy( out, in + literalStart, nLiteral * sizeof( uint32_t ));
+        out += nLiteral;
+    }
+
+    result->setSize( ( out - start ) * sizeof( uint32_t ));
+}
+
+static void _decompressChunk( const void* const inData,
+                              const eq_uint64_t inSize, uint32_t* out )
+{
+    SpanReader reader( inData, inSize );
+    const uint32_t background = reader.getBackground();
+
+    while( reader.next( ))
+    {
+        const uint32_t nBackground = reader.getNBackground();
+        for( uint32_t i = 0; i < nBackground; ++i )
+            out[i] = background;
+        out += nBackground;
+
+        const uint32_t nLiteral = reader.getNLiteral();
+        memcpy( out, reader.getLiteral(), nLiteral * sizeof( uint32_t ));
+        out += nLiteral;
+    }
+}
+}
+
+CompressorSpan::CompressorSpan( const unsigned name )
+        : Compressor()
+{}
+
+CompressorSpan::~CompressorSpan()
+{}
+
+void CompressorSpan::compress( const void* const inData,
+                               const eq_uint64_t nPixels, const bool useAlpha )
+{
+    // The alpha channel is always kept, see the missing
+    // EQ_COMPRESSOR_IGNORE_ALPHA capability.
+    const unsigned maxChunks = lunchbox::OMP::getNThreads() * 4;
+    const unsigned nChunks = unsigned( LB_MAX( 1u, LB_MIN( maxChunks,
+                                                 nPixels / _chunkSize )));
+
+    while( _results.size() < nChunks )
+        _results.push_back( new Result );
+    _nResults = nChunks;
+
+    const uint32_t* const in = reinterpret_cast< const uint32_t* >( inData );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nChunks ); ++i )
+    {
+        const eq_uint64_t start = getChunkStart( i, nChunks, nPixels );
+        const eq_uint64_t end = getChunkStart( i + 1, nChunks, nPixels );
+        if( start == end )
+            _results[i]->setSize( 0 );
+        else
+            _compressChunk( in + start, end - start, _results[i] );
+    }
+}
+
+void CompressorSpan::decompress( const void* const* inData,
+                                 const eq_uint64_t* const inSizes,
+                                 const unsigned nInputs, void* const outData,
+                                 const eq_uint64_t nPixels, const bool useAlpha )
+{
+    uint32_t* const out = reinterpret_cast< uint32_t* >( outData );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nInputs ); ++i )
+    {
+        if( inSizes[i] > 0 )
+            _decompressChunk( inData[i], inSizes[i],
+                              out + getChunkStart( i, nInputs, nPixels ));
+    }
+}
+
+}
+}
@@ -0,0 +1,143 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PLUGIN_COMPRESSORSPAN
+#define EQ_PLUGIN_COMPRESSORSPAN
+
+#include "compressor.h"
+
+/**
+ * @name Names of the CPU compressors built into Equalizer.
+ *
+ * They use a block well above the names assigned in co/plugins/compressor.h.
+ */
+//@{
+#define EQ_COMPRESSOR_SPAN_RGBA                 0xe0000001u
+#define EQ_COMPRESSOR_SPAN_BGRA                 0xe0000002u
+#define EQ_COMPRESSOR_SPAN_DEPTH_UNSIGNED_INT   0xe0000003u
+//@}
+
+namespace eq
+{
+namespace plugin
+{
+
+/**
+ * Lossless span run-length compressor for 32 bit pixels.
+ *
+ * The pixels are split into chunks, which are compressed in parallel. A chunk
+ * starts with its background value, the first pixel of the chunk, followed by
+ * records of background and literal pixels:
+ * @code
+ * background ( nBackground nLiteral literal[ nLiteral ] )*
+ * @endcode
+ * All values are 32 bit words in host byte order.
+ *
+ * Sort-last images are mostly background, i.e., cleared color and the far
+ * depth value. The CPU compositor understands this format and merges the
+ * literal spans directly, without decompressing the background spans.
+ */
+class CompressorSpan : public Compressor
+{
+public:
+    CompressorSpan( const unsigned name );
+    virtual ~CompressorSpan();
+
+    virtual void compress( const void* const inData,
+                           const eq_uint64_t nPixels,
+                           const bool        useAlpha );
+
+    static void decompress( const void* const* inData,
+                            const eq_uint64_t* const inSizes,
+                            const unsigned nInputs, void* const outData,
+                            const eq_uint64_t nPixels, const bool useAlpha );
+
+    static void* getNewCompressor( const unsigned name )
+        { return new CompressorSpan( name ); }
+
+    static void* getNewDecompressor( const unsigned name ) { return 0; }
+
+    /** @return true if the given name is a span compressor. */
+    static bool isSpanCompressor( const unsigned name )
+        { return name >= EQ_COMPRESSOR_SPAN_RGBA &&
+                 name <= EQ_COMPRESSOR_SPAN_DEPTH_UNSIGNED_INT; }
+
+    /** @return the index of the first pixel of the given chunk. */
+    static eq_uint64_t getChunkStart( const unsigned chunk,
+                                      const unsigned nChunks,
+                                      const eq_uint64_t nPixels )
+        { return nPixels * chunk / nChunks; }
+};
+
+/** Sequential reader of the records of one compressed chunk. */
+class SpanReader
+{
+public:
+    SpanReader()
+        : _in( 0 ), _end( 0 ), _background( 0 ), _literal( 0 )
+        , _nBackground( 0 ), _nLiteral( 0 )
+    {}
+
+    /** Read the given chunk, which has to contain at least one pixel. */
+    SpanReader( const void* const data, const eq_uint64_t size )
+        : _in( reinterpret_cast< const uint32_t* >( data ))
+        , _end( _in + size / sizeof( uint32_t ))
+        , _background( *_in )
+        , _literal( 0 )
+        , _nBackground( 0 )
+        , _nLiteral( 0 )
+    {
+        ++_in;
+    }
+
+    /** Advance to the next record. @return false at the end of the chunk. */
+    bool next()
+    {
+        if( _in >= _end )
+            return false;
+
+        _nBackground = _in[0];
+        _nLiteral = _in[1];
+        _literal = _in + 2;
+        _in = _literal + _nLiteral;
+        return true;
+    }
+
+    /** @return the value of all background pixels of the chunk. */
+    uint32_t getBackground() const { return _background; }
+
+    /** @return the number of background pixels of the current record. */
+    uint32_t getNBackground() const { return _nBackground; }
+
+    /** @return the number of literal pixels of the current record. */
+    uint32_t getNLiteral() const { return _nLiteral; }
+
+    /** @return the literal pixels following the background pixels. */
+    const uint32_t* getLiteral() const { return _literal; }
+
+private:
+    const uint32_t* _in;
+    const uint32_t* _end;
+    uint32_t _background;
+    const uint32_t* _literal;
+    uint32_t _nBackground;
+    uint32_t _nLiteral;
+};
+
+}
+}
+
+#endif // EQ_PLUGIN_COMPRESSORSPAN
@@ -0,0 +1,564 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compressorYUV420.h"
+
+#include "bitStream.h"
+#include "../compositorKernels.h"
+
+#include <lunchbox/omp.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#  define EQ_YUV420_SSE2
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(__clang__)
+#    define EQ_TARGET_SSE2 __attribute__((target("sse2")))
+#  else
+#    define EQ_TARGET_SSE2
+#  endif
+#endif
+
+namespace eq
+{
+namespace plugin
+{
+namespace
+{
+// Strip flags
+static const uint32_t _flagAlpha = 0x1u;
+static const uint32_t _flagBGRA = 0x2u;
+static const unsigned _shiftOffset = 8; // quantization shift in bits 8-15
+
+// Pixels per strip, enough to amortize the strip setup
+static const eq_uint64_t _chunkSize = 64 * 1024;
+
+#define REGISTER_ENGINE( type_, quality_, ratio_ )                      \
+    static void _getInfo ## type_ ## quality_( EqCompressorInfo* const info ) \
+    {                                                                   \
+        info->version         = EQ_COMPRESSOR_VERSION;                  \
+        info->name            = EQ_COMPRESSOR_YUV420_ ## type_ ## _ ##  \
+                                    quality_ ## P;                      \
+        info->capabilities    = EQ_COMPRESSOR_DATA_2D |                 \
+                                EQ_COMPRESSOR_IGNORE_ALPHA;             \
+        info->tokenType       = EQ_COMPRESSOR_DATATYPE_ ## type_;       \
+        info->outputTokenType = EQ_COMPRESSOR_DATATYPE_ ## type_;       \
+        info->outputTokenSize = 4;                                      \
+        info->quality         = float( quality_ ) / 100.f;              \
+        info->ratio           = ratio_;                                 \
+        info->speed           = .4f;                                    \
+    }                                                                   \
+                                                                        \
+    static bool _register ## type_ ## quality_()                        \
+    {                                                                   \
+        Compressor::registerEngine(                                     \
+            Compressor::Functions( EQ_COMPRESSOR_YUV420_ ## type_ ## _ ## \
+                                       quality_ ## P,                   \
+                                   _getInfo ## type_ ## quality_,       \
+                                   CompressorYUV420::getNewCompressor,  \
+                                   CompressorYUV420::getNewDecompressor, \
+                                   CompressorYUV420::decompress, 0 ));  \
+        return true;                                                    \
+    }                                                                   \
+                                                                        \
+    static bool _initialized ## type_ ## quality_ =                     \
+        _register ## type_ ## quality_();
+
+REGISTER_ENGINE( RGBA, 90, .3f );
+REGISTER_ENGINE( RGBA, 70, .2f );
+REGISTER_ENGINE( RGBA, 50, .15f );
+REGISTER_ENGINE( BGRA, 90, .3f );
+REGISTER_ENGINE( BGRA, 70, .2f );
+REGISTER_ENGINE( BGRA, 50, .15f );
+
+/** @return the quantization of the samples for the given engine. */
+static unsigned _getShift( const unsigned name )
+{
+    switch( name )
+    {
+        case EQ_COMPRESSOR_YUV420_RGBA_70P:
+        case EQ_COMPRESSOR_YUV420_BGRA_70P:
+            return 2;
+        case EQ_COMPRESSOR_YUV420_RGBA_50P:
+        case EQ_COMPRESSOR_YUV420_BGRA_50P:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @return the largest chroma deviation of a pixel from its 2x2 block.
+ *
+ * The error of a color channel is at most 1.8 times the chroma error plus the
+ * luma error, and the quantization adds up to half a step to each. The
+ * thresholds keep the error of each channel below ( 1 - quality ) * 255.
+ */
+static int32_t _getThreshold( const unsigned name )
+{
+    switch( name )
+    {
+        case EQ_COMPRESSOR_YUV420_RGBA_70P:
+        case EQ_COMPRESSOR_YUV420_BGRA_70P:
+            return 32;
+        case EQ_COMPRESSOR_YUV420_RGBA_50P:
+        case EQ_COMPRESSOR_YUV420_BGRA_50P:
+            return 48;
+        default:
+            return 8;
+    }
+}
+
+static bool _isBGRA( const unsigned name )
+{
+    return name >= EQ_COMPRESSOR_YUV420_BGRA_90P &&
+           name <= EQ_COMPRESSOR_YUV420_BGRA_50P;
+}
+
+/** @return the first row of the given strip, strips have row pairs. */
+static inline eq_uint64_t _getStartRow( const eq_uint64_t strip,
+                                        const eq_uint64_t nStrips,
+                                        const eq_uint64_t height )
+{
+    const eq_uint64_t nPairs = ( height + 1 ) / 2;
+    return LB_MIN( height, 2 * ( nPairs * strip / nStrips ));
+}
+
+//----------------------------------------------------------------------
+// Color conversion, BT.601 full range in 8 bit fixed point
+//----------------------------------------------------------------------
+/** Compute the luma of one row of pixels. */
+typedef void (*LumaRowFunc)( const uint32_t* in, uint8_t* out,
+                             const int32_t nPixels, const unsigned red );
+
+void _getLumaRowScalar( const uint32_t* in, uint8_t* out,
+                        const int32_t nPixels, const unsigned red )
+{
+    const uint8_t* pixel = reinterpret_cast< const uint8_t* >( in );
+    const unsigned blue = 2 - red;
+    for( int32_t x = 0; x < nPixels; ++x )
+    {
+        out[x] = uint8_t(( 77 * pixel[ red ] + 150 * pixel[1] +
+                           29 * pixel[ blue ] + 128 ) >> 8 );
+        pixel += 4;
+    }
+}
+
+#ifdef EQ_YUV420_SSE2
+EQ_TARGET_SSE2
+void _getLumaRowSSE2( const uint32_t* in, uint8_t* out,
+                      const int32_t nPixels, const unsigned red )
+{
+    // one weight per 16 bit channel of two pixels, the sums of the channel
+    // pairs are added to the luma of each pixel
+    const __m128i weights = red == 0 ?
+        _mm_set_epi16( 0, 29, 150, 77, 0, 29, 150, 77 ) :
+        _mm_set_epi16( 0, 77, 150, 29, 0, 77, 150, 29 );
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi32( 128 );
+    int32_t x = 0;
+
+    for( ; x + 4 <= nPixels; x += 4 )
+    {
+        const __m128i pixels = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >( in + x ));
+        __m128i lo = _mm_madd_epi16( _mm_unpacklo_epi8( pixels, zero ),
+                                     weights );
+        __m128i hi = _mm_madd_epi16( _mm_unpackhi_epi8( pixels, zero ),
+                                     weights );
+        lo = _mm_add_epi32( lo, _mm_srli_epi64( lo, 32 ));
+        hi = _mm_add_epi32( hi, _mm_srli_epi64( hi, 32 ));
+        lo = _mm_shuffle_epi32( lo, _MM_SHUFFLE( 3, 3, 2, 0 ));
+        hi = _mm_shuffle_epi32( hi, _MM_SHUFFLE( 3, 3, 2, 0 ));
+
+        __m128i luma = _mm_unpacklo_epi64( lo, hi );
+        luma = _mm_srli_epi32( _mm_add_epi32( luma, half ), 8 );
+        luma = _mm_packs_epi32( luma, luma );
+        luma = _mm_packus_epi16( luma, luma );
+
+        const int32_t bytes = _mm_cvtsi128_si32( luma );
+        memcpy( out + x, &bytes, sizeof( bytes ));
+    }
+    _getLumaRowScalar( in + x, out + x, nPixels - x, red );
+}
+#endif
+
+/** @return the luma kernel for the current CPU. */
+static LumaRowFunc _getLumaRow()
+{
+#ifdef EQ_YUV420_SSE2
+    const detail::SIMDLevel level = detail::getSIMDLevel();
+    if( level == detail::SIMD_SSE2 || level == detail::SIMD_AVX2 )
+        return _getLumaRowSSE2;
+#endif
+    return _getLumaRowScalar;
+}
+
+/** Compute the chroma of each pixel of a row. */
+static void _getChromaRow( const uint32_t* row, const eq_uint64_t width,
+                           const unsigned red, uint8_t* cb, uint8_t* cr )
+{
+    const uint8_t* in = reinterpret_cast< const uint8_t* >( row );
+    const unsigned blue = 2 - red;
+
+    for( eq_uint64_t x = 0; x < width; ++x )
+    {
+        const int32_t u = ( -43 * in[ red ] - 85 * in[1] + 128 * in[ blue ] +
+                            32896 ) >> 8;
+        const int32_t v = ( 128 * in[ red ] - 107 * in[1] - 21 * in[ blue ] +
+                            32896 ) >> 8;
+        cb[x] = uint8_t( LB_MIN( u, 255 ));
+        cr[x] = uint8_t( LB_MIN( v, 255 ));
+        in += 4;
+    }
+}
+
+/**
+ * Subsample the chroma of a row pair to 2x2 pixel blocks.
+ *
+ * A block which has a pixel deviating more than the threshold from the block
+ * average is flagged, and keeps the chroma of its top left pixel in block and
+ * the chroma of its other three pixels in detail. The last column of an odd
+ * width and the last row of an odd height are used twice.
+ */
+static void _getChromaBlocks( const uint8_t* const chroma[2],
+                              const eq_uint64_t width,
+                              const int32_t threshold, uint8_t* block,
+                              uint8_t* flags, std::vector< uint8_t >& detail )
+{
+    for( eq_uint64_t x = 0; x < width; x += 2 )
+    {
+        const eq_uint64_t right = x + 1 < width ? x + 1 : x;
+        const int32_t samples[4] = { chroma[0][x], chroma[0][ right ],
+                                     chroma[1][x], chroma[1][ right ] };
+        const int32_t average = ( samples[0] + samples[1] + samples[2] +
+                                  samples[3] + 2 ) >> 2;
+        bool flag = false;
+        for( unsigned i = 0; i < 4; ++i )
+            flag = flag || std::abs( samples[i] - average ) > threshold;
+
+        flags[ x / 2 ] = flag;
+        block[ x / 2 ] = uint8_t( flag ? samples[0] : average );
+        if( !flag )
+            continue;
+
+        for( unsigned i = 1; i < 4; ++i )
+            detail.push_back( uint8_t( samples[i] ));
+    }
+}
+
+/** Expand the chroma blocks of a row pair to the chroma of each pixel. */
+static void _setChromaBlocks( const uint8_t* block, const uint8_t* flags,
+                              const uint8_t*& detail, const eq_uint64_t width,
+                              uint8_t* chroma[2] )
+{
+    for( eq_uint64_t x = 0; x < width; x += 2 )
+    {
+        const eq_uint64_t right = x + 1 < width ? x + 1 : x;
+        const uint8_t value = block[ x / 2 ];
+        chroma[0][x] = value;
+        if( flags[ x / 2 ] )
+        {
+            chroma[0][ right ] = detail[0];
+            chroma[1][x] = detail[1];
+            chroma[1][ right ] = detail[2];
+            detail += 3;
+        }
+        else
+            chroma[0][ right ] = chroma[1][x] = chroma[1][ right ] = value;
+    }
+}
+
+static void _getAlphaRow( const uint32_t* row, const eq_uint64_t width,
+                          uint8_t* out )
+{
+    const uint8_t* const in = reinterpret_cast< const uint8_t* >( row );
+    for( eq_uint64_t x = 0; x < width; ++x )
+        out[x] = in[ x * 4 + 3 ];
+}
+
+/** @return the 8 bit channel of a value with 8 fractional bits. */
+static inline uint8_t _toChannel( const int32_t value )
+{
+    // offset keeps the shifted value positive
+    const int32_t channel = (( value + 65536 ) >> 8 ) - 256;
+    return uint8_t( channel < 0 ? 0 : LB_MIN( channel, 255 ));
+}
+
+static void _setPixelRow( const uint8_t* luma, const uint8_t* cb,
+                          const uint8_t* cr, const uint8_t* alpha,
+                          const eq_uint64_t width, const unsigned red,
+                          uint32_t* row )
+{
+    uint8_t* out = reinterpret_cast< uint8_t* >( row );
+    const unsigned blue = 2 - red;
+
+    for( eq_uint64_t x = 0; x < width; ++x )
+    {
+        const int32_t y = luma[x] * 256 + 128;
+        const int32_t u = cb[x] - 128;
+        const int32_t v = cr[x] - 128;
+
+        out[ red ] = _toChannel( y + 359 * v );
+        out[ 1 ] = _toChannel( y - 88 * u - 183 * v );
+        out[ blue ] = _toChannel( y + 454 * u );
+        out[ 3 ] = alpha ? alpha[x] : 255;
+        out += 4;
+    }
+}
+
+//----------------------------------------------------------------------
+// Sample coding
+//----------------------------------------------------------------------
+/** Quantize a row of samples and write the differences to their left. */
+static void _putRow( BlockWriter& writer, const uint8_t* samples,
+                     const eq_uint64_t n, const unsigned shift )
+{
+    const uint32_t half = ( 1u << shift ) >> 1;
+    uint32_t last = 0;
+    for( eq_uint64_t i = 0; i < n; ++i )
+    {
+        const uint32_t value = ( samples[i] + half ) >> shift;
+        writer.put( encodeResidual( value - last ));
+        last = value;
+    }
+}
+
+static void _getRow( BlockReader& reader, uint8_t* samples,
+                     const eq_uint64_t n, const unsigned shift )
+{
+    uint32_t last = 0;
+    for( eq_uint64_t i = 0; i < n; ++i )
+    {
+        last += decodeResidual( reader.get( ));
+        samples[i] = uint8_t( LB_MIN( last << shift, 255u ));
+    }
+}
+
+/** Write the flags, blocks and details of one chroma plane of a row pair. */
+static void _putChroma( BlockWriter& writer, const uint8_t* const chroma[2],
+                        const eq_uint64_t width, const unsigned shift,
+                        const int32_t threshold, uint8_t* block,
+                        uint8_t* flags, std::vector< uint8_t >& detail )
+{
+    const eq_uint64_t chromaWidth = ( width + 1 ) / 2;
+    detail.clear();
+    _getChromaBlocks( chroma, width, threshold, block, flags, detail );
+
+    _putRow( writer, flags, chromaWidth, 0 );
+    _putRow( writer, block, chromaWidth, shift );
+    if( !detail.empty( ))
+        _putRow( writer, &detail[0], detail.size(), shift );
+}
+
+static void _getChroma( BlockReader& reader, const eq_uint64_t width,
+                        const unsigned shift, uint8_t* block, uint8_t* flags,
+                        std::vector< uint8_t >& detail, uint8_t* chroma[2] )
+{
+    const eq_uint64_t chromaWidth = ( width + 1 ) / 2;
+    _getRow( reader, flags, chromaWidth, 0 );
+    _getRow( reader, block, chromaWidth, shift );
+
+    size_t nDetails = 0;
+    for( eq_uint64_t i = 0; i < chromaWidth; ++i )
+        nDetails += flags[i] ? 3 : 0;
+    detail.resize( nDetails + 1 );
+    _getRow( reader, &detail[0], nDetails, shift );
+
+    const uint8_t* next = &detail[0];
+    _setChromaBlocks( block, flags, next, width, chroma );
+}
+
+static void _compressChunk( const uint32_t* const in, const eq_uint64_t width,
+                            const eq_uint64_t height, const uint32_t flags,
+                            const int32_t threshold,
+                            const LumaRowFunc getLumaRow,
+                            Compressor::Result* result )
+{
+    const unsigned red = ( flags & _flagBGRA ) ? 2 : 0;
+    const unsigned shift = ( flags >> _shiftOffset ) & 0xffu;
+    const bool useAlpha = ( flags & _flagAlpha ) != 0;
+    const eq_uint64_t chromaWidth = ( width + 1 ) / 2;
+    // flags, blocks and at most three details per block and chroma plane
+    const eq_uint64_t nValues = width * height * ( useAlpha ? 2 : 1 ) +
+                                5 * chromaWidth * ( height + 1 );
+    const uint32_t header[2] = { uint32_t( width ), flags };
+    result->resize( sizeof( header ) + BlockWriter::getMaxSize( nValues ));
+
+    uint8_t* const start = reinterpret_cast< uint8_t* >( result->getData( ));
+    memcpy( start, header, sizeof( header ));
+
+    BlockWriter writer( start + sizeof( header ));
+    std::vector< uint8_t > samples( 5 * width + 2 * chromaWidth );
+    uint8_t* const cb[2] = { &samples[ width ], &samples[ 2 * width ] };
+    uint8_t* const cr[2] = { &samples[ 3 * width ], &samples[ 4 * width ] };
+    uint8_t* const block = &samples[ 5 * width ];
+    uint8_t* const blockFlags = block + chromaWidth;
+    std::vector< uint8_t > detail;
+
+    for( eq_uint64_t y = 0; y < height; y += 2 )
+    {
+        const uint32_t* const row[2] = { in + y * width,
+                                         in + ( y + 1 < height ? y + 1 : y ) *
+                                              width };
+        const unsigned nRows = row[1] == row[0] ? 1 : 2;
+
+        for( unsigned i = 0; i < nRows; ++i )
+        {
+            getLumaRow( row[i], &samples[0], int32_t( width ), red );
+            _putRow( writer, &samples[0], width, shift );
+            _getChromaRow( row[i], width, red, cb[i], cr[i] );
+        }
+
+        const uint8_t* const cbRows[2] = { cb[0], cb[ nRows - 1 ] };
+        const uint8_t* const crRows[2] = { cr[0], cr[ nRows - 1 ] };
+        _putChroma( writer, cbRows, width, shift, threshold, block,
+                    blockFlags, detail );
+        _putChroma( writer, crRows, width, shift, threshold, block,
+                    blockFlags, detail );
+
+        if( !useAlpha )
+            continue;
+        for( unsigned i = 0; i < nRows; ++i )
+        {
+            _getAlphaRow( row[i], width, &samples[0] );
+            _putRow( writer, &samples[0], width, 0 );
+        }
+    }
+
+    result->setSize( writer.flush() - start );
+}
+
+static void _decompressChunk( const void* const inData,
+                              const eq_uint64_t inSize, uint32_t* const out,
+                              const eq_uint64_t width,
+                              const eq_uint64_t height, const uint32_t flags )
+{
+    const unsigned red = ( flags & _flagBGRA ) ? 2 : 0;
+    const unsigned shift = ( flags >> _shiftOffset ) & 0xffu;
+    const bool useAlpha = ( flags & _flagAlpha ) != 0;
+    const eq_uint64_t chromaWidth = ( width + 1 ) / 2;
+
+    const uint8_t* const in = reinterpret_cast< const uint8_t* >( inData );
+    BlockReader reader( in + 2 * sizeof( uint32_t ), in + inSize );
+    std::vector< uint8_t > samples( 8 * width + 2 * chromaWidth );
+    uint8_t* const luma[2] = { &samples[0], &samples[ width ] };
+    uint8_t* const alpha[2] = { &samples[ 2 * width ], &samples[ 3 * width ] };
+    uint8_t* cb[2] = { &samples[ 4 * width ], &samples[ 5 * width ] };
+    uint8_t* cr[2] = { &samples[ 6 * width ], &samples[ 7 * width ] };
+    uint8_t* const block = &samples[ 8 * width ];
+    uint8_t* const blockFlags = block + chromaWidth;
+    std::vector< uint8_t > detail;
+
+    for( eq_uint64_t y = 0; y < height; y += 2 )
+    {
+        const unsigned nRows = y + 1 < height ? 2 : 1;
+        for( unsigned i = 0; i < nRows; ++i )
+            _getRow( reader, luma[i], width, shift );
+        _getChroma( reader, width, shift, block, blockFlags, detail, cb );
+        _getChroma( reader, width, shift, block, blockFlags, detail, cr );
+        if( useAlpha )
+            for( unsigned i = 0; i < nRows; ++i )
+                _getRow( reader, alpha[i], width, 0 );
+
+        for( unsigned i = 0; i < nRows; ++i )
+            _setPixelRow( luma[i], cb[i], cr[i], useAlpha ? alpha[i] : 0,
+                          width, red, out + ( y + i ) * width );
+    }
+}
+}
+
+CompressorYUV420::CompressorYUV420( const unsigned name )
+        : Compressor()
+        , _red( _isBGRA( name ) ? 2 : 0 )
+        , _shift( _getShift( name ))
+        , _threshold( _getThreshold( name ))
+{}
+
+CompressorYUV420::~CompressorYUV420()
+{}
+
+void CompressorYUV420::compress( const void* const inData,
+                                 const eq_uint64_t nPixels,
+                                 const bool useAlpha )
+{
+    compress2D( inData, nPixels, 1, useAlpha );
+}
+
+void CompressorYUV420::compress2D( const void* const inData,
+                                   const eq_uint64_t width,
+                                   const eq_uint64_t height,
+                                   const bool useAlpha )
+{
+    const eq_uint64_t nPixels = width * height;
+    const unsigned maxChunks = lunchbox::OMP::getNThreads() * 4;
+    const unsigned nChunks = unsigned( LB_MAX( 1u, LB_MIN( maxChunks,
+                             LB_MIN( ( height + 1 ) / 2, nPixels / _chunkSize ))));
+
+    while( _results.size() < nChunks )
+        _results.push_back( new Result );
+    _nResults = nChunks;
+
+    const uint32_t flags = ( useAlpha ? _flagAlpha : 0 ) |
+                           ( _red ? _flagBGRA : 0 ) |
+                           ( _shift << _shiftOffset );
+    const LumaRowFunc getLumaRow = _getLumaRow();
+    const uint32_t* const in = reinterpret_cast< const uint32_t* >( inData );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nChunks ); ++i )
+    {
+        const eq_uint64_t start = _getStartRow( i, nChunks, height );
+        const eq_uint64_t end = _getStartRow( i + 1, nChunks, height );
+        if( start == end || width == 0 )
+            _results[i]->setSize( 0 );
+        else
+            _compressChunk( in + start * width, width, end - start, flags,
+                            _threshold, getLumaRow, _results[i] );
+    }
+}
+
+void CompressorYUV420::decompress( const void* const* inData,
+                                   const eq_uint64_t* const inSizes,
+                                   const unsigned nInputs, void* const outData,
+                                   const eq_uint64_t nPixels,
+                                   const bool useAlpha )
+{
+    uint32_t* const out = reinterpret_cast< uint32_t* >( outData );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nInputs ); ++i )
+    {
+        if( inSizes[i] < 2 * sizeof( uint32_t ))
+            continue;
+
+        uint32_t header[2] = { 0, 0 };
+        memcpy( header, inData[i], sizeof( header ));
+        const eq_uint64_t width = header[0];
+        if( width == 0 )
+            continue;
+
+        const eq_uint64_t height = nPixels / width;
+        const eq_uint64_t start = _getStartRow( i, nInputs, height );
+        const eq_uint64_t end = _getStartRow( i + 1, nInputs, height );
+        _decompressChunk( inData[i], inSizes[i], out + start * width, width,
+                          end - start, header[1] );
+    }
+}
+
+}
+}
@@ -0,0 +1,101 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PLUGIN_COMPRESSORYUV420
+#define EQ_PLUGIN_COMPRESSORYUV420
+
+#include "compressor.h"
+
+/**
+ * @name Built-in lossy CPU color compressors, following the span compressor
+ *       names.
+ *
+ * The suffix is the advertised quality in percent.
+ */
+//@{
+#define EQ_COMPRESSOR_YUV420_RGBA_90P   0xe0000005u
+#define EQ_COMPRESSOR_YUV420_RGBA_70P   0xe0000006u
+#define EQ_COMPRESSOR_YUV420_RGBA_50P   0xe0000007u
+#define EQ_COMPRESSOR_YUV420_BGRA_90P   0xe0000008u
+#define EQ_COMPRESSOR_YUV420_BGRA_70P   0xe0000009u
+#define EQ_COMPRESSOR_YUV420_BGRA_50P   0xe000000au
+//@}
+
+namespace eq
+{
+namespace plugin
+{
+
+/**
+ * Lossy CPU compressor for 8 bit RGBA and BGRA color buffers.
+ *
+ * The pixels are converted to YCbCr with 4:2:0 chroma subsampling, the samples
+ * are quantized depending on the quality of the engine, and the differences of
+ * neighbouring samples are bit-packed as described in bitStream.h. Alpha is
+ * kept losslessly at full resolution unless the alpha channel is ignored.
+ *
+ * Subsampling is skipped for 2x2 blocks whose chroma varies more than the
+ * engine allows, e.g., at the edges of saturated colors. These blocks are
+ * flagged and keep the chroma of all four pixels, which bounds the error of
+ * each color channel by the advertised quality, i.e., ( 1 - quality ) * 255.
+ *
+ * The rows are split into strips of an even number of rows, which are
+ * compressed in parallel. Each strip stores its width and the flags needed
+ * for decoding, i.e., the channel order, the quantization and whether it has
+ * alpha, followed by the samples of each row pair:
+ * @code
+ * width flags ( Y[ 2 * width ] Cb Cr A[ 2 * width ] )*
+ * Cb, Cr: flag[ width/2 ] block[ width/2 ] detail[ 3 * nFlagged ]
+ * @endcode
+ *
+ * The engines are registered with decreasing quality and ratio, so that
+ * lowering Image::setQuality() trades fidelity for a smaller size.
+ */
+class CompressorYUV420 : public Compressor
+{
+public:
+    CompressorYUV420( const unsigned name );
+    virtual ~CompressorYUV420();
+
+    virtual void compress( const void* const inData,
+                           const eq_uint64_t nPixels,
+                           const bool        useAlpha );
+
+    virtual void compress2D( const void* const inData,
+                             const eq_uint64_t width,
+                             const eq_uint64_t height,
+                             const bool        useAlpha );
+
+    static void decompress( const void* const* inData,
+                            const eq_uint64_t* const inSizes,
+                            const unsigned nInputs, void* const outData,
+                            const eq_uint64_t nPixels, const bool useAlpha );
+
+    static void* getNewCompressor( const unsigned name )
+        { return new CompressorYUV420( name ); }
+
+    static void* getNewDecompressor( const unsigned name ) { return 0; }
+
+private:
+    const unsigned _red;   //!< byte index of the red channel
+    const unsigned _shift; //!< quantization of the samples
+    const int32_t _threshold; //!< chroma deviation of a subsampled block
+};
+
+}
+}
+
+#endif // EQ_PLUGIN_COMPRESSORYUV420
@@ -3,12 +3,19 @@
 
 set( EQ_COMPRESSOR_SOURCES
   compressor/compressor.cpp
+  compressor/compressorPredict.cpp
   compressor/compressorReadDrawPixels.cpp
+  compressor/compressorSpan.cpp
   compressor/compressorYUV.cpp
+  compressor/compressorYUV420.cpp
 )
 
 set( EQ_COMPRESSOR_HEADERS
+  compressor/bitStream.h
   compressor/compressor.h
+  compressor/compressorPredict.h
   compressor/compressorReadDrawPixels.h
+  compressor/compressorSpan.h
   compressor/compressorYUV.h
+  compressor/compressorYUV420.h
 )
@@ -0,0 +1,181 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "decompressQueue.h"
+
+#include "log.h"
+#include "node.h"
+#include "nodePackets.h"
+#include "nodeStatistics.h"
+#include "transmitShaper.h"
+
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/thread.h>
+
+#include <sstream>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+/**
+ * Add the decompression times of one image to the report of a packet.
+ *
+ * Each buffer reports the compressor used first, the images of one packet
+ * normally use the same compressors.
+ * @return true if a compressor was used.
+ */
+bool _addTimes( NodeFrameDataDecompressPacket& report,
+                const NodeFrameDataDecompressPacket& times )
+{
+    bool decompressed = false;
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const uint32_t name = times.compressors[i];
+        if( name == EQ_COMPRESSOR_NONE )
+            continue;
+
+        decompressed = true;
+        if( report.compressors[i] == EQ_COMPRESSOR_NONE )
+            report.compressors[i] = name;
+        else if( report.compressors[i] != name )
+            continue;
+
+        report.sizes[i] += times.sizes[i];
+        report.times[i] += times.times[i];
+    }
+    return decompressed;
+}
+}
+
+class DecompressThread : public lunchbox::Thread
+{
+public:
+    DecompressThread( DecompressQueue& queue, const size_t index,
+                      const int32_t affinity )
+            : _queue( queue ), _index( index ), _affinity( affinity ) {}
+    virtual ~DecompressThread() {}
+
+protected:
+    virtual void run()
+    {
+        std::ostringstream name;
+        name << "Dec" << _index << " " << lunchbox::className( _queue._node );
+        lunchbox::Thread::setName( name.str( ));
+        if( _affinity != OFF && _affinity != AUTO )
+            lunchbox::Thread::setAffinity( _affinity );
+
+        while( true )
+        {
+            const DecompressQueue::Job job = _queue._jobs.pop();
+            if( job.images.empty( ))
+                return; // exit thread
+
+            NodeFrameDataDecompressPacket report;
+            bool decompressed = false;
+            for( ImagesCIter i = job.images.begin(); i != job.images.end();
+                 ++i )
+            {
+                NodeFrameDataDecompressPacket times;
+                {
+                    NodeStatistics event( Statistic::NODE_FRAME_DECOMPRESS,
+                                          _queue._node, job.frameNumber );
+                    job.frameData->decompressImage( *i, times );
+                }
+                if( _addTimes( report, times ))
+                    decompressed = true;
+            }
+
+            // the source chooses the compressors, see TransmitCostModel, and
+            // paces its sends, see TransmitShaper
+            if( !job.source )
+                continue;
+
+            report.spareShare = TransmitShaper::getInstance().getSpareShare();
+            if( _queue._updateSpareShare( job.source->getNodeID(),
+                                          report.spareShare ) || decompressed )
+            {
+                report.objectID = job.sourceID;
+                job.source->send( report );
+            }
+        }
+    }
+
+private:
+    DecompressQueue& _queue;
+    const size_t _index;
+    const int32_t _affinity;
+};
+
+DecompressQueue::DecompressQueue( Node* node )
+        : _node( node )
+{}
+
+DecompressQueue::~DecompressQueue()
+{
+    LBASSERT( _threads.empty( ));
+}
+
+void DecompressQueue::start( const size_t nThreads, const int32_t affinity )
+{
+    LBASSERT( _threads.empty( ));
+    LBASSERT( nThreads > 0 );
+
+    for( size_t i = 0; i < nThreads; ++i )
+    {
+        _threads.push_back( new DecompressThread( *this, i, affinity ));
+        _threads.back()->start();
+    }
+}
+
+void DecompressQueue::exit()
+{
+    for( size_t i = 0; i < _threads.size(); ++i )
+        _jobs.push( Job( )); // wake up to exit
+
+    for( size_t i = 0; i < _threads.size(); ++i )
+    {
+        _threads[i]->join();
+        delete _threads[i];
+    }
+    _threads.clear();
+}
+
+void DecompressQueue::push( FrameDataPtr frameData, const Images& images,
+                            const uint32_t frameNumber, co::NodePtr source,
+                            const uint128_t& sourceID )
+{
+    LBASSERT( !_threads.empty( ));
+    if( !images.empty( ))
+        _jobs.push( Job( frameData, images, frameNumber, source, sourceID ));
+}
+
+bool DecompressQueue::_updateSpareShare( const uint128_t& source,
+                                         const uint32_t share )
+{
+    lunchbox::ScopedWrite mutex( _spareShares );
+    SpareShares::iterator i = _spareShares->find( source );
+    if( i != _spareShares->end() && i->second == share )
+        return false;
+
+    (*_spareShares)[ source ] = share;
+    return true;
+}
+
+}
+}
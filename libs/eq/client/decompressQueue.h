@@ -0,0 +1,107 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DECOMPRESSQUEUE_H
+#define EQ_DECOMPRESSQUEUE_H
+
+#include <eq/client/frameData.h> // Job member
+#include <co/node.h>               // Job member
+#include <lunchbox/lockable.h>
+#include <lunchbox/mtQueue.h>
+
+#include <map>
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+class DecompressThread;
+
+/**
+ * Decompresses the images received by a node using a pool of threads.
+ *
+ * Keeps the command thread of the node free to receive further images and
+ * frame data ready notifications while images are decompressed. The
+ * chunks of one image are decompressed in parallel by the image. The images
+ * of one received packet are decompressed by one thread, which sends one
+ * report of their decompression times and the spare receive rate back to the
+ * source node, if any image was decompressed or the spare rate changed.
+ *
+ * @sa FrameData::addImage(), FrameData::decompressImage()
+ */
+class DecompressQueue
+{
+public:
+    DecompressQueue( Node* node );
+    ~DecompressQueue();
+
+    /** Start the given number of threads with the given affinity. */
+    void start( const size_t nThreads, const int32_t affinity );
+
+    /** Decompress all pending images and stop the threads. */
+    void exit();
+
+    /**
+     * Decompress the images of a received packet of the given frame data.
+     *
+     * @param frameData the frame data of the images.
+     * @param images the images returned by FrameData::addImage() or
+     *               FrameData::addImages().
+     * @param frameNumber the frame number, for statistics.
+     * @param source the node which sent the images.
+     * @param sourceID the identifier of the eq::Node which sent the images.
+     */
+    void push( FrameDataPtr frameData, const Images& images,
+               const uint32_t frameNumber, co::NodePtr source,
+               const uint128_t& sourceID );
+
+private:
+    friend class DecompressThread;
+
+    struct Job
+    {
+        Job() : frameNumber( 0 ) {}
+        Job( FrameDataPtr frameData_, const Images& images_,
+             const uint32_t frameNumber_, co::NodePtr source_,
+             const uint128_t& sourceID_ )
+            : frameData( frameData_ ), images( images_ )
+            , frameNumber( frameNumber_ ), source( source_ )
+            , sourceID( sourceID_ ) {}
+
+        FrameDataPtr frameData;
+        Images images; //!< empty to exit
+        uint32_t frameNumber;
+        co::NodePtr source;
+        uint128_t sourceID;
+    };
+
+    typedef std::map< uint128_t, uint32_t > SpareShares;
+
+    Node* const _node;
+    lunchbox::MTQueue< Job > _jobs;
+    std::vector< DecompressThread* > _threads;
+
+    /** The spare share last reported to each source node. */
+    lunchbox::Lockable< SpareShares > _spareShares;
+
+    /** @return true if the spare share changed since the last report. */
+    bool _updateSpareShare( const uint128_t& source, const uint32_t share );
+};
+}
+}
+
+#endif // EQ_DECOMPRESSQUEUE_H
@@ -0,0 +1,632 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "deltaCache.h"
+
+#include "frameData.h"
+#include "image.h"
+#include "log.h"
+#include "nodePackets.h"
+#include "pixelData.h"
+#include "pixelDataWriter.h"
+
+#include <co/cpuCompressor.h>
+#include <co/plugins/compressor.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <cstring>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+// Edge length of the compared blocks in pixels
+static const int32_t _blockSize = 32;
+
+// Deltas sent before the next full image
+static const uint32_t _keyInterval = 100;
+
+/** Layout of the start of delta-encoded data, followed by the block bitmap. */
+struct DeltaHeader
+{
+    uint32_t blockSize;
+    uint32_t nBlocks;
+    uint32_t nPixels; //!< in all changed blocks
+};
+
+inline size_t _getBufferIndex( const Frame::Buffer buffer )
+{
+    return buffer == Frame::BUFFER_DEPTH ? 1 : 0;
+}
+
+/**
+ * Add the changed blocks to the chunks of a delta, compressed losslessly if a
+ * compressor exists for the pixel format. The results of the compressor are
+ * referenced by the delta.
+ */
+void _compressBlocks( co::CPUCompressor& compressor,
+                      std::vector< uint8_t >& blocks, PixelData& delta )
+{
+    delta.compressorName = EQ_COMPRESSOR_NONE;
+    if( blocks.empty( ))
+        return;
+
+    const uint32_t name =
+        co::CPUCompressor::chooseCompressor( delta.externalFormat, 1.f, false );
+    if( name <= EQ_COMPRESSOR_NONE ||
+        ( !compressor.isValid( name ) &&
+          !compressor.co::Compressor::initCompressor( name )))
+    {
+        delta.compressedData.push_back( &blocks.front( ));
+        delta.compressedSize.push_back( blocks.size( ));
+        return;
+    }
+
+    // the blocks are compressed as one row of pixels
+    const uint64_t inDims[4] = { 0, blocks.size() / delta.pixelSize, 0, 1 };
+    compressor.compress( &blocks.front(), inDims, EQ_COMPRESSOR_DATA_2D );
+
+    const unsigned nResults = compressor.getNumResults();
+    for( unsigned i = 0; i < nResults; ++i )
+    {
+        void* data = 0;
+        uint64_t size = 0;
+        compressor.getResult( i, &data, &size );
+        delta.compressedData.push_back( data );
+        delta.compressedSize.push_back( size );
+    }
+    delta.compressorName = name;
+}
+}
+
+/** The received changed blocks of one buffer, see DeltaCache::addDelta(). */
+struct DeltaBlocks
+{
+    DeltaBlocks() : compressorName( EQ_COMPRESSOR_NONE ) {}
+
+    void set( const PixelData& data )
+    {
+        compressorName = data.compressorName;
+        sizes.assign( data.compressedSize.begin() + 1,
+                      data.compressedSize.end( ));
+
+        const uint8_t* bytes =
+            static_cast< const uint8_t* >( data.compressedData[0] );
+        delta.assign( bytes, bytes + data.compressedSize[0] );
+
+        chunks.clear();
+        for( size_t i = 1; i < data.compressedData.size(); ++i )
+        {
+            bytes = static_cast< const uint8_t* >( data.compressedData[i] );
+            chunks.insert( chunks.end(), bytes,
+                           bytes + data.compressedSize[i] );
+        }
+    }
+
+    /** Decompress the changed blocks. @return false on a decoding error. */
+    bool decompress( co::CPUCompressor& decompressor, const uint32_t pixelSize,
+                     std::vector< uint8_t >& blocks ) const
+    {
+        if( delta.size() < sizeof( DeltaHeader ))
+            return false;
+
+        const DeltaHeader* header =
+            reinterpret_cast< const DeltaHeader* >( &delta[0] );
+        blocks.resize( uint64_t( header->nPixels ) * pixelSize );
+        if( blocks.empty( ))
+            return true;
+
+        if( compressorName == EQ_COMPRESSOR_NONE )
+        {
+            if( chunks.size() != blocks.size( ))
+                return false;
+            blocks = chunks;
+            return true;
+        }
+
+        if( !decompressor.isValid( compressorName ) &&
+            !decompressor.initDecompressor( compressorName ))
+        {
+            return false;
+        }
+
+        std::vector< const void* > inData( sizes.size( ));
+        uint64_t offset = 0;
+        for( size_t i = 0; i < sizes.size(); ++i )
+        {
+            inData[i] = &chunks[0] + offset;
+            offset += sizes[i];
+        }
+        if( inData.empty() || offset != chunks.size( ))
+            return false;
+
+        uint64_t outDims[4] = { 0, header->nPixels, 0, 1 };
+        decompressor.decompress( &inData.front(), &sizes.front(),
+                                 unsigned( sizes.size( )), &blocks.front(),
+                                 outDims, EQ_COMPRESSOR_DATA_2D );
+        return true;
+    }
+
+    uint32_t compressorName;
+    std::vector< uint8_t > delta;  //!< header and block bitmap
+    std::vector< uint8_t > chunks; //!< the compressed changed blocks
+    std::vector< uint64_t > sizes; //!< of each compressed chunk
+};
+
+/** The pixels of one image buffer known to both sides. */
+class DeltaReference
+{
+public:
+    DeltaReference() : _internalFormat( 0 ), _externalFormat( 0 )
+                     , _pixelSize( 0 ) {}
+
+    void set( const PixelData& data )
+    {
+        _internalFormat = data.internalFormat;
+        _externalFormat = data.externalFormat;
+        _pixelSize = data.pixelSize;
+        _pvp = data.pvp;
+        const uint8_t* pixels = static_cast< const uint8_t* >( data.pixels );
+        _pixels.assign( pixels, pixels + _getSize( ));
+    }
+
+    void invalidate() { _pixels.clear(); }
+
+    uint32_t getPixelSize() const { return _pixelSize; }
+
+    /** Fill the pixel data with the reference pixels. */
+    void get( PixelData& data )
+    {
+        data.internalFormat = _internalFormat;
+        data.externalFormat = _externalFormat;
+        data.pixelSize = _pixelSize;
+        data.pvp = _pvp;
+        data.pixels = &_pixels.front();
+        data.compressorName = EQ_COMPRESSOR_NONE;
+        data.isCompressed = false;
+    }
+
+    /**
+     * Encode the blocks of the pixel data which differ from the reference,
+     * and update the reference.
+     *
+     * @param data the new pixels.
+     * @param delta returns the header and the bitmap of the changed blocks.
+     * @param blocks returns the pixels of the changed blocks.
+     * @return false if the reference does not match the pixel data, or if
+     *         most blocks changed.
+     */
+    bool encode( const PixelData& data, std::vector< uint8_t >& delta,
+                 std::vector< uint8_t >& blocks )
+    {
+        if( _pixels.empty() || data.pvp != _pvp ||
+            data.pixelSize != _pixelSize ||
+            data.internalFormat != _internalFormat ||
+            data.externalFormat != _externalFormat )
+        {
+            return false;
+        }
+
+        const int32_t nBlocksX = ( _pvp.w + _blockSize - 1 ) / _blockSize;
+        const int32_t nBlocksY = ( _pvp.h + _blockSize - 1 ) / _blockSize;
+        const int32_t nBlocks = nBlocksX * nBlocksY;
+        const uint8_t* pixels = static_cast< const uint8_t* >( data.pixels );
+
+        std::vector< uint8_t > changed( nBlocks, 0 );
+#pragma omp parallel for
+        for( int32_t i = 0; i < nBlocks; ++i )
+            changed[i] = _compare( pixels, i, nBlocksX ) ? 0 : 1;
+
+        const size_t nWords = ( nBlocks + 31 ) / 32;
+        std::vector< uint32_t > bitmap( nWords, 0 );
+        size_t nChanged = 0;
+        for( int32_t i = 0; i < nBlocks; ++i )
+        {
+            if( !changed[i] )
+                continue;
+            bitmap[ i / 32 ] |= 1u << ( i % 32 );
+            ++nChanged;
+        }
+        if( nChanged * 2 > size_t( nBlocks ))
+            return false;
+
+        blocks.clear();
+        for( int32_t i = 0; i < nBlocks; ++i )
+        {
+            if( !changed[i] )
+                continue;
+
+            int32_t x, y, w, h;
+            _getBlock( i, nBlocksX, x, y, w, h );
+            const size_t rowSize = w * _pixelSize;
+            for( int32_t row = y; row < y + h; ++row )
+            {
+                const size_t offset = _getOffset( x, row );
+                blocks.insert( blocks.end(), pixels + offset,
+                               pixels + offset + rowSize );
+                memcpy( &_pixels[ offset ], pixels + offset, rowSize );
+            }
+        }
+
+        const DeltaHeader header = { uint32_t( _blockSize ),
+                                     uint32_t( nBlocks ),
+                                     uint32_t( blocks.size() / _pixelSize ) };
+        const uint8_t* bytes = reinterpret_cast< const uint8_t* >( &header );
+        delta.assign( bytes, bytes + sizeof( header ));
+        bytes = reinterpret_cast< const uint8_t* >( &bitmap.front( ));
+        delta.insert( delta.end(), bytes, bytes + nWords * sizeof( uint32_t ));
+        return true;
+    }
+
+    /** Patch the reference with the changed blocks. @return success. */
+    bool decode( const std::vector< uint8_t >& delta,
+                 const std::vector< uint8_t >& changed )
+    {
+        if( _pixels.empty() || delta.size() < sizeof( DeltaHeader ))
+            return false;
+
+        const DeltaHeader* header =
+            reinterpret_cast< const DeltaHeader* >( &delta[0] );
+        const int32_t nBlocksX = ( _pvp.w + _blockSize - 1 ) / _blockSize;
+        const int32_t nBlocksY = ( _pvp.h + _blockSize - 1 ) / _blockSize;
+        const int32_t nBlocks = nBlocksX * nBlocksY;
+        const size_t nWords = ( nBlocks + 31 ) / 32;
+        if( header->blockSize != uint32_t( _blockSize ) ||
+            header->nBlocks != uint32_t( nBlocks ) ||
+            delta.size() < sizeof( DeltaHeader ) + nWords * sizeof( uint32_t ))
+        {
+            return false;
+        }
+
+        const uint32_t* bitmap = reinterpret_cast< const uint32_t* >( header+1 );
+        if( changed.empty( ))
+            return header->nPixels == 0;
+
+        const uint8_t* blocks = &changed[0];
+        const uint8_t* const end = blocks + changed.size();
+        for( int32_t i = 0; i < nBlocks; ++i )
+        {
+            if( !( bitmap[ i / 32 ] & ( 1u << ( i % 32 ))))
+                continue;
+
+            int32_t x, y, w, h;
+            _getBlock( i, nBlocksX, x, y, w, h );
+            const size_t rowSize = w * _pixelSize;
+            if( blocks + rowSize * h > end )
+                return false;
+
+            for( int32_t row = y; row < y + h; ++row )
+            {
+                memcpy( &_pixels[ _getOffset( x, row ) ], blocks, rowSize );
+                blocks += rowSize;
+            }
+        }
+        return blocks == end;
+    }
+
+private:
+    uint32_t _internalFormat;
+    uint32_t _externalFormat;
+    uint32_t _pixelSize;
+    PixelViewport _pvp;
+    std::vector< uint8_t > _pixels;
+
+    size_t _getSize() const { return _pvp.getArea() * _pixelSize; }
+
+    size_t _getOffset( const int32_t x, const int32_t y ) const
+        { return ( size_t( y ) * _pvp.w + x ) * _pixelSize; }
+
+    void _getBlock( const int32_t i, const int32_t nBlocksX,
+                    int32_t& x, int32_t& y, int32_t& w, int32_t& h ) const
+    {
+        x = ( i % nBlocksX ) * _blockSize;
+        y = ( i / nBlocksX ) * _blockSize;
+        w = LB_MIN( _blockSize, _pvp.w - x );
+        h = LB_MIN( _blockSize, _pvp.h - y );
+    }
+
+    /** @return true if the block of the pixels equals the reference. */
+    bool _compare( const uint8_t* pixels, const int32_t i,
+                   const int32_t nBlocksX ) const
+    {
+        int32_t x, y, w, h;
+        _getBlock( i, nBlocksX, x, y, w, h );
+        const size_t rowSize = w * _pixelSize;
+        for( int32_t row = y; row < y + h; ++row )
+        {
+            const size_t offset = _getOffset( x, row );
+            if( memcmp( pixels + offset, &_pixels[ offset ], rowSize ) != 0 )
+                return false;
+        }
+        return true;
+    }
+};
+
+/** The references of one image sent to one destination. */
+struct DeltaSendState
+{
+    DeltaSendState() : sequence( 0 ), nDeltas( 0 ), lost( false ) {}
+
+    uint32_t sequence; //!< of the last sent image, 0 if none
+    uint32_t nDeltas;  //!< sent since the last full image
+    bool lost;         //!< the receiver lost the reference, locked
+    DeltaReference references[2];
+
+    // referenced by the writer until sent
+    std::vector< uint8_t > deltas[2];
+    std::vector< uint8_t > blocks[2];
+    co::CPUCompressor compressors[2];
+};
+
+/** The references of one received image. */
+struct DeltaReceiveState
+{
+    DeltaReceiveState() : sequence( 0 ), nReceived( 0 ), lost( false )
+                        , waiting( false ), decoded( 0 ) {}
+
+    uint32_t sequence;  //!< of the last received image, 0 if out of sync
+    uint32_t nReceived; //!< the number of received images
+    bool lost;          //!< a reference was lost and not yet reported
+    bool waiting;       //!< for a full image after a lost reference
+    lunchbox::Monitor< uint32_t > decoded; //!< the number of decoded images
+    DeltaReference references[2];
+    co::CPUCompressor decompressors[2]; //!< used in decoding order
+};
+
+/** A received image not yet decoded. */
+struct DeltaCache::Pending
+{
+    Pending() : state( 0 ), ticket( 0 ), valid( false ), delta( false ) {}
+
+    DeltaReceiveState* state;
+    uint32_t ticket; //!< the position in the received images of the state
+    bool valid;      //!< false if the delta is based on a lost reference
+    bool delta;
+    DeltaBlocks deltas[2];
+};
+
+DeltaCache::DeltaCache()
+{}
+
+DeltaCache::~DeltaCache()
+{
+    for( SendStates::const_iterator i = _sendStates.begin();
+         i != _sendStates.end(); ++i )
+    {
+        delete i->second;
+    }
+    for( ReceiveStates::const_iterator i = _receiveStates.begin();
+         i != _receiveStates.end(); ++i )
+    {
+        delete i->second;
+    }
+    for( PendingImages::const_iterator i = _pending.begin();
+         i != _pending.end(); ++i )
+    {
+        delete i->second;
+    }
+}
+
+DeltaSendState* DeltaCache::_getSendState( const uint128_t& node,
+                                           const uint32_t index )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    DeltaSendState*& state = _sendStates[ SendKey( node, index )];
+    if( !state )
+        state = new DeltaSendState;
+    return state;
+}
+
+bool DeltaCache::encode( const uint128_t& node, const uint32_t index,
+                         const Image* image, PixelDataWriter& writer,
+                         NodeFrameDataTransmitPacket& packet )
+{
+    // the transmit lock of the image serializes the sends of one image
+    DeltaSendState* state = _getSendState( node, index );
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        if( state->lost )
+        {
+            state->lost = false;
+            return false;
+        }
+    }
+    if( state->sequence == 0 || state->nDeltas >= _keyInterval )
+        return false;
+
+    const Frame::Buffer buffers[] = { Frame::BUFFER_COLOR,
+                                      Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        state->deltas[i].clear();
+        if( image->hasPixelData( buffers[i] ) &&
+            !state->references[i].encode( image->getPixelData( buffers[i] ),
+                                          state->deltas[i],
+                                          state->blocks[i] ))
+        {
+            return false;
+        }
+    }
+
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        if( !image->hasPixelData( buffer ))
+            continue;
+
+        // the bitmap chunk is followed by the chunks of the changed blocks
+        const PixelData& data = image->getPixelData( buffer );
+        PixelData delta;
+        delta.internalFormat = data.internalFormat;
+        delta.externalFormat = data.externalFormat;
+        delta.pixelSize = data.pixelSize;
+        delta.pvp = data.pvp;
+        delta.compressorFlags = DELTA_ENCODED;
+        delta.isCompressed = true;
+        delta.compressedData.push_back( &state->deltas[i].front( ));
+        delta.compressedSize.push_back( state->deltas[i].size( ));
+        _compressBlocks( state->compressors[i], state->blocks[i], delta );
+
+        writer.add( delta, image->getQuality( buffer ));
+        packet.buffers |= buffer;
+    }
+
+    packet.deltaBase = state->sequence;
+    packet.deltaSequence = ++state->sequence;
+    ++state->nDeltas;
+    return true;
+}
+
+void DeltaCache::invalidate( const uint128_t& node, const uint32_t index )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    SendStates::const_iterator i = _sendStates.find( SendKey( node, index ));
+    if( i != _sendStates.end( ))
+        i->second->lost = true;
+}
+
+void DeltaCache::setReference( const uint128_t& node, const uint32_t index,
+                               const Image* image,
+                               NodeFrameDataTransmitPacket& packet )
+{
+    DeltaSendState* state = _getSendState( node, index );
+    const Frame::Buffer buffers[] = { Frame::BUFFER_COLOR,
+                                      Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        if( image->hasPixelData( buffers[i] ))
+            state->references[i].set( image->getPixelData( buffers[i] ));
+        else
+            state->references[i].invalidate();
+    }
+
+    packet.deltaBase = 0;
+    packet.deltaSequence = ++state->sequence;
+    state->nDeltas = 0;
+}
+
+void DeltaCache::receive( const Image* image,
+                          const NodeFrameDataTransmitPacket* packet )
+{
+    LBASSERT( packet->deltaSequence != 0 );
+    lunchbox::ScopedWrite mutex( _lock );
+    DeltaReceiveState*& state = _receiveStates[ packet->imageIndex ];
+    if( !state )
+        state = new DeltaReceiveState;
+
+    Pending* pending = new Pending;
+    pending->state = state;
+    pending->ticket = ++state->nReceived;
+    pending->delta = packet->deltaBase != 0;
+    pending->valid = !pending->delta || packet->deltaBase == state->sequence;
+    if( !pending->valid && !state->waiting )
+    {
+        LBWARN << "Lost reference for delta-encoded image " << packet->pvp
+               << ", requesting a full image" << std::endl;
+        state->lost = true;
+    }
+    state->waiting = !pending->valid;
+    state->sequence = pending->valid ? packet->deltaSequence : 0;
+
+    LBASSERT( _pending.find( image ) == _pending.end( ));
+    _pending[ image ] = pending;
+}
+
+bool DeltaCache::isReferenceLost( const uint32_t index )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    ReceiveStates::const_iterator i = _receiveStates.find( index );
+    if( i == _receiveStates.end() || !i->second->lost )
+        return false;
+
+    i->second->lost = false;
+    return true;
+}
+
+void DeltaCache::addDelta( const Image* image, const Frame::Buffer buffer,
+                           const PixelData& data )
+{
+    LBASSERT( !data.compressedData.empty( ));
+    lunchbox::ScopedWrite mutex( _lock );
+    PendingImages::const_iterator i = _pending.find( image );
+    LBASSERT( i != _pending.end( ));
+    if( i != _pending.end() && i->second->valid &&
+        !data.compressedData.empty( ))
+    {
+        i->second->deltas[ _getBufferIndex( buffer )].set( data );
+    }
+}
+
+void DeltaCache::decode( Image* image )
+{
+    Pending* pending = 0;
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        PendingImages::iterator i = _pending.find( image );
+        if( i == _pending.end( ))
+            return;
+        pending = i->second;
+        _pending.erase( i );
+    }
+
+    // Preceding images were queued for decompression before this one, and
+    // never wait for it.
+    DeltaReceiveState* state = pending->state;
+    state->decoded.waitGE( pending->ticket - 1 );
+
+    const Frame::Buffer buffers[] = { Frame::BUFFER_COLOR,
+                                      Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2 && pending->valid; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        DeltaReference& reference = state->references[i];
+        if( !pending->delta )
+        {
+            if( image->hasPixelData( buffer ))
+                reference.set( image->getPixelData( buffer ));
+            else
+                reference.invalidate();
+            continue;
+        }
+
+        const DeltaBlocks& delta = pending->deltas[i];
+        if( delta.delta.empty( ))
+            continue;
+
+        std::vector< uint8_t > blocks;
+        if( !delta.decompress( state->decompressors[i],
+                               reference.getPixelSize(), blocks ) ||
+            !reference.decode( delta.delta, blocks ))
+        {
+            LBWARN << "Invalid delta-encoded image data" << std::endl;
+            reference.invalidate();
+            continue;
+        }
+
+        PixelData data;
+        reference.get( data );
+        image->setPixelData( buffer, data );
+    }
+
+    state->decoded = pending->ticket;
+    delete pending;
+}
+
+}
+}
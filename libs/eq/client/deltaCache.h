@@ -0,0 +1,144 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DELTACACHE_H
+#define EQ_DELTACACHE_H
+
+#include <eq/client/frame.h> // enum Frame::Buffer
+#include <eq/client/types.h>
+#include <lunchbox/lock.h>
+
+#include <map>
+
+namespace eq
+{
+struct NodeFrameDataTransmitPacket;
+
+namespace detail
+{
+class PixelDataWriter;
+struct DeltaSendState;
+struct DeltaReceiveState;
+
+/** Set in the compressor flags of delta-encoded data, not for plugins. */
+static const uint32_t DELTA_ENCODED = 0x40000000u;
+
+/**
+ * Encodes the images of a frame data as changes to the previous frame.
+ *
+ * The sender keeps the pixels last sent for each image and destination node,
+ * and sends only the blocks which changed since, together with a bitmap of the
+ * changed blocks. The changed blocks are compressed with the best lossless
+ * compressor for the pixel format. The receiver keeps the pixels last received
+ * for each image and patches them with the changed blocks. A full image is sent
+ * for the first frame, when most blocks changed, when the image layout changed,
+ * when the receiver reported a lost reference and periodically.
+ *
+ * Each transmitted image carries a sequence number and, for delta-encoded
+ * images, the sequence number of the image it is based on. The receiver decodes
+ * the images of one source image in the order they were received, even though
+ * they are decompressed by multiple threads.
+ */
+class DeltaCache
+{
+public:
+    DeltaCache();
+    ~DeltaCache();
+
+    /**
+     * Add the changed blocks of all buffers of an image to a writer.
+     *
+     * If false is returned, nothing was added and the full image has to be
+     * sent, followed by setReference().
+     *
+     * @param node the destination node.
+     * @param index the index of the image in the frame data.
+     * @param image the image to send.
+     * @param writer the writer receiving the delta-encoded buffers.
+     * @param packet the transmit packet, updated with the sent buffers and the
+     *               delta sequence.
+     * @return true if the delta was added.
+     */
+    bool encode( const uint128_t& node, const uint32_t index,
+                 const Image* image, PixelDataWriter& writer,
+                 NodeFrameDataTransmitPacket& packet );
+
+    /**
+     * Send a full image next, after the destination node lost the reference.
+     *
+     * @param node the destination node.
+     * @param index the index of the image in the frame data.
+     */
+    void invalidate( const uint128_t& node, const uint32_t index );
+
+    /** Use a fully sent image as the reference for the following deltas. */
+    void setReference( const uint128_t& node, const uint32_t index,
+                       const Image* image,
+                       NodeFrameDataTransmitPacket& packet );
+
+    /**
+     * Register a received image of a packet with a delta sequence.
+     *
+     * Delta-encoded buffers are not set on the image, but passed to addDelta().
+     */
+    void receive( const Image* image,
+                  const NodeFrameDataTransmitPacket* packet );
+
+    /**
+     * @return true once for each lost reference of the given image index, in
+     *         which case the sender has to be told to invalidate() it.
+     */
+    bool isReferenceLost( const uint32_t index );
+
+    /**
+     * Add the received changed blocks of a buffer of an image.
+     *
+     * The first chunk of the data has the block bitmap, the others the
+     * changed blocks compressed with the compressor of the data.
+     */
+    void addDelta( const Image* image, const Frame::Buffer buffer,
+                   const PixelData& data );
+
+    /**
+     * Decode a received image after it has been decompressed.
+     *
+     * Waits for the preceding images of the same source image. Sets the
+     * patched buffers of delta-encoded images, and stores the buffers of full
+     * images as the reference for the following deltas.
+     */
+    void decode( Image* image );
+
+private:
+    lunchbox::Lock _lock;
+
+    typedef std::pair< uint128_t, uint32_t > SendKey;
+    typedef std::map< SendKey, DeltaSendState* > SendStates;
+    SendStates _sendStates; //!< per destination node and image index
+
+    typedef std::map< uint32_t, DeltaReceiveState* > ReceiveStates;
+    ReceiveStates _receiveStates; //!< per image index
+
+    struct Pending;
+    typedef std::map< const Image*, Pending* > PendingImages;
+    PendingImages _pending; //!< received images not yet decoded
+
+    DeltaSendState* _getSendState( const uint128_t& node,
+                                   const uint32_t index );
+};
+}
+}
+
+#endif // EQ_DELTACACHE_H
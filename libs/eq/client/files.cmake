@@ -102,12 +102,15 @@ set(CLIENT_SOURCES
   client.cpp
   commandQueue.cpp
   compositor.cpp
+  compositorKernels.cpp
   computeContext.cpp
   config.cpp
   configEvent.cpp
   configParams.cpp
   configStatistics.cpp
   cudaContext.cpp
+  decompressQueue.cpp
+  deltaCache.cpp
   event.cpp
   eventHandler.cpp
   frame.cpp
@@ -125,15 +128,21 @@ set(CLIENT_SOURCES
   observer.cpp
   pipe.cpp
   pipeStatistics.cpp
+  pixelBufferPool.cpp
   pixelData.cpp
+  pixelDataWriter.cpp
   roiEmptySpaceFinder.cpp
   roiFinder.cpp
   roiTracker.cpp
   segment.cpp
   server.cpp
+  shmTransport.cpp
   statistic.cpp
   systemPipe.cpp
   systemWindow.cpp
+  transmitCostModel.cpp
+  transmitQueue.cpp
+  transmitShaper.cpp
   version.cpp
   view.cpp
   window.cpp
@@ -169,6 +169,18 @@ void Frame::useCompressor( const Frame::Buffer buffer, const uint32_t name )
         _impl->frameData->useCompressor( buffer, name );
 }
 
+void Frame::setDeltaEncoding( const bool enable )
+{
+    if( _impl->frameData )
+        _impl->frameData->setDeltaEncoding( enable );
+}
+
+void Frame::setROIDetection( const bool enable )
+{
+    if( _impl->frameData )
+        _impl->frameData->setROIDetection( enable );
+}
+
 void Frame::readback( ObjectManager* glObjects, const DrawableConfig& config )
 {
     LBASSERT( _impl->frameData );
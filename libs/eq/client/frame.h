@@ -137,6 +137,20 @@ namespace detail{ class Frame; }
         /** Sets a compressor for compression for following transmissions. */
         EQ_API void useCompressor( const Frame::Buffer buffer,
                                    const uint32_t name );
+
+        /**
+         * Enable sending only the changes to the previous frame.
+         * @sa FrameData::setDeltaEncoding()
+         * @version 1.5
+         */
+        EQ_API void setDeltaEncoding( const bool enable );
+
+        /**
+         * Enable cropping read back images to their regions of interest.
+         * @sa FrameData::setROIDetection()
+         * @version 1.5
+         */
+        EQ_API void setROIDetection( const bool enable );
         //@}
 
         /** @name Operations */
@@ -18,6 +18,7 @@
 
 #include "frameData.h"
 
+#include "deltaCache.h"
 #include "nodeStatistics.h"
 #include "channelStatistics.h"
 #include "exception.h"
@@ -26,6 +27,8 @@
 #include "nodePackets.h"
 #include "pixelData.h"
 #include "roiFinder.h"
+#include "shmTransport.h"
+#include "compressor/compressorSpan.h"
 
 #include <eq/fabric/drawableConfig.h>
 #include <eq/util/objectManager.h>
@@ -34,6 +37,7 @@
 #include <co/connectionDescription.h>
 #include <co/dataIStream.h>
 #include <co/dataOStream.h>
+#include <lunchbox/clock.h>
 #include <lunchbox/monitor.h>
 #include <lunchbox/scopedMutex.h>
 
@@ -45,6 +49,50 @@ namespace eq
 
 typedef co::CommandFunc<FrameData> CmdFunc;
 
+namespace
+{
+/** Shared memory ring and slot referenced by received images. */
+typedef std::pair< uint128_t, uint32_t > ShmSlot;
+typedef std::vector< ShmSlot > ShmSlots;
+typedef ShmSlots::const_iterator ShmSlotsCIter;
+}
+
+struct FrameData::Private
+{
+    Private() : nDecompressing( 0 ), deferredVersion( 0 ), decodedVersion( 0 )
+              , decodedZoom( false ), useDelta( false ), useROI( false ) {}
+
+    lunchbox::Lock roiLock; //!< serializes the use of _roiFinder
+
+    ShmSlots shmSlots;        //!< used by the images
+    ShmSlots pendingShmSlots; //!< used by the received images
+
+    /** Protects the received image state below. */
+    lunchbox::Lock receiveLock;
+
+    /** The number of received images not yet decompressed. */
+    uint32_t nDecompressing;
+
+    /** The version of a ready packet deferred by decompression, or 0. */
+    uint64_t deferredVersion;
+
+    /** The frame data of the deferred ready packet. */
+    Data deferredData;
+
+    /** Decompressed images of the version being received. */
+    Images decodedImages;
+    uint64_t decodedVersion;
+    bool decodedZoom; //!< any image of the decoded version is zoomed
+
+    /** Monitors incremented for each decompressed image. */
+    lunchbox::Lockable< Listeners, lunchbox::SpinLock > imageListeners;
+
+    bool useDelta;
+    detail::DeltaCache deltaCache;
+
+    bool useROI; //!< crop read back images, see cropImage()
+};
+
 FrameData::FrameData()
         : _version( co::VERSION_NONE.low( ))
         , _useAlpha( true )
@@ -52,6 +100,7 @@ FrameData::FrameData()
         , _depthQuality( 1.f )
         , _colorCompressor( EQ_COMPRESSOR_AUTO )
         , _depthCompressor( EQ_COMPRESSOR_AUTO )
+        , _private( new Private )
 {
     _roiFinder = new ROIFinder();
 }
@@ -71,6 +120,7 @@ FrameData::~FrameData()
 
     delete _roiFinder;
     _roiFinder = 0;
+    delete _private;
 }
 
 void FrameData::setQuality( Frame::Buffer buffer, float quality )
@@ -97,6 +147,31 @@ void FrameData::useCompressor( const Frame::Buffer buffer, const uint32_t name )
     _colorCompressor = name;
 }
 
+void FrameData::setDeltaEncoding( const bool enable )
+{
+    _private->useDelta = enable;
+}
+
+bool FrameData::getDeltaEncoding() const
+{
+    return _private->useDelta;
+}
+
+detail::DeltaCache& FrameData::getDeltaCache()
+{
+    return _private->deltaCache;
+}
+
+void FrameData::setROIDetection( const bool enable )
+{
+    _private->useROI = enable;
+}
+
+bool FrameData::getROIDetection() const
+{
+    return _private->useROI;
+}
+
 void FrameData::getInstanceData( co::DataOStream& os )
 {
     LBUNREACHABLE;
@@ -146,6 +221,14 @@ void FrameData::clear()
     _imageCache.insert( _imageCache.end(), _images.begin(), _images.end( ));
     _imageCacheLock.unset();
     _images.clear();
+
+    detail::ShmTransport& shm = detail::ShmTransport::getInstance();
+    for( ShmSlotsCIter i = _private->shmSlots.begin();
+         i != _private->shmSlots.end(); ++i )
+    {
+        shm.release( i->first, i->second );
+    }
+    _private->shmSlots.clear();
 }
 
 void FrameData::flush()
@@ -320,6 +403,32 @@ Images FrameData::startReadback( const Frame& frame,
     return images;
 }
 
+void FrameData::cropImage( Image* image, const uint32_t frameNumber )
+{
+    if( !_private->useROI || _private->useDelta ||
+        !( _data.buffers & Frame::BUFFER_DEPTH ) ||
+        !image->hasPixelData( Frame::BUFFER_DEPTH ))
+    {
+        return;
+    }
+
+    PixelViewports regions;
+    {
+        lunchbox::ScopedWrite mutex( _private->roiLock );
+        regions = _roiFinder->findRegions( *image, 0,
+                                           uint128_t( 0, frameNumber ));
+    }
+    if( regions.empty( ))
+        return;
+
+    PixelViewport pvp = regions.front();
+    for( PixelViewportsCIter i = regions.begin() + 1; i != regions.end(); ++i )
+        pvp.merge( *i );
+
+    if( image->crop( pvp ))
+        LBLOG( LOG_ASSEMBLY ) << "Cropped image to " << pvp << std::endl;
+}
+
 void FrameData::setVersion( const uint64_t version )
 {
     LBASSERTINFO( _version <= version, _version << " > " << version );
@@ -340,19 +449,38 @@ void FrameData::setReady()
 
 void FrameData::setReady( const NodeFrameDataReadyPacket* packet )
 {
-    clear();
     LBASSERT(  packet->frameData.version.high() == 0 );
     LBASSERT( _readyVersion < packet->frameData.version.low( ));
     LBASSERT( _readyVersion == 0 ||
               _readyVersion + 1 == packet->frameData.version.low( ));
     LBASSERT( _version == packet->frameData.version.low( ));
+    {
+        lunchbox::ScopedWrite mutex( _private->receiveLock );
+        LBASSERT( _private->deferredVersion == 0 );
+        if( _private->nDecompressing > 0 )
+        {
+            // the last decompressImage() sets the frame data ready
+            _private->deferredData = packet->data;
+            _private->deferredVersion = packet->frameData.version.low();
+            return;
+        }
+    }
+    _setReceivedReady( packet->data, packet->frameData.version.low( ));
+}
 
+void FrameData::_setReceivedReady( const Data& data, const uint64_t version )
+{
+    clear();
     _images.swap( _pendingImages );
-    _data = packet->data;
-    _setReady( packet->frameData.version.low());
+    _private->shmSlots.swap( _private->pendingShmSlots );
+    {
+        lunchbox::ScopedWrite mutex( _private->receiveLock );
+        _private->decodedImages.clear();
+    }
+    _data = data;
+    _setReady( version );
 
-    LBLOG( LOG_ASSEMBLY ) << this << " applied v"
-                          << packet->frameData.version.low() << std::endl;
+    LBLOG( LOG_ASSEMBLY ) << this << " applied v" << version << std::endl;
 }
 
 void FrameData::_setReady( const uint64_t version )
@@ -397,25 +525,106 @@ void FrameData::removeListener( lunchbox::Monitor<uint32_t>& listener )
     _listeners->erase( i );
 }
 
-bool FrameData::addImage( const NodeFrameDataTransmitPacket* packet )
+void FrameData::addImageListener( lunchbox::Monitor<uint32_t>& listener )
 {
-    Image* image = _allocImage( Frame::TYPE_MEMORY, DrawableConfig(),
-                                false /* set quality */ );
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex(
+        _private->imageListeners );
+    _private->imageListeners->push_back( &listener );
+}
+
+void FrameData::removeImageListener( lunchbox::Monitor<uint32_t>& listener )
+{
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex(
+        _private->imageListeners );
+
+    Listeners::iterator i = std::find( _private->imageListeners->begin(),
+                                       _private->imageListeners->end(),
+                                       &listener );
+    LBASSERT( i != _private->imageListeners->end( ));
+    _private->imageListeners->erase( i );
+}
 
+void FrameData::getDecodedImages( Images& images )
+{
+    lunchbox::ScopedWrite mutex( _private->receiveLock );
+    if( _private->decodedVersion == _version &&
+        _readyVersion.get() < _version && !_private->decodedZoom )
+    {
+        images = _private->decodedImages;
+    }
+    else
+        images.clear();
+}
+
+Image* FrameData::addImage( const NodeFrameDataTransmitPacket* packet )
+{
+    uint8_t* data = _getImageData( packet );
+    return _addImage( packet, data, packet->shmSlot != LB_UNDEFINED_UINT32 );
+}
+
+void FrameData::addImages( const NodeFrameDataTransmitPacket* packet,
+                           Images& images )
+{
+    uint8_t* data = _getImageData( packet );
+    if( !data )
+        return;
+
+    // each image is a packet without the command header, see
+    // Channel::_transmitImage
+    const bool useShm = packet->shmSlot != LB_UNDEFINED_UINT32;
+    for( uint32_t i = 0; i < packet->nImages; ++i )
+    {
+        const NodeFrameDataTransmitPacket* imagePacket =
+            reinterpret_cast< const NodeFrameDataTransmitPacket* >( data );
+        LBASSERT( imagePacket->nImages == 0 );
+        images.push_back( _addImage( imagePacket,
+                               const_cast< uint8_t* >( imagePacket->data ),
+                               useShm ));
+        data += imagePacket->size;
+    }
+}
+
+uint8_t* FrameData::_getImageData( const NodeFrameDataTransmitPacket* packet )
+{
     // Note on the const_cast: since the PixelData structure stores non-const
     // pointers, we have to go non-const at some point, even though we do not
     // modify the data.
-    uint8_t* data  = const_cast< uint8_t* >( packet->data );
+    if( packet->shmSlot == LB_UNDEFINED_UINT32 )
+        return const_cast< uint8_t* >( packet->data );
+
+    // the slot is released when the image is no longer used, see clear()
+    uint8_t* data = detail::ShmTransport::getInstance().getData(
+        packet->shmRing, packet->shmSlot );
+    if( data )
+    {
+        lunchbox::ScopedWrite mutex( _private->receiveLock );
+        _private->pendingShmSlots.push_back( ShmSlot( packet->shmRing,
+                                                      packet->shmSlot ));
+    }
+    else
+        LBERROR << "Lost image data in shared memory" << std::endl;
+    return data;
+}
+
+Image* FrameData::_addImage( const NodeFrameDataTransmitPacket* packet,
+                             uint8_t* data, const bool useShm )
+{
+    Image* image = _allocImage( Frame::TYPE_MEMORY, DrawableConfig(),
+                                false /* set quality */ );
+    const uint32_t received = data ? packet->buffers :
+                                     uint32_t( Frame::BUFFER_NONE );
 
     image->setPixelViewport( packet->pvp );
     image->setAlphaUsage( packet->useAlpha );
+    if( packet->deltaSequence != 0 )
+        _private->deltaCache.receive( image, packet );
 
     Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
     for( unsigned i = 0; i < 2; ++i )
     {
         const Frame::Buffer buffer = buffers[i];
 
-        if( packet->buffers & buffer )
+        if( received & buffer )
         {
             PixelData pixelData;
             const ImageHeader* header = reinterpret_cast<ImageHeader*>( data );
@@ -431,19 +640,30 @@ bool FrameData::addImage( const NodeFrameDataTransmitPacket* packet )
             const uint32_t nChunks    = header->nChunks;
             data += sizeof( ImageHeader );
 
-            if( pixelData.isCompressed )
+            image->setZoom( packet->zoom );
+            image->setQuality( buffer, header->quality );
+
+            const bool isDelta =
+                ( pixelData.compressorFlags & detail::DELTA_ENCODED ) != 0;
+            if( pixelData.isCompressed || isDelta )
             {
-                pixelData.compressedSize.resize( nChunks );
-                pixelData.compressedData.resize( nChunks );
+                // chunk sizes followed by the chunks, see PixelDataWriter
+                const uint64_t* sizes = reinterpret_cast< uint64_t* >( data );
+                data += nChunks * sizeof( uint64_t );
 
+                pixelData.compressedSize.assign( sizes, sizes + nChunks );
+                pixelData.compressedData.resize( nChunks );
                 for( uint32_t j = 0; j < nChunks; ++j )
                 {
-                    const uint64_t size = *reinterpret_cast< uint64_t*>( data );
-                    data += sizeof( uint64_t );
-
-                    pixelData.compressedSize[j] = size;
                     pixelData.compressedData[j] = data;
-                    data += size;
+                    data += sizes[j];
+                }
+
+                if( isDelta )
+                {
+                    // patches the previous image, see decompressImage()
+                    _private->deltaCache.addDelta( image, buffer, pixelData );
+                    continue;
                 }
             }
             else
@@ -455,15 +675,82 @@ bool FrameData::addImage( const NodeFrameDataTransmitPacket* packet )
                 LBASSERT( size == pixelData.pvp.getArea()*pixelData.pixelSize );
             }
 
-            image->setZoom( packet->zoom );
-            image->setQuality( buffer, header->quality );
-            image->setPixelData( buffer, pixelData );
+            if( useShm )
+                image->referencePixelData( buffer, pixelData );
+            else
+                image->setCompressedPixelData( buffer, pixelData );
         }
     }
 
     LBASSERT( _readyVersion < packet->frameData.version.low( ));
+    lunchbox::ScopedWrite mutex( _private->receiveLock );
+    LBASSERT( _private->deferredVersion == 0 );
     _pendingImages.push_back( image );
-    return true;
+    if( _private->decodedVersion != packet->frameData.version.low( ))
+    {
+        _private->decodedVersion = packet->frameData.version.low();
+        _private->decodedZoom = false;
+    }
+    if( packet->zoom != Zoom::NONE )
+        _private->decodedZoom = true;
+    ++_private->nDecompressing;
+    return image;
+}
+
+void FrameData::decompressImage( Image* image,
+                                 NodeFrameDataDecompressPacket& times )
+{
+    Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        if( !image->hasPixelData( buffer ) ||
+            !image->hasCompressedPixelData( buffer ))
+        {
+            continue;
+        }
+
+        // span compressed data is merged directly by the CPU compositor
+        const uint32_t name =
+            image->getCompressedPixelData( buffer ).compressorName;
+        if( plugin::CompressorSpan::isSpanCompressor( name ))
+            continue;
+
+        lunchbox::Clock clock;
+        image->decompressPixelData( buffer );
+        times.compressors[i] = name;
+        times.sizes[i] = image->getPixelDataSize( buffer );
+        times.times[i] = clock.getTimef();
+    }
+    _private->deltaCache.decode( image );
+
+    {
+        lunchbox::ScopedWrite mutex( _private->receiveLock );
+        _private->decodedImages.push_back( image );
+    }
+    {
+        lunchbox::ScopedMutex< lunchbox::SpinLock > mutex(
+            _private->imageListeners );
+        for( Listeners::iterator i = _private->imageListeners->begin();
+             i != _private->imageListeners->end(); ++i )
+        {
+            ++(**i);
+        }
+    }
+
+    Data data;
+    uint64_t version = 0;
+    {
+        lunchbox::ScopedWrite mutex( _private->receiveLock );
+        LBASSERT( _private->nDecompressing > 0 );
+        if( --_private->nDecompressing > 0 || _private->deferredVersion == 0 )
+            return;
+
+        data = _private->deferredData;
+        version = _private->deferredVersion;
+        _private->deferredVersion = 0;
+    }
+    _setReceivedReady( data, version );
 }
 
 std::ostream& operator << ( std::ostream& os, const FrameData& data )
@@ -33,10 +33,12 @@
 namespace eq
 {
 namespace server { class FrameData; }
+namespace detail { class DeltaCache; }
 
     class  ROIFinder;
     struct NodeFrameDataTransmitPacket;
     struct NodeFrameDataReadyPacket;
+    struct NodeFrameDataDecompressPacket;
 
     /**
      * A holder for multiple images.
@@ -186,6 +188,46 @@ namespace server { class FrameData; }
          * @param name the compressor name.
          */
         void useCompressor( const Frame::Buffer buffer, const uint32_t name );
+
+        /** @internal @return the compressor set for the buffer. */
+        uint32_t getCompressor( const Frame::Buffer buffer ) const
+            { return buffer == Frame::BUFFER_DEPTH ? _depthCompressor :
+                                                     _colorCompressor; }
+
+        /**
+         * Enable sending only the changes to the previous frame.
+         *
+         * When enabled, transmitted images are compared block-wise with the
+         * image previously sent to the same destination, and only the changed
+         * blocks are sent. The receiver patches its copy of the previous image.
+         * This reduces the network and compression cost of mostly static
+         * scenes, at the expense of memory for the previous images. Disabled
+         * by default.
+         * @version 1.5
+         */
+        EQ_API void setDeltaEncoding( const bool enable );
+
+        /** @return true if delta encoding is enabled. @version 1.5 */
+        EQ_API bool getDeltaEncoding() const;
+
+        /** @internal @return the state of the delta encoding. */
+        EQ_API detail::DeltaCache& getDeltaCache();
+
+        /**
+         * Enable cropping read back images to their regions of interest.
+         *
+         * When enabled, the depth buffer of each image read back into main
+         * memory is searched for the area not on the far plane, and the image
+         * is cropped to it before it is transmitted. This reduces the
+         * transmission and compositing cost of images which cover only a part
+         * of the frame, e.g., in database decompositions, at the expense of a
+         * pass over the depth buffer for each image. Disabled by default.
+         * @version 1.5
+         */
+        EQ_API void setROIDetection( const bool enable );
+
+        /** @return true if ROI detection is enabled. @version 1.5 */
+        EQ_API bool getROIDetection() const;
         //@}
 
         /** @name Operations */
@@ -285,6 +327,30 @@ namespace server { class FrameData; }
          * @version 1.0
          */
         void removeListener( lunchbox::Monitor<uint32_t>& listener );
+
+        /**
+         * @internal
+         * Add a listener incremented for each received image decompressed
+         * before the frame data is ready.
+         *
+         * @sa getDecodedImages()
+         */
+        void addImageListener( lunchbox::Monitor<uint32_t>& listener );
+
+        /** @internal Remove a listener added with addImageListener(). */
+        void removeImageListener( lunchbox::Monitor<uint32_t>& listener );
+
+        /**
+         * @internal
+         * Get the received images of the current version which are
+         * decompressed while the frame data is not yet ready.
+         *
+         * Large images are received as independent strips, which allows
+         * compositing to start before all images arrived. The images are
+         * part of getImages() once the frame data is ready. No images are
+         * returned if any image of the version is zoomed.
+         */
+        void getDecodedImages( Images& images );
         
         /** 
          * Disable the usage of a frame buffer attachment for all images.
@@ -296,9 +362,57 @@ namespace server { class FrameData; }
             { _data.buffers &= ~buffer; }
          //@}
 
-        /** @internal */
-        bool addImage( const NodeFrameDataTransmitPacket* packet );
-        void setReady( const NodeFrameDataReadyPacket* packet ); //!< @internal
+        /**
+         * @internal
+         * Add a received image without decompressing it.
+         *
+         * The frame data is set ready only after the image has been passed to
+         * decompressImage().
+         *
+         * @return the new image.
+         */
+        Image* addImage( const NodeFrameDataTransmitPacket* packet );
+
+        /**
+         * @internal
+         * Add all received images of a batched packet, see addImage().
+         *
+         * @param packet the packet with a batch of images.
+         * @param images returns the new images.
+         */
+        void addImages( const NodeFrameDataTransmitPacket* packet,
+                        Images& images );
+
+        /**
+         * @internal
+         * Crop a read back image to its regions of interest.
+         *
+         * Only images with depth are cropped if ROI detection is enabled,
+         * since the background of color images is not known. Images are not
+         * cropped when delta encoding is used, which needs the same pixel
+         * viewport each frame.
+         *
+         * @param image the image in main memory.
+         * @param frameNumber the current frame number.
+         */
+        void cropImage( Image* image, const uint32_t frameNumber );
+
+        /**
+         * @internal
+         * Decompress an image returned by addImage().
+         *
+         * @param image the received image.
+         * @param times returns the decompression time of each buffer, for
+         *              the source of the image.
+         */
+        void decompressImage( Image* image,
+                              NodeFrameDataDecompressPacket& times );
+
+        /**
+         * @internal
+         * Set the received images ready, once all are decompressed.
+         */
+        void setReady( const NodeFrameDataReadyPacket* packet );
 
     protected:
         virtual ChangeType getChangeType() const { return INSTANCE; }
@@ -365,12 +479,22 @@ namespace server { class FrameData; }
                             const DrawableConfig& config,
                             const bool setQuality );
 
+        /** @return the image data of a received packet, or 0 if lost. */
+        uint8_t* _getImageData( const NodeFrameDataTransmitPacket* packet );
+
+        /** Add an image from the given packet and image data. */
+        Image* _addImage( const NodeFrameDataTransmitPacket* packet,
+                          uint8_t* data, const bool useShm );
+
         /** Apply all received images of the given version. */
         void _applyVersion( const uint128_t& version );
 
         /** Set a specific version ready. */
         void _setReady( const uint64_t version );
 
+        /** Apply the received images of the given version and set it ready */
+        void _setReceivedReady( const Data& data, const uint64_t version );
+
         LB_TS_VAR( _commandThread );
     };
 
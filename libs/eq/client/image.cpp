@@ -20,8 +20,11 @@
 
 #include "gl.h"
 #include "log.h"
+#include "pixelBufferPool.h"
 #include "pixelData.h"
+#include "pixelStrips.h"
 #include "windowSystem.h"
+#include "compressor/compressorSpan.h"
 
 #include <eq/util/frameBufferObject.h>
 #include <eq/util/objectManager.h>
@@ -34,8 +37,10 @@
 #include <co/plugin.h>
 #include <co/pluginRegistry.h>
 
+#include <lunchbox/lock.h>
 #include <lunchbox/memoryMap.h>
 #include <lunchbox/omp.h>
+#include <lunchbox/scopedMutex.h>
 
 // Internal headers
 #include "../util/gpuCompressor.h"
@@ -66,6 +71,7 @@ public:
         PixelData::reset();
         state = INVALID;
         localBuffer.clear();
+        compressedBuffer.clear();
         hasAlpha = true;
     }
 
@@ -84,14 +90,24 @@ public:
     {
         INVALID,
         VALID,
-        DOWNLOAD // async RB is in progress
+        DOWNLOAD, // async RB is in progress
+        COMPRESSED // only compressedData is set, decompressed on first use
     };
 
     State state;   //!< The current state of the memory
 
     /** During the call of setPixelData or writeImage, we have to
         manage an internal buffer to copy the data */
-    lunchbox::Bufferb localBuffer;
+    detail::PixelBuffer localBuffer;
+
+    /** Copy of the compressed data in the COMPRESSED state. */
+    detail::PixelBuffer compressedBuffer;
+
+    /** Protects the state during the decompression of COMPRESSED memory. */
+    lunchbox::Lock lock;
+
+    /** The strip table chunk of strip-compressed data, see _compressStrips */
+    std::vector< uint32_t > strips;
 
     bool hasAlpha; //!< The uncompressed pixels contain alpha
 };
@@ -116,6 +132,9 @@ struct Attachment
     /** Current pixel data (memory images). */
     Memory memory;
 
+    /** The CPU (de)compressors of the strips of strip-compressed data. */
+    std::vector< co::CPUCompressor* > stripCompressors;
+
     Attachment()
             : compressor( &fullCompressor )
             , transfer ( &fullTransfer )
@@ -129,6 +148,7 @@ struct Attachment
         LBASSERT( !lossyCompressor.isValid( lossyCompressor.getName( )));
         LBASSERT( !fullTransfer.isValid( fullTransfer.getName( )));
         LBASSERT( !lossyTransfer.isValid( lossyTransfer.getName( )));
+        LBASSERT( stripCompressors.empty( ));
     }
 
     void flush()
@@ -144,6 +164,21 @@ struct Attachment
         lossyCompressor.reset();
         fullTransfer.reset();
         lossyTransfer.reset();
+
+        for( size_t i = 0; i < stripCompressors.size(); ++i )
+        {
+            stripCompressors[i]->reset();
+            delete stripCompressors[i];
+        }
+        stripCompressors.clear();
+    }
+
+    /** @return the (de)compressor of the given strip. */
+    co::CPUCompressor& getStripCompressor( const size_t i )
+    {
+        while( stripCompressors.size() <= i )
+            stripCompressors.push_back( new co::CPUCompressor );
+        return *stripCompressors[ i ];
     }
 };
 
@@ -157,6 +192,193 @@ static bool _allocDecompressor( Attachment& attachment, uint32_t name )
     }
     return true;
 }
+
+/** @return the number of strips of compressed memory. */
+static size_t _getNStrips( const Memory& memory )
+{
+    if( !memory.isCompressed ||
+        !( memory.compressorFlags & detail::STRIP_COMPRESSED ))
+    {
+        return 1;
+    }
+    return memory.strips[0];
+}
+
+/** @return the first row of the given strip. */
+static int32_t _getStripStart( const size_t strip, const size_t nStrips,
+                               const int32_t height )
+{
+    return int32_t( uint64_t( height ) * strip / nStrips );
+}
+
+/**
+ * Compress the memory in horizontal strips in parallel.
+ *
+ * The compressed data starts with a chunk containing the strip table, the
+ * number of strips followed by the height and the number of chunks of each
+ * strip. It is followed by the chunks of all strips. The table is only used
+ * in memory, see detail::STRIP_COMPRESSED.
+ *
+ * @return false if a strip compressor could not be instantiated.
+ */
+static bool _compressStrips( Attachment& attachment, const size_t nStrips )
+{
+    Memory& memory = attachment.memory;
+    const uint32_t name = memory.compressorName;
+    for( size_t i = 0; i < nStrips; ++i )
+    {
+        co::CPUCompressor& compressor = attachment.getStripCompressor( i );
+        if( !compressor.isValid( name ) &&
+            !compressor.co::Compressor::initCompressor( name ))
+        {
+            return false;
+        }
+    }
+
+    const PixelViewport& pvp = memory.pvp;
+    const uint64_t rowSize = uint64_t( pvp.w ) * memory.pixelSize;
+    uint8_t* const pixels = reinterpret_cast< uint8_t* >( memory.pixels );
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nStrips ); ++i )
+    {
+        const int32_t y = _getStripStart( i, nStrips, pvp.h );
+        const int32_t end = _getStripStart( i + 1, nStrips, pvp.h );
+        const uint64_t inDims[4] = { pvp.x, pvp.w, pvp.y + y, end - y };
+        attachment.stripCompressors[i]->compress( pixels + y * rowSize, inDims,
+                                                  memory.compressorFlags );
+    }
+
+    memory.strips.resize( 1 + 2 * nStrips );
+    memory.strips[0] = uint32_t( nStrips );
+    memory.compressedData.resize( 1 );
+    memory.compressedSize.resize( 1 );
+    for( size_t i = 0; i < nStrips; ++i )
+    {
+        co::CPUCompressor* compressor = attachment.stripCompressors[i];
+        const unsigned nResults = compressor->getNumResults();
+        memory.strips[ 1 + 2 * i ] = _getStripStart( i + 1, nStrips, pvp.h ) -
+                                     _getStripStart( i, nStrips, pvp.h );
+        memory.strips[ 2 + 2 * i ] = nResults;
+
+        for( unsigned j = 0; j < nResults; ++j )
+        {
+            void* data;
+            uint64_t size;
+            compressor->getResult( j, &data, &size );
+            memory.compressedData.push_back( data );
+            memory.compressedSize.push_back( size );
+        }
+    }
+    memory.compressedData[0] = &memory.strips.front();
+    memory.compressedSize[0] = memory.strips.size() * sizeof( uint32_t );
+    memory.compressorFlags |= detail::STRIP_COMPRESSED;
+    return true;
+}
+
+/** Decompress strip-compressed data into the memory in parallel. */
+static bool _decompressStrips( Attachment& attachment, const PixelData& data )
+{
+    const detail::PixelStrips& strips = detail::getPixelStrips( data );
+    const size_t nStrips = strips.size();
+    for( size_t i = 0; i < nStrips; ++i )
+    {
+        co::CPUCompressor& compressor = attachment.getStripCompressor( i );
+        if( !compressor.isValid( data.compressorName ) &&
+            !compressor.initDecompressor( data.compressorName ))
+        {
+            return false;
+        }
+    }
+
+    Memory& memory = attachment.memory;
+    const PixelViewport& pvp = memory.pvp;
+    const uint64_t rowSize = uint64_t( pvp.w ) * memory.pixelSize;
+    uint8_t* const pixels = reinterpret_cast< uint8_t* >( memory.pixels );
+    const uint32_t flags = data.compressorFlags & ~detail::STRIP_COMPRESSED;
+#pragma omp parallel for
+    for( ssize_t i = 0; i < ssize_t( nStrips ); ++i )
+    {
+        const detail::PixelStrip& strip = strips[i];
+        uint64_t outDims[4] = { pvp.x, pvp.w, pvp.y + strip.y, strip.h };
+        attachment.stripCompressors[i]->decompress(
+            &data.compressedData[ strip.chunk ],
+            &data.compressedSize[ strip.chunk ], unsigned( strip.nChunks ),
+            pixels + strip.y * rowSize, outDims, flags );
+    }
+    return true;
+}
+
+/** Decompress memory in the COMPRESSED state. */
+static void _decompress( Attachment& attachment )
+{
+    // Images may be shared by all pipes of a node. The state is only read
+    // under the lock, which also publishes the decompressed pixels to the
+    // threads waiting for them.
+    Memory& memory = attachment.memory;
+    lunchbox::ScopedWrite mutex( &memory.lock );
+    if( memory.state != Memory::COMPRESSED )
+        return;
+
+    // compressedData stays valid, e.g., for sending the image again
+    memory.useLocalBuffer();
+
+    if( memory.compressorFlags & detail::STRIP_COMPRESSED )
+        LBCHECK( _decompressStrips( attachment, memory ));
+    else
+    {
+        uint64_t outDims[4] = { memory.pvp.x, memory.pvp.w,
+                                memory.pvp.y, memory.pvp.h };
+        const uint64_t nBlocks = memory.compressedSize.size();
+        attachment.compressor->decompress( &memory.compressedData.front(),
+                                           &memory.compressedSize.front(),
+                                           nBlocks, memory.pixels, outDims,
+                                           memory.compressorFlags );
+    }
+    memory.state = Memory::VALID;
+}
+
+/**
+ * Reduce valid memory to a part of its pixel viewport.
+ *
+ * The area is relative to the pixel viewport of the image, which has the same
+ * size but not necessarily the same position as the pixel viewport of the
+ * memory, see Image::setOffset().
+ */
+static void _crop( Attachment& attachment, const PixelViewport& area )
+{
+    Memory& memory = attachment.memory;
+    if( memory.state != Memory::VALID && memory.state != Memory::COMPRESSED )
+        return;
+
+    _decompress( attachment );
+
+    const uint64_t srcRowSize = memory.pvp.w * memory.pixelSize;
+    const uint64_t dstRowSize = area.w * memory.pixelSize;
+    const uint8_t* src = reinterpret_cast< const uint8_t* >( memory.pixels ) +
+                         area.y * srcRowSize + area.x * memory.pixelSize;
+
+    if( memory.pixels == memory.localBuffer.getData( ))
+    {
+        // rows only move to lower addresses
+        uint8_t* dst = memory.localBuffer.getData();
+        for( int32_t y = 0; y < area.h; ++y )
+            memmove( dst + y * dstRowSize, src + y * srcRowSize, dstRowSize );
+        memory.localBuffer.resize( area.h * dstRowSize );
+    }
+    else // referenced data, copy cropped rows
+    {
+        uint8_t* dst = memory.localBuffer.resize( area.h * dstRowSize );
+        for( int32_t y = 0; y < area.h; ++y )
+            memcpy( dst + y * dstRowSize, src + y * srcRowSize, dstRowSize );
+    }
+
+    memory.pixels = memory.localBuffer.getData();
+    memory.pvp.x += area.x;
+    memory.pvp.y += area.y;
+    memory.pvp.w = area.w;
+    memory.pvp.h = area.h;
+    memory.isCompressed = false;
+}
 }
 
 namespace detail
@@ -181,6 +403,9 @@ public:
     /** Alpha channel significance. */
     bool ignoreAlpha;
 
+    /** Serializes transmissions of the image to different nodes. */
+    lunchbox::Lock transmitLock;
+
     Attachment& getAttachment( const eq::Frame::Buffer buffer )
     {
         switch( buffer )
@@ -364,6 +589,32 @@ std::vector< uint32_t > Image::findCompressors( const Frame::Buffer buffer )
     return names;
 }
 
+void Image::findCompressors( const Frame::Buffer buffer,
+                             co::CompressorInfos& result ) const
+{
+    const co::PluginRegistry& registry = co::Global::getPluginRegistry();
+    const co::Plugins& plugins = registry.getPlugins();
+    const uint32_t tokenType = getExternalFormat( buffer );
+    const Attachment& attachment = _impl->getAttachment( buffer );
+    const float quality = attachment.quality /
+                          attachment.lossyTransfer.getQuality();
+
+    for( co::Plugins::const_iterator i = plugins.begin();
+         i != plugins.end(); ++i )
+    {
+        const co::CompressorInfos& infos = (*i)->getInfos();
+        for( co::CompressorInfosCIter j = infos.begin(); j != infos.end(); ++j )
+        {
+            const co::CompressorInfo& info = *j;
+            if( !( info.capabilities & EQ_COMPRESSOR_TRANSFER ) &&
+                info.tokenType == tokenType && info.quality >= quality )
+            {
+                result.push_back( info );
+            }
+        }
+    }
+}
+
 void Image::findTransferers( const Frame::Buffer buffer,
                              const GLEWContext* glewContext,
                              std::vector< uint32_t >& names )
@@ -454,18 +705,34 @@ const util::Texture& Image::getTexture( const Frame::Buffer buffer ) const
 const uint8_t* Image::getPixelPointer( const Frame::Buffer buffer ) const
 {
     LBASSERT( hasPixelData( buffer ));
+    _decompress( _impl->getAttachment( buffer ));
     return reinterpret_cast< const uint8_t* >( _impl->getMemory( buffer ).pixels );
 }
 
 uint8_t* Image::getPixelPointer( const Frame::Buffer buffer )
 {
     LBASSERT( hasPixelData( buffer ));
+    _decompress( _impl->getAttachment( buffer ));
     return  reinterpret_cast< uint8_t* >( _impl->getMemory( buffer ).pixels );
 }
 
 const PixelData& Image::getPixelData( const Frame::Buffer buffer ) const
 {
     LBASSERT( hasPixelData( buffer ));
+    _decompress( _impl->getAttachment( buffer ));
+    return _impl->getMemory( buffer );
+}
+
+bool Image::hasCompressedPixelData( const Frame::Buffer buffer ) const
+{
+    const Memory& memory = _impl->getMemory( buffer );
+    return memory.isCompressed && memory.state != Memory::INVALID;
+}
+
+const PixelData& Image::getCompressedPixelData( const Frame::Buffer buffer )
+    const
+{
+    LBASSERT( hasCompressedPixelData( buffer ));
     return _impl->getMemory( buffer );
 }
 
@@ -782,6 +1049,37 @@ void Image::setPixelViewport( const PixelViewport& pvp )
     _impl->depth.memory.isCompressed = false;
 }
 
+bool Image::crop( const PixelViewport& pvp )
+{
+    PixelViewport area = pvp;
+    area.intersect( _impl->pvp );
+    if( !area.hasArea() || area == _impl->pvp ||
+        _impl->type != Frame::TYPE_MEMORY || hasAsyncReadback( ))
+    {
+        return false;
+    }
+
+    // zoomed buffers do not have the size of the image
+    const Frame::Buffer buffers[] = { Frame::BUFFER_COLOR,
+                                      Frame::BUFFER_DEPTH };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const PixelViewport& dataPVP = _impl->getMemory( buffers[i] ).pvp;
+        if( hasPixelData( buffers[i] ) &&
+            ( dataPVP.w != _impl->pvp.w || dataPVP.h != _impl->pvp.h ))
+        {
+            return false;
+        }
+    }
+
+    const PixelViewport relative( area.x - _impl->pvp.x,
+                                  area.y - _impl->pvp.y, area.w, area.h );
+    _crop( _impl->color, relative );
+    _crop( _impl->depth, relative );
+    _impl->pvp = area;
+    return true;
+}
+
 void Image::clearPixelData( const Frame::Buffer buffer )
 {
     Memory& memory = _impl->getAttachment( buffer ).memory;
@@ -830,6 +1128,29 @@ void Image::validatePixelData( const Frame::Buffer buffer )
 }
 
 void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
+{
+    _setPixelData( buffer, pixels, false, true );
+}
+
+void Image::setCompressedPixelData( const Frame::Buffer buffer,
+                                    const PixelData& pixels )
+{
+    _setPixelData( buffer, pixels, true, true );
+}
+
+void Image::referencePixelData( const Frame::Buffer buffer,
+                                const PixelData& pixels )
+{
+    _setPixelData( buffer, pixels, true, false );
+}
+
+void Image::decompressPixelData( const Frame::Buffer buffer )
+{
+    _decompress( _impl->getAttachment( buffer ));
+}
+
+void Image::_setPixelData( const Frame::Buffer buffer, const PixelData& pixels,
+                           const bool keepCompressed, const bool copy )
 {
     Memory& memory = _impl->getMemory( buffer );
     memory.externalFormat = pixels.externalFormat;
@@ -868,6 +1189,13 @@ void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
 
     if( pixels.compressorName <= EQ_COMPRESSOR_NONE )
     {
+        if( !copy && pixels.pixels )
+        {
+            memory.pixels = pixels.pixels;
+            memory.state = Memory::VALID;
+            return;
+        }
+
         validatePixelData( buffer ); // alloc memory for pixels
 
         if( pixels.pixels )
@@ -901,13 +1229,59 @@ void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
         memory.externalFormat = info.outputTokenType;
         memory.pixelSize = info.outputTokenSize;
     }
+
+    const uint64_t nBlocks = pixels.compressedSize.size();
+    LBASSERT( nBlocks == pixels.compressedData.size( ));
+
+    if( keepCompressed ||
+        plugin::CompressorSpan::isSpanCompressor( pixels.compressorName ))
+    {
+        // Keep the compressed data, which the CPU compositor merges directly
+        // for span compressors. The pixels are decompressed on first access,
+        // see _decompress().
+        if( copy )
+        {
+            uint64_t size = 0;
+            for( uint64_t i = 0; i < nBlocks; ++i )
+                size += pixels.compressedSize[i];
+
+            memory.compressedBuffer.resize( size );
+            memory.compressedData.resize( nBlocks );
+
+            uint8_t* data = memory.compressedBuffer.getData();
+            for( uint64_t i = 0; i < nBlocks; ++i )
+            {
+                memcpy( data, pixels.compressedData[i],
+                        pixels.compressedSize[i] );
+                memory.compressedData[i] = data;
+                data += pixels.compressedSize[i];
+            }
+        }
+        else
+            memory.compressedData = pixels.compressedData;
+
+        memory.compressedSize = pixels.compressedSize;
+        memory.compressorName = pixels.compressorName;
+        memory.compressorFlags = pixels.compressorFlags;
+        memory.isCompressed = true;
+        memory.state = Memory::COMPRESSED;
+        return;
+    }
+
     validatePixelData( buffer ); // alloc memory for pixels
 
+    if( pixels.compressorFlags & detail::STRIP_COMPRESSED )
+    {
+        if( !_decompressStrips( attachment, pixels ))
+        {
+            LBASSERTINFO( false, "Can't allocate strip decompressors " <<
+                          pixels.compressorName );
+        }
+        return;
+    }
+
     uint64_t outDims[4] = { memory.pvp.x, memory.pvp.w,
                             memory.pvp.y, memory.pvp.h };
-    const uint64_t nBlocks = pixels.compressedSize.size();
-
-    LBASSERT( nBlocks == pixels.compressedData.size( ));
     attachment.compressor->decompress( &pixels.compressedData.front(),
                                        &pixels.compressedSize.front(),
                                        nBlocks, memory.pixels, outDims,
@@ -984,17 +1358,34 @@ uint32_t Image::getDownloaderName( const Frame::Buffer buffer ) const
     return EQ_COMPRESSOR_INVALID;
 }
 
+lunchbox::Lock& Image::getTransmitLock()
+{
+    return _impl->transmitLock;
+}
+
 void Image::useCompressor( const Frame::Buffer buffer, const uint32_t name )
 {
     _impl->getMemory( buffer ).compressorName = name;
 }
 
 const PixelData& Image::compressPixelData( const Frame::Buffer buffer )
+{
+    return _compressPixelData( buffer, 1 );
+}
+
+const PixelData& Image::_compressPixelData( const Frame::Buffer buffer,
+                                            size_t nStrips )
 {
     LBASSERT( getPixelDataSize( buffer ) > 0 );
 
     Attachment& attachment = _impl->getAttachment( buffer );
     Memory& memory = attachment.memory;
+    nStrips = LB_MAX( 1u, LB_MIN( nStrips, size_t( memory.pvp.h )));
+    if( memory.isCompressed && _getNStrips( memory ) != nStrips )
+    {
+        _decompress( attachment );
+        memory.isCompressed = false;
+    }
     if( memory.isCompressed || memory.compressorName == EQ_COMPRESSOR_NONE )
     {
         LBASSERT( memory.compressorName != EQ_COMPRESSOR_AUTO );
@@ -1035,6 +1426,16 @@ const PixelData& Image::compressPixelData( const Frame::Buffer buffer )
         memory.compressorFlags |= EQ_COMPRESSOR_IGNORE_ALPHA;
     }
 
+    // The span compressor parallelizes internally, and the CPU compositor
+    // relies on its chunk layout
+    if( nStrips > 1 &&
+        !plugin::CompressorSpan::isSpanCompressor( memory.compressorName ) &&
+        _compressStrips( attachment, nStrips ))
+    {
+        memory.isCompressed = true;
+        return memory;
+    }
+
     const uint64_t inDims[4] = { memory.pvp.x, memory.pvp.w,
                                  memory.pvp.y, memory.pvp.h };
     attachment.compressor->compress( memory.pixels, inDims,
@@ -1053,6 +1454,24 @@ const PixelData& Image::compressPixelData( const Frame::Buffer buffer )
     return memory;
 }
 
+const PixelData& Image::compressPixelData( const Frame::Buffer buffer,
+                                           const uint32_t name,
+                                           const uint32_t nStrips )
+{
+    Attachment& attachment = _impl->getAttachment( buffer );
+    Memory& memory = attachment.memory;
+    if( memory.isCompressed && memory.compressorName == name )
+        return _compressPixelData( buffer, nStrips );
+
+    // the uncompressed pixels are needed, either directly or to recompress
+    _decompress( attachment );
+    memory.isCompressed = false;
+    memory.compressorName = name;
+    if( !allocCompressor( buffer, name ))
+        memory.compressorName = EQ_COMPRESSOR_AUTO;
+    return _compressPixelData( buffer, nStrips );
+}
+
 
 //---------------------------------------------------------------------------
 // File IO
@@ -1125,6 +1544,7 @@ struct RGBHeader
 bool Image::writeImage( const std::string& filename,
                         const Frame::Buffer buffer ) const
 {
+    _decompress( _impl->getAttachment( buffer ));
     const Memory& memory = _impl->getMemory( buffer );
 
     const PixelViewport& pvp = memory.pvp;
@@ -1539,7 +1959,8 @@ const Zoom& Image::getZoom() const
 
 bool Image::hasPixelData( const Frame::Buffer buffer ) const
 {
-    return _impl->getMemory( buffer ).state == Memory::VALID;
+    const Memory& memory = _impl->getMemory( buffer );
+    return memory.state == Memory::VALID || memory.state == Memory::COMPRESSED;
 }
 
 bool Image::hasAsyncReadback( const Frame::Buffer buffer ) const
@@ -189,6 +189,23 @@ namespace detail { class Image; }
         /** @return the pixel data, compressing it if needed. @version 1.0 */
         EQ_API const PixelData& compressPixelData( const Frame::Buffer );
 
+        /**
+         * @return true if compressed pixel data is available for the buffer.
+         *
+         * Pixel data set with a compressor the CPU compositor can merge
+         * directly is kept compressed, and only decompressed on the first
+         * access to the pixels.
+         * @version 1.5
+         */
+        EQ_API bool hasCompressedPixelData( const Frame::Buffer buffer ) const;
+
+        /**
+         * @return the compressed pixel data, without decompressing it.
+         * @version 1.5
+         */
+        EQ_API const PixelData& getCompressedPixelData( const Frame::Buffer )
+            const;
+
         /**
          * @return true if the image has valid pixel data for the buffer.
          * @version 1.0
@@ -207,6 +224,19 @@ namespace detail { class Image; }
          */
         EQ_API bool hasAsyncReadback() const;
 
+        /**
+         * Reduce the image to a part of its pixel viewport.
+         *
+         * The pixel data in main memory is kept, decompressing it if
+         * needed. Images without pixel data in main memory or with a readback
+         * in progress are not cropped.
+         *
+         * @param pvp the part of the pixel viewport to keep.
+         * @return true if the image was cropped, false otherwise.
+         * @version 1.5
+         */
+        EQ_API bool crop( const PixelViewport& pvp );
+
         /**
          * Clear and validate an image buffer.
          *
@@ -227,7 +257,8 @@ namespace detail { class Image; }
          *
          * Previous data for the buffer is overwritten. Validates the
          * buffer. Depending on the given PixelData parameters, the pixel data
-         * is copied, decompressed or cleared.
+         * is copied, decompressed or cleared. Data compressed with a span
+         * compressor is copied and decompressed on first use.
          *
          * @param buffer the image buffer to set.
          * @param data the pixel data.
@@ -236,6 +267,29 @@ namespace detail { class Image; }
         EQ_API void setPixelData( const Frame::Buffer buffer,
                                      const PixelData& data );
 
+        /**
+         * @internal
+         * Set the pixel data of the given image buffer without decompressing.
+         *
+         * Compressed data is copied and decompressed by decompressPixelData()
+         * or on first use.
+         */
+        EQ_API void setCompressedPixelData( const Frame::Buffer buffer,
+                                            const PixelData& data );
+
+        /**
+         * @internal
+         * Set the pixel data of the given image buffer without copying.
+         *
+         * The image references the uncompressed or compressed data, which has
+         * to stay valid until the pixel data is reset or set again.
+         */
+        EQ_API void referencePixelData( const Frame::Buffer buffer,
+                                        const PixelData& data );
+
+        /** @internal Decompress pixel data set compressed. */
+        EQ_API void decompressPixelData( const Frame::Buffer buffer );
+
         /**
          * Set alpha data preservation during download and compression.
          * @version 1.0
@@ -366,6 +420,33 @@ namespace detail { class Image; }
         EQ_API std::vector< uint32_t >
         findCompressors( const Frame::Buffer buffer ) const;
 
+        /**
+         * @internal
+         * Assemble the compressors for the buffer meeting its quality.
+         */
+        EQ_API void findCompressors( const Frame::Buffer buffer,
+                                     co::CompressorInfos& result ) const;
+
+        /**
+         * @internal
+         * @return the pixel data, compressed with the given compressor.
+         *
+         * Compressed data of another compressor is replaced. With
+         * EQ_COMPRESSOR_NONE the uncompressed pixel data is returned.
+         *
+         * With more than one strip, the rows are split into horizontal strips
+         * compressed in parallel. The result has an internal strip table and
+         * has to be sent strip by strip, see PixelDataWriter. It is not a
+         * valid wire format by itself.
+         *
+         * @param buffer the buffer to compress.
+         * @param name the compressor name.
+         * @param nStrips the number of strips.
+         */
+        EQ_API const PixelData& compressPixelData( const Frame::Buffer buffer,
+                                                   const uint32_t name,
+                                                   const uint32_t nStrips = 1 );
+
         /**
          * @internal
          * Assemble a list of possible up/downloaders for the given buffer.
@@ -385,6 +466,13 @@ namespace detail { class Image; }
 
         /** @internal */
         EQ_API uint32_t getDownloaderName( const Frame::Buffer buffer ) const;
+
+        /**
+         * @internal
+         * @return the lock serializing the compression and transmission of
+         *         this image by the transmit threads.
+         */
+        EQ_API lunchbox::Lock& getTransmitLock();
         //@}
 
     private:
@@ -393,6 +481,10 @@ namespace detail { class Image; }
         /** @return an appropriate compressor name for the given buffer.*/
         uint32_t _chooseCompressor( const Frame::Buffer buffer ) const;
 
+        /** Compress the pixel data in the given number of strips. */
+        const PixelData& _compressPixelData( const Frame::Buffer buffer,
+                                             size_t nStrips );
+
         void _findTransferers( const Frame::Buffer buffer,
                                const GLEWContext* glewContext,
                                co::CompressorInfos& result );
@@ -429,6 +521,9 @@ namespace detail { class Image; }
 
         bool _readbackZoom( const Frame::Buffer buffer, const Zoom& zoom,
                             ObjectManager* glObjects );
+
+        void _setPixelData( const Frame::Buffer buffer, const PixelData& data,
+                            const bool keepCompressed, const bool copy );
     };
 };
 #endif // EQ_IMAGE_H
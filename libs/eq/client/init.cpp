@@ -19,11 +19,13 @@
 #include "init.h"
 
 #include "client.h"
+#include "compressor/compressor.h"
 #include "config.h"
 #include "configParams.h"
 #include "global.h"
 #include "nodeFactory.h"
 #include "os.h"
+#include "pixelBufferPool.h"
 #include "server.h"
 
 #include <eq/client/version.h>
@@ -51,6 +53,8 @@ static lunchbox::a_int32_t _initialized;
 }
 
 static void _parseArguments( const int argc, char** argv );
+static void* _allocPixels( eq_uint64_t& size );
+static void _freePixels( void* data, const eq_uint64_t size );
 static void _initPlugins();
 static void _exitPlugins();
 //extern void _initErrors();
@@ -207,8 +211,24 @@ void _parseArguments( const int argc, char** argv )
     }
 }
 
+void* _allocPixels( eq_uint64_t& size )
+{
+    uint64_t capacity = size;
+    void* data = detail::PixelBufferPool::getInstance().alloc( capacity );
+    size = capacity;
+    return data;
+}
+
+void _freePixels( void* data, const eq_uint64_t size )
+{
+    detail::PixelBufferPool::getInstance().free( data, size );
+}
+
 void _initPlugins()
 {
+    // the built-in compressors use the node-wide pixel memory pool
+    plugin::Compressor::setAllocator( &_allocPixels, &_freePixels );
+
     co::PluginRegistry& plugins = co::Global::getPluginRegistry();
 
     plugins.addDirectory( "/usr/share/Equalizer/plugins" );
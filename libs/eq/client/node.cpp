@@ -21,6 +21,8 @@
 #include "client.h"
 #include "config.h"
 #include "configPackets.h"
+#include "decompressQueue.h"
+#include "deltaCache.h"
 #include "error.h"
 #include "exception.h"
 #include "frameData.h"
@@ -30,8 +32,13 @@
 #include "nodePackets.h"
 #include "nodeStatistics.h"
 #include "pipe.h"
+#include "pixelBufferPool.h"
 #include "pipePackets.h"
 #include "server.h"
+#include "shmTransport.h"
+#include "transmitCostModel.h"
+#include "transmitQueue.h"
+#include "transmitShaper.h"
 
 #include <eq/fabric/elementVisitor.h>
 #include <eq/fabric/packets.h>
@@ -39,6 +46,7 @@
 #include <co/barrier.h>
 #include <co/command.h>
 #include <co/connection.h>
+#include <lunchbox/omp.h>
 #include <lunchbox/scopedMutex.h>
 
 namespace eq
@@ -48,6 +56,17 @@ typedef co::CommandFunc<Node> NodeFunc;
 typedef fabric::Node< Config, Node, Pipe, NodeVisitor > Super;
 /** @endcond */
 
+struct Node::Private
+{
+    Private( Node* node ) : transmitQueue( node ), decompressQueue( node ) {}
+
+    /** The image transmission commands, executed by a thread pool. */
+    detail::TransmitQueue transmitQueue;
+
+    /** The received images, decompressed by a thread pool. */
+    detail::DecompressQueue decompressQueue;
+};
+
 Node::Node( Config* parent )
         : Super( parent )
 #pragma warning(push)
@@ -57,12 +76,17 @@ Node::Node( Config* parent )
         , _state( STATE_STOPPED )
         , _finishedFrame( 0 )
         , _unlockedFrame( 0 )
+#pragma warning(push)
+#pragma warning(disable: 4355)
+        , _private( new Private( this ))
+#pragma warning(pop)
 {
 }
 
 Node::~Node()
 {
     LBASSERT( getPipes().empty( ));
+    delete _private;
 }
 
 void Node::attach( const UUID& id, const uint32_t instanceID )
@@ -71,7 +95,6 @@ void Node::attach( const UUID& id, const uint32_t instanceID )
 
     co::CommandQueue* queue = getMainThreadQueue();
     co::CommandQueue* commandQ = getCommandThreadQueue();
-    co::CommandQueue* transmitQ = &transmitter.getQueue();
 
     registerCommand( fabric::CMD_NODE_CREATE_PIPE,
                      NodeFunc( this, &Node::_cmdCreatePipe ), queue );
@@ -79,8 +102,6 @@ void Node::attach( const UUID& id, const uint32_t instanceID )
                      NodeFunc( this, &Node::_cmdDestroyPipe ), queue );
     registerCommand( fabric::CMD_NODE_CONFIG_INIT, 
                      NodeFunc( this, &Node::_cmdConfigInit ), queue );
-    registerCommand( fabric::CMD_NODE_SET_AFFINITY,
-                     NodeFunc( this, &Node::_cmdSetAffinity), transmitQ );
     registerCommand( fabric::CMD_NODE_CONFIG_EXIT,
                      NodeFunc( this, &Node::_cmdConfigExit ), queue );
     registerCommand( fabric::CMD_NODE_FRAME_START,
@@ -95,6 +116,16 @@ void Node::attach( const UUID& id, const uint32_t instanceID )
                      NodeFunc( this, &Node::_cmdFrameDataTransmit ), commandQ );
     registerCommand( fabric::CMD_NODE_FRAMEDATA_READY,
                      NodeFunc( this, &Node::_cmdFrameDataReady ), commandQ );
+    registerCommand( fabric::CMD_NODE_FRAMEDATA_INVALIDATE,
+                     NodeFunc( this, &Node::_cmdFrameDataInvalidate ),
+                     commandQ );
+    registerCommand( fabric::CMD_NODE_FRAMEDATA_DECOMPRESS,
+                     NodeFunc( this, &Node::_cmdFrameDataDecompress ),
+                     commandQ );
+    registerCommand( fabric::CMD_NODE_SHM_PROBE,
+                     NodeFunc( this, &Node::_cmdShmProbe ), commandQ );
+    registerCommand( fabric::CMD_NODE_SHM_PROBE_REPLY,
+                     NodeFunc( this, &Node::_cmdShmProbeReply ), commandQ );
 }
 
 void Node::setDirty( const uint64_t bits )
@@ -218,12 +249,8 @@ void Node::_setAffinity()
             break;
 
         default:
-            NodeAffinityPacket packet;
-            packet.affinity = affinity;
-            co::LocalNodePtr node = getLocalNode();
-            send( node, packet );
-
-            node->setAffinity( affinity );
+            // transmit threads are bound when started in _cmdConfigInit
+            getLocalNode()->setAffinity( affinity );
             break;
     }
 }
@@ -263,6 +290,16 @@ void Node::_frameFinish( const uint128_t& frameID,
     LBLOG( LOG_TASKS ) << "---- Finished Frame --- " << frameNumber
                        << std::endl;
 
+    {
+        // the frame is done on this node, adapt the cached pixel memory
+        NodeStatistics event( Statistic::NODE_PIXEL_POOL, this, frameNumber );
+        const detail::PixelBufferPool::Stats stats =
+            detail::PixelBufferPool::getInstance().trim();
+        event.event.data.statistic.poolUsed = stats.used;
+        event.event.data.statistic.poolCached = stats.cached;
+        event.event.data.statistic.ratio = stats.getReuse();
+    }
+
     if( _unlockedFrame < frameNumber )
     {
         LBWARN << "Finished frame was not locally unlocked, enforcing unlock" 
@@ -411,18 +448,52 @@ void Node::_flushObjects()
 
 void Node::TransmitThread::run()
 {
-    lunchbox::Thread::setName( std::string( "Trm " ) +
-                               lunchbox::className( _node ));
-    while( true )
+    // deprecated, not started
+    LBUNREACHABLE;
+}
+
+size_t Node::_getNTransmitThreads() const
+{
+    const int32_t nThreads = getIAttribute( IATTR_HINT_TRANSMIT_THREADS );
+    switch( nThreads )
     {
-        co::CommandPtr command = _queue.pop();
-        if( !command )
-            return; // exit thread
+        case OFF:
+            return 1;
 
-        LBCHECK( (*command)( ));
+        case AUTO:
+        case UNDEFINED:
+            // one thread per core, up to four
+            return LB_MIN( 4u, lunchbox::OMP::getNThreads( ));
+
+        default:
+            LBASSERT( nThreads > 0 );
+            return LB_MAX( 1, nThreads );
     }
 }
 
+co::CommandQueue* Node::getTransmitQueue()
+{
+    return &_private->transmitQueue;
+}
+
+void Node::_startThreads()
+{
+    const int32_t affinity = getIAttribute( IATTR_HINT_AFFINITY );
+    _private->transmitQueue.start( _getNTransmitThreads(), affinity );
+
+    // each image is decompressed using all cores, the threads overlap images
+    _private->decompressQueue.start( LB_MIN( 4u,
+                                             lunchbox::OMP::getNThreads( )),
+                                     affinity );
+}
+
+void Node::_exitThreads()
+{
+    _private->transmitQueue.exit();
+    _private->decompressQueue.exit();
+    detail::ShmTransport::getInstance().unlink();
+}
+
 void Node::dirtyClientExit()
 {
     const Pipes& pipes = getPipes();
@@ -431,8 +502,7 @@ void Node::dirtyClientExit()
         Pipe* pipe = *i;
         pipe->cancelThread();
     }
-    transmitter.getQueue().push( 0 ); // wake up to exit
-    transmitter.join();
+    _exitThreads();
 }
 
 //---------------------------------------------------------------------------
@@ -493,8 +563,9 @@ bool Node::_cmdConfigInit( co::Command& command )
     _unlockedFrame = packet->frameNumber;
     _finishedFrame = packet->frameNumber;
     _setAffinity();
+    detail::TransmitShaper::getInstance().setReceiveRate( packet->receiveRate );
 
-    transmitter.start();
+    _startThreads();
     setError( ERROR_NONE );
     NodeConfigInitReplyPacket reply;
     reply.result = configInit( packet->initID );
@@ -523,8 +594,7 @@ bool Node::_cmdConfigExit( co::Command& command )
     }
     
     _state = configExit() ? STATE_STOPPED : STATE_FAILED;
-    transmitter.getQueue().push( 0 ); // wake up to exit
-    transmitter.join();
+    _exitThreads();
     _flushObjects();
 
     ConfigDestroyNodePacket destroyPacket( getID( ));
@@ -608,18 +678,44 @@ bool Node::_cmdFrameDataTransmit( co::Command& command )
     const NodeFrameDataTransmitPacket* packet =
         command.get<NodeFrameDataTransmitPacket>();
 
+    FrameDataPtr frameData = getFrameData( packet->frameData );
+    LBASSERT( !frameData->isReady() );
+    detail::TransmitShaper::getInstance().addReceived( packet->size );
+
+    if( packet->nImages > 0 )
+    {
+        LBLOG( LOG_ASSEMBLY )
+            << "received " << packet->nImages << " images for "
+            << packet->frameData << std::endl;
+
+        Images images;
+        frameData->addImages( packet, images );
+        _private->decompressQueue.push( frameData, images, packet->frameNumber,
+                                        command.getNode(), packet->sourceID );
+        return true;
+    }
+
     LBLOG( LOG_ASSEMBLY )
         << "received image data for " << packet->frameData << ", buffers "
         << packet->buffers << " pvp " << packet->pvp << std::endl;
 
     LBASSERT( packet->pvp.isValid( ));
 
-    FrameDataPtr frameData = getFrameData( packet->frameData );
-    LBASSERT( !frameData->isReady() );
+    Image* image = frameData->addImage( packet );
+    _private->decompressQueue.push( frameData, Images( 1, image ),
+                                    packet->frameNumber, command.getNode(),
+                                    packet->sourceID );
 
-    NodeStatistics event( Statistic::NODE_FRAME_DECOMPRESS, this,
-                          packet->frameNumber );
-    LBCHECK( frameData->addImage( packet ));
+    // a delta without its reference can't be decoded until the next full image
+    if( packet->deltaBase != 0 &&
+        frameData->getDeltaCache().isReferenceLost( packet->imageIndex ))
+    {
+        NodeFrameDataInvalidatePacket reply;
+        reply.objectID = packet->sourceID;
+        reply.frameData = packet->frameData.identifier;
+        reply.imageIndex = packet->imageIndex;
+        command.getNode()->send( reply );
+    }
     return true;
 }
 
@@ -633,17 +729,74 @@ bool Node::_cmdFrameDataReady( co::Command& command )
     FrameDataPtr frameData = getFrameData( packet->frameData );
     LBASSERT( frameData );
     LBASSERT( !frameData->isReady() );
+    // set ready by the last decompressImage() if images are still decoded
     frameData->setReady( packet );
-    LBASSERT( frameData->isReady() );
     return true;
 }
 
-bool Node::_cmdSetAffinity( co::Command& command )
+bool Node::_cmdFrameDataInvalidate( co::Command& command )
+{
+    const NodeFrameDataInvalidatePacket* packet =
+        command.get< NodeFrameDataInvalidatePacket >();
+
+    LBLOG( LOG_ASSEMBLY ) << "received invalidate for image "
+                          << packet->imageIndex << " of " << packet->frameData
+                          << std::endl;
+    FrameDataPtr frameData;
+    {
+        lunchbox::ScopedWrite mutex( _frameDatas );
+        FrameDataHashCIter i = _frameDatas->find( packet->frameData );
+        if( i != _frameDatas->end( ))
+            frameData = i->second;
+    }
+    if( frameData )
+        frameData->getDeltaCache().invalidate( command.getNode()->getNodeID(),
+                                               packet->imageIndex );
+    return true;
+}
+
+bool Node::_cmdFrameDataDecompress( co::Command& command )
 {
-    const NodeAffinityPacket* packet = command.get <NodeAffinityPacket>();
-    lunchbox::Thread::setAffinity( packet->affinity );
+    const NodeFrameDataDecompressPacket* packet =
+        command.get< NodeFrameDataDecompressPacket >();
+
+    detail::TransmitCostModel& costModel =
+        detail::TransmitCostModel::getInstance();
+    const uint128_t& nodeID = command.getNode()->getNodeID();
+    for( size_t i = 0; i < 2; ++i )
+        costModel.addDecompress( nodeID, packet->compressors[i],
+                                 packet->sizes[i], packet->times[i] );
+
+    detail::TransmitShaper::getInstance().setSpareShare( nodeID,
+                                                         packet->spareShare );
     return true;
 }
+
+bool Node::_cmdShmProbe( co::Command& command )
+{
+    const NodeShmProbePacket* packet = command.get< NodeShmProbePacket >();
+
+    NodeShmProbeReplyPacket reply( packet );
+    reply.acknowledged =
+        detail::ShmTransport::getInstance().acknowledge( packet->token );
+    LBLOG( LOG_ASSEMBLY ) << "shared memory probe " << packet->token
+                          << " acknowledged: " << reply.acknowledged
+                          << std::endl;
+    command.getNode()->send( reply );
+    return true;
+}
+
+bool Node::_cmdShmProbeReply( co::Command& command )
+{
+    const NodeShmProbeReplyPacket* packet =
+        command.get< NodeShmProbeReplyPacket >();
+
+    detail::ShmTransport::getInstance().setAcknowledged(
+        command.getNode()->getNodeID(), packet->token,
+        packet->acknowledged != 0 );
+    return true;
+}
+
 }
 
 #include "../fabric/node.ipp"
@@ -118,23 +118,32 @@ namespace eq
         /** @internal @return the number of the last finished frame. */
         uint32_t getFinishedFrame() const { return _finishedFrame; }
 
-        /** @internal */
+        /**
+         * @internal
+         * @deprecated Not started, the images are transmitted by a thread
+         *             pool, see getTransmitQueue(). Kept for compatibility.
+         */
         class TransmitThread : public lunchbox::Thread
         {
         public:
             TransmitThread( Node* parent ) : _node( parent ) {}
             virtual ~TransmitThread() {}
 
-            co::CommandQueue& getQueue() { return _queue; }
+            /** @return the queue of the image transmit threads. */
+            co::CommandQueue& getQueue()
+                { return *_node->getTransmitQueue(); }
             
         protected:
             virtual void run();
 
         private:
-            co::CommandQueue     _queue;
+            co::CommandQueue     _queue; // unused, kept for binary compat
             Node* const           _node;
         } transmitter;
 
+        /** @internal @return the queue of the image transmit threads. */
+        co::CommandQueue* getTransmitQueue();
+
         /** @internal @sa Serializable::setDirty() */
         EQ_API virtual void setDirty( const uint64_t bits );
 
@@ -291,6 +300,9 @@ namespace eq
         Private* _private; // placeholder for binary-compatible changes
 
         void _setAffinity();
+        size_t _getNTransmitThreads() const;
+        void _startThreads();
+        void _exitThreads();
 
         void _finishFrame( const uint32_t frameNumber ) const;
         void _frameFinish( const uint128_t& frameID,
@@ -309,7 +321,10 @@ namespace eq
         bool _cmdFrameTasksFinish( co::Command& command );
         bool _cmdFrameDataTransmit( co::Command& command );
         bool _cmdFrameDataReady( co::Command& command );
-        bool _cmdSetAffinity( co::Command& command );
+        bool _cmdFrameDataInvalidate( co::Command& command );
+        bool _cmdFrameDataDecompress( co::Command& command );
+        bool _cmdShmProbe( co::Command& command );
+        bool _cmdShmProbeReply( co::Command& command );
 
         LB_TS_VAR( _nodeThread );
         LB_TS_VAR( _commandThread );
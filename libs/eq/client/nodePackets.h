@@ -21,6 +21,7 @@
 
 #include <eq/client/packets.h>   // base structs
 #include <eq/client/frameData.h> // member
+#include <co/plugins/compressor.h> // EQ_COMPRESSOR_NONE
 
 /** @cond IGNORE */
 namespace eq
@@ -36,6 +37,7 @@ namespace eq
 
         uint128_t initID;
         uint32_t frameNumber;
+        uint32_t receiveRate; //!< in KB/s, see server::Node::getReceiveRate()
     };
 
     struct NodeConfigInitReplyPacket : public co::ObjectPacket
@@ -149,13 +151,26 @@ namespace eq
             {
                 command = fabric::CMD_NODE_FRAMEDATA_TRANSMIT;
                 size    = sizeof( NodeFrameDataTransmitPacket );
+                shmSlot = LB_UNDEFINED_UINT32;
+                deltaSequence = 0;
+                deltaBase = 0;
+                nImages = 0;
+                padding = 0;
             }
 
         co::ObjectVersion frameData;
+        uint128_t     sourceID; //!< the sending node, for replies
+        uint128_t     shmRing; //!< shared memory ring of the data, see shmSlot
         PixelViewport pvp;
         Zoom          zoom;
         uint32_t      buffers;
         uint32_t      frameNumber;
+        uint32_t      shmSlot; //!< data in shared memory, or in packet if undef
+        uint32_t      imageIndex; //!< in the output frame data
+        uint32_t      deltaSequence; //!< delta encoding, see DeltaCache
+        uint32_t      deltaBase;  //!< sequence of the delta reference, or 0
+        uint32_t      nImages; //!< images batched in the data, or 0
+        uint32_t      padding;
         uint64_t useAlpha; // bool + valgrind padding
 
         LB_ALIGN8( uint8_t data[8] );
@@ -174,6 +189,73 @@ namespace eq
         const FrameData::Data data;
     };
 
+    /** Request a full image after a lost delta reference, see DeltaCache. */
+    struct NodeFrameDataInvalidatePacket : public NodePacket
+    {
+        NodeFrameDataInvalidatePacket()
+            {
+                command = fabric::CMD_NODE_FRAMEDATA_INVALIDATE;
+                size    = sizeof( NodeFrameDataInvalidatePacket );
+            }
+
+        uint128_t frameData;
+        uint32_t imageIndex;
+    };
+
+    /**
+     * The decompression times of the images of one transmit and the unused
+     * receive rate of the destination, sent back to its source for the
+     * TransmitCostModel and the TransmitShaper.
+     */
+    struct NodeFrameDataDecompressPacket : public NodePacket
+    {
+        NodeFrameDataDecompressPacket()
+            {
+                command = fabric::CMD_NODE_FRAMEDATA_DECOMPRESS;
+                size    = sizeof( NodeFrameDataDecompressPacket );
+                spareShare = 0;
+                for( size_t i = 0; i < 2; ++i )
+                {
+                    compressors[i] = EQ_COMPRESSOR_NONE;
+                    sizes[i] = 0;
+                    times[i] = 0.f;
+                }
+            }
+
+        uint32_t compressors[2]; //!< per buffer, EQ_COMPRESSOR_NONE if unused
+        uint64_t sizes[2];       //!< decompressed bytes per buffer
+        float times[2];          //!< decompression ms per buffer
+        uint32_t spareShare;     //!< unused part of the receive rate in 1/1000
+    };
+
+    /** Start the shared memory handshake, see ShmTransport. */
+    struct NodeShmProbePacket : public NodePacket
+    {
+        NodeShmProbePacket()
+            {
+                command = fabric::CMD_NODE_SHM_PROBE;
+                size    = sizeof( NodeShmProbePacket );
+            }
+
+        uint128_t sourceID; //!< the sending node, for the reply
+        uint128_t token;
+    };
+
+    struct NodeShmProbeReplyPacket : public NodePacket
+    {
+        NodeShmProbeReplyPacket( const NodeShmProbePacket* request )
+                : token( request->token )
+                , acknowledged( 0 )
+            {
+                command  = fabric::CMD_NODE_SHM_PROBE_REPLY;
+                size     = sizeof( NodeShmProbeReplyPacket );
+                objectID = request->sourceID;
+            }
+
+        const uint128_t token;
+        uint64_t acknowledged; // bool, padded for valgrind
+    };
+
     struct NodeFrameTasksFinishPacket : public NodePacket
     {
         NodeFrameTasksFinishPacket()
@@ -186,17 +268,6 @@ namespace eq
         uint32_t frameNumber;
     };
 
-    struct NodeAffinityPacket : public NodePacket
-    {
-        NodeAffinityPacket()
-              {
-                  command = fabric::CMD_NODE_SET_AFFINITY;
-                  size = sizeof(NodeAffinityPacket);
-              }
-
-        int32_t affinity;
-    };
-
     inline std::ostream& operator << ( std::ostream& os, 
                                        const NodeCreatePipePacket* packet )
     {
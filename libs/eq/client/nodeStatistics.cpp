@@ -72,7 +72,8 @@ NodeStatistics::~NodeStatistics()
         return;
 
     Config* config = _owner->getConfig();
-    event.data.statistic.endTime = config->getTime();
+    if( event.data.statistic.type != Statistic::NODE_PIXEL_POOL )
+        event.data.statistic.endTime = config->getTime();
     config->sendEvent( event );
 }
 
@@ -0,0 +1,300 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pixelBufferPool.h"
+
+#include <lunchbox/scopedMutex.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#  include <sys/mman.h>
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+// The smallest size class, 4 KB
+static const unsigned _minShift = 12;
+
+// Buffers up to 2^_maxShift bytes (1 GB) are pooled, larger ones are not
+// cached
+static const unsigned _maxShift = 30;
+static const size_t _nClasses = 1 + ( _maxShift - _minShift ) * 4;
+
+// Number of trim() calls over which the high-water mark is tracked
+static const size_t _nPeriods = 32;
+
+// Buffers of at least this size are backed by huge pages, if enabled
+static const uint64_t _hugePageSize = 2 * 1024 * 1024;
+
+/**
+ * @return the size class of the given size, and its usable size.
+ *
+ * Class 0 holds all buffers up to 4 KB. Above, each power of two interval
+ * ( 2^n, 2^(n+1) ] is split into four classes of 2^(n-2) bytes each.
+ */
+static size_t _getClass( const uint64_t size, uint64_t& capacity )
+{
+    if( size <= ( 1ull << _minShift ))
+    {
+        capacity = 1ull << _minShift;
+        return 0;
+    }
+
+    unsigned shift = _minShift;
+    while(( size - 1 ) >> ( shift + 1 ))
+        ++shift;
+
+    const uint64_t step = 1ull << ( shift - 2 );
+    const uint64_t n = ( size - 1 ) / step + 1; // 5..8
+    capacity = n * step;
+    return 1 + ( shift - _minShift ) * 4 + size_t( n - 5 );
+}
+
+/** @return the usable size of the given size class. */
+static uint64_t _getClassSize( const size_t index )
+{
+    if( index == 0 )
+        return 1ull << _minShift;
+
+    const unsigned shift = _minShift + unsigned(( index - 1 ) / 4 );
+    const uint64_t n = 5 + ( index - 1 ) % 4;
+    return n << ( shift - 2 );
+}
+
+#ifdef MADV_HUGEPAGE
+static size_t _getMapSize( const uint64_t size )
+{
+    return size_t(( size + _hugePageSize - 1 ) / _hugePageSize *
+                  _hugePageSize );
+}
+#endif
+}
+
+PixelBufferPool::PixelBufferPool()
+        : _classes( _nClasses )
+        , _peaks( _nPeriods, 0 )
+        , _period( 0 )
+        , _peak( 0 )
+#ifdef MADV_HUGEPAGE
+        , _useHugePages( ::getenv( "EQ_PIXEL_POOL_HUGEPAGES" ) != 0 )
+#else
+        , _useHugePages( false )
+#endif
+{
+    if( _useHugePages )
+        LBINFO << "Using huge pages for pixel buffers" << std::endl;
+}
+
+PixelBufferPool::~PixelBufferPool()
+{
+    for( size_t i = 0; i < _nClasses; ++i )
+    {
+        const Buffers& buffers = _classes[i];
+        for( BuffersCIter j = buffers.begin(); j != buffers.end(); ++j )
+            _freeSystem( *j, _getClassSize( i ));
+    }
+}
+
+PixelBufferPool& PixelBufferPool::getInstance()
+{
+    // Never destroyed: images in static per-thread storage may release their
+    // memory during static destruction.
+    static PixelBufferPool* instance = new PixelBufferPool;
+    return *instance;
+}
+
+uint64_t PixelBufferPool::getCapacity( const uint64_t size )
+{
+    uint64_t capacity = 0;
+    _getClass( size, capacity );
+    return capacity;
+}
+
+void* PixelBufferPool::alloc( uint64_t& size )
+{
+    const size_t index = _getClass( size, size );
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        _stats.used += size;
+        _peak = LB_MAX( _peak, _stats.used );
+
+        if( index < _nClasses && !_classes[ index ].empty( ))
+        {
+            void* data = _classes[ index ].back();
+            _classes[ index ].pop_back();
+            _stats.cached -= size;
+            ++_stats.hits;
+            return data;
+        }
+        ++_stats.misses;
+    }
+
+    void* data = _allocSystem( size );
+    if( !data )
+    {
+        LBWARN << "Can't allocate pixel buffer of " << size << " bytes"
+               << std::endl;
+        lunchbox::ScopedWrite mutex( _lock );
+        _stats.used -= size;
+    }
+    return data;
+}
+
+void PixelBufferPool::free( void* data, const uint64_t size )
+{
+    if( !data )
+        return;
+
+    uint64_t capacity = 0;
+    const size_t index = _getClass( size, capacity );
+    LBASSERTINFO( capacity == size, size << " is not a pool size class" );
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        LBASSERT( _stats.used >= size );
+        _stats.used -= size;
+
+        if( index < _nClasses )
+        {
+            _classes[ index ].push_back( data );
+            _stats.cached += size;
+            return;
+        }
+    }
+    _freeSystem( data, size );
+}
+
+PixelBufferPool::Stats PixelBufferPool::trim()
+{
+    typedef std::pair< void*, uint64_t > Release;
+    std::vector< Release > released;
+    Stats stats;
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        _peaks[ _period ] = _peak;
+        _period = ( _period + 1 ) % _nPeriods;
+        _peak = _stats.used;
+        _stats.highWater = *std::max_element( _peaks.begin(), _peaks.end( ));
+
+        // Release the largest buffers first, they return the most memory and
+        // are the least likely to match the size of a new image.
+        for( size_t i = _nClasses; i > 0; --i )
+        {
+            Buffers& buffers = _classes[ i - 1 ];
+            const uint64_t size = _getClassSize( i - 1 );
+            while( !buffers.empty() &&
+                   _stats.used + _stats.cached > _stats.highWater )
+            {
+                released.push_back( Release( buffers.back(), size ));
+                buffers.pop_back();
+                _stats.cached -= size;
+            }
+        }
+
+        stats = _stats;
+        _stats.hits = 0;
+        _stats.misses = 0;
+    }
+
+    for( size_t i = 0; i < released.size(); ++i )
+        _freeSystem( released[i].first, released[i].second );
+    return stats;
+}
+
+PixelBufferPool::Stats PixelBufferPool::getStats() const
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    return _stats;
+}
+
+void* PixelBufferPool::_allocSystem( const uint64_t size )
+{
+#ifdef MADV_HUGEPAGE
+    if( _useHugePages && size >= _hugePageSize )
+    {
+        const size_t mapSize = _getMapSize( size );
+        void* data = ::mmap( 0, mapSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if( data == MAP_FAILED )
+            return 0;
+
+        if( ::madvise( data, mapSize, MADV_HUGEPAGE ) != 0 )
+            LBVERB << "No transparent huge pages for pixel buffer: "
+                   << lunchbox::sysError << std::endl;
+        return data;
+    }
+#endif
+    return ::malloc( size_t( size ));
+}
+
+void PixelBufferPool::_freeSystem( void* data, const uint64_t size )
+{
+#ifdef MADV_HUGEPAGE
+    if( _useHugePages && size >= _hugePageSize )
+    {
+        ::munmap( data, _getMapSize( size ));
+        return;
+    }
+#endif
+    ::free( data );
+}
+
+uint8_t* PixelBuffer::resize( const uint64_t size )
+{
+    // keep the memory unless the size class changes by more than factor four
+    if( _data && size <= _capacity &&
+        PixelBufferPool::getCapacity( size ) * 4 > _capacity )
+    {
+        _size = size;
+        return _data;
+    }
+
+    PixelBufferPool& pool = PixelBufferPool::getInstance();
+    uint64_t capacity = size;
+    uint8_t* data = static_cast< uint8_t* >( pool.alloc( capacity ));
+    LBASSERT( data );
+    if( !data )
+        return _data;
+
+    if( _data )
+    {
+        ::memcpy( data, _data, size_t( LB_MIN( size, _size )));
+        pool.free( _data, _capacity );
+    }
+
+    _data = data;
+    _size = size;
+    _capacity = capacity;
+    return _data;
+}
+
+void PixelBuffer::clear()
+{
+    if( _data )
+        PixelBufferPool::getInstance().free( _data, _capacity );
+    _data = 0;
+    _size = 0;
+    _capacity = 0;
+}
+
+}
+}
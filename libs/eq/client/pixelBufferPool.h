@@ -0,0 +1,165 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PIXELBUFFERPOOL_H
+#define EQ_PIXELBUFFERPOOL_H
+
+#include <eq/client/api.h>
+#include <lunchbox/debug.h>
+#include <lunchbox/lock.h>
+#include <lunchbox/types.h>
+
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * A process-wide cache of pixel memory, shared by all entities of a node.
+ *
+ * Sort-first and sort-last images change their size each frame with dynamic
+ * load balancing. Instead of returning their memory to the system, buffers
+ * are kept in size classes with four classes per power of two, i.e., a
+ * buffer is at most 25% larger than requested. Released buffers are reused
+ * by the next allocation of the same class.
+ *
+ * The pool keeps at most the high-water mark of the memory in use during the
+ * last frames, see trim(). Large buffers are backed by transparent huge pages
+ * on Linux if the environment variable EQ_PIXEL_POOL_HUGEPAGES is set.
+ */
+class PixelBufferPool
+{
+public:
+    /** The memory usage and reuse of the pool. */
+    struct Stats
+    {
+        Stats() : used( 0 ), cached( 0 ), highWater( 0 ), hits( 0 ),
+                  misses( 0 ) {}
+
+        uint64_t used;      //!< Bytes handed out and not yet released
+        uint64_t cached;    //!< Bytes released and kept for reuse
+        uint64_t highWater; //!< Peak of used bytes over the trim window
+        uint64_t hits;      //!< Allocations served from the cache
+        uint64_t misses;    //!< Allocations served by the system
+
+        /** @return the ratio of allocations served from the cache. */
+        float getReuse() const
+            {
+                const uint64_t n = hits + misses;
+                return n == 0 ? 1.f : float( hits ) / float( n );
+            }
+    };
+
+    /** @return the pool of this process. */
+    EQ_API static PixelBufferPool& getInstance();
+
+    /**
+     * Allocate a buffer of at least the given size.
+     *
+     * @param size the requested size, set to the usable size on return.
+     * @return the buffer, or 0 if out of memory.
+     */
+    EQ_API void* alloc( uint64_t& size );
+
+    /** Release a buffer with the usable size returned by alloc(). */
+    EQ_API void free( void* data, const uint64_t size );
+
+    /**
+     * Release cached buffers exceeding the recent high-water mark.
+     *
+     * Called once per frame. The high-water mark is the peak of the used
+     * memory over the last trim periods, which lets the pool follow a
+     * shrinking working set without freeing memory needed next frame.
+     *
+     * @return the statistics of the finished period, after trimming.
+     */
+    EQ_API Stats trim();
+
+    /** @return the current statistics, hits and misses since the last trim. */
+    EQ_API Stats getStats() const;
+
+    /** @return the usable size of the size class of the given size. */
+    EQ_API static uint64_t getCapacity( const uint64_t size );
+
+private:
+    PixelBufferPool();
+    ~PixelBufferPool();
+    PixelBufferPool( const PixelBufferPool& );
+    PixelBufferPool& operator = ( const PixelBufferPool& );
+
+    typedef std::vector< void* > Buffers;
+    typedef Buffers::const_iterator BuffersCIter;
+
+    mutable lunchbox::Lock _lock;
+    std::vector< Buffers > _classes; //!< Cached buffers per size class
+    std::vector< uint64_t > _peaks;   //!< Used peak of the last trim periods
+    size_t _period;                   //!< Current index in _peaks
+    uint64_t _peak;                   //!< Used peak of the current period
+    Stats _stats;
+    const bool _useHugePages;
+
+    void* _allocSystem( const uint64_t size );
+    void _freeSystem( void* data, const uint64_t size );
+};
+
+/**
+ * A resizeable byte buffer using memory of the PixelBufferPool.
+ *
+ * Offers the subset of the lunchbox::Bufferb interface used for pixel data.
+ * The memory is only returned to the pool by clear() and the destructor, or
+ * when the buffer is resized to less than a quarter of its capacity.
+ */
+class PixelBuffer
+{
+public:
+    PixelBuffer() : _data( 0 ), _size( 0 ), _capacity( 0 ) {}
+    ~PixelBuffer() { clear(); }
+
+    /** Resize the buffer, retaining its content up to the new size. */
+    EQ_API uint8_t* resize( const uint64_t size );
+
+    /** Set the used size, which has to fit into the allocated memory. */
+    void setSize( const uint64_t size )
+        { LBASSERT( size <= _capacity ); _size = size; }
+
+    /** Release the memory to the pool. */
+    EQ_API void clear();
+
+    /** @return a pointer to the data. */
+    uint8_t* getData() { return _data; }
+
+    /** @return a const pointer to the data. */
+    const uint8_t* getData() const { return _data; }
+
+    /** @return the used size of the buffer. */
+    uint64_t getSize() const { return _size; }
+
+    /** @return the allocated size of the buffer. */
+    uint64_t getMaxSize() const { return _capacity; }
+
+private:
+    PixelBuffer( const PixelBuffer& );
+    PixelBuffer& operator = ( const PixelBuffer& );
+
+    uint8_t* _data;
+    uint64_t _size;
+    uint64_t _capacity;
+};
+}
+}
+
+#endif // EQ_PIXELBUFFERPOOL_H
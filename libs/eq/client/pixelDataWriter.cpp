@@ -0,0 +1,274 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pixelDataWriter.h"
+
+#include "frameData.h"
+#include "log.h"
+#include "nodePackets.h"
+#include "pixelData.h"
+#include "pixelStrips.h"
+
+#include <co/connection.h>
+#include <co/plugins/compressor.h>
+
+#include <cstring>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+// Chunks smaller than this are copied to the staging buffer, which is cheaper
+// than a separate send
+static const uint64_t _minReferenceSize = 16384;
+}
+
+PixelDataWriter::PixelDataWriter()
+        : _size( 0 )
+{}
+
+PixelDataWriter::~PixelDataWriter()
+{}
+
+void PixelDataWriter::add( const void* data, const uint64_t size )
+{
+    if( size < _minReferenceSize )
+        _stage( data, size );
+    else
+        _reference( data, size );
+}
+
+void PixelDataWriter::addCopy( const void* data, const uint64_t size )
+{
+    _stage( data, size );
+}
+
+void PixelDataWriter::add( const PixelData& data, const float quality )
+{
+    // the strip table is not part of the wire format, see add( y, h )
+    LBASSERTINFO( !data.isCompressed ||
+                  !( data.compressorFlags & STRIP_COMPRESSED ),
+                  "Strip-compressed data has to be written strip by strip" );
+    const uint32_t nChunks =
+        data.isCompressed ? uint32_t( data.compressedSize.size( )) : 1;
+    const FrameData::ImageHeader header =
+        { data.internalFormat, data.externalFormat, data.pixelSize, data.pvp,
+          data.isCompressed ? data.compressorName : EQ_COMPRESSOR_NONE,
+          data.compressorFlags, nChunks, quality };
+    _stage( &header, sizeof( header ));
+
+    if( !data.isCompressed )
+    {
+        const uint64_t size = data.pvp.getArea() * data.pixelSize;
+        _stage( &size, sizeof( size ));
+        add( data.pixels, size );
+        return;
+    }
+
+    _stage( &data.compressedSize.front(), nChunks * sizeof( uint64_t ));
+    for( uint32_t i = 0; i < nChunks; ++i )
+    {
+        if( data.compressedSize[i] > 0 )
+            add( data.compressedData[i], data.compressedSize[i] );
+    }
+}
+
+void PixelDataWriter::add( const PixelData& data, const float quality,
+                           const int32_t y, const int32_t h )
+{
+    LBASSERT( y >= 0 && y + h <= data.pvp.h );
+    const PixelViewport pvp( data.pvp.x, data.pvp.y + y, data.pvp.w, h );
+
+    if( !data.isCompressed )
+    {
+        const FrameData::ImageHeader header =
+            { data.internalFormat, data.externalFormat, data.pixelSize, pvp,
+              EQ_COMPRESSOR_NONE, data.compressorFlags, 1, quality };
+        _stage( &header, sizeof( header ));
+
+        const uint64_t rowSize = uint64_t( data.pvp.w ) * data.pixelSize;
+        const uint64_t size = rowSize * h;
+        _stage( &size, sizeof( size ));
+        add( static_cast< const uint8_t* >( data.pixels ) + y * rowSize, size );
+        return;
+    }
+
+    const PixelStrips& strips = getPixelStrips( data );
+    PixelStrips::const_iterator i = strips.begin();
+    while( i != strips.end() && i->y != y )
+        ++i;
+    LBASSERT( i != strips.end() && i->h == h );
+    if( i == strips.end( ))
+        return;
+
+    const FrameData::ImageHeader header =
+        { data.internalFormat, data.externalFormat, data.pixelSize, pvp,
+          data.compressorName, data.compressorFlags & ~STRIP_COMPRESSED,
+          uint32_t( i->nChunks ), quality };
+    _stage( &header, sizeof( header ));
+    _stage( &data.compressedSize[ i->chunk ], i->nChunks * sizeof( uint64_t ));
+    for( size_t j = i->chunk; j < i->chunk + i->nChunks; ++j )
+    {
+        if( data.compressedSize[j] > 0 )
+            add( data.compressedData[j], data.compressedSize[j] );
+    }
+}
+
+void PixelDataWriter::addImage( NodeFrameDataTransmitPacket& packet,
+                                const PixelDataWriter& image )
+{
+    static const uint64_t padding = 0;
+    const uint64_t packetSize = sizeof( packet ) - 8 * sizeof( uint8_t );
+    const uint64_t size = packetSize + image.getSize();
+    packet.size = ( size + 7 ) & ~uint64_t( 7 );
+    _stage( &packet, packetSize );
+
+    if( image.getSize() > 0 )
+    {
+        std::vector< uint8_t > data( image.getSize( ));
+        image.copy( &data.front( ));
+        _stage( &data.front(), data.size( ));
+    }
+    _stage( &padding, packet.size - size );
+}
+
+bool PixelDataWriter::getStripRows( const std::vector< const PixelData* >&
+                                        datas,
+                                    const uint64_t stripSize,
+                                    std::vector< int32_t >& rows )
+{
+    rows.clear();
+    if( datas.empty( ))
+        return false;
+
+    const PixelViewport& pvp = datas.front()->pvp;
+    uint64_t rowSize = 0;
+    for( size_t i = 0; i < datas.size(); ++i )
+    {
+        const PixelData& data = *datas[i];
+        if( data.pvp != pvp )
+            return false;
+
+        rowSize += uint64_t( data.pvp.w ) * data.pixelSize;
+        if( !data.isCompressed )
+            continue;
+        if( !( data.compressorFlags & STRIP_COMPRESSED ))
+            return false;
+
+        // all strip-compressed buffers have to use the same strips
+        const PixelStrips& strips = getPixelStrips( data );
+        std::vector< int32_t > stripRows;
+        for( PixelStrips::const_iterator j = strips.begin();
+             j != strips.end(); ++j )
+        {
+            stripRows.push_back( j->y );
+        }
+        stripRows.push_back( pvp.h );
+
+        if( rows.empty( ))
+            rows.swap( stripRows );
+        else if( rows != stripRows )
+            return false;
+    }
+
+    if( rows.empty( ))
+    {
+        const uint64_t nStrips = LB_MAX( 1u, LB_MIN( uint64_t( pvp.h ),
+                                           rowSize * pvp.h / stripSize ));
+        for( uint64_t i = 0; i <= nStrips; ++i )
+            rows.push_back( int32_t( uint64_t( pvp.h ) * i / nStrips ));
+    }
+    return rows.size() > 2;
+}
+
+bool PixelDataWriter::send( co::ConnectionPtr connection, const void* header,
+                            const uint64_t headerSize ) const
+{
+    // one send for the header and the first staged image header
+    const uint8_t* bytes = static_cast< const uint8_t* >( header );
+    std::vector< uint8_t > first( bytes, bytes + headerSize );
+    std::vector< Item >::const_iterator i = _items.begin();
+    if( i != _items.end() && !i->data )
+    {
+        first.insert( first.end(), _staging.begin() + i->offset,
+                      _staging.begin() + i->offset + i->size );
+        ++i;
+    }
+    if( !connection->send( &first.front(), first.size(), true ))
+        return false;
+
+    for( ; i != _items.end(); ++i )
+    {
+        const void* data = i->data ? i->data : &_staging[ i->offset ];
+        if( !connection->send( data, i->size, true ))
+            return false;
+    }
+    return true;
+}
+
+void PixelDataWriter::copy( uint8_t* to ) const
+{
+    for( std::vector< Item >::const_iterator i = _items.begin();
+         i != _items.end(); ++i )
+    {
+        const void* data = i->data ? i->data : &_staging[ i->offset ];
+        ::memcpy( to, data, i->size );
+        to += i->size;
+    }
+}
+
+void PixelDataWriter::_stage( const void* data, const uint64_t size )
+{
+    if( size == 0 )
+        return;
+
+    const uint64_t offset = _staging.size();
+    const uint8_t* bytes = static_cast< const uint8_t* >( data );
+    _staging.insert( _staging.end(), bytes, bytes + size );
+    _size += size;
+
+    if( !_items.empty() && !_items.back().data )
+    {
+        // staged items are consecutive in the staging buffer
+        _items.back().size += size;
+        return;
+    }
+    const Item item = { 0, offset, size };
+    _items.push_back( item );
+}
+
+void PixelDataWriter::_reference( const void* data, const uint64_t size )
+{
+    const uint8_t* bytes = static_cast< const uint8_t* >( data );
+    _size += size;
+
+    if( !_items.empty( ))
+    {
+        Item& last = _items.back();
+        if( last.data && last.data + last.size == bytes )
+        {
+            last.size += size;
+            return;
+        }
+    }
+    const Item item = { bytes, 0, size };
+    _items.push_back( item );
+}
+
+}
+}
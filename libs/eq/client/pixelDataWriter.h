@@ -0,0 +1,137 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PIXELDATAWRITER_H
+#define EQ_PIXELDATAWRITER_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+#include <co/types.h>
+
+#include <vector>
+
+namespace eq
+{
+struct NodeFrameDataTransmitPacket;
+
+namespace detail
+{
+/**
+ * Gathers a transmit packet and its pixel data for sending.
+ *
+ * The wire format of one image buffer is its FrameData::ImageHeader, the size
+ * of each chunk as uint64_t and the chunk data. Headers, sizes and small
+ * chunks are coalesced into one internal staging buffer, larger chunks are
+ * referenced in place, and chunks adjacent in memory are merged. The data is
+ * then sent with one send per gathered item instead of one per header, size
+ * and chunk.
+ *
+ * Referenced data has to stay valid until the writer has been sent or copied.
+ */
+class PixelDataWriter
+{
+public:
+    EQ_API PixelDataWriter();
+    EQ_API ~PixelDataWriter();
+
+    /** Add raw data. */
+    EQ_API void add( const void* data, const uint64_t size );
+
+    /** Add a copy of raw data, which does not need to stay valid. */
+    EQ_API void addCopy( const void* data, const uint64_t size );
+
+    /**
+     * Add the header, chunk sizes and chunks of an image buffer.
+     *
+     * The data is uncompressed or compressed as a whole.
+     */
+    EQ_API void add( const PixelData& data, const float quality );
+
+    /**
+     * Add the rows [y, y + h) of an image buffer as separate pixel data.
+     *
+     * The data is uncompressed, or strip-compressed with a strip starting at
+     * y of height h. The strip is written like an image buffer compressed as
+     * a whole, with its own header and the chunks of its compressor, and is
+     * sent as a separate image.
+     */
+    EQ_API void add( const PixelData& data, const float quality,
+                     const int32_t y, const int32_t h );
+
+    /**
+     * Add a copy of an image packet and its data to a batch of images.
+     *
+     * The packet is written without its command header and padded to eight
+     * bytes, see FrameData::addImages(). Its size is set to the padded size.
+     *
+     * @param packet the image packet.
+     * @param image the pixel data of the image.
+     */
+    EQ_API void addImage( NodeFrameDataTransmitPacket& packet,
+                          const PixelDataWriter& image );
+
+    /**
+     * Compute the rows at which the given image buffers can be split into
+     * independently decodable strips.
+     *
+     * Strip-compressed buffers define the rows, uncompressed buffers are split
+     * into strips of about stripSize bytes.
+     *
+     * @param datas the pixel data of all buffers of one image.
+     * @param stripSize the target size of uncompressed strips.
+     * @param rows returns the first row of each strip and the height.
+     * @return true if the buffers can be split into at least two strips.
+     */
+    EQ_API static bool getStripRows( const std::vector< const PixelData* >&
+                                         datas,
+                                     const uint64_t stripSize,
+                                     std::vector< int32_t >& rows );
+
+    /**
+     * Send a packet header and all data over a connection locked by the
+     * caller. The header is coalesced with the staged data.
+     */
+    EQ_API bool send( co::ConnectionPtr connection, const void* header,
+                      const uint64_t headerSize ) const;
+
+    /** Copy all data to the given memory of getSize() bytes. */
+    EQ_API void copy( uint8_t* to ) const;
+
+    /** @return the total size of all added data. */
+    uint64_t getSize() const { return _size; }
+
+    /** @return the number of sends needed by send(). */
+    size_t getNItems() const { return _items.size(); }
+
+private:
+    struct Item
+    {
+        const uint8_t* data; //!< referenced data, or 0 if staged
+        uint64_t offset;     //!< offset in the staging buffer if staged
+        uint64_t size;
+    };
+
+    std::vector< Item > _items;
+    std::vector< uint8_t > _staging;
+    uint64_t _size;
+
+    void _stage( const void* data, const uint64_t size );
+    void _reference( const void* data, const uint64_t size );
+};
+}
+}
+
+#endif // EQ_PIXELDATAWRITER_H
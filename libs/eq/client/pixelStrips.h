@@ -0,0 +1,82 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_PIXELSTRIPS_H
+#define EQ_PIXELSTRIPS_H
+
+#include <eq/client/pixelData.h>
+#include <lunchbox/debug.h>
+
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Set in the compressor flags of strip-compressed data, not for plugins.
+ *
+ * Strip-compressed data exists only in memory. It is never sent as such, but
+ * each strip is sent as a separate image with its own header and chunks, see
+ * PixelDataWriter::add(). The wire format of images is therefore unchanged.
+ */
+static const uint32_t STRIP_COMPRESSED = 0x80000000u;
+
+/** One horizontal strip of strip-compressed pixel data. */
+struct PixelStrip
+{
+    int32_t y;      //!< first row, relative to the pixel data
+    int32_t h;      //!< number of rows
+    size_t chunk;   //!< index of the first compressed chunk
+    size_t nChunks; //!< number of compressed chunks
+};
+typedef std::vector< PixelStrip > PixelStrips;
+
+/**
+ * @return the strips of strip-compressed pixel data.
+ *
+ * The first chunk of strip-compressed data is the strip table: the number of
+ * strips followed by the height and the number of chunks of each strip. It is
+ * followed by the chunks of all strips.
+ */
+inline PixelStrips getPixelStrips( const PixelData& data )
+{
+    LBASSERT( data.compressorFlags & STRIP_COMPRESSED );
+    const uint32_t* const table =
+        reinterpret_cast< const uint32_t* >( data.compressedData[0] );
+    const size_t nStrips = table[0];
+    LBASSERT( data.compressedSize[0] == ( 1 + 2 * nStrips ) * sizeof( uint32_t ));
+
+    PixelStrips strips( nStrips );
+    int32_t y = 0;
+    size_t chunk = 1;
+    for( size_t i = 0; i < nStrips; ++i )
+    {
+        strips[i].y = y;
+        strips[i].h = int32_t( table[ 1 + 2 * i ] );
+        strips[i].chunk = chunk;
+        strips[i].nChunks = table[ 2 + 2 * i ];
+        y += strips[i].h;
+        chunk += strips[i].nChunks;
+    }
+    LBASSERT( y == data.pvp.h );
+    LBASSERT( chunk == data.compressedSize.size( ));
+    return strips;
+}
+}
+}
+
+#endif // EQ_PIXELSTRIPS_H
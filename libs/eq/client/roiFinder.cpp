@@ -30,6 +30,7 @@
 #include "roiFragmentShaderRGB_glsl.h"
 #endif
 
+#include "compositorKernels.h"
 #include "gl.h"
 #include "log.h"
 
@@ -47,6 +48,7 @@ static const char seeds = 42;
 static const char* shaderRBInfo = &seeds;
 
 #define GRID_SIZE 16 // will be replaced later by variable
+#define MOTION_MARGIN 2 // blocks added around the regions of the last frame
 
 
 ROIFinder::ROIFinder()
@@ -204,6 +206,150 @@ void ROIFinder::_init( )
 }
 
 
+void ROIFinder::_init( const uint32_t* pixels, const PixelViewport& pvp,
+                       const uint32_t background, const uint32_t mask )
+{
+    _areasToCheck.clear();
+    memset( &_mask[0]   , 0, _mask.size( ));
+    memset( &_tmpMask[0], 0, _tmpMask.size( ));
+
+    const detail::HasForegroundFunc hasForeground = detail::getHasForeground();
+
+    for( int32_t y = 0; y < pvp.h; y++ )
+    {
+        const uint32_t* src = pixels + y * pvp.w;
+              uint8_t*  dst = &_mask[0] +
+                              (( pvp.y + y ) / GRID_SIZE - _pvp.y ) * _wb;
+
+        for( int32_t x = 0; x < _w; x++ )
+        {
+            if( dst[x] ) // already found in a previous row
+                continue;
+
+            const int32_t start = LB_MAX(( _pvp.x + x ) * GRID_SIZE, pvp.x );
+            const int32_t end   = LB_MIN(( _pvp.x + x + 1 ) * GRID_SIZE,
+                                         pvp.x + pvp.w );
+            if( hasForeground( src + start - pvp.x, end - start, background,
+                               mask ))
+            {
+                dst[x] = 255;
+            }
+        }
+    }
+}
+
+
+static PixelViewport _getBoundingPVP( const PixelViewport& pvp )
+{
+    PixelViewport pvp_;
+
+    pvp_.x = ( pvp.x / GRID_SIZE );
+    pvp_.y = ( pvp.y / GRID_SIZE );
+
+    pvp_.w = (( pvp.x + pvp.w + GRID_SIZE-1 )/GRID_SIZE ) - pvp_.x;
+    pvp_.h = (( pvp.y + pvp.h + GRID_SIZE-1 )/GRID_SIZE ) - pvp_.y;
+
+    return pvp_;
+}
+
+
+/** @return true if a pixel of the block differs from the background. */
+static bool _hasForeground( const uint32_t* pixels, const PixelViewport& pvp,
+                            PixelViewport block, const uint32_t background,
+                            const uint32_t mask )
+{
+    const detail::HasForegroundFunc hasForeground = detail::getHasForeground();
+
+    block.intersect( pvp );
+    const uint32_t* src = pixels + ( block.y - pvp.y ) * pvp.w +
+                          ( block.x - pvp.x );
+    for( int32_t y = 0; y < block.h; ++y, src += pvp.w )
+        if( hasForeground( src, block.w, background, mask ))
+            return true;
+    return false;
+}
+
+/** Adds a pvp, merging it with the overlapping ones. */
+static void _addMerged( PixelViewports& pvps, PixelViewport pvp )
+{
+    for( PixelViewports::iterator i = pvps.begin(); i != pvps.end(); )
+    {
+        PixelViewport overlap = *i;
+        overlap.intersect( pvp );
+        if( overlap.hasArea( ))
+        {
+            // the merged pvp may overlap with previous ones, restart
+            pvp.merge( *i );
+            pvps.erase( i );
+            i = pvps.begin();
+        }
+        else
+            ++i;
+    }
+    pvps.push_back( pvp );
+}
+
+
+bool ROIFinder::_predictRegions( const PixelViewports& prediction,
+                                 const uint32_t* pixels,
+                                 const PixelViewport& pvp,
+                                 const uint32_t background,
+                                 const uint32_t mask,
+                                 PixelViewports& resultPVPs )
+{
+    // mark the blocks of the dilated regions in _tmpMask
+    memset( &_tmpMask[0], 0, _tmpMask.size( ));
+    resultPVPs.clear();
+
+    const PixelViewport blocks( 0, 0, _w, _h );
+    for( PixelViewportsCIter i = prediction.begin(); i != prediction.end(); ++i)
+    {
+        PixelViewport region = _getBoundingPVP( *i );
+        region.x -= _pvp.x + MOTION_MARGIN;
+        region.y -= _pvp.y + MOTION_MARGIN;
+        region.w += 2 * MOTION_MARGIN;
+        region.h += 2 * MOTION_MARGIN;
+        region.intersect( blocks );
+        if( !region.hasArea( ))
+            continue;
+
+        for( int32_t y = region.y; y < region.y + region.h; ++y )
+            memset( &_tmpMask[ y * _wb + region.x ], 1, region.w );
+
+        region.x += _pvp.x;
+        region.y += _pvp.y;
+        region.apply( Zoom( GRID_SIZE, GRID_SIZE ));
+        region.intersect( pvp );
+        _addMerged( resultPVPs, region );
+    }
+
+    // content crossing the margin touches the blocks on the edge of the
+    // prediction, i.e., blocks with a neighbour outside of it
+    for( int32_t y = 0; y < _h; ++y )
+    {
+        const uint8_t* row = &_tmpMask[ y * _wb ];
+        for( int32_t x = 0; x < _w; ++x )
+        {
+            if( !row[x] )
+                continue;
+
+            const bool isEdge = ( x > 0      && !row[ x - 1 ] ) ||
+                                ( x < _w - 1 && !row[ x + 1 ] ) ||
+                                ( y > 0      && !row[ x - _wb ] ) ||
+                                ( y < _h - 1 && !row[ x + _wb ] );
+            if( !isEdge )
+                continue;
+
+            PixelViewport block( _pvp.x + x, _pvp.y + y, 1, 1 );
+            block.apply( Zoom( GRID_SIZE, GRID_SIZE ));
+            if( _hasForeground( pixels, pvp, block, background, mask ))
+                return false;
+        }
+    }
+    return true;
+}
+
+
 void ROIFinder::_fillWithColor( const PixelViewport& pvp,
                                       uint8_t* dst, const uint8_t val )
 {
@@ -660,20 +806,6 @@ void ROIFinder::_readbackInfo( )
 }
 
 
-static PixelViewport _getBoundingPVP( const PixelViewport& pvp )
-{
-    PixelViewport pvp_;
-
-    pvp_.x = ( pvp.x / GRID_SIZE );
-    pvp_.y = ( pvp.y / GRID_SIZE );
-
-    pvp_.w = (( pvp.x + pvp.w + GRID_SIZE-1 )/GRID_SIZE ) - pvp_.x;
-    pvp_.h = (( pvp.y + pvp.h + GRID_SIZE-1 )/GRID_SIZE ) - pvp_.y;
-
-    return pvp_;
-}
-
-
 PixelViewports ROIFinder::findRegions( const uint32_t         buffers,
                                        const PixelViewport&   pvp,
                                        const Zoom&            zoom,
@@ -727,11 +859,7 @@ for( int i = 0; i < 100; i++ ) {
     _init( );
 //    _dumpDebug( 0 );
 
-    _emptyFinder.update( &_mask[0], _wb, _hb );
-    _emptyFinder.setLimits( 200, 0.002f );
-    
-    result.clear();
-    _findAreas( result );
+    _findRegions( result );
 //    _dumpDebug( 1 );
 
 #ifdef EQ_ROI_USE_TRACKER
@@ -763,6 +891,95 @@ for( int i = 0; i < 100; i++ ) {
     return result;
 }
 
+void ROIFinder::_findRegions( PixelViewports& resultPVPs )
+{
+    _emptyFinder.update( &_mask[0], _wb, _hb );
+    _emptyFinder.setLimits( 200, 0.002f );
+
+    resultPVPs.clear();
+    _findAreas( resultPVPs );
+}
+
+PixelViewports ROIFinder::findRegions( const Image&     image,
+                                       const uint32_t   stage,
+                                       const uint128_t& frameID )
+{
+    const PixelViewport& pvp = image.getPixelViewport();
+    PixelViewports result;
+    result.push_back( pvp );
+
+    // same tests as the GPU shaders: depth not on the far plane, or not black
+    const bool useDepth = image.hasPixelData( Frame::BUFFER_DEPTH );
+    const Frame::Buffer buffer = useDepth ? Frame::BUFFER_DEPTH :
+                                            Frame::BUFFER_COLOR;
+    if( !image.hasPixelData( buffer ))
+        return result;
+
+    uint32_t background = 0xffffffffu;
+    uint32_t mask = 0xffffffffu;
+    switch( image.getExternalFormat( buffer ))
+    {
+      case EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT:
+          break;
+
+      case EQ_COMPRESSOR_DATATYPE_RGBA:
+      case EQ_COMPRESSOR_DATATYPE_BGRA:
+      {
+          const uint8_t colorBytes[4] = { 0xff, 0xff, 0xff, 0 };
+          memcpy( &mask, colorBytes, sizeof( mask ));
+          background = 0;
+          break;
+      }
+
+      default:
+          return result;
+    }
+
+    // the histograms of _getObjectPVP count up to 256 blocks
+    const PixelViewport blockPVP = _getBoundingPVP( pvp );
+    if( blockPVP.w > 255 || blockPVP.h > 255 )
+        return result;
+
+#ifdef EQ_ROI_USE_TRACKER
+    uint8_t* ticket;
+    if( !_roiTracker.useROIFinder( pvp, stage, frameID, ticket ))
+        return result;
+#endif
+
+    _pvpOriginal = pvp;
+    _resize( blockPVP );
+    const uint32_t* pixels =
+        reinterpret_cast< const uint32_t* >( image.getPixelPointer( buffer ));
+
+#ifdef EQ_ROI_USE_TRACKER
+    // reuse the regions of the last frame while the content stays inside
+    PixelViewports prediction;
+    if( _roiTracker.getPrediction( ticket, prediction ) &&
+        _predictRegions( prediction, pixels, pvp, background, mask, result ))
+    {
+        _roiTracker.usePrediction( ticket );
+        return result;
+    }
+#endif
+
+    _init( pixels, pvp, background, mask );
+    _findRegions( result );
+
+    for( PixelViewports::iterator i = result.begin(); i != result.end(); )
+    {
+        i->intersect( pvp );
+        if( i->hasArea( ))
+            ++i;
+        else
+            i = result.erase( i );
+    }
+
+#ifdef EQ_ROI_USE_TRACKER
+    _roiTracker.updateDelay( result, ticket );
+#endif
+    return result;
+}
+
 const GLEWContext* ROIFinder::glewGetContext() const
 {
     LBASSERT( _glObjects );
@@ -37,7 +37,7 @@ namespace eq
     class ROIFinder
     {
     public:
-        ROIFinder();
+        EQ_API ROIFinder();
         virtual ~ROIFinder() {}
 
         /**
@@ -59,6 +59,24 @@ namespace eq
                                     const uint128_t&       frameID,
                                     ObjectManager*         glObjects );
 
+        /**
+         * Find the regions of interest of an image in main memory.
+         *
+         * Computes the per-block occupancy on the CPU and splits the occupied
+         * area like the GPU path. A block is occupied if one of its depth
+         * values is not on the far plane or, without a depth buffer, if one of
+         * its colors is not black.
+         *
+         * @param image     image with 32 bit color or depth pixel data.
+         * @param stage     compositing stage (to track separate statistics).
+         * @param frameID   ID of current frame (to track separate statistics).
+         *
+         * @return the areas to keep, within the image's pixel viewport
+         */
+        EQ_API PixelViewports findRegions( const Image&     image,
+                                           const uint32_t   stage,
+                                           const uint128_t& frameID );
+
         /** @return the GL function table, valid during findRegions(). */
         const GLEWContext* glewGetContext() const;
 
@@ -80,6 +98,22 @@ namespace eq
             that was previously read-back from GPU in _readbackInfo */
         void _init( );
 
+        /** Clears masks, fills per-block occupancy _mask from the pixels of
+            an image in main memory */
+        void _init( const uint32_t* pixels, const PixelViewport& pvp,
+                    const uint32_t background, const uint32_t mask );
+
+        /** Splits the occupied blocks of _mask into regions */
+        void _findRegions( PixelViewports& resultPVPs );
+
+        /** Dilates the regions of the previous frame by a motion margin.
+            @return false if the edge blocks of the dilated regions are
+                    occupied, i.e., the content may have left them */
+        bool _predictRegions( const PixelViewports& prediction,
+                              const uint32_t* pixels, const PixelViewport& pvp,
+                              const uint32_t background, const uint32_t mask,
+                              PixelViewports& resultPVPs );
+
         /** For debugging purposes */
         void _fillWithColor( const PixelViewport& pvp, uint8_t* dst,
                              const uint8_t val );
@@ -18,6 +18,11 @@
 
 namespace eq
 {
+namespace
+{
+/** Maximum number of consecutive frames using the regions of one search */
+static const uint32_t _maxPredictions = 16;
+}
 
 ROITracker::Area::Area( const PixelViewport& pvp_,
                               uint32_t       lastSkip_,
@@ -25,6 +30,7 @@ ROITracker::Area::Area( const PixelViewport& pvp_,
     :pvp(      pvp_      )
     ,lastSkip( lastSkip_ )
     ,skip(     skip_     )
+    ,nPredicted( 0 )
 {
 }
 
@@ -114,6 +120,12 @@ bool ROITracker::useROIFinder( const PixelViewport& pvp,
     if( match->skip == 0 ) // don't skip frame
     {
         curStage.areas.push_back( Area( pvp, match->lastSkip ));
+        if( match->pvp == pvp ) // keep regions as prediction for this frame
+        {
+            Area& area = curStage.areas.back();
+            area.regions    = match->regions;
+            area.nPredicted = match->nPredicted;
+        }
         return _returnPositive( ticket );
     }
     //else skip frame
@@ -123,8 +135,7 @@ bool ROITracker::useROIFinder( const PixelViewport& pvp,
 }
 
 
-void ROITracker::updateDelay( const PixelViewports& pvps,
-                              const uint8_t* ticket )
+bool ROITracker::_checkTicket( const uint8_t* ticket ) const
 {
     LBASSERT( _needsUpdate );
     LBASSERTINFO( ticket == _ticket, "Wrong ticket" );
@@ -132,8 +143,17 @@ void ROITracker::updateDelay( const PixelViewports& pvps,
     if( ticket != _ticket )
     {
         LBERROR << "Wrong ticket" << std::endl;
-        return;
+        return false;
     }
+    return true;
+}
+
+
+void ROITracker::updateDelay( const PixelViewports& pvps,
+                              const uint8_t* ticket )
+{
+    if( !_checkTicket( ticket ))
+        return;
 
     uint32_t totalAreaFound = 0;
     for( uint32_t i = 0; i < pvps.size(); i++ )
@@ -151,6 +171,37 @@ void ROITracker::updateDelay( const PixelViewports& pvps,
         area.lastSkip = LB_MIN( area.lastSkip*2 + 1, 64 );
         area.skip     = area.lastSkip;
     }
+    area.regions    = pvps;
+    area.nPredicted = 0;
+    _needsUpdate = false;
+}
+
+
+bool ROITracker::getPrediction( const uint8_t* ticket,
+                                PixelViewports& regions ) const
+{
+    if( !_checkTicket( ticket ))
+        return false;
+
+    const stde::hash_map< uint32_t, Stage >::const_iterator i =
+        _curFrame->find( _lastStage );
+    LBASSERT( i != _curFrame->end( ));
+
+    const Area& area = i->second.areas.back();
+    if( area.regions.empty() || area.nPredicted >= _maxPredictions )
+        return false;
+
+    regions = area.regions;
+    return true;
+}
+
+
+void ROITracker::usePrediction( const uint8_t* ticket )
+{
+    if( !_checkTicket( ticket ))
+        return;
+
+    ++(*_curFrame)[ _lastStage ].areas.back().nPredicted;
     _needsUpdate = false;
 }
 
@@ -18,6 +18,7 @@
 #ifndef EQ_ROI_TRACKER_H
 #define EQ_ROI_TRACKER_H
 
+#include <eq/client/api.h>
 #include <eq/client/types.h>
 #include <eq/fabric/pixelViewport.h> // member
 
@@ -34,7 +35,7 @@ namespace eq
     {
     public:
         ROITracker();
-        virtual ~ROITracker();
+        EQ_API virtual ~ROITracker();
 
         /**
          * Has to be called once before any ROI calculation. Tels wether
@@ -76,6 +77,30 @@ namespace eq
          */
         void updateDelay( const PixelViewports& pvps, const uint8_t* ticket );
 
+        /**
+         * Get the regions of the last search for the area of a positive
+         * useROIFinder() call.
+         *
+         * The regions are available if the area has the same pvp as in the
+         * previous frame. They are reused for at most _maxPredictions
+         * consecutive frames, to pick up content appearing away from them.
+         *
+         * @param  ticket   value from useROIFinder
+         * @param  regions  returns the regions found by the last search
+         *
+         * @return true if the regions can be used as a prediction.
+         */
+        bool getPrediction( const uint8_t* ticket,
+                            PixelViewports& regions ) const;
+
+        /**
+         * Has to be called instead of updateDelay if the prediction was used
+         * in place of a ROIFinder search.
+         *
+         * @param  ticket  value from useROIFinder
+         */
+        void usePrediction( const uint8_t* ticket );
+
     protected:
 
     private:
@@ -89,6 +114,8 @@ namespace eq
             PixelViewport pvp;
             uint32_t      lastSkip; //!< Previousely skiped number of frames
             uint32_t      skip;     //!< Number of frames to skip ROIFinder
+            PixelViewports regions; //!< Result of the last ROIFinder search
+            uint32_t      nPredicted; //!< Frames the regions were reused
         };
         /** Set of readback areas per compositiong stage */
         struct Stage
@@ -109,6 +136,7 @@ namespace eq
         uint32_t _lastStage;  //!< used in updateDelay to find last added area
 
         bool _returnPositive( uint8_t*& ticket );
+        bool _checkTicket( const uint8_t* ticket ) const;
     };
 }
 
@@ -0,0 +1,477 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "shmTransport.h"
+
+#include "log.h"
+
+#include <lunchbox/atomic.h>
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/uuid.h>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+#include <new>
+#include <sstream>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+static const uint32_t _magic = 0x45715368u; // 'EqSh'
+static const uint32_t _nSlots = 4;
+static const uint64_t _slotAlignment = 1024 * 1024;
+static const uint64_t _maxSlotSize = 64 * 1024 * 1024;
+static const uint64_t _headerSize = 4096;
+
+enum SlotState
+{
+    SLOT_FREE = 0,
+    SLOT_USED
+};
+
+/** The layout of the first page of a ring. */
+struct Header
+{
+    uint32_t magic;
+    uint32_t nSlots;
+    uint64_t slotSize;
+    lunchbox::a_int32_t states[ _nSlots ];
+};
+
+std::string _getName( const uint128_t& ring )
+{
+    std::ostringstream name;
+    name << "/eqImage" << std::hex << ring.high() << "_" << ring.low();
+    return name.str();
+}
+
+/** The layout of a handshake token, see ShmTransport::probe(). */
+struct Token
+{
+    uint32_t magic;
+    lunchbox::a_int32_t acknowledged;
+};
+
+std::string _getTokenName( const uint128_t& token )
+{
+    std::ostringstream name;
+    name << "/eqToken" << std::hex << token.high() << "_" << token.low();
+    return name.str();
+}
+
+#ifndef _WIN32
+/** @return the mapping of the given size of a shared memory name, or 0. */
+void* _map( const std::string& name, const int flags, const size_t size )
+{
+    const int fd = ::shm_open( name.c_str(), flags, S_IRUSR | S_IWUSR );
+    if( fd < 0 )
+        return 0;
+
+    const bool reserved = !( flags & O_CREAT ) ||
+                          ::ftruncate( fd, size ) == 0;
+    void* data = 0;
+    if( reserved )
+        data = ::mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    ::close( fd );
+
+    if( data == MAP_FAILED )
+        return 0;
+    return data;
+}
+#endif
+}
+
+/**
+ * A handshake token created by the sender. A destination node which can map
+ * the token and acknowledge it shares the memory of the sender.
+ */
+class ShmProbe
+{
+public:
+    ShmProbe( const uint128_t& id, Token* token ) : _id( id ), _token( token )
+        {}
+
+    ~ShmProbe()
+    {
+#ifndef _WIN32
+        ::munmap( _token, sizeof( Token ));
+        ::shm_unlink( _getTokenName( _id ).c_str( ));
+#endif
+    }
+
+    const uint128_t& getID() const { return _id; }
+
+    /** @return true if the destination acknowledged the token. */
+    bool isAcknowledged() const { return _token->acknowledged == 1; }
+
+#ifndef _WIN32
+    static ShmProbe* create()
+    {
+        const uint128_t id = lunchbox::UUID( true );
+        const std::string& name = _getTokenName( id );
+        void* data = _map( name, O_RDWR | O_CREAT | O_EXCL, sizeof( Token ));
+        if( !data )
+        {
+            LBWARN << "Can't create shared memory " << name << ": "
+                   << lunchbox::sysError << std::endl;
+            ::shm_unlink( name.c_str( ));
+            return 0;
+        }
+
+        Token* token = new( data ) Token;
+        token->magic = _magic;
+        token->acknowledged = 0;
+        return new ShmProbe( id, token );
+    }
+
+    static bool acknowledge( const uint128_t& id )
+    {
+        void* data = _map( _getTokenName( id ), O_RDWR, sizeof( Token ));
+        if( !data )
+            return false;
+
+        Token* token = reinterpret_cast< Token* >( data );
+        const bool valid = token->magic == _magic;
+        if( valid )
+            token->acknowledged = 1;
+        ::munmap( data, sizeof( Token ));
+        return valid;
+    }
+#endif
+
+private:
+    const uint128_t _id;
+    Token* const _token;
+};
+
+/** @return the size of a ring with the given slot size. */
+size_t _getRingSize( const uint64_t slotSize )
+{
+    return size_t( _headerSize + _nSlots * slotSize );
+}
+
+/** A mapped shared memory ring. */
+class ShmRing
+{
+public:
+    ShmRing( const uint128_t& id, Header* header )
+        : _id( id ), _header( header ), _slotSize( header->slotSize ) {}
+
+    ~ShmRing()
+    {
+#ifndef _WIN32
+        ::munmap( _header, _getRingSize( _slotSize ));
+#endif
+    }
+
+    const uint128_t& getID() const { return _id; }
+
+    uint64_t getSlotSize() const { return _slotSize; }
+
+    uint8_t* getData( const uint32_t slot )
+    {
+        LBASSERT( slot < _nSlots );
+        return reinterpret_cast< uint8_t* >( _header ) + _headerSize +
+               slot * _slotSize;
+    }
+
+    bool acquire( uint32_t& slot )
+    {
+        for( uint32_t i = 0; i < _nSlots; ++i )
+        {
+            if( _header->states[i].compareAndSwap( SLOT_FREE, SLOT_USED ))
+            {
+                slot = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release( const uint32_t slot )
+    {
+        LBASSERT( slot < _nSlots );
+        LBCHECK( _header->states[ slot ].compareAndSwap( SLOT_USED,
+                                                         SLOT_FREE ));
+    }
+
+#ifndef _WIN32
+    static ShmRing* create( const uint64_t slotSize )
+    {
+        const uint128_t id = lunchbox::UUID( true );
+        const std::string& name = _getName( id );
+        const int fd = ::shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL,
+                                   S_IRUSR | S_IWUSR );
+        if( fd < 0 )
+        {
+            LBWARN << "Can't create shared memory " << name << ": "
+                   << lunchbox::sysError << std::endl;
+            return 0;
+        }
+
+        // reserve the memory, a sparse mapping would fault on a full /dev/shm
+        const size_t size = _getRingSize( slotSize );
+#ifdef __linux__
+        const bool reserved = ::posix_fallocate( fd, 0, size ) == 0;
+#else
+        const bool reserved = ::ftruncate( fd, size ) == 0;
+#endif
+        void* data = 0;
+        if( reserved )
+            data = ::mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close( fd );
+
+        if( !data || data == MAP_FAILED )
+        {
+            LBINFO << "Can't reserve " << size << " bytes of shared memory,"
+                   << " using connection for image transport" << std::endl;
+            ::shm_unlink( name.c_str( ));
+            return 0;
+        }
+
+        Header* header = new( data ) Header;
+        header->magic = _magic;
+        header->nSlots = _nSlots;
+        header->slotSize = slotSize;
+        for( uint32_t i = 0; i < _nSlots; ++i )
+            header->states[i] = SLOT_FREE;
+        return new ShmRing( id, header );
+    }
+
+    static ShmRing* open( const uint128_t& id )
+    {
+        const std::string& name = _getName( id );
+        const int fd = ::shm_open( name.c_str(), O_RDWR, 0 );
+        if( fd < 0 )
+        {
+            LBWARN << "Can't open shared memory " << name << ": "
+                   << lunchbox::sysError << std::endl;
+            return 0;
+        }
+
+        // the slot size is chosen by the sender, see ShmTransport::acquire()
+        void* data = ::mmap( 0, _headerSize, PROT_READ, MAP_SHARED, fd, 0 );
+        size_t size = 0;
+        if( data != MAP_FAILED )
+        {
+            const Header* header = reinterpret_cast< const Header* >( data );
+            if( header->magic == _magic && header->nSlots == _nSlots &&
+                header->slotSize > 0 && header->slotSize <= _maxSlotSize )
+            {
+                size = _getRingSize( header->slotSize );
+            }
+            ::munmap( data, _headerSize );
+            data = size == 0 ? MAP_FAILED :
+                   ::mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        }
+        ::close( fd );
+        // the sender and this process keep the mapping
+        ::shm_unlink( name.c_str( ));
+
+        if( data == MAP_FAILED )
+        {
+            LBWARN << "Can't map shared memory image ring " << name << ": "
+                   << lunchbox::sysError << std::endl;
+            return 0;
+        }
+        return new ShmRing( id, reinterpret_cast< Header* >( data ));
+    }
+#endif
+
+private:
+    const uint128_t _id;
+    Header* const _header;
+    const uint64_t _slotSize;
+};
+
+ShmTransport& ShmTransport::getInstance()
+{
+    static ShmTransport* instance = new ShmTransport;
+    return *instance;
+}
+
+bool ShmTransport::probe( const uint128_t& node, uint128_t& token )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    if( _sendRings.find( node ) != _sendRings.end() ||
+        _probes.find( node ) != _probes.end() ||
+        _pending.find( node ) != _pending.end( ))
+    {
+        return false;
+    }
+
+    ShmProbe* probe = 0;
+#ifndef _WIN32
+    probe = ShmProbe::create();
+#endif
+    if( !probe )
+    {
+        _sendRings[ node ] = 0;
+        return false;
+    }
+
+    _probes[ node ] = probe;
+    token = probe->getID();
+    return true;
+}
+
+bool ShmTransport::acknowledge( const uint128_t& token )
+{
+#ifdef _WIN32
+    return false;
+#else
+    return ShmProbe::acknowledge( token );
+#endif
+}
+
+void ShmTransport::setAcknowledged( const uint128_t& node,
+                                    const uint128_t& token,
+                                    const bool acknowledged )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    Probes::iterator i = _probes.find( node );
+    if( i == _probes.end() || i->second->getID() != token )
+    {
+        LBWARN << "Unknown shared memory probe from " << node << std::endl;
+        return;
+    }
+
+    // the token memory has to be written by the destination, the ring is
+    // created by the first acquire()
+    ShmProbe* probe = i->second;
+    if( acknowledged && probe->isAcknowledged( ))
+        _pending[ node ] = false;
+    else
+        _sendRings[ node ] = 0;
+
+    _probes.erase( i );
+    delete probe;
+}
+
+uint8_t* ShmTransport::acquire( const uint128_t& node, const uint64_t size,
+                                uint128_t& ring, uint32_t& slot )
+{
+    ShmRing* shmRing = _getSendRing( node, size );
+    if( !shmRing || size > shmRing->getSlotSize() || !shmRing->acquire( slot ))
+        return 0;
+
+    ring = shmRing->getID();
+    return shmRing->getData( slot );
+}
+
+void ShmTransport::cancel( const uint128_t& node, const uint32_t slot )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    Rings::const_iterator i = _sendRings.find( node );
+    LBASSERT( i != _sendRings.end() && i->second );
+    if( i != _sendRings.end() && i->second )
+        i->second->release( slot );
+}
+
+uint8_t* ShmTransport::getData( const uint128_t& ring, const uint32_t slot )
+{
+    ShmRing* shmRing = _getReceiveRing( ring );
+    if( !shmRing || slot >= _nSlots )
+        return 0;
+    return shmRing->getData( slot );
+}
+
+void ShmTransport::release( const uint128_t& ring, const uint32_t slot )
+{
+    ShmRing* shmRing = _getReceiveRing( ring );
+    LBASSERT( shmRing );
+    if( shmRing )
+        shmRing->release( slot );
+}
+
+void ShmTransport::unlink()
+{
+#ifndef _WIN32
+    lunchbox::ScopedWrite mutex( _lock );
+    for( Rings::const_iterator i = _sendRings.begin();
+         i != _sendRings.end(); ++i )
+    {
+        // already unlinked if opened by the receiver
+        if( i->second )
+            ::shm_unlink( _getName( i->second->getID( )).c_str( ));
+    }
+#endif
+    for( Probes::const_iterator i = _probes.begin(); i != _probes.end(); ++i )
+        delete i->second;
+    _probes.clear();
+}
+
+ShmRing* ShmTransport::_getSendRing( const uint128_t& node,
+                                     const uint64_t size )
+{
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        Rings::const_iterator i = _sendRings.find( node );
+        if( i != _sendRings.end( ))
+            return i->second;
+
+        // other threads use the connection while the ring is created
+        Pending::iterator j = _pending.find( node );
+        if( j == _pending.end() || j->second )
+            return 0;
+        j->second = true;
+    }
+
+    // Reserving the memory takes long, create the ring unlocked. The slots
+    // hold the first image with some headroom for larger ones.
+    ShmRing* ring = 0;
+#ifndef _WIN32
+    uint64_t slotSize = size + size / 4 + _slotAlignment - 1;
+    slotSize -= slotSize % _slotAlignment;
+    slotSize = LB_MAX( slotSize, _slotAlignment );
+    if( slotSize <= _maxSlotSize )
+        ring = ShmRing::create( slotSize );
+#endif
+    if( ring )
+        LBINFO << "Using shared memory for images to " << node << ", "
+               << _nSlots << " slots of " << ring->getSlotSize() << " bytes"
+               << std::endl;
+
+    lunchbox::ScopedWrite mutex( _lock );
+    _sendRings[ node ] = ring;
+    _pending.erase( node );
+    return ring;
+}
+
+ShmRing* ShmTransport::_getReceiveRing( const uint128_t& ring )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    Rings::const_iterator i = _receiveRings.find( ring );
+    if( i != _receiveRings.end( ))
+        return i->second;
+
+    ShmRing* shmRing = 0;
+#ifndef _WIN32
+    shmRing = ShmRing::open( ring );
+#endif
+    _receiveRings[ ring ] = shmRing;
+    return shmRing;
+}
+
+}
+}
@@ -0,0 +1,132 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_SHMTRANSPORT_H
+#define EQ_SHMTRANSPORT_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+#include <lunchbox/lock.h>
+
+#include <map>
+
+namespace eq
+{
+namespace detail
+{
+class ShmProbe;
+class ShmRing;
+
+/**
+ * Transports image data between node processes on the same host.
+ *
+ * The sender owns one shared memory ring of fixed-size slots per destination
+ * node. The ring is created by the first image sent to the destination, and
+ * its slots are sized for this image with some headroom. Image data is
+ * written into a free slot, and only the transmit packet referencing the ring
+ * and slot is sent over the connection. The receiver maps
+ * the ring on first use, references the slot data from the received images and
+ * releases the slot once the images are no longer used.
+ *
+ * A destination uses shared memory only after a handshake: the sender creates
+ * a token in shared memory and sends its identifier to the destination, which
+ * acknowledges the token in memory if it can map it. Until then, and for
+ * destinations which did not acknowledge the token, images larger than a slot
+ * or a full ring, the data uses the connection. The transport is process-wide
+ * and thread-safe.
+ */
+class ShmTransport
+{
+public:
+    /** @return the shared memory transport of this process. */
+    EQ_API static ShmTransport& getInstance();
+
+    /**
+     * Start the handshake with a destination node.
+     *
+     * @param node the destination node.
+     * @param token returns the token to send to the destination.
+     * @return true if the token has to be sent, false if the handshake was
+     *         already started or is not possible.
+     */
+    EQ_API bool probe( const uint128_t& node, uint128_t& token );
+
+    /**
+     * Acknowledge a token received from a sender.
+     *
+     * @return true if the token is in memory shared with the sender.
+     */
+    EQ_API bool acknowledge( const uint128_t& token );
+
+    /**
+     * Finish the handshake with the reply of the destination node.
+     *
+     * @param node the destination node.
+     * @param token the token sent to the destination.
+     * @param acknowledged the result of acknowledge() on the destination.
+     */
+    EQ_API void setAcknowledged( const uint128_t& node,
+                                 const uint128_t& token,
+                                 const bool acknowledged );
+
+    /**
+     * Acquire a slot to send data to the given node.
+     *
+     * The first call after the handshake creates the ring to the node, with
+     * slots sized for the given data.
+     *
+     * @param node the destination node.
+     * @param size the size of the data.
+     * @param ring returns the identifier of the ring.
+     * @param slot returns the index of the slot.
+     * @return the slot memory, or 0 if the data has to use the connection.
+     */
+    EQ_API uint8_t* acquire( const uint128_t& node, const uint64_t size,
+                             uint128_t& ring, uint32_t& slot );
+
+    /** Release a slot acquired by the sender which was not sent. */
+    EQ_API void cancel( const uint128_t& node, const uint32_t slot );
+
+    /** @return the data of a received slot, or 0 on error. */
+    EQ_API uint8_t* getData( const uint128_t& ring, const uint32_t slot );
+
+    /** Release a received slot for reuse by the sender. */
+    EQ_API void release( const uint128_t& ring, const uint32_t slot );
+
+    /** Remove the names of all sending rings and pending tokens. */
+    EQ_API void unlink();
+
+private:
+    ShmTransport() {}
+    ~ShmTransport() {}
+
+    lunchbox::Lock _lock;
+    typedef std::map< uint128_t, ShmRing* > Rings;
+    Rings _sendRings;    //!< per destination node, 0 if not on this host
+    Rings _receiveRings; //!< per ring identifier
+    typedef std::map< uint128_t, ShmProbe* > Probes;
+    Probes _probes;      //!< per destination node during the handshake
+    typedef std::map< uint128_t, bool > Pending;
+    Pending _pending;    //!< acknowledged nodes, true while the ring is created
+
+    /** @return the ring to the node, created for the given data size. */
+    ShmRing* _getSendRing( const uint128_t& node, const uint64_t size );
+    ShmRing* _getReceiveRing( const uint128_t& ring );
+};
+}
+}
+
+#endif // EQ_SHMTRANSPORT_H
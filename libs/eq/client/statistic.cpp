@@ -81,6 +81,8 @@ static StatisticData _statisticData[] =
    "finish frame", Vector3f( .5f, .5f, .5f ) }, 
  { Statistic::CONFIG_WAIT_FINISH_FRAME,
    "wait finish",  Vector3f( 1.0f, 0.f, 0.f ) }, 
+ { Statistic::NODE_PIXEL_POOL,
+   "pixel pool",   Vector3f( 1.f, 1.f, 1.f ) }, 
  { Statistic::ALL,
    "ALL EVENTS",   Vector3f( 0.0f, 0.f, 0.f ) }} ;
 }
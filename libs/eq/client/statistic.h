@@ -36,7 +36,7 @@ namespace eq
     struct Statistic
     {
         /** The type of the statistics event. */
-        enum Type // Also update string and color table in statistic.cpp
+        enum Type // Also update the tables in statistic.cpp, loadRecorder.cpp
         {
             NONE = 0,
             CHANNEL_CLEAR, //!< Sampling of Channel::frameClear
@@ -63,26 +63,36 @@ namespace eq
             CONFIG_FINISH_FRAME, //!< Sampling of Config::finishFrame
             /** Sampling of synchronization time during Config::finishFrame */
             CONFIG_WAIT_FINISH_FRAME,
+            NODE_PIXEL_POOL, //!< Pixel buffer memory usage of a node
             ALL          // must be last
         };
 
         Type type; //!< The type of statistic
         uint32_t frameNumber; //!< The frame during when the sampling happened
         uint32_t task; //!< @internal
-        uint32_t plugins[2]; //!< color,depth plugins (readback, compression)
-        float ratio; //!< compression ratio (transfer, compression)
+        union
+        {
+            /** color,depth plugins (readback, compression) */
+            uint32_t plugins[2];
+            /** Priority of CHANNEL_FRAME_TRANSMIT, lower is sent first */
+            uint32_t priority;
+        };
+        /** compression ratio (transfer, compression), reuse (pixel pool) */
+        float ratio;
         
         union
         {
             int64_t  startTime; //!< Absolute start time of the operation
             int64_t  idleTime;  //!< Absolute idle time of PIPE_IDLE
             float    currentFPS; //!< FPS of last frame (WINDOW_FPS)
+            int64_t  poolUsed;   //!< Bytes in use (NODE_PIXEL_POOL)
         };
         union
         {
             int64_t  endTime;    //!< Absolute end time of the operation
             int64_t  totalTime;  //!< Total time of a pipe frame (PIPE_IDLE)
             float    averageFPS; //!< Weighted sum averaging of FPS (WINDOW_FPS)
+            int64_t  poolCached; //!< Bytes kept for reuse (NODE_PIXEL_POOL)
         };
 
         char resourceName[32]; //!< A non-unique name of the originator
@@ -0,0 +1,166 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "transmitCostModel.h"
+
+#include "log.h"
+
+#include <co/plugins/compressor.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <limits>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+// Weight of a new sample in the moving averages
+static const float _weight = .2f;
+
+// Speed of a compressor with a speed of 1 in its EqCompressorInfo, which is
+// relative to the RLE compressor (bytes/ms)
+static const float _referenceSpeed = 1024.f * 1024.f;
+
+// Link speed without a known bandwidth, 1 GBit/s (bytes/ms)
+static const float _defaultLinkSpeed = 128.f * 1024.f * 1024.f / 1000.f;
+
+// Every n'th choice for a link uses the second best compressor, to keep the
+// measurements of the alternatives up to date
+static const uint32_t _exploreInterval = 64;
+}
+
+void TransmitCostModel::Average::add( const float sample )
+{
+    if( valid )
+        value += _weight * ( sample - value );
+    else
+        value = sample;
+    valid = true;
+}
+
+TransmitCostModel& TransmitCostModel::getInstance()
+{
+    static TransmitCostModel* instance = new TransmitCostModel;
+    return *instance;
+}
+
+uint32_t TransmitCostModel::choose( const uint128_t& node,
+                                    const int32_t bandwidth,
+                                    const co::CompressorInfos& candidates,
+                                    const uint64_t size )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    Link& link = _links[ node ];
+
+    uint32_t best = EQ_COMPRESSOR_NONE;
+    uint32_t second = EQ_COMPRESSOR_NONE;
+    float bestTime = _estimate( link, bandwidth, 0, size );
+    float secondTime = std::numeric_limits< float >::max();
+
+    for( co::CompressorInfosCIter i = candidates.begin();
+         i != candidates.end(); ++i )
+    {
+        const float time = _estimate( link, bandwidth, &(*i), size );
+        if( time < bestTime )
+        {
+            second = best;
+            secondTime = bestTime;
+            best = i->name;
+            bestTime = time;
+        }
+        else if( time < secondTime )
+        {
+            second = i->name;
+            secondTime = time;
+        }
+    }
+
+    if( ++link.nChoices % _exploreInterval == 0 &&
+        secondTime < std::numeric_limits< float >::max( ))
+    {
+        return second;
+    }
+
+    LBLOG( LOG_ASSEMBLY ) << "Use compressor 0x" << std::hex << best
+                          << std::dec << " for " << size << " bytes to "
+                          << node << ", estimated " << bestTime << " ms"
+                          << std::endl;
+    return best;
+}
+
+float TransmitCostModel::_estimate( const Link& link, const int32_t bandwidth,
+                                    const co::CompressorInfo* info,
+                                    const uint64_t size )
+{
+    const float linkPrior = bandwidth > 0 ?
+                            float( bandwidth ) * 1024.f / 1000.f :
+                            _defaultLinkSpeed;
+    const float linkSpeed = link.speed.get( linkPrior );
+    const float bytes = float( size );
+    if( !info )
+        return bytes / linkSpeed;
+
+    const Compressor& compressor = _compressors[ info->name ];
+    const float speed = _referenceSpeed * LB_MAX( info->speed, .01f );
+    const float ratio = compressor.ratio.get( info->ratio );
+    std::map< uint32_t, Average >::const_iterator i =
+        link.decompressSpeeds.find( info->name );
+    const float decompressSpeed = i == link.decompressSpeeds.end() ?
+                                  speed : i->second.get( speed );
+
+    return bytes / compressor.compressSpeed.get( speed ) +
+           bytes * ratio / linkSpeed + bytes / decompressSpeed;
+}
+
+void TransmitCostModel::addCompress( const uint32_t name, const uint64_t size,
+                                     const uint64_t compressedSize,
+                                     const float time )
+{
+    if( size == 0 )
+        return;
+
+    lunchbox::ScopedWrite mutex( _lock );
+    Compressor& compressor = _compressors[ name ];
+    compressor.ratio.add( float( compressedSize ) / float( size ));
+    if( time > 0.f )
+        compressor.compressSpeed.add( float( size ) / time );
+}
+
+void TransmitCostModel::addDecompress( const uint128_t& node,
+                                       const uint32_t name,
+                                       const uint64_t size, const float time )
+{
+    if( size == 0 || time <= 0.f || name <= EQ_COMPRESSOR_NONE )
+        return;
+
+    lunchbox::ScopedWrite mutex( _lock );
+    _links[ node ].decompressSpeeds[ name ].add( float( size ) / time );
+}
+
+void TransmitCostModel::addTransmit( const uint128_t& node,
+                                     const uint64_t size, const float time )
+{
+    if( size == 0 || time <= 0.f )
+        return;
+
+    lunchbox::ScopedWrite mutex( _lock );
+    _links[ node ].speed.add( float( size ) / time );
+}
+
+}
+}
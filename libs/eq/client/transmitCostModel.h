@@ -0,0 +1,117 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_TRANSMITCOSTMODEL_H
+#define EQ_TRANSMITCOSTMODEL_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+#include <co/compressorInfo.h> // CompressorInfos
+#include <lunchbox/lock.h>
+
+#include <map>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Estimates the cost of transmitting an image with a given compressor.
+ *
+ * The end-to-end time of one image buffer is estimated as
+ * @code
+ * size / compressSpeed + size * ratio / linkSpeed + size / decompressSpeed
+ * @endcode
+ * where the compression speed and the ratio of each compressor are measured
+ * during image transmission on this node, the link speed is measured per
+ * destination node, and the decompression speed of each compressor is reported
+ * back by each destination node. Until a value has been measured, it is
+ * derived from the compressor information and the connection bandwidth.
+ *
+ * All speeds are in bytes per millisecond. The model is shared by all
+ * channels of a node and is thread-safe.
+ */
+class TransmitCostModel
+{
+public:
+    /** @return the cost model of this process. */
+    EQ_API static TransmitCostModel& getInstance();
+
+    /**
+     * Choose the compressor with the lowest estimated transfer time.
+     *
+     * @param node the destination node.
+     * @param bandwidth the bandwidth of the connection in KB/s, or 0.
+     * @param candidates the compressors usable for the image buffer.
+     * @param size the uncompressed size of the image buffer.
+     * @return the name of the compressor, or EQ_COMPRESSOR_NONE.
+     */
+    EQ_API uint32_t choose( const uint128_t& node, const int32_t bandwidth,
+                            const co::CompressorInfos& candidates,
+                            const uint64_t size );
+
+    /** Add a compression sample of the given compressor. */
+    EQ_API void addCompress( const uint32_t name, const uint64_t size,
+                             const uint64_t compressedSize, const float time );
+
+    /** Add a decompression sample of the given compressor on a node. */
+    EQ_API void addDecompress( const uint128_t& node, const uint32_t name,
+                               const uint64_t size, const float time );
+
+    /** Add a sample of sending size bytes to the given node. */
+    EQ_API void addTransmit( const uint128_t& node, const uint64_t size,
+                             const float time );
+
+private:
+    TransmitCostModel() {}
+    ~TransmitCostModel() {}
+
+    /** An exponentially weighted moving average, invalid until set. */
+    struct Average
+    {
+        Average() : value( 0.f ), valid( false ) {}
+        void add( const float sample );
+        float get( const float prior ) const { return valid ? value : prior; }
+
+        float value;
+        bool valid;
+    };
+
+    struct Compressor
+    {
+        Average compressSpeed;
+        Average ratio;
+    };
+
+    struct Link
+    {
+        Link() : nChoices( 0 ) {}
+        Average speed;
+        std::map< uint32_t, Average > decompressSpeeds; //!< per compressor
+        uint32_t nChoices;
+    };
+
+    lunchbox::Lock _lock;
+    std::map< uint32_t, Compressor > _compressors;
+    std::map< uint128_t, Link > _links;
+
+    float _estimate( const Link& link, const int32_t bandwidth,
+                     const co::CompressorInfo* info, const uint64_t size );
+};
+}
+}
+
+#endif // EQ_TRANSMITCOSTMODEL_H
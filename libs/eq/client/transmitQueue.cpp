@@ -0,0 +1,206 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "transmitQueue.h"
+
+#include "channelPackets.h"
+#include "log.h"
+#include "node.h"
+
+#include <co/command.h>
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/thread.h>
+
+#include <sstream>
+
+namespace eq
+{
+namespace detail
+{
+class TransmitThread : public lunchbox::Thread
+{
+public:
+    TransmitThread( TransmitQueue& queue, const size_t index,
+                    const int32_t affinity )
+            : _queue( queue ), _index( index ), _affinity( affinity ) {}
+    virtual ~TransmitThread() {}
+
+protected:
+    virtual void run()
+    {
+        std::ostringstream name;
+        name << "Trm" << _index << " " << lunchbox::className( _queue._node );
+        lunchbox::Thread::setName( name.str( ));
+        if( _affinity != OFF && _affinity != AUTO )
+            lunchbox::Thread::setAffinity( _affinity );
+
+        while( true )
+        {
+            const uint128_t node = _queue._ready.pop();
+            if( node == uint128_t( 0 ))
+                return; // exit thread
+
+            _queue._execute( node );
+        }
+    }
+
+private:
+    TransmitQueue& _queue;
+    const size_t _index;
+    const int32_t _affinity;
+};
+
+TransmitQueue::TransmitQueue( Node* node )
+        : _node( node )
+        , _pending( 0 )
+{}
+
+TransmitQueue::~TransmitQueue()
+{
+    LBASSERT( _threads.empty( ));
+}
+
+void TransmitQueue::start( const size_t nThreads, const int32_t affinity )
+{
+    LBASSERT( _threads.empty( ));
+    LBASSERT( nThreads > 0 );
+
+    for( size_t i = 0; i < nThreads; ++i )
+    {
+        _threads.push_back( new TransmitThread( *this, i, affinity ));
+        _threads.back()->start();
+    }
+    LBLOG( LOG_ASSEMBLY ) << "Started " << nThreads << " transmit threads"
+                          << std::endl;
+}
+
+void TransmitQueue::exit()
+{
+    _pending.waitEQ( 0 );
+
+    for( size_t i = 0; i < _threads.size(); ++i )
+        _ready.push( uint128_t( 0 )); // wake up to exit
+
+    for( size_t i = 0; i < _threads.size(); ++i )
+    {
+        _threads[i]->join();
+        delete _threads[i];
+    }
+    _threads.clear();
+}
+
+void TransmitQueue::push( co::CommandPtr command )
+{
+    const co::ObjectPacket* packet = command->get< co::ObjectPacket >();
+    Entry entry;
+    entry.command = command;
+    uint128_t node;
+    switch( packet->command )
+    {
+      case fabric::CMD_CHANNEL_FRAME_TRANSMIT_IMAGE:
+      {
+          const ChannelFrameTransmitImagePacket* transmit =
+              command->get< ChannelFrameTransmitImagePacket >();
+          node = transmit->netNodeID;
+          entry.frameNumber = transmit->frameNumber;
+          entry.priority = transmit->priority;
+          entry.isImage = true;
+          break;
+      }
+
+      case fabric::CMD_CHANNEL_FRAME_SET_READY_NODE:
+          node = command->get< ChannelFrameSetReadyNodePacket >()->netNodeID;
+          break;
+
+      default:
+          LBUNIMPLEMENTED;
+          return;
+    }
+    LBASSERT( node != uint128_t( 0 ));
+
+    ++_pending;
+    lunchbox::ScopedWrite mutex( _lock );
+    Destination& destination = _destinations[ node ];
+    insert( destination.entries, entry );
+    if( !destination.busy )
+    {
+        destination.busy = true;
+        _ready.push( node );
+    }
+}
+
+namespace
+{
+/** @return true if the image of a should be transmitted before b. */
+bool _isMoreUrgent( const TransmitQueue::Entry& a,
+                    const TransmitQueue::Entry& b )
+{
+    // the earlier frame has the earlier deadline, frame numbers may wrap
+    const int32_t age = int32_t( b.frameNumber - a.frameNumber );
+    if( age != 0 )
+        return age > 0;
+    return a.priority < b.priority;
+}
+}
+
+void TransmitQueue::insert( Entries& entries, const Entry& entry )
+{
+    if( !entry.isImage )
+    {
+        entries.push_back( entry );
+        return;
+    }
+
+    // Move before less urgent images, but never past a set ready, which has to
+    // follow all images of its frame
+    Entries::iterator i = entries.end();
+    while( i != entries.begin( ))
+    {
+        const Entry& previous = *(i - 1);
+        if( !previous.isImage || !_isMoreUrgent( entry, previous ))
+            break;
+        --i;
+    }
+    entries.insert( i, entry );
+}
+
+void TransmitQueue::_execute( const uint128_t& node )
+{
+    co::CommandPtr command;
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        Destination& destination = _destinations[ node ];
+        LBASSERT( destination.busy );
+        LBASSERT( !destination.entries.empty( ));
+        command = destination.entries.front().command;
+        destination.entries.pop_front();
+    }
+
+    LBCHECK( (*command)( ));
+
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        Destination& destination = _destinations[ node ];
+        if( destination.entries.empty( ))
+            destination.busy = false;
+        else
+            _ready.push( node ); // round-robin with other destinations
+    }
+    --_pending;
+}
+
+}
+}
@@ -0,0 +1,121 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_TRANSMITQUEUE_H
+#define EQ_TRANSMITQUEUE_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+#include <co/commandQueue.h> // base class
+#include <lunchbox/lock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/mtQueue.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+class TransmitThread;
+
+/**
+ * The image transmission queue of a node, executed by a pool of threads.
+ *
+ * Commands are queued per destination node. Each destination is served by at
+ * most one thread at a time, which preserves the order of the commands to one
+ * node while transmissions to different nodes overlap. Destinations with
+ * pending commands are served round-robin.
+ *
+ * Image transmissions to one node are ordered by frame number and priority,
+ * so that the image the destination assembles first is sent first. They are
+ * never reordered across a set ready command.
+ *
+ * Only the commands of ChannelFrameTransmitImagePacket and
+ * ChannelFrameSetReadyNodePacket may be registered with this queue.
+ */
+class TransmitQueue : public co::CommandQueue
+{
+public:
+    TransmitQueue( Node* node );
+    virtual ~TransmitQueue();
+
+    /** Start the given number of threads with the given affinity. */
+    void start( const size_t nThreads, const int32_t affinity );
+
+    /** Execute all pending commands and stop the threads. */
+    void exit();
+
+    /** Queue the command to its destination node. */
+    virtual void push( co::CommandPtr command );
+
+    /** Same as push(). */
+    virtual void pushFront( co::CommandPtr command ) { push( command ); }
+
+    /** A queued command and its transmission order. */
+    struct Entry
+    {
+        Entry() : frameNumber( 0 ), priority( 0 ), isImage( false ) {}
+
+        co::CommandPtr command;
+        uint32_t frameNumber; //!< of an image transmission
+        uint32_t priority;    //!< of an image transmission, lower is first
+        bool isImage;         //!< false for a set ready
+    };
+    typedef std::deque< Entry > Entries;
+
+    /**
+     * Insert a command into the queue of a destination.
+     *
+     * Images move before images of later frames and, within a frame, before
+     * images of lower priority. They never move past a set ready, which has
+     * to follow all images of its frame. Frame numbers may wrap.
+     */
+    EQ_API static void insert( Entries& entries, const Entry& entry );
+
+private:
+    friend class TransmitThread;
+
+    Node* const _node;
+
+    struct Destination
+    {
+        Destination() : busy( false ) {}
+        Entries entries;
+        bool busy; //!< commands are queued in _ready or being executed
+    };
+    typedef std::map< uint128_t, Destination > Destinations;
+
+    lunchbox::Lock _lock;
+    Destinations _destinations;
+
+    /** Destinations with pending commands and no thread, 0 to exit. */
+    lunchbox::MTQueue< uint128_t > _ready;
+
+    /** The number of queued and executing commands. */
+    lunchbox::Monitor< size_t > _pending;
+
+    std::vector< TransmitThread* > _threads;
+
+    /** Execute the next command of the given destination. */
+    void _execute( const uint128_t& node );
+};
+}
+}
+
+#endif // EQ_TRANSMITQUEUE_H
@@ -0,0 +1,133 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "transmitShaper.h"
+
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/sleep.h>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+// Unused rate is kept for this long (ms), which allows a burst of this
+// duration after a pause
+static const double _maxBurst = 5.;
+
+// The received data is measured over at least this time (ms)
+static const double _receiveWindow = 100.;
+
+// Reported spare rates are used for this long (ms)
+static const double _maxSpareAge = 500.;
+
+// The unit of the spare shares
+static const uint32_t _fullShare = 1000;
+}
+
+TransmitShaper::TransmitShaper()
+        : _receiveRate( 0 )
+        , _receivedRate( 0. )
+        , _received( 0 )
+        , _receiveStart( 0. )
+{}
+
+TransmitShaper& TransmitShaper::getInstance()
+{
+    static TransmitShaper* instance = new TransmitShaper;
+    return *instance;
+}
+
+float TransmitShaper::wait( const uint128_t& node, const uint32_t rate,
+                            const uint64_t size )
+{
+    if( rate == 0 || size == 0 )
+        return 0.f;
+
+    double delay = 0.;
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        const double now = _clock.getTimed();
+
+        // add our share of the rate left unused by the other senders
+        double actualRate = rate;
+        std::map< uint128_t, Spare >::const_iterator j = _spares.find( node );
+        if( j != _spares.end() && now - j->second.time < _maxSpareAge )
+            actualRate += double( rate ) * double( j->second.share ) /
+                          double( _fullShare );
+
+        // KB/s equals 1.024 bytes/ms
+        const double duration = double( size ) / ( actualRate * 1.024 );
+        std::map< uint128_t, double >::iterator i = _drained.find( node );
+        const double drained = i == _drained.end() ? now : i->second;
+
+        const double start = LB_MAX( drained, now - _maxBurst );
+        _drained[ node ] = start + duration;
+        delay = start - now;
+    }
+
+    if( delay < 1. )
+        return 0.f;
+    lunchbox::sleep( uint32_t( delay ));
+    return float( delay );
+}
+
+void TransmitShaper::setSpareShare( const uint128_t& node,
+                                    const uint32_t spare )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    Spare& data = _spares[ node ];
+    data.share = LB_MIN( spare, _fullShare );
+    data.time = _clock.getTimed();
+}
+
+void TransmitShaper::setReceiveRate( const uint32_t rate )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    _receiveRate = rate;
+}
+
+void TransmitShaper::addReceived( const uint64_t size )
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    _updateReceived();
+    _received += size;
+}
+
+uint32_t TransmitShaper::getSpareShare()
+{
+    lunchbox::ScopedWrite mutex( _lock );
+    _updateReceived();
+    if( _receivedRate >= double( _receiveRate ))
+        return 0;
+    return _fullShare - uint32_t( _receivedRate * _fullShare / _receiveRate );
+}
+
+void TransmitShaper::_updateReceived()
+{
+    const double now = _clock.getTimed();
+    const double elapsed = now - _receiveStart;
+    if( elapsed < _receiveWindow )
+        return;
+
+    _receivedRate = double( _received ) / ( elapsed * 1.024 );
+    _received = 0;
+    _receiveStart = now;
+}
+
+}
+}
@@ -0,0 +1,120 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_TRANSMITSHAPER_H
+#define EQ_TRANSMITSHAPER_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/lock.h>
+
+#include <map>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Paces the image data sent to each destination node to a given rate.
+ *
+ * The server shares the receive rate of each node among all nodes sending to
+ * it, weighted by their transmit weight. Each sender paces its sends to its
+ * share, so that the images of all senders arrive at an even rate instead of
+ * in bursts which overrun the destination link.
+ *
+ * The shares are work-conserving: each destination measures the rate it
+ * actually receives and reports the unused part of its receive rate back to
+ * its senders, see getSpareShare(). A sender increases its rate by the same
+ * part, which is its share of the unused rate, so that the shares of idle
+ * senders are used by the busy ones.
+ *
+ * A send is delayed until the previous sends to the same node have drained
+ * at the resulting rate. Unused rate is kept for a short time, so that sends
+ * following a short pause are not delayed. The shaper is process-wide and
+ * thread-safe.
+ */
+class TransmitShaper
+{
+public:
+    /** @return the transmit shaper of this process. */
+    EQ_API static TransmitShaper& getInstance();
+
+    /**
+     * Wait until size bytes may be sent to the given node.
+     *
+     * @param node the destination node.
+     * @param rate the share of this process of the rate to the destination in
+     *             KB/s, 0 if unlimited.
+     * @param size the size of the data to send.
+     * @return the time waited in milliseconds.
+     */
+    EQ_API float wait( const uint128_t& node, const uint32_t rate,
+                       const uint64_t size );
+
+    /**
+     * Set the unused part of the receive rate reported by a destination node.
+     *
+     * @param node the destination node.
+     * @param spare the unused part of its receive rate, in 1/1000.
+     */
+    EQ_API void setSpareShare( const uint128_t& node, const uint32_t spare );
+
+    /**
+     * Set the receive rate of this process.
+     *
+     * @param rate the rate in KB/s as configured on the server, 0 if unknown.
+     */
+    EQ_API void setReceiveRate( const uint32_t rate );
+
+    /** Account image data received by this process. */
+    EQ_API void addReceived( const uint64_t size );
+
+    /**
+     * @return the part of the receive rate of this process not used during
+     *         the last measurement, in 1/1000.
+     */
+    EQ_API uint32_t getSpareShare();
+
+private:
+    TransmitShaper();
+    ~TransmitShaper() {}
+
+    /** The unused receive rate of a destination, see setSpareShare(). */
+    struct Spare
+    {
+        uint32_t share; //!< in 1/1000
+        double time;    //!< of the report
+    };
+
+    lunchbox::Lock _lock;
+    lunchbox::Clock _clock;
+
+    /** The time at which all data sent to each node has drained. */
+    std::map< uint128_t, double > _drained;
+    std::map< uint128_t, Spare > _spares;
+
+    uint32_t _receiveRate;  //!< from the server, in KB/s
+    double _receivedRate;   //!< measured, in KB/s
+    uint64_t _received;     //!< bytes since _receiveStart
+    double _receiveStart;
+
+    void _updateReceived();
+};
+}
+}
+
+#endif // EQ_TRANSMITSHAPER_H
@@ -102,7 +102,7 @@ namespace fabric
     {
         CMD_NODE_CONFIG_INIT = CMD_OBJECT_CUSTOM, // 15
         CMD_NODE_CONFIG_INIT_REPLY,
-        CMD_NODE_SET_AFFINITY,
+        CMD_NODE_SET_AFFINITY, // reserved: no longer used, keeps numbering
         CMD_NODE_CONFIG_EXIT,
         CMD_NODE_CONFIG_EXIT_REPLY,
         CMD_NODE_CREATE_PIPE,
@@ -114,6 +114,10 @@ namespace fabric
         CMD_NODE_FRAME_TASKS_FINISH,
         CMD_NODE_FRAMEDATA_TRANSMIT,       
         CMD_NODE_FRAMEDATA_READY,
+        CMD_NODE_FRAMEDATA_INVALIDATE,
+        CMD_NODE_FRAMEDATA_DECOMPRESS,
+        CMD_NODE_SHM_PROBE,
+        CMD_NODE_SHM_PROBE_REPLY,
         CMD_NODE_CUSTOM = 35  // some buffer for binary-compatible patches
     };
 
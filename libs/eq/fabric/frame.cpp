@@ -29,6 +29,8 @@ struct ToNodes
 {
     std::vector< uint128_t > inputNodes;
     std::vector< uint128_t > inputNetNodes;
+    std::vector< uint32_t > inputPriorities;
+    std::vector< uint32_t > inputRates;
 };
 
 namespace detail
@@ -51,7 +53,8 @@ public:
 
         for( unsigned i = 0; i < NUM_EYES; ++i )
             os << frameDataVersion[i] << toNodes[i].inputNodes 
-               << toNodes[i].inputNetNodes;
+               << toNodes[i].inputNetNodes << toNodes[i].inputPriorities
+               << toNodes[i].inputRates;
     }
 
     void deserialize( co::DataIStream& is )
@@ -60,7 +63,8 @@ public:
 
         for( unsigned i = 0; i < NUM_EYES; ++i )
             is >> frameDataVersion[i] >> toNodes[i].inputNodes
-               >> toNodes[i].inputNetNodes;
+               >> toNodes[i].inputNetNodes >> toNodes[i].inputPriorities
+               >> toNodes[i].inputRates;
     }
 };
 }
@@ -133,6 +137,16 @@ const std::vector< uint128_t >& Frame::getInputNetNodes(const Eye eye) const
     return _impl->toNodes[ lunchbox::getIndexOfLastBit( eye )].inputNetNodes;
 }
 
+const std::vector< uint32_t >& Frame::getInputPriorities( const Eye eye ) const
+{
+    return _impl->toNodes[ lunchbox::getIndexOfLastBit( eye )].inputPriorities;
+}
+
+const std::vector< uint32_t >& Frame::getInputRates( const Eye eye ) const
+{
+    return _impl->toNodes[ lunchbox::getIndexOfLastBit( eye )].inputRates;
+}
+
 std::vector< uint128_t >& Frame::_getInputNodes( const unsigned i )
 {
     return _impl->toNodes[ i ].inputNodes;
@@ -143,6 +157,16 @@ std::vector< uint128_t >& Frame::_getInputNetNodes( const unsigned i )
     return _impl->toNodes[ i ].inputNetNodes;
 }
 
+std::vector< uint32_t >& Frame::_getInputPriorities( const unsigned i )
+{
+    return _impl->toNodes[ i ].inputPriorities;
+}
+
+std::vector< uint32_t >& Frame::_getInputRates( const unsigned i )
+{
+    return _impl->toNodes[ i ].inputRates;
+}
+
 std::ostream& operator << ( std::ostream& os, const Frame& frame )
 {
     os << lunchbox::disableFlush << "frame" << std::endl
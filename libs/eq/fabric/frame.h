@@ -105,6 +105,22 @@ namespace detail { class Frame; }
         EQFABRIC_API const std::vector< uint128_t >&
         getInputNetNodes(const Eye eye) const;
 
+        /**
+         * @internal
+         * @return the transmission priority for each receiving node of an
+         *         output frame, lower values are more urgent.
+         */
+        EQFABRIC_API const std::vector< uint32_t >&
+        getInputPriorities( const Eye eye ) const;
+
+        /**
+         * @internal
+         * @return the maximum transmission rate in KB/s to each receiving node
+         *         of an output frame, 0 if unlimited.
+         */
+        EQFABRIC_API const std::vector< uint32_t >&
+        getInputRates( const Eye eye ) const;
+
     protected:
         virtual ChangeType getChangeType() const { return INSTANCE; }
         EQFABRIC_API virtual void getInstanceData( co::DataOStream& os );
@@ -121,6 +137,13 @@ namespace detail { class Frame; }
         EQFABRIC_API std::vector< uint128_t >&
         _getInputNetNodes( const unsigned i);
 
+        /** @internal @return the transmission priorities of an output frame */
+        EQFABRIC_API std::vector< uint32_t >&
+        _getInputPriorities( const unsigned i );
+
+        /** @internal @return the transmission rates of an output frame */
+        EQFABRIC_API std::vector< uint32_t >& _getInputRates( const unsigned i );
+
     private:
         detail::Frame* const _impl;
     };
@@ -82,8 +82,11 @@ namespace fabric
             IATTR_THREAD_MODEL,
             IATTR_LAUNCH_TIMEOUT, //!< Timeout when auto-launching the node
             IATTR_HINT_AFFINITY,
+            IATTR_HINT_TRANSMIT_THREADS, //!< Number of image transmit threads
+            IATTR_HINT_RECEIVE_RATE, //!< Max image receive rate in MB/s
+            IATTR_HINT_TRANSMIT_WEIGHT, //!< Share of the receive rate of others
             IATTR_LAST,
-            IATTR_ALL = IATTR_LAST + 5
+            IATTR_ALL = IATTR_LAST + 2
         };
 
         /** @internal Set a node integer attribute. */
@@ -439,10 +439,10 @@ void Channel::removeListener(  ChannelListener* listener )
         _listeners.erase( i );
 }
 
-void Channel::_fireLoadData( const uint32_t frameNumber, 
-                             const uint32_t nStatistics,
-                             const Statistic* statistics,
-                             const Viewport& region )
+void Channel::fireLoadData( const uint32_t frameNumber,
+                            const uint32_t nStatistics,
+                            const Statistic* statistics,
+                            const Viewport& region )
 {
     LB_TS_SCOPED( _serverThread );
 
@@ -484,8 +484,8 @@ bool Channel::_cmdFrameFinishReply( co::Command& command )
     const ChannelFrameFinishReplyPacket* packet = 
         command.get<ChannelFrameFinishReplyPacket>();
 
-    _fireLoadData( packet->frameNumber, packet->nStatistics,
-                   packet->statistics, packet->region );
+    fireLoadData( packet->frameNumber, packet->nStatistics,
+                  packet->statistics, packet->region );
     return true;
 }
 
@@ -180,6 +180,12 @@ namespace server
         void removeListener( ChannelListener* listener );
         /** @return true if the channel has listeners */
         bool hasListeners() const { return !_listeners.empty(); }
+
+        /** Notify all channel listeners of new load data. @internal */
+        void fireLoadData( const uint32_t frameNumber,
+                           const uint32_t nStatistics,
+                           const eq::Statistic* statistics,
+                           const Viewport& region );
         //@}
 
         bool omitOutput() const; //!< @internal
@@ -222,11 +228,6 @@ namespace server
         void _setupRenderContext( const uint128_t& frameID,
                                   RenderContext& context );
 
-        void _fireLoadData( const uint32_t frameNumber, 
-                            const uint32_t nStatistics,
-                            const eq::Statistic* statistics,
-                            const Viewport& region );
-
         /* command handler functions. */
         bool _cmdConfigInitReply( co::Command& command );
         bool _cmdConfigExitReply( co::Command& command );
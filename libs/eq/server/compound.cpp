@@ -1156,7 +1156,7 @@ void Compound::deregister()
 //---------------------------------------------------------------------------
 // pre-render compound state update
 //---------------------------------------------------------------------------
-void Compound::update( const uint32_t frameNumber )
+void Compound::update( const uint32_t frameNumber, Frames& outputFrames )
 {
     CompoundUpdateDataVisitor updateDataVisitor( frameNumber );
     accept( updateDataVisitor );
@@ -1164,17 +1164,13 @@ void Compound::update( const uint32_t frameNumber )
     CompoundUpdateOutputVisitor updateOutputVisitor( frameNumber );
     accept( updateOutputVisitor );
 
-    const FrameMap& outputFrames = updateOutputVisitor.getOutputFrames();
+    const FrameMap& frames = updateOutputVisitor.getOutputFrames();
     const TileQueueMap& outputQueues = updateOutputVisitor.getOutputQueues();
-    CompoundUpdateInputVisitor updateInputVisitor( outputFrames, outputQueues );
+    CompoundUpdateInputVisitor updateInputVisitor( frames, outputQueues );
     accept( updateInputVisitor );
 
-    // commit output frames after input frames have been set
-    for( FrameMapCIter i = outputFrames.begin(); i != outputFrames.end(); ++i )
-    {
-        Frame* frame = i->second;
-        frame->commit();
-    }
+    for( FrameMapCIter i = frames.begin(); i != frames.end(); ++i )
+        outputFrames.push_back( i->second );
 
     const BarrierMap& swapBarriers = updateOutputVisitor.getSwapBarriers();
     for( BarrierMapCIter i = swapBarriers.begin(); i != swapBarriers.end(); ++i)
@@ -485,8 +485,13 @@ namespace server
          * Updates this compound.
          * 
          * The compound's parameters for the next frame are computed.
+         *
+         * @param frameNumber the number of the next frame.
+         * @param outputFrames returns the updated output frames, which have
+         *                     to be committed by the caller, see
+         *                     Frame::updateInputRates().
          */
-        void update( const uint32_t frameNumber );
+        void update( const uint32_t frameNumber, Frames& outputFrames );
 
         /** Update the inherit data of this compound. */
         void updateInheritData( const uint32_t frameNumber );
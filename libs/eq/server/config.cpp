@@ -24,6 +24,8 @@
 #include "compoundVisitor.h"
 #include "configUpdateDataVisitor.h"
 #include "equalizers/equalizer.h"
+#include "equalizers/loadRecorder.h"
+#include "frame.h"
 #include "global.h"
 #include "layout.h"
 #include "log.h"
@@ -45,6 +47,8 @@
 #include <co/command.h>
 #include <lunchbox/sleep.h>
 
+#include <cstdlib>
+
 #include "channelStopFrameVisitor.h"
 #include "configDeregistrator.h"
 #include "configRegistrator.h"
@@ -61,6 +65,15 @@ using fabric::ON;
 using fabric::OFF;
 using fabric::ServerCreateConfigPacket;
 
+struct Config::Private
+{
+    Private() : loadRecorder( 0 ) {}
+    ~Private() { delete loadRecorder; }
+
+    /** Writes the load data to $EQ_LOAD_RECORD while running, or 0. */
+    LoadRecorder* loadRecorder;
+};
+
 Config::Config( ServerPtr parent )
         : Super( parent )
         , _currentFrame( 0 )
@@ -68,6 +81,7 @@ Config::Config( ServerPtr parent )
         , _finishedFrame( 0 )
         , _state( STATE_UNUSED )
         , _needsFinish( false )
+        , _private( new Private )
 {
     const Global* global = Global::instance();
     for( int i=0; i<FATTR_ALL; ++i )
@@ -84,6 +98,9 @@ Config::Config( ServerPtr parent )
 
 Config::~Config()
 {
+    delete _private;
+    _private = 0;
+
     while( !_compounds.empty( ))
     {
         Compound* compound = _compounds.back();
@@ -785,8 +802,14 @@ bool Config::_init( const uint128_t& initID )
         return false;
 
     // Needed to set up active state for first LB update
-    for( CompoundsCIter i = _compounds.begin(); i != _compounds.end(); ++i )
-        (*i)->update( 0 );
+    _updateCompounds( 0 );
+
+    const char* loadRecord = getenv( "EQ_LOAD_RECORD" );
+    if( loadRecord && !_private->loadRecorder )
+    {
+        _private->loadRecorder = new LoadRecorder( loadRecord );
+        _private->loadRecorder->attach( this );
+    }
 
     _needsFinish = false;
     _state = STATE_RUNNING;
@@ -819,6 +842,9 @@ bool Config::exit()
         compound->exit();
     }
 
+    delete _private->loadRecorder;
+    _private->loadRecorder = 0;
+
     const bool success = _updateRunning();
 
     ConfigEvent exitEvent;
@@ -833,6 +859,20 @@ bool Config::exit()
 //---------------------------------------------------------------------------
 // frame
 //---------------------------------------------------------------------------
+void Config::_updateCompounds( const uint32_t frameNumber )
+{
+    Frames outputFrames;
+    for( CompoundsCIter i = _compounds.begin(); i != _compounds.end(); ++i )
+        (*i)->update( frameNumber, outputFrames );
+
+    // the receive rates are shared among the senders of all compounds
+    Frame::updateInputRates( outputFrames );
+
+    // commit output frames after input frames have been set
+    for( FramesCIter i = outputFrames.begin(); i != outputFrames.end(); ++i )
+        (*i)->commit();
+}
+
 void Config::_startFrame( const uint128_t& frameID )
 {
     LBASSERT( _state == STATE_RUNNING );
@@ -844,13 +884,8 @@ void Config::_startFrame( const uint128_t& frameID )
     LBLOG( lunchbox::LOG_ANY ) << "----- Start Frame ----- " << _currentFrame
                                << std::endl;
 
-    for( Compounds::const_iterator i = _compounds.begin(); 
-         i != _compounds.end(); ++i )
-    {
-        Compound* compound = *i;
-        compound->update( _currentFrame );
-    }
-    
+    _updateCompounds( _currentFrame );
+
     ConfigUpdateDataVisitor configDataVisitor;
     accept( configDataVisitor );
 
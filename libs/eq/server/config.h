@@ -239,6 +239,7 @@ namespace server
         void _verifyFrameFinished( const uint32_t frameNumber );
         bool _init( const uint128_t& initID );
 
+        void _updateCompounds( const uint32_t frameNumber );
         void _startFrame( const uint128_t& frameID );
         void _flushAllFrames();
         //@}
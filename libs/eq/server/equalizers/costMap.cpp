@@ -0,0 +1,290 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "costMap.h"
+
+#include <lunchbox/debug.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+/** The maximum extrapolation, in normalized units. */
+static const float _maxOffset = .25f;
+}
+
+CostMap::CostMap()
+        : _width( 0 )
+        , _height( 0 )
+        , _frameNumber( 0 )
+        , _centroid( Vector2f::ZERO )
+        , _hasCentroid( false )
+        , _motion( Vector2f::ZERO )
+{}
+
+void CostMap::resize( const size_t width, const size_t height )
+{
+    LBASSERT( width > 0 && height > 0 );
+    _width = width;
+    _height = height;
+    clear();
+}
+
+void CostMap::clear()
+{
+    const size_t size = _width * _height;
+    _frame.assign( size, 0.f );
+    _cost.assign( size, 0.f );
+    _predicted.assign( size, 0.f );
+
+    _frameNumber = 0;
+    _centroid = Vector2f::ZERO;
+    _hasCentroid = false;
+    _motion = Vector2f::ZERO;
+}
+
+void CostMap::addLoad( const Viewport& vp, const float time )
+{
+    if( !vp.hasArea() || time <= 0.f )
+        return;
+
+    // spread the time uniformly: the share of a cell is its overlap with vp
+    const float density = time / ( vp.w * vp.h );
+    const float w = float( _width );
+    const float h = float( _height );
+
+    for( size_t y = 0; y < _height; ++y )
+    {
+        const float overlapY = LB_MIN( vp.getYEnd(), float( y + 1 ) / h ) -
+                               LB_MAX( vp.y, float( y ) / h );
+        if( overlapY <= 0.f )
+            continue;
+
+        for( size_t x = 0; x < _width; ++x )
+        {
+            const float overlapX = LB_MIN( vp.getXEnd(), float( x + 1 ) / w ) -
+                                   LB_MAX( vp.x, float( x ) / w );
+            if( overlapX > 0.f )
+                _frame[ y * _width + x ] += density * overlapX * overlapY;
+        }
+    }
+}
+
+void CostMap::finishFrame( const uint32_t frameNumber, const float damping )
+{
+    LBASSERT( frameNumber > _frameNumber );
+
+    Vector2f centroid;
+    const bool hasCentroid = _width > 1 && _height > 1 &&
+                             _getCentroid( _frame, centroid );
+
+    if( _frameNumber == 0 )
+        _cost = _frame;
+    else
+    {
+        // move the old map along with the model before blending
+        Vector2f offset = Vector2f::ZERO;
+        if( hasCentroid && _hasCentroid )
+            offset = centroid - _centroid;
+        _motion = offset / float( frameNumber - _frameNumber );
+
+        Cells moved;
+        _move( _cost, moved, offset );
+        for( size_t i = 0; i < _cost.size(); ++i )
+            _cost[i] = ( 1.f - damping ) * _frame[i] + damping * moved[i];
+    }
+
+    _frameNumber = frameNumber;
+    _centroid = centroid;
+    _hasCentroid = hasCentroid;
+    std::fill( _frame.begin(), _frame.end(), 0.f );
+}
+
+void CostMap::predict( const uint32_t frameNumber )
+{
+    if( _frameNumber == 0 )
+    {
+        const float uniform = 1.f / float( _width * _height );
+        std::fill( _predicted.begin(), _predicted.end(), uniform );
+        return;
+    }
+
+    const float latency = frameNumber > _frameNumber ?
+                          float( frameNumber - _frameNumber ) : 0.f;
+    Vector2f offset = _motion * latency;
+    offset.x() = LB_MAX( -_maxOffset, LB_MIN( offset.x(), _maxOffset ));
+    offset.y() = LB_MAX( -_maxOffset, LB_MIN( offset.y(), _maxOffset ));
+    _move( _cost, _predicted, offset );
+}
+
+float CostMap::getCost( const Viewport& vp ) const
+{
+    return _getCost( _predicted, vp );
+}
+
+float CostMap::findSplitX( const Viewport& vp, const float cost ) const
+{
+    const float end = vp.getXEnd();
+    const float w = float( _width );
+    float accumulated = 0.f;
+    float x = vp.x;
+
+    for( size_t i = size_t( LB_MAX( vp.x, 0.f ) * w );
+         x < end && i < _width; ++i )
+    {
+        const float next = LB_MIN( end, float( i + 1 ) / w );
+        if( next <= x )
+            continue;
+
+        const float columnCost =
+            _getCost( _predicted, Viewport( x, vp.y, next - x, vp.h ));
+        if( columnCost > 0.f && accumulated + columnCost >= cost )
+            return x + ( next - x ) * ( cost - accumulated ) / columnCost;
+
+        accumulated += columnCost;
+        x = next;
+    }
+    return end;
+}
+
+float CostMap::findSplitY( const Viewport& vp, const float cost ) const
+{
+    const float end = vp.getYEnd();
+    const float h = float( _height );
+    float accumulated = 0.f;
+    float y = vp.y;
+
+    for( size_t i = size_t( LB_MAX( vp.y, 0.f ) * h );
+         y < end && i < _height; ++i )
+    {
+        const float next = LB_MIN( end, float( i + 1 ) / h );
+        if( next <= y )
+            continue;
+
+        const float rowCost =
+            _getCost( _predicted, Viewport( vp.x, y, vp.w, next - y ));
+        if( rowCost > 0.f && accumulated + rowCost >= cost )
+            return y + ( next - y ) * ( cost - accumulated ) / rowCost;
+
+        accumulated += rowCost;
+        y = next;
+    }
+    return end;
+}
+
+float CostMap::_getCost( const Cells& cells, const Viewport& vp ) const
+{
+    if( !vp.hasArea( ))
+        return 0.f;
+
+    const float w = float( _width );
+    const float h = float( _height );
+    const size_t startX = size_t( LB_MAX( vp.x, 0.f ) * w );
+    const size_t startY = size_t( LB_MAX( vp.y, 0.f ) * h );
+    const size_t endX = LB_MIN( _width, size_t( std::ceil( vp.getXEnd() * w )));
+    const size_t endY = LB_MIN( _height, size_t( std::ceil( vp.getYEnd() * h)));
+
+    float cost = 0.f;
+    for( size_t y = startY; y < endY; ++y )
+    {
+        const float overlapY = LB_MIN( vp.getYEnd(), float( y + 1 ) / h ) -
+                               LB_MAX( vp.y, float( y ) / h );
+        if( overlapY <= 0.f )
+            continue;
+
+        for( size_t x = startX; x < endX; ++x )
+        {
+            const float overlapX = LB_MIN( vp.getXEnd(), float( x + 1 ) / w ) -
+                                   LB_MAX( vp.x, float( x ) / w );
+            if( overlapX > 0.f )
+                cost += cells[ y * _width + x ] * overlapX * w * overlapY * h;
+        }
+    }
+    return cost;
+}
+
+bool CostMap::_getCentroid( const Cells& cells, Vector2f& centroid ) const
+{
+    float total = 0.f;
+    centroid = Vector2f::ZERO;
+    for( size_t y = 0; y < _height; ++y )
+    {
+        for( size_t x = 0; x < _width; ++x )
+        {
+            const float cost = cells[ y * _width + x ];
+            total += cost;
+            centroid.x() += cost * ( float( x ) + .5f ) / float( _width );
+            centroid.y() += cost * ( float( y ) + .5f ) / float( _height );
+        }
+    }
+
+    if( total <= 0.f )
+        return false;
+    centroid /= total;
+    return true;
+}
+
+void CostMap::_move( const Cells& from, Cells& to, const Vector2f& offset )
+    const
+{
+    // bilinear resampling, cells moved in from outside of the map are empty
+    const float dx = offset.x() * float( _width );
+    const float dy = offset.y() * float( _height );
+    const ssize_t width = ssize_t( _width );
+    const ssize_t height = ssize_t( _height );
+
+    to.assign( from.size(), 0.f );
+    for( ssize_t y = 0; y < height; ++y )
+    {
+        const float sourceY = float( y ) - dy;
+        const ssize_t y0 = ssize_t( std::floor( sourceY ));
+        const float fy = sourceY - float( y0 );
+
+        for( ssize_t x = 0; x < width; ++x )
+        {
+            const float sourceX = float( x ) - dx;
+            const ssize_t x0 = ssize_t( std::floor( sourceX ));
+            const float fx = sourceX - float( x0 );
+
+            float cost = 0.f;
+            for( ssize_t j = 0; j < 2; ++j )
+            {
+                const ssize_t sy = y0 + j;
+                if( sy < 0 || sy >= height )
+                    continue;
+                const float wy = j ? fy : 1.f - fy;
+
+                for( ssize_t i = 0; i < 2; ++i )
+                {
+                    const ssize_t sx = x0 + i;
+                    if( sx < 0 || sx >= width )
+                        continue;
+                    const float wx = i ? fx : 1.f - fx;
+                    cost += wx * wy * from[ sy * _width + sx ];
+                }
+            }
+            to[ y * _width + x ] = cost;
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_COSTMAP_H
+#define EQS_COSTMAP_H
+
+#include "../api.h"
+#include "../types.h"
+
+#include <eq/client/types.h>
+#include <eq/fabric/viewport.h> // member
+
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * A screen-space map of the render cost, learned from measured times.
+     *
+     * The normalized viewport is covered by a coarse grid of cells. The time
+     * measured for a viewport is distributed uniformly over the cells it
+     * covers. A new frame is blended into the map after moving the map by the
+     * motion of the cost centroid, so that damping smoothes the measurements
+     * without lagging behind a moving model. The map can be extrapolated along
+     * this motion to the frame being balanced.
+     */
+    class CostMap
+    {
+    public:
+        EQSERVER_API CostMap();
+
+        /** Set the number of cells and clear the map. */
+        EQSERVER_API void resize( const size_t width, const size_t height );
+
+        /** Forget all learned frames. */
+        EQSERVER_API void clear();
+
+        /** @name Learning */
+        //@{
+        /** Distribute the time of a viewport over the cells of the frame. */
+        EQSERVER_API void addLoad( const Viewport& vp, const float time );
+
+        /**
+         * Blend the loads added since the last call into the map.
+         *
+         * The motion is only estimated for maps with more than one row and
+         * column, since it has no meaning for DB ranges.
+         *
+         * @param frameNumber the frame the loads were measured in.
+         * @param damping the weight of the old map, 0 to use the new frame.
+         */
+        EQSERVER_API void finishFrame( const uint32_t frameNumber,
+                                       const float damping );
+
+        /** @return the number of the last learned frame, 0 if none. */
+        uint32_t getFrameNumber() const { return _frameNumber; }
+
+        /** @return the motion of the cost per frame, in normalized units. */
+        const Vector2f& getMotion() const { return _motion; }
+        //@}
+
+        /** @name Prediction */
+        //@{
+        /**
+         * Extrapolate the map along its motion to the given frame.
+         *
+         * Without any learned frame, the prediction has a uniform cost.
+         */
+        EQSERVER_API void predict( const uint32_t frameNumber );
+
+        /** @return the predicted cost of a viewport. */
+        EQSERVER_API float getCost( const Viewport& vp ) const;
+
+        /**
+         * @return the position in [vp.x, vp.getXEnd()] left of which the
+         *         predicted cost of the viewport is the given cost.
+         */
+        EQSERVER_API float findSplitX( const Viewport& vp,
+                                       const float cost ) const;
+
+        /**
+         * @return the position in [vp.y, vp.getYEnd()] below which the
+         *         predicted cost of the viewport is the given cost.
+         */
+        EQSERVER_API float findSplitY( const Viewport& vp,
+                                       const float cost ) const;
+        //@}
+
+    private:
+        typedef std::vector< float > Cells;
+
+        size_t _width;
+        size_t _height;
+
+        Cells _frame;     //!< Loads added for the current frame
+        Cells _cost;      //!< Learned cost of each cell
+        Cells _predicted; //!< Cost extrapolated by predict()
+
+        uint32_t _frameNumber; //!< Last learned frame
+        Vector2f _centroid;    //!< Cost centroid of the last learned frame
+        bool     _hasCentroid; //!< The last learned frame had a cost
+        Vector2f _motion;      //!< Centroid motion per frame
+
+        float _getCost( const Cells& cells, const Viewport& vp ) const;
+        bool _getCentroid( const Cells& cells, Vector2f& centroid ) const;
+        void _move( const Cells& from, Cells& to, const Vector2f& offset )
+            const;
+    };
+}
+}
+
+#endif // EQS_COSTMAP_H
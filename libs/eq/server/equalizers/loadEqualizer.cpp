@@ -28,6 +28,18 @@ namespace eq
 {
 namespace server
 {
+namespace
+{
+// Cells of the cost map in 2D and DB mode
+static const size_t _mapSize2D = 64;
+static const size_t _mapSizeDB = 256;
+
+/** @return the range as a viewport on the x axis of the cost map. */
+static Viewport _getViewport( const Range& range )
+{
+    return Viewport( range.start, 0.f, range.end - range.start, 1.f );
+}
+}
 
 std::ostream& operator << ( std::ostream& os, const LoadEqualizer::Node* );
 
@@ -42,6 +54,7 @@ LoadEqualizer::LoadEqualizer( const Mode mode )
         , _boundary2i( 1, 1 )
         , _boundaryf( std::numeric_limits<float>::epsilon() )
         , _assembleOnlyLimit( std::numeric_limits< float >::max( ) )
+        , _transferWeight( 0.f )
 {
     LBVERB << "New LoadEqualizer @" << (void*)this << std::endl;
 }
@@ -55,6 +68,7 @@ LoadEqualizer::LoadEqualizer( const LoadEqualizer& from )
         , _boundary2i( from._boundary2i )
         , _boundaryf( from._boundaryf )
         , _assembleOnlyLimit( from._assembleOnlyLimit )
+        , _transferWeight( from._transferWeight )
 {}
 
 LoadEqualizer::~LoadEqualizer()
@@ -90,6 +104,10 @@ void LoadEqualizer::notifyUpdatePre( Compound* compound,
           default:
               _tree = _buildTree( children );
               _init( _tree, Viewport(), Range( ));
+              if( _mode == MODE_DB )
+                  _costMap.resize( _mapSizeDB, 1 );
+              else
+                  _costMap.resize( _mapSize2D, _mapSize2D );
               break;
         }
     }
@@ -102,7 +120,7 @@ void LoadEqualizer::notifyUpdatePre( Compound* compound,
     }
 
     _update( _tree );
-    _computeSplit();
+    _computeSplit( frameNumber );
 }
 
 LoadEqualizer::Node* LoadEqualizer::_buildTree( const Compounds& compounds )
@@ -286,10 +304,13 @@ void LoadEqualizer::notifyLoadData( Channel* channel,
             data.vp.apply( region ); // Update ROI
             data.time = endTime - startTime;
             data.time = LB_MAX( data.time, 1 );
-            data.time = LB_MAX( data.time, transmitTime );
+            data.transferTime = LB_MAX( transmitTime, 0 );
+            if( _transferWeight <= 0.f ) // transmission overlaps rendering
+                data.time = LB_MAX( data.time, transmitTime );
             data.assembleTime = LB_MAX( data.assembleTime, 0 );
             LBLOG( LOG_LB2 ) << "Added time " << data.time << " (+"
-                             << data.assembleTime << ") for "
+                             << data.assembleTime << ", transfer "
+                             << data.transferTime << ") for "
                              << channel->getName() << " " << data.vp << ", "
                              << data.range << " @ " << frameNumber << std::endl;
             return;
@@ -401,6 +422,7 @@ void LoadEqualizer::_updateLeaf( Node* node )
     node->maxSize.y() = pvp.h; 
     node->boundaryf = _boundaryf;
     node->boundary2i = _boundary2i;
+    _updateTransferCost( node );
     if( !compound->hasDestinationChannel( ))
         return;
 
@@ -482,6 +504,56 @@ void LoadEqualizer::_updateNode( Node* node )
             LBUNIMPLEMENTED;
         }
     }
+
+    // each DB child transfers a full image, 2D children share the area
+    if( _mode == MODE_DB )
+        node->transferCost = left->transferCost + right->transferCost;
+    else if( node->resources > 0.f )
+        node->transferCost = ( left->transferCost * left->resources +
+                               right->transferCost * right->resources ) /
+                             node->resources;
+    else
+        node->transferCost = 0.f;
+}
+
+void LoadEqualizer::_updateTransferCost( Node* node )
+{
+    node->transferCost = 0.f;
+    if( _transferWeight <= 0.f )
+        return;
+
+    const Channel* channel = node->compound->getChannel();
+    const Channel* destChannel = getCompound()->getChannel();
+    if( channel == destChannel ) // no transfer
+        return;
+
+    // the assembly is shared by the area of the transferred images
+    const LBDatas& items = _history.front().second;
+    const Data* data = 0;
+    float transferArea = 0.f;
+    for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
+    {
+        if( i->channel == channel )
+            data = &(*i);
+        if( i->channel && i->channel != destChannel )
+            transferArea += i->vp.getArea();
+    }
+    if( !data || !data->vp.hasArea( ))
+        return;
+
+    float cost = float( data->transferTime );
+    if( transferArea > 0.f )
+        cost += float( _getAssembleTime( )) * data->vp.getArea() /
+                transferArea;
+    cost *= _transferWeight;
+
+    // _getTime() scales by the assigned area, not by the transmitted ROI
+    if( _mode == MODE_DB )
+        node->transferCost = cost;
+    else if( data->area > 0.f )
+        node->transferCost = cost / data->area;
+    LBLOG( LOG_LB2 ) << channel->getName() << " transfer cost " << cost
+                     << std::endl;
 }
 
 int64_t LoadEqualizer::_getTotalTime() 
@@ -517,50 +589,43 @@ int64_t LoadEqualizer::_getAssembleTime( )
     return assembleTime;
 }
 
-void LoadEqualizer::_computeSplit()
+void LoadEqualizer::_updateCostMap()
 {
-    LBASSERT( !_history.empty( ));
-    
     const LBFrameData& frameData = _history.front();
-    const Compound* compound = getCompound();
-    LBLOG( LOG_LB2 ) << "----- balance " << compound->getChannel()->getName()
-                    << " using frame " << frameData.first << " tree "
-                     << std::endl << _tree;
+    if( frameData.first <= _costMap.getFrameNumber( )) // known or fake set
+        return;
 
-    // sort load items for each of the split directions
     LBDatas items( frameData.second );
     _removeEmpty( items );
 
-    LBDatas sortedData[3] = { items, items, items };
-
-    if( _mode == MODE_DB )
-    {
-        LBDatas& rangeData = sortedData[ MODE_DB ];
-        sort( rangeData.begin(), rangeData.end(), _compareRange );
-    }
-    else
+    for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
     {
-        LBDatas& xData = sortedData[ MODE_VERTICAL ];
-        sort( xData.begin(), xData.end(), _compareX );
-
-        LBDatas& yData = sortedData[ MODE_HORIZONTAL ];
-        sort( yData.begin(), yData.end(), _compareY );
-
-#ifndef NDEBUG
-        for( LBDatas::const_iterator i = xData.begin(); i != xData.end();
-             ++i )
-        {  
-            const Data& data = *i;
-            LBLOG( LOG_LB2 ) << "  " << data.vp << ", time " << data.time
-                             << " (+" << data.assembleTime << ")" << std::endl;
-        }
-#endif
+        const Data& data = *i;
+        LBLOG( LOG_LB2 ) << "  " << data.vp << ", " << data.range << " time "
+                         << data.time << " (+" << data.assembleTime << ")"
+                         << std::endl;
+        if( _mode == MODE_DB )
+            _costMap.addLoad( _getViewport( data.range ), float( data.time ));
+        else
+            _costMap.addLoad( data.vp, float( data.time ));
     }
+    _costMap.finishFrame( frameData.first, _damping );
+}
 
-    const float time = float( _getTotalTime( ));
-    LBLOG( LOG_LB2 ) << "Render time " << time << " for "
-                     << _tree->resources << " resources" << std::endl;
-    _computeSplit( _tree, time, sortedData, Viewport(), Range( ));
+void LoadEqualizer::_computeSplit( const uint32_t frameNumber )
+{
+    LBASSERT( !_history.empty( ));
+
+    _updateCostMap();
+    _costMap.predict( frameNumber );
+
+    const Compound* compound = getCompound();
+    LBLOG( LOG_LB2 ) << "----- balance " << compound->getChannel()->getName()
+                     << " using frame " << _costMap.getFrameNumber()
+                     << " motion " << _costMap.getMotion() << " for frame "
+                     << frameNumber << " tree " << std::endl << _tree;
+
+    _computeSplit( _tree, Viewport(), Range( ));
 }
 
 void LoadEqualizer::_removeEmpty( LBDatas& items )
@@ -576,12 +641,10 @@ void LoadEqualizer::_removeEmpty( LBDatas& items )
     }
 }
 
-void LoadEqualizer::_computeSplit( Node* node, const float time,
-                                   LBDatas* datas, const Viewport& vp,
+void LoadEqualizer::_computeSplit( Node* node, const Viewport& vp,
                                    const Range& range )
 {
-    LBLOG( LOG_LB2 ) << "_computeSplit " << vp << ", " << range << " time "
-                    << time << std::endl;
+    LBLOG( LOG_LB2 ) << "_computeSplit " << vp << ", " << range << std::endl;
     LBASSERTINFO( vp.isValid(), vp );
     LBASSERTINFO( range.isValid(), range );
     LBASSERTINFO( node->resources > 0.f || !vp.hasArea() || !range.hasData(),
@@ -597,117 +660,15 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
 
     LBASSERT( node->left && node->right );
 
-    LBDatas workingSet = datas[ node->mode ];
-    const float leftTime = node->resources > 0 ?
-                           time * node->left->resources / node->resources : 0.f;
-    float timeLeft = LB_MIN( leftTime, time ); // correct for fp rounding error
-
     switch( node->mode )
     {
         case MODE_VERTICAL:
         {
             LBASSERT( range == Range::ALL );
 
-            float splitPos = vp.x;
             const float end = vp.getXEnd();
-
-            while( timeLeft > std::numeric_limits< float >::epsilon() &&
-                   splitPos < end )
-            {
-                LBLOG( LOG_LB2 ) << timeLeft << "ms left using "
-                                << workingSet.size() << " tiles" << std::endl;
-
-                // remove all irrelevant items from working set
-                for( LBDatas::iterator i = workingSet.begin();
-                     i != workingSet.end(); )
-                {
-                    const Data& data = *i;
-                    if( data.vp.getXEnd() > splitPos )
-                        ++i;
-                    else
-                        i = workingSet.erase( i );
-                }
-                if( workingSet.empty( ))
-                    break;
-
-                // find next 'discontinouity' in loads
-                float currentPos = 1.0f;
-                for( LBDatas::const_iterator i = workingSet.begin();
-                     i != workingSet.end(); ++i )
-                {
-                    const Data& data = *i;
-                    if( data.vp.x > splitPos && data.vp.x < currentPos )
-                        currentPos = data.vp.x;
-                    const float xEnd = data.vp.getXEnd();
-                    if( xEnd > splitPos && xEnd < currentPos )
-                        currentPos = xEnd;
-                }
-
-                const float width = currentPos - splitPos;
-                LBASSERTINFO( width > 0.f, currentPos << "<=" << splitPos );
-                LBASSERT( currentPos <= 1.0f );
-
-                // accumulate normalized load in splitPos...currentPos
-                LBLOG( LOG_LB2 ) << "Computing load in X " << splitPos << "..."
-                                 << currentPos << std::endl;
-                float currentTime = 0.f;
-                for( LBDatas::const_iterator i = workingSet.begin();
-                     i != workingSet.end(); ++i )
-                {
-                    const Data& data = *i;
-                        
-                    if( data.vp.x >= currentPos ) // not yet needed data sets
-                        break;
-
-                    float yContrib = data.vp.h;
-                    if( data.vp.y < vp.y )
-                        yContrib -= (vp.y - data.vp.y);
-                    
-                    const float dataEnd = data.vp.getYEnd();
-                    const float vpEnd   = vp.getYEnd();
-                    if( dataEnd > vpEnd )
-                        yContrib -= (dataEnd - vpEnd);
-
-                    if( yContrib > 0.f )
-                    {
-                        const float percentage = ( width / data.vp.w ) *
-                                                 ( yContrib / data.vp.h );
-                        currentTime += ( data.time * percentage );
-
-                        LBLOG( LOG_LB2 ) << data.vp << " contributes "
-                                         << yContrib << " in " << vp.h << " ("
-                                         << percentage << ") with " << data.time
-                                         << ": " << ( data.time * percentage )
-                                         << " vp.y " << vp.y << " dataEnd " 
-                                         << dataEnd << " vpEnd " << vpEnd
-                                         << std::endl;
-                        LBASSERT( percentage < 1.01f )
-                    }
-                }
-
-                LBLOG( LOG_LB2 ) << splitPos << "..." << currentPos << ": t="
-                                 << currentTime << " of " << timeLeft
-                                 << std::endl;
-
-                if( currentTime >= timeLeft ) // found last region
-                {
-                    splitPos += ( width * timeLeft / currentTime );
-                    timeLeft = 0.0f;
-                }
-                else
-                {
-                    timeLeft -= currentTime;
-                    splitPos  = currentPos;
-                }
-            }
-
+            float splitPos = _getSplit( node, vp, range );
             LBLOG( LOG_LB2 ) << "Should split at X " << splitPos << std::endl;
-            if( _damping < 1.f )
-                splitPos = (1.f - _damping) * splitPos + _damping * node->split;
-            LBLOG( LOG_LB2 ) << "Dampened split at X " << splitPos << std::endl;
-
-            // There might be more time left due to MIN_PIXEL rounding by parent
-            // LBASSERTINFO( timeLeft <= .001f, timeLeft );
 
             // Ensure minimum size
             const Compound* root = getCompound();
@@ -752,7 +713,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             // balance children
             Viewport childVP = vp;
             childVP.w = (splitPos - vp.x);
-            _computeSplit( node->left, leftTime, datas, childVP, range );
+            _computeSplit( node->left, childVP, range );
 
             childVP.x = childVP.getXEnd();
             childVP.w = end - childVP.x;
@@ -761,111 +722,17 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             //   child which is slightly below the parent width. Correct it.
             while( childVP.getXEnd() < end )
                 childVP.w += std::numeric_limits< float >::epsilon();
-            _computeSplit( node->right, time-leftTime, datas, childVP, range );
+            _computeSplit( node->right, childVP, range );
             break;
         }
 
         case MODE_HORIZONTAL:
         {
             LBASSERT( range == Range::ALL );
-            float splitPos = vp.y;
-            const float end = vp.getYEnd();
-
-            while( timeLeft > std::numeric_limits< float >::epsilon() &&
-                   splitPos < end )
-            {
-                LBLOG( LOG_LB2 ) << timeLeft << "ms left using "
-                                 << workingSet.size() << " tiles" << std::endl;
-
-                // remove all unrelevant items from working set
-                for( LBDatas::iterator i = workingSet.begin();
-                     i != workingSet.end(); )
-                {
-                    const Data& data = *i;
-                    if( data.vp.getYEnd() > splitPos )
-                        ++i;
-                    else
-                        i = workingSet.erase( i );
-                }
-                if( workingSet.empty( ))
-                    break;
-
-                // find next 'discontinuouity' in loads
-                float currentPos = 1.0f;
-                for( LBDatas::const_iterator i = workingSet.begin();
-                     i != workingSet.end(); ++i )
-                {
-                    const Data& data = *i;
-                    if( data.vp.y > splitPos && data.vp.y < currentPos )
-                        currentPos = data.vp.y;
-                    const float yEnd = data.vp.getYEnd();
-                    if( yEnd > splitPos && yEnd < currentPos )
-                        currentPos = yEnd;
-                }
-
-                const float height = currentPos - splitPos;
-                LBASSERTINFO( height > 0.f, currentPos << "<=" << splitPos );
-                LBASSERT( currentPos <= 1.0f );
-
-                // accumulate normalized load in splitPos...currentPos
-                LBLOG( LOG_LB2 ) << "Computing load in Y " << splitPos << "..."
-                                << currentPos << std::endl;
-                float currentTime = 0.f;
-                for( LBDatas::const_iterator i = workingSet.begin();
-                     i != workingSet.end(); ++i )
-                {
-                    const Data& data = *i;
-                        
-                    if( data.vp.y >= currentPos ) // not yet needed data sets
-                        break;
-
-                    float xContrib = data.vp.w;
-
-                    if( data.vp.x < vp.x )
-                        xContrib -= (vp.x - data.vp.x);
-                    
-                    const float dataEnd = data.vp.getXEnd();
-                    const float vpEnd   = vp.getXEnd();
-                    if( dataEnd > vpEnd )
-                        xContrib -= (dataEnd - vpEnd);
-                    
-                    if( xContrib > 0.f )
-                    {
-                        const float percentage = ( height / data.vp.h ) *
-                                                 ( xContrib / data.vp.w );
-                        currentTime += ( data.time * percentage );
-
-                        LBLOG( LOG_LB2 ) << data.vp << " contributes "
-                                         << xContrib << " in " << vp.w << " ("
-                                         << percentage << ") with " << data.time
-                                         << ": " << ( data.time * percentage )
-                                         << " total " << currentTime << " vp.x "
-                                         << vp.x << " dataEnd " << dataEnd
-                                         << " vpEnd " << vpEnd << std::endl;
-                        LBASSERT( percentage < 1.01f )
-                    }
-                }
-
-                LBLOG( LOG_LB2 ) << splitPos << "..." << currentPos << ": t="
-                                 << currentTime << " of " << timeLeft
-                                 << std::endl;
-
-                if( currentTime >= timeLeft ) // found last region
-                {
-                    splitPos += (height * timeLeft / currentTime );
-                    timeLeft = 0.0f;
-                }
-                else
-                {
-                    timeLeft -= currentTime;
-                    splitPos  = currentPos;
-                }
-            }
 
+            const float end = vp.getYEnd();
+            float splitPos = _getSplit( node, vp, range );
             LBLOG( LOG_LB2 ) << "Should split at Y " << splitPos << std::endl;
-            if( _damping < 1.f )
-                splitPos = (1.f - _damping) * splitPos + _damping * node->split;
-            LBLOG( LOG_LB2 ) << "Dampened split at Y " << splitPos << std::endl;
 
             const Compound* root = getCompound();
             
@@ -910,95 +777,23 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
 
             Viewport childVP = vp;
             childVP.h = (splitPos - vp.y);
-            _computeSplit( node->left, leftTime, datas, childVP, range );
+            _computeSplit( node->left, childVP, range );
 
             childVP.y = childVP.getYEnd();
             childVP.h = end - childVP.y;
             while( childVP.getYEnd() < end )
                 childVP.h += std::numeric_limits< float >::epsilon();
-            _computeSplit( node->right, time - leftTime, datas, childVP, range);
+            _computeSplit( node->right, childVP, range );
             break;
         }
 
         case MODE_DB:
         {
             LBASSERT( vp == Viewport::FULL );
-            float splitPos = range.start;
-            const float end = range.end;
 
-            while( timeLeft > std::numeric_limits< float >::epsilon() && 
-                   splitPos < end )
-            {
-                LBLOG( LOG_LB2 ) << timeLeft << "ms left using "
-                                 << workingSet.size() << " tiles" << std::endl;
-
-                // remove all irrelevant items from working set
-                for( LBDatas::iterator i = workingSet.begin();
-                     i != workingSet.end(); )
-                {
-                    const Data& data = *i;
-                    if( data.range.end > splitPos )
-                        ++i;
-                    else
-                        i = workingSet.erase( i );
-                }
-                if( workingSet.empty( ))
-                    break;
-
-                // find next 'discontinouity' in loads
-                float currentPos = 1.0f;
-                for( LBDatas::const_iterator i = workingSet.begin();
-                     i != workingSet.end(); ++i )
-                {
-                    const Data& data = *i;                        
-                    currentPos = LB_MIN( currentPos, data.range.end );
-                }
-
-                const float size = currentPos - splitPos;
-                LBASSERTINFO( size > 0.f, currentPos << "<=" << splitPos );
-                LBASSERT( currentPos <= 1.0f );
-
-                // accumulate normalized load in splitPos...currentPos
-                LBLOG( LOG_LB2 ) << "Computing load in range " << splitPos
-                                << "..." << currentPos << std::endl;
-                float currentTime = 0.f;
-                for( LBDatas::const_iterator i = workingSet.begin();
-                     i != workingSet.end(); ++i )
-                {
-                    const Data& data = *i;
-                        
-                    if( data.range.start >= currentPos ) // not yet needed data
-                        break;
-#if 0
-                    // make sure we cover full area
-                    LBASSERTINFO(  data.range.start <= splitPos, 
-                                   data.range.start << " > " << splitPos );
-                    LBASSERTINFO( data.range.end >= currentPos, 
-                                  data.range.end << " < " << currentPos);
-#endif
-                    currentTime += data.time * size / data.range.getSize();
-                }
-
-                LBLOG( LOG_LB2 ) << splitPos << "..." << currentPos << ": t="
-                                 << currentTime << " of " << timeLeft
-                                 << std::endl;
-
-                if( currentTime >= timeLeft ) // found last region
-                {
-                    const float width = currentPos - splitPos;
-                    splitPos += (width * timeLeft / currentTime );
-                    timeLeft = 0.0f;
-                }
-                else
-                {
-                    timeLeft -= currentTime;
-                    splitPos  = currentPos;
-                }
-            }
+            const float end = range.end;
+            float splitPos = _getSplit( node, vp, range );
             LBLOG( LOG_LB2 ) << "Should split at " << splitPos << std::endl;
-            if( _damping < 1.f )
-                splitPos = (1.f - _damping) * splitPos + _damping * node->split;
-            LBLOG( LOG_LB2 ) << "Dampened split at " << splitPos << std::endl;
 
             const float boundary( node->boundaryf );
             if( node->left->resources == 0.f )
@@ -1020,11 +815,11 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
 
             Range childRange = range;
             childRange.end = splitPos;
-            _computeSplit( node->left, leftTime, datas, vp, childRange );
+            _computeSplit( node->left, vp, childRange );
 
             childRange.start = childRange.end;
             childRange.end   = range.end;
-            _computeSplit( node->right, time - leftTime, datas, vp, childRange);
+            _computeSplit( node->right, vp, childRange );
             break;
         }
 
@@ -1033,6 +828,66 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
     }
 }
 
+float LoadEqualizer::_getSplit( const Node* node, const Viewport& vp,
+                                const Range& range ) const
+{
+    const Viewport area = node->mode == MODE_DB ? _getViewport( range ) : vp;
+    const bool alongX = node->mode != MODE_HORIZONTAL;
+    const float start = alongX ? area.x : area.y;
+    const float end = alongX ? area.getXEnd() : area.getYEnd();
+
+    // the share of the left subtree, used as is if the area has no cost
+    const float share = node->resources > 0.f ?
+                        node->left->resources / node->resources : 0.f;
+
+    if( _transferWeight <= 0.f || node->left->resources == 0.f ||
+        node->right->resources == 0.f )
+    {
+        const float time = _costMap.getCost( area );
+        if( time <= 0.f )
+            return start + ( end - start ) * share;
+        return alongX ? _costMap.findSplitX( area, time * share ) :
+                        _costMap.findSplitY( area, time * share );
+    }
+
+    // the transfer cost is not proportional to the render cost, search the
+    // position where both subtrees finish at the same time
+    float low = start;
+    float high = end;
+    for( size_t i = 0; i < 24; ++i )
+    {
+        const float pos = ( low + high ) * .5f;
+        Viewport left = area;
+        Viewport right = area;
+        if( alongX )
+        {
+            left.w = pos - area.x;
+            right.x = pos;
+            right.w = end - pos;
+        }
+        else
+        {
+            left.h = pos - area.y;
+            right.y = pos;
+            right.h = end - pos;
+        }
+
+        if( _getTime( node->left, left ) < _getTime( node->right, right ))
+            low = pos;
+        else
+            high = pos;
+    }
+    return ( low + high ) * .5f;
+}
+
+float LoadEqualizer::_getTime( const Node* node, const Viewport& vp ) const
+{
+    LBASSERT( node->resources > 0.f );
+    const float transfer = _mode == MODE_DB ? node->transferCost :
+                                              node->transferCost * vp.getArea();
+    return ( _costMap.getCost( vp ) + transfer ) / node->resources;
+}
+
 void LoadEqualizer::_assign( Compound* compound, const Viewport& vp,
                              const Range& range )
 {
@@ -1050,6 +905,7 @@ void LoadEqualizer::_assign( Compound* compound, const Viewport& vp,
     // save data for later use
     Data data;
     data.vp      = vp;
+    data.area    = vp.getArea();
     data.range   = range;
     data.channel = compound->getChannel();
     data.taskID  = compound->getTaskID();
@@ -1118,6 +974,9 @@ std::ostream& operator << ( std::ostream& os, const LoadEqualizer* lb )
     if( lb->getBoundaryf() != std::numeric_limits<float>::epsilon() )
         os << "    boundary " << lb->getBoundaryf() << std::endl;
 
+    if( lb->getTransferWeight() != 0.f )
+        os << "    transfer_weight " << lb->getTransferWeight() << std::endl;
+
     os << '}' << std::endl << lunchbox::enableFlush;
     return os;
 }
@@ -20,6 +20,7 @@
 #define EQS_LOADEQUALIZER_H
 
 #include "../channelListener.h" // base class
+#include "costMap.h"            // member
 #include "equalizer.h"          // base class
 
 #include <eq/client/types.h>
@@ -59,7 +60,12 @@ namespace server
         /** @return the load balancer adaptation mode. */
         Mode getMode() const { return _mode; }
 
-        /** Set the damping factor for the viewport or range adjustment.  */
+        /**
+         * Set the damping factor for the viewport or range adjustment.
+         *
+         * The damping is applied to the cost map, after compensating the
+         * motion of the model, and not to the split positions.
+         */
         void setDamping( const float damping ) { _damping = damping; }
 
         /** @return the damping factor. */
@@ -99,6 +105,21 @@ namespace server
         void setAssembleOnlyLimit( const float limit )
             { _assembleOnlyLimit = limit; }
 
+        /**
+         * Set the weight of the transfer costs in the split.
+         *
+         * The transfer cost of a child is the time of its async readback,
+         * compression and transmission, and its share of the assembly on the
+         * destination. It grows with the area of the child in 2D modes, and is
+         * fixed in DB mode. With a weight of 0 (the default), the transmission
+         * is only assumed to overlap with the rendering.
+         */
+        void setTransferWeight( const float weight )
+            { _transferWeight = weight; }
+
+        /** @return the weight of the transfer costs in the split. */
+        float getTransferWeight() const { return _transferWeight; }
+
         virtual uint32_t getType() const { return fabric::LOAD_EQUALIZER; }
 
     protected:
@@ -114,7 +135,8 @@ namespace server
         struct Node
         {
             Node() : left(0), right(0), compound(0), mode( MODE_VERTICAL )
-                   , resources( 0.0f ), split( 0.5f ), boundaryf( 0.0f ) {}
+                   , resources( 0.0f ), split( 0.5f ), boundaryf( 0.0f )
+                   , transferCost( 0.0f ) {}
             ~Node() { delete left; delete right; }
 
             Node*     left;      //<! Left child (only on non-leafs)
@@ -126,6 +148,7 @@ namespace server
             float     boundaryf;
             Vector2i  boundary2i;
             Vector2i  maxSize;
+            float     transferCost; //<! per area (2D) or fixed (DB) of subtree
         };
         friend std::ostream& operator << ( std::ostream& os, const Node* node );
         typedef std::vector< Node* > LBNodes;
@@ -134,15 +157,17 @@ namespace server
 
         struct Data
         {
-            Data() : channel( 0 ), taskID( 0 ), destTaskID( 0 )
-                   , time( -1 ), assembleTime( 0 ) {}
+            Data() : channel( 0 ), taskID( 0 ), destTaskID( 0 ), area( 0.f )
+                   , time( -1 ), assembleTime( 0 ), transferTime( 0 ) {}
             Channel*     channel;
             uint32_t     taskID;
             uint32_t     destTaskID;
-            eq::Viewport vp;
+            eq::Viewport vp;   //<! assigned, reduced to the ROI on load data
+            float        area; //<! of the assigned viewport
             eq::Range    range;
             int64_t      time;
             int64_t      assembleTime;
+            int64_t      transferTime; //<! readback, compress and transmit
         };
 
         typedef std::vector< Data > LBDatas;
@@ -153,6 +178,9 @@ namespace server
         Vector2i _boundary2i;  // default: 1 1
         float    _boundaryf;   // default: numeric_limits<float>::epsilon
         float    _assembleOnlyLimit; // default: numeric_limits<float>::max
+        float    _transferWeight;    // default: 0
+
+        CostMap _costMap; //!< The learned screen-space or range cost
 
         //-------------------- Methods --------------------
         /** @return true if we have a valid LB tree */
@@ -179,25 +207,29 @@ namespace server
         void _update( Node* node );
         void   _updateLeaf( Node* node );
         void   _updateNode( Node* node );
+        void   _updateTransferCost( Node* node );
+
+        /** Learn the front-most _history in the cost map. */
+        void _updateCostMap();
 
-        /** Adjust the split of each node based on the front-most _history. */
-        void _computeSplit();
+        /** Adjust the split of each node based on the predicted cost map. */
+        void _computeSplit( const uint32_t frameNumber );
         void _removeEmpty( LBDatas& items );
 
-        void _computeSplit( Node* node, const float time, LBDatas* sortedData,
-                            const eq::Viewport& vp, const eq::Range& range );
+        void _computeSplit( Node* node, const eq::Viewport& vp,
+                            const eq::Range& range );
+
+        /** @return the split position balancing the children of the node. */
+        float _getSplit( const Node* node, const eq::Viewport& vp,
+                         const eq::Range& range ) const;
+
+        /** @return the predicted time of a subtree for a part of the area. */
+        float _getTime( const Node* node, const eq::Viewport& vp ) const;
         void _assign( Compound* compound, const Viewport& vp,
                       const Range& range );
 
         /** Get the resource for all children compound. */
         float _getTotalResources( ) const;
-
-        static bool _compareX( const Data& data1, const Data& data2 )
-            { return data1.vp.x < data2.vp.x; }
-        static bool _compareY( const Data& data1, const Data& data2 )
-            { return data1.vp.y < data2.vp.y; }
-        static bool _compareRange( const Data& data1, const Data& data2 )
-            { return data1.range.start < data2.range.start; }
     };
 
     std::ostream& operator << ( std::ostream& os, const LoadEqualizer::Mode );
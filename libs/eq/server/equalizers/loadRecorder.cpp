@@ -0,0 +1,265 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "loadRecorder.h"
+
+#include "../channel.h"
+#include "../config.h"
+#include "../configVisitor.h"
+
+#include <lunchbox/debug.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+static const char* const _header = "#Equalizer load record 2";
+
+// The statistic types are written by name, which keeps records readable when
+// the enum changes. Indexed by Statistic::Type.
+#define MAKE_TYPE_STRING( type ) { Statistic::type, #type }
+
+static const struct
+{
+    Statistic::Type type;
+    const char* name;
+} _types[] = {
+    MAKE_TYPE_STRING( NONE ),
+    MAKE_TYPE_STRING( CHANNEL_CLEAR ),
+    MAKE_TYPE_STRING( CHANNEL_DRAW ),
+    MAKE_TYPE_STRING( CHANNEL_DRAW_FINISH ),
+    MAKE_TYPE_STRING( CHANNEL_ASSEMBLE ),
+    MAKE_TYPE_STRING( CHANNEL_FRAME_WAIT_READY ),
+    MAKE_TYPE_STRING( CHANNEL_READBACK ),
+    MAKE_TYPE_STRING( CHANNEL_ASYNC_READBACK ),
+    MAKE_TYPE_STRING( CHANNEL_VIEW_FINISH ),
+    MAKE_TYPE_STRING( CHANNEL_FRAME_TRANSMIT ),
+    MAKE_TYPE_STRING( CHANNEL_FRAME_COMPRESS ),
+    MAKE_TYPE_STRING( CHANNEL_FRAME_WAIT_SENDTOKEN ),
+    MAKE_TYPE_STRING( WINDOW_FINISH ),
+    MAKE_TYPE_STRING( WINDOW_THROTTLE_FRAMERATE ),
+    MAKE_TYPE_STRING( WINDOW_SWAP_BARRIER ),
+    MAKE_TYPE_STRING( WINDOW_SWAP ),
+    MAKE_TYPE_STRING( WINDOW_FPS ),
+    MAKE_TYPE_STRING( PIPE_IDLE ),
+    MAKE_TYPE_STRING( NODE_FRAME_DECOMPRESS ),
+    MAKE_TYPE_STRING( CONFIG_START_FRAME ),
+    MAKE_TYPE_STRING( CONFIG_FINISH_FRAME ),
+    MAKE_TYPE_STRING( CONFIG_WAIT_FINISH_FRAME ),
+    MAKE_TYPE_STRING( NODE_PIXEL_POOL )
+};
+static const size_t _nTypes = sizeof( _types ) / sizeof( _types[0] );
+
+static const char* _getTypeName( const Statistic::Type type )
+{
+    LBASSERTINFO( _nTypes == size_t( Statistic::ALL ),
+                  "Update the statistic types" );
+    const size_t index = size_t( type );
+    LBASSERTINFO( index < _nTypes && _types[ index ].type == type, index );
+    return index < _nTypes ? _types[ index ].name : "NONE";
+}
+
+/** @return false if the name is not a statistic type. */
+static bool _getType( const std::string& name, Statistic::Type& type )
+{
+    for( size_t i = 0; i < _nTypes; ++i )
+    {
+        if( name == _types[i].name )
+        {
+            type = _types[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+class ChannelCollector : public ConfigVisitor
+{
+public:
+    virtual ~ChannelCollector() {}
+
+    virtual VisitorResult visit( Channel* channel )
+        {
+            _channels.push_back( channel );
+            return TRAVERSE_CONTINUE;
+        }
+
+    const Channels& getChannels() const { return _channels; }
+
+private:
+    Channels _channels;
+};
+
+static void _writeString( std::ostream& os, const std::string& string )
+{
+    os << '"' << string << '"';
+}
+
+static bool _readString( std::istream& is, std::string& string )
+{
+    char quote = 0;
+    is >> quote;
+    if( quote != '"' )
+        return false;
+    return !std::getline( is, string, '"' ).fail();
+}
+}
+
+LoadRecorder::LoadRecorder( const std::string& filename )
+        : _file( filename.c_str( ))
+{
+    if( !_file.is_open( ))
+    {
+        LBWARN << "Can't open load record file " << filename << std::endl;
+        return;
+    }
+
+    _file.precision( 9 );
+    _file << _header << std::endl;
+}
+
+LoadRecorder::~LoadRecorder()
+{
+    detach();
+}
+
+Channels LoadRecorder::getChannels( Config* config )
+{
+    ChannelCollector collector;
+    config->accept( collector );
+    return collector.getChannels();
+}
+
+void LoadRecorder::attach( Config* config )
+{
+    detach();
+    _channels = getChannels( config );
+    for( ChannelsCIter i = _channels.begin(); i != _channels.end(); ++i )
+        (*i)->addListener( this );
+}
+
+void LoadRecorder::detach()
+{
+    for( ChannelsCIter i = _channels.begin(); i != _channels.end(); ++i )
+        (*i)->removeListener( this );
+    _channels.clear();
+    _file.flush();
+}
+
+void LoadRecorder::notifyLoadData( Channel* channel,
+                                   const uint32_t frameNumber,
+                                   const uint32_t nStatistics,
+                                   const Statistic* statistics,
+                                   const Viewport& region )
+{
+    ChannelsCIter i = std::find( _channels.begin(), _channels.end(), channel );
+    LBASSERT( i != _channels.end( ));
+    if( i == _channels.end() || !_file.good( ))
+        return;
+
+    _file << "load " << frameNumber << ' ' << (i - _channels.begin()) << ' ';
+    _writeString( _file, channel->getName( ));
+    _file << ' ' << region.x << ' ' << region.y << ' ' << region.w << ' '
+          << region.h << ' ' << nStatistics << std::endl;
+
+    for( uint32_t j = 0; j < nStatistics; ++j )
+    {
+        const Statistic& stat = statistics[ j ];
+        const char* name = stat.resourceName;
+        const size_t length = std::find( name, name + sizeof(
+                                      stat.resourceName ), '\0' ) - name;
+
+        _file << "stat " << _getTypeName( stat.type ) << ' ' << stat.frameNumber
+              << ' ' << stat.task << ' ' << stat.plugins[0] << ' '
+              << stat.plugins[1] << ' ' << stat.ratio << ' '
+              << stat.startTime << ' ' << stat.endTime << ' ';
+        _writeString( _file, std::string( name, length ));
+        _file << std::endl;
+    }
+}
+
+bool LoadRecorder::read( const std::string& filename, Records& records )
+{
+    std::ifstream file( filename.c_str( ));
+    std::string line;
+    if( !std::getline( file, line ) || line != _header )
+    {
+        LBWARN << "Can't read load record file " << filename << std::endl;
+        return false;
+    }
+
+    size_t nStatistics = 0;
+    for( size_t lineNumber = 2; std::getline( file, line ); ++lineNumber )
+    {
+        if( line.empty( ))
+            continue;
+
+        std::istringstream is( line );
+        std::string keyword;
+        is >> keyword;
+
+        bool good = false;
+        if( keyword == "load" && nStatistics == 0 )
+        {
+            Record record;
+            is >> record.frameNumber >> record.channel;
+            good = _readString( is, record.name );
+            is >> record.region.x >> record.region.y >> record.region.w
+               >> record.region.h >> nStatistics;
+            records.push_back( record );
+        }
+        else if( keyword == "stat" && nStatistics > 0 )
+        {
+            Statistic stat;
+            std::string type;
+            std::string name;
+            is >> type >> stat.frameNumber >> stat.task >> stat.plugins[0]
+               >> stat.plugins[1] >> stat.ratio >> stat.startTime
+               >> stat.endTime;
+            good = _readString( is, name ) && _getType( type, stat.type );
+
+            const size_t length = LB_MIN( name.length(),
+                                          sizeof( stat.resourceName ) - 1 );
+            ::memcpy( stat.resourceName, name.c_str(), length );
+            stat.resourceName[ length ] = '\0';
+
+            records.back().statistics.push_back( stat );
+            --nStatistics;
+        }
+
+        if( !good || is.fail( ))
+        {
+            LBWARN << "Malformed load record in " << filename << ":"
+                   << lineNumber << ": " << line << std::endl;
+            return false;
+        }
+    }
+
+    if( nStatistics == 0 )
+        return true;
+
+    LBWARN << "Truncated load record file " << filename << std::endl;
+    return false;
+}
+
+}
+}
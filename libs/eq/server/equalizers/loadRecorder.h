@@ -0,0 +1,101 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_LOADRECORDER_H
+#define EQS_LOADRECORDER_H
+
+#include "../api.h"
+#include "../channelListener.h" // base class
+#include "../types.h"
+
+#include <eq/client/statistic.h> // member
+#include <eq/fabric/viewport.h>  // member
+
+#include <fstream>
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * Writes the load data of all channels of a config to a file.
+     *
+     * Each notification is written as one 'load' line, followed by one 'stat'
+     * line per statistic. Channels are identified by their index in the
+     * traversal order of the config, which is stable for a given config
+     * file. The records can be read back and replayed using LoadReplay.
+     */
+    class LoadRecorder : protected ChannelListener
+    {
+    public:
+        /** One recorded load data notification. */
+        struct Record
+        {
+            Record() : channel( 0 ), frameNumber( 0 ) {}
+
+            uint32_t channel; //!< The index of the channel in the config
+            std::string name; //!< The name of the channel
+            uint32_t frameNumber; //!< The frame of the load data
+            Viewport region; //!< The draw area wrt the channel's viewport
+            std::vector< Statistic > statistics; //!< The frame's statistics
+        };
+        typedef std::vector< Record > Records;
+
+        /** Open the given file for writing. */
+        EQSERVER_API LoadRecorder( const std::string& filename );
+
+        /** Detach and close the file. */
+        EQSERVER_API virtual ~LoadRecorder();
+
+        /** @return true if the file is open and no write failed. */
+        bool isGood() const { return _file.good(); }
+
+        /** Start recording the load data of all channels of the config. */
+        EQSERVER_API void attach( Config* config );
+
+        /** Stop recording. */
+        EQSERVER_API void detach();
+
+        /** @return the channels of the config, in record index order. */
+        EQSERVER_API static Channels getChannels( Config* config );
+
+        /**
+         * Read a file written by a LoadRecorder.
+         *
+         * @param filename the name of the record file.
+         * @param records the records read, in file order.
+         * @return true on success, false on a read or format error.
+         */
+        EQSERVER_API static bool read( const std::string& filename,
+                                       Records& records );
+
+    protected:
+        /** @sa ChannelListener::notifyLoadData */
+        virtual void notifyLoadData( Channel* channel,
+                                     const uint32_t frameNumber,
+                                     const uint32_t nStatistics,
+                                     const Statistic* statistics,
+                                     const Viewport& region );
+
+    private:
+        std::ofstream _file;
+        Channels _channels;
+    };
+}
+}
+
+#endif // EQS_LOADRECORDER_H
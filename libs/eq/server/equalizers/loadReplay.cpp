@@ -0,0 +1,465 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "loadReplay.h"
+
+#include "../canvas.h"
+#include "../channel.h"
+#include "../compound.h"
+#include "../compoundUpdateDataVisitor.h"
+#include "../config.h"
+#include "../configVisitor.h"
+#include "../log.h"
+#include "../node.h"
+#include "../observer.h"
+#include "../pipe.h"
+#include "../window.h"
+
+#include <lunchbox/debug.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+/** Changes of a split below this are ignored for reversals. */
+static const float _epsilon = .0001f;
+
+/** The viewport of pipes which are not configured explicitly. */
+static const PixelViewport _defaultPVP( 0, 0, 1920, 1200 );
+
+/** Sets the state of all resources, since no render client runs them. */
+class StateSetter : public ConfigVisitor
+{
+public:
+    StateSetter( const State state ) : _state( state ) {}
+    virtual ~StateSetter() {}
+
+    virtual VisitorResult visitPre( Node* node )
+        { node->setState( _state ); return TRAVERSE_CONTINUE; }
+    virtual VisitorResult visitPre( Pipe* pipe )
+        { pipe->setState( _state ); return TRAVERSE_CONTINUE; }
+    virtual VisitorResult visitPre( Window* window )
+        { window->setState( _state ); return TRAVERSE_CONTINUE; }
+    virtual VisitorResult visit( Channel* channel )
+        { channel->setState( _state ); return TRAVERSE_CONTINUE; }
+
+private:
+    const State _state;
+};
+
+/** Collects all active compounds drawing in the current frame. */
+class TaskCollector : public CompoundVisitor
+{
+public:
+    virtual ~TaskCollector() {}
+
+    virtual VisitorResult visit( Compound* compound )
+        {
+            if( !compound->isActive() || !compound->getChannel() ||
+                !compound->testInheritTask( fabric::TASK_DRAW ))
+            {
+                return TRAVERSE_CONTINUE;
+            }
+            _compounds.push_back( compound );
+            return TRAVERSE_CONTINUE;
+        }
+
+    const Compounds& getCompounds() const { return _compounds; }
+
+private:
+    Compounds _compounds;
+};
+
+static void _setResourceName( Statistic& stat, const std::string& name )
+{
+    const size_t length = LB_MIN( name.length(),
+                                  sizeof( stat.resourceName ) - 1 );
+    ::memcpy( stat.resourceName, name.c_str(), length );
+    stat.resourceName[ length ] = '\0';
+}
+
+static Viewport _getModelArea( const LoadReplay::Model& model,
+                               const uint32_t frameNumber )
+{
+    Viewport area = model.area;
+    area.x += model.motion.x() * ( float( frameNumber ) - 1.f );
+    area.y += model.motion.y() * ( float( frameNumber ) - 1.f );
+    return area;
+}
+}
+
+LoadReplay::Model::Model()
+        : background( 10.f )
+        , foreground( 90.f )
+        , transfer( 0.f )
+        , area( .2f, .3f, .3f, .4f )
+        , motion( Vector2f::ZERO )
+        , roi( false )
+{}
+
+float LoadReplay::Model::getTime( const Viewport& vp, const Range& range,
+                                  const uint32_t frameNumber ) const
+{
+    float time = background * vp.w * vp.h;
+
+    Viewport overlap = vp;
+    overlap.intersect( _getModelArea( *this, frameNumber ));
+    if( overlap.hasArea() && area.hasArea( ))
+        time += foreground * overlap.w * overlap.h / ( area.w * area.h );
+
+    return time * ( range.end - range.start );
+}
+
+Viewport LoadReplay::Model::getRegion( const Viewport& vp,
+                                       const uint32_t frameNumber ) const
+{
+    Viewport overlap = vp;
+    overlap.intersect( _getModelArea( *this, frameNumber ));
+    if( !overlap.hasArea() || !vp.hasArea( ))
+        return Viewport( 0.f, 0.f, 0.f, 0.f );
+
+    return Viewport( ( overlap.x - vp.x ) / vp.w, ( overlap.y - vp.y ) / vp.h,
+                     overlap.w / vp.w, overlap.h / vp.h );
+}
+
+LoadReplay::LoadReplay( Config* config )
+        : _config( config )
+        , _channels( LoadRecorder::getChannels( config ))
+        , _frameNumber( 0 )
+        , _clock( 0 )
+{
+    const Compounds& compounds = config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+        (*i)->init();
+
+    const Observers& observers = config->getObservers();
+    for( ObserversCIter i = observers.begin(); i != observers.end(); ++i )
+        (*i)->init();
+
+    const Canvases& canvases = config->getCanvases();
+    for( CanvasesCIter i = canvases.begin(); i != canvases.end(); ++i )
+        (*i)->init();
+
+    // pipes without a configured viewport get theirs from the render client
+    const Nodes& nodes = config->getNodes();
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        const Pipes& pipes = (*i)->getPipes();
+        for( PipesCIter j = pipes.begin(); j != pipes.end(); ++j )
+        {
+            Pipe* pipe = *j;
+            if( !pipe->getPixelViewport().hasArea( ))
+                pipe->setPixelViewport( _defaultPVP );
+        }
+    }
+
+    StateSetter running( STATE_RUNNING );
+    config->accept( running );
+
+    // set up the active state for the first update, see Config::_init
+    CompoundUpdateDataVisitor visitor( 0 );
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+        (*i)->accept( visitor );
+}
+
+LoadReplay::~LoadReplay()
+{
+    const Canvases& canvases = _config->getCanvases();
+    for( CanvasesCIter i = canvases.begin(); i != canvases.end(); ++i )
+        (*i)->exit();
+
+    const Compounds& compounds = _config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+        (*i)->exit();
+
+    StateSetter stopped( STATE_STOPPED );
+    _config->accept( stopped );
+}
+
+void LoadReplay::run( const Model& model, const uint32_t nFrames )
+{
+    for( uint32_t i = 0; i < nFrames; ++i )
+    {
+        const Tasks tasks = _startFrame();
+
+        // draw the tasks of each channel back to back, starting at _clock
+        ChannelTimes times;
+        std::map< Channel*, Load > loads;
+        for( Tasks::const_iterator j = tasks.begin(); j != tasks.end(); ++j )
+        {
+            const Task& task = *j;
+            const float time = model.getTime( task.vp, task.range,
+                                              _frameNumber ) * task.zoom;
+            float& channelTime = times[ task.channel ];
+
+            Statistic stat;
+            stat.type = Statistic::CHANNEL_DRAW;
+            stat.frameNumber = _frameNumber;
+            stat.task = task.taskID;
+            stat.plugins[0] = stat.plugins[1] = 0;
+            stat.ratio = 1.f;
+            stat.startTime = _clock + int64_t( channelTime + .5f );
+            channelTime += time;
+            stat.endTime = LB_MAX( stat.startTime + 1,
+                                   _clock + int64_t( channelTime + .5f ));
+            _setResourceName( stat, task.channel->getName( ));
+
+            const bool isFirst = loads.find( task.channel ) == loads.end();
+            Load& load = loads[ task.channel ];
+            load.channel = task.channel;
+            load.frameNumber = _frameNumber;
+            load.statistics.push_back( stat );
+
+            // a channel with several tasks reports its full viewport
+            const Viewport region = model.roi ?
+                model.getRegion( task.vp, _frameNumber ) : Viewport::FULL;
+            load.region = isFirst ? region : Viewport::FULL;
+
+            const Compound* compound = task.compound;
+            if( model.transfer <= 0.f || compound->getOutputFrames().empty( ))
+                continue;
+
+            // readback and transmit the region after drawing
+            Viewport transmitted = task.vp;
+            transmitted.apply( region );
+
+            stat.type = Statistic::CHANNEL_FRAME_TRANSMIT;
+            stat.startTime = stat.endTime;
+            channelTime += model.transfer * transmitted.getArea() * task.zoom;
+            stat.endTime = LB_MAX( stat.startTime + 1,
+                                   _clock + int64_t( channelTime + .5f ));
+            load.statistics.push_back( stat );
+        }
+
+        for( std::map< Channel*, Load >::const_iterator j = loads.begin();
+             j != loads.end(); ++j )
+        {
+            _loads.push_back( j->second );
+        }
+        _finishFrame( tasks, times );
+    }
+}
+
+bool LoadReplay::run( const LoadRecorder::Records& records )
+{
+    if( records.empty( ))
+        return true;
+
+    typedef std::multimap< uint32_t, const LoadRecorder::Record* > FrameMap;
+    FrameMap frames;
+    for( LoadRecorder::Records::const_iterator i = records.begin();
+         i != records.end(); ++i )
+    {
+        const LoadRecorder::Record& record = *i;
+        if( record.channel >= _channels.size() || ( !record.name.empty() &&
+                        record.name != _channels[ record.channel ]->getName( )))
+        {
+            LBWARN << "Load record for channel " << record.channel << " \""
+                   << record.name << "\" does not match the config"
+                   << std::endl;
+            return false;
+        }
+        frames.insert( std::make_pair( record.frameNumber, &record ));
+    }
+
+    // replay with the recorded frame numbers, which match the task data
+    const uint32_t first = frames.begin()->first;
+    const uint32_t last = frames.rbegin()->first;
+    if( first > 0 )
+        _frameNumber = LB_MAX( _frameNumber, first - 1 );
+
+    while( _frameNumber < last )
+    {
+        const Tasks tasks = _startFrame();
+        ChannelTimes times;
+
+        std::pair< FrameMap::const_iterator, FrameMap::const_iterator > range =
+            frames.equal_range( _frameNumber );
+        for( FrameMap::const_iterator i = range.first; i != range.second; ++i )
+        {
+            const LoadRecorder::Record& record = *i->second;
+            Load load;
+            load.channel = _channels[ record.channel ];
+            load.frameNumber = record.frameNumber;
+            load.region = record.region;
+            load.statistics = record.statistics;
+            _loads.push_back( load );
+
+            int64_t startTime = std::numeric_limits< int64_t >::max();
+            int64_t endTime = 0;
+            for( std::vector< Statistic >::const_iterator j =
+                     record.statistics.begin();
+                 j != record.statistics.end(); ++j )
+            {
+                switch( j->type )
+                {
+                case Statistic::CHANNEL_CLEAR:
+                case Statistic::CHANNEL_DRAW:
+                case Statistic::CHANNEL_ASSEMBLE:
+                case Statistic::CHANNEL_READBACK:
+                    startTime = LB_MIN( startTime, j->startTime );
+                    endTime = LB_MAX( endTime, j->endTime );
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            if( endTime > startTime )
+            {
+                float& time = times[ load.channel ];
+                time = LB_MAX( time, float( endTime - startTime ));
+            }
+        }
+        _finishFrame( tasks, times );
+    }
+    return true;
+}
+
+uint32_t LoadReplay::getConvergenceFrame( const float imbalance ) const
+{
+    uint32_t frame = 0;
+    for( Reports::const_iterator i = _reports.begin(); i != _reports.end();
+         ++i )
+    {
+        if( i->imbalance >= imbalance )
+            frame = 0;
+        else if( frame == 0 )
+            frame = i->frameNumber;
+    }
+    return frame;
+}
+
+LoadReplay::Tasks LoadReplay::_startFrame()
+{
+    ++_frameNumber;
+    _deliverLoads();
+
+    CompoundUpdateDataVisitor visitor( _frameNumber );
+    TaskCollector collector;
+    const Compounds& compounds = _config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+    {
+        (*i)->accept( visitor );
+        (*i)->accept( collector );
+    }
+
+    Tasks tasks;
+    const Compounds& drawing = collector.getCompounds();
+    for( CompoundsCIter i = drawing.begin(); i != drawing.end(); ++i )
+    {
+        Compound* compound = *i;
+        const Zoom& zoom = compound->getInheritZoom();
+
+        Task task;
+        task.compound = compound;
+        task.channel = compound->getChannel();
+        task.taskID = compound->getTaskID();
+        task.vp = compound->getInheritViewport();
+        task.range = compound->getInheritRange();
+        task.zoom = zoom.x() * zoom.y();
+        tasks.push_back( task );
+    }
+    return tasks;
+}
+
+void LoadReplay::_deliverLoads()
+{
+    // The load of a frame is known when the frame after the latency starts
+    const uint32_t latency = _config->getLatency();
+    while( !_loads.empty() &&
+           _loads.front().frameNumber + latency < _frameNumber )
+    {
+        const Load& load = _loads.front();
+        if( !load.statistics.empty( ))
+            load.channel->fireLoadData( load.frameNumber,
+                                        uint32_t( load.statistics.size( )),
+                                        &load.statistics.front(),
+                                        load.region );
+        _loads.pop_front();
+    }
+}
+
+void LoadReplay::_finishFrame( const Tasks& tasks, const ChannelTimes& times )
+{
+    Report report;
+    report.frameNumber = _frameNumber;
+
+    float sum = 0.f;
+    size_t nChannels = 0;
+    for( ChannelTimes::const_iterator i = times.begin(); i != times.end(); ++i )
+    {
+        if( i->second <= 0.f )
+            continue;
+        sum += i->second;
+        report.time = LB_MAX( report.time, i->second );
+        ++nChannels;
+    }
+    if( nChannels > 0 )
+        report.imbalance = 1.f - sum / float( nChannels ) / report.time;
+    _clock += LB_MAX( int64_t( 1 ), int64_t( report.time + .5f ));
+
+    for( Tasks::const_iterator i = tasks.begin(); i != tasks.end(); ++i )
+    {
+        const Task& task = *i;
+        const float edges[] = { task.vp.x, task.vp.getXEnd(), task.vp.y,
+                                task.vp.getYEnd(), task.range.start,
+                                task.range.end, task.zoom };
+
+        Splits::iterator j = _splits.find( task.compound );
+        if( j == _splits.end( ))
+        {
+            Split& split = _splits[ task.compound ];
+            ::memcpy( split.edges, edges, sizeof( edges ));
+            ::memset( split.deltas, 0, sizeof( split.deltas ));
+            continue;
+        }
+
+        Split& split = j->second;
+        for( size_t k = 0; k < sizeof( edges ) / sizeof( float ); ++k )
+        {
+            const float delta = edges[k] - split.edges[k];
+            report.movement = LB_MAX( report.movement, std::abs( delta ));
+
+            if( std::abs( delta ) <= _epsilon )
+                continue;
+            if( delta * split.deltas[k] < 0.f )
+                ++report.reversals;
+            split.edges[k] = edges[k];
+            split.deltas[k] = delta;
+        }
+    }
+
+    LBLOG( LOG_LB1 ) << report << std::endl;
+    _reports.push_back( report );
+}
+
+std::ostream& operator << ( std::ostream& os, const LoadReplay::Report& report )
+{
+    os << "frame " << report.frameNumber << " time " << report.time
+       << " imbalance " << report.imbalance << " movement " << report.movement
+       << " reversals " << report.reversals;
+    return os;
+}
+
+}
+}
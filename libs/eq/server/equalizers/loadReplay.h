@@ -0,0 +1,181 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_LOADREPLAY_H
+#define EQS_LOADREPLAY_H
+
+#include "loadRecorder.h" // Records
+
+#include "../api.h"
+#include "../types.h"
+
+#include <eq/client/types.h>
+#include <eq/fabric/range.h>    // member
+#include <eq/fabric/viewport.h> // member
+
+#include <deque>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * Runs the equalizers of a loaded config without any render clients.
+     *
+     * The compounds of the config are updated for each frame as during a
+     * normal run, and the load data of each drawing channel is either
+     * generated from a synthetic cost model or taken from records written by
+     * a LoadRecorder. The load data is delivered to the channels after the
+     * latency of the config. Each frame is summarized by its time, the
+     * imbalance between the channels and the change of the splits.
+     */
+    class LoadReplay
+    {
+    public:
+        /**
+         * A synthetic cost model.
+         *
+         * The screen has a uniform cost, and a model with a uniform cost
+         * moves across it. The cost of a task is proportional to its share
+         * of the screen, model and range, and to the pixels drawn.
+         */
+        struct Model
+        {
+            EQSERVER_API Model();
+
+            /** @return the time in ms to draw the given area in a frame. */
+            EQSERVER_API float getTime( const Viewport& vp,
+                                        const Range& range,
+                                        const uint32_t frameNumber ) const;
+
+            /**
+             * @return the area covered by the model in a frame, relative to
+             *         the given viewport.
+             */
+            EQSERVER_API Viewport getRegion( const Viewport& vp,
+                                             const uint32_t frameNumber )
+                const;
+
+            float background; //!< ms to draw the full screen without model
+            float foreground; //!< ms to draw the full model
+            /** ms to transmit the full screen from a source channel. */
+            float transfer;
+            Viewport area;    //!< The area of the model in frame 1
+            Vector2f motion;  //!< The motion of the model per frame
+            /** Report and transmit only the model's region (ROI). */
+            bool roi;
+        };
+
+        /** The summary of one replayed frame. */
+        struct Report
+        {
+            Report() : frameNumber( 0 ), time( 0.f ), imbalance( 0.f ),
+                      movement( 0.f ), reversals( 0 ) {}
+
+            uint32_t frameNumber;
+            float time;         //!< The time of the slowest channel, in ms
+            /** 1 - mean / maximum channel time, 0 if perfectly balanced. */
+            float imbalance;
+            float movement;     //!< The largest change of a split or zoom
+            uint32_t reversals; //!< Splits which changed their direction
+        };
+        typedef std::vector< Report > Reports;
+
+        /** Initialize the compounds and canvases of the config. */
+        EQSERVER_API LoadReplay( Config* config );
+
+        /** Exit the compounds and canvases of the config. */
+        EQSERVER_API ~LoadReplay();
+
+        /** Run the given number of frames, closing the loop over a model. */
+        EQSERVER_API void run( const Model& model, const uint32_t nFrames );
+
+        /**
+         * Run all frames of the records.
+         *
+         * The records are replayed as recorded, i.e., they do not depend on
+         * the splits computed during the replay.
+         *
+         * @return false if a record does not match the config.
+         */
+        EQSERVER_API bool run( const LoadRecorder::Records& records );
+
+        /** @return the summary of all replayed frames. */
+        const Reports& getReports() const { return _reports; }
+
+        /**
+         * @return the first frame after which the imbalance stays below the
+         *         given value, or 0 if it never settles.
+         */
+        EQSERVER_API uint32_t getConvergenceFrame( const float imbalance )
+            const;
+
+    private:
+        /** A drawing compound of the current frame. */
+        struct Task
+        {
+            Compound* compound;
+            Channel* channel;
+            uint32_t taskID;
+            Viewport vp;
+            Range range;
+            float zoom;
+        };
+        typedef std::vector< Task > Tasks;
+
+        /** The load data of one channel, waiting for delivery. */
+        struct Load
+        {
+            Channel* channel;
+            uint32_t frameNumber;
+            Viewport region;
+            std::vector< Statistic > statistics;
+        };
+        typedef std::deque< Load > Loads;
+
+        /** The last split and zoom of a compound, and their last change. */
+        struct Split
+        {
+            float edges[7];
+            float deltas[7];
+        };
+        typedef std::map< const Compound*, Split > Splits;
+
+        /** The time each channel was busy in a frame, in ms. */
+        typedef std::map< Channel*, float > ChannelTimes;
+
+        Config* const _config;
+        const Channels _channels;
+        uint32_t _frameNumber;
+        int64_t _clock;
+        Loads _loads;
+        Splits _splits;
+        Reports _reports;
+
+        Tasks _startFrame();
+        void _deliverLoads();
+        void _finishFrame( const Tasks& tasks, const ChannelTimes& times );
+    };
+
+    EQSERVER_API std::ostream& operator << ( std::ostream&,
+                                             const LoadReplay::Report& );
+}
+}
+
+#endif // EQS_LOADREPLAY_H
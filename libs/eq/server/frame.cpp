@@ -25,6 +25,10 @@
 #include <co/dataIStream.h>
 #include <co/dataOStream.h>
 
+#include <algorithm>
+#include <map>
+#include <set>
+
 namespace eq
 {
 namespace server
@@ -81,6 +85,8 @@ void Frame::unsetData()
         _inputFrames[i].clear();
         _getInputNodes( i ).clear();
         _getInputNetNodes( i ).clear();
+        _getInputPriorities( i ).clear();
+        _getInputRates( i ).clear();
     }
 }
 
@@ -144,13 +150,34 @@ void Frame::cycleData( const uint32_t frameNumber, const Compound* compound )
         _frameData[i] = data;
         _getInputNodes( i ).clear();
         _getInputNetNodes( i ).clear();
+        _getInputPriorities( i ).clear();
+        _getInputRates( i ).clear();
         if( !_masterFrameData )
             _masterFrameData = data;
     }
 }
 
+uint32_t Frame::getInputPriority( const Frame* frame,
+                                  const Compound* compound )
+{
+    // The destination assembles the compound tree bottom-up, and the input
+    // frames of one compound in order. Images needed first get a lower value.
+    const Frames& frames = compound->getInputFrames();
+    const size_t position = std::find( frames.begin(), frames.end(), frame ) -
+                            frames.begin();
+    uint32_t depth = 0;
+    for( const Compound* parent = compound->getParent(); parent;
+         parent = parent->getParent( ))
+    {
+        ++depth;
+    }
+    return ( ( 0xffffu - LB_MIN( depth, 0xffffu )) << 16 ) |
+           uint32_t( LB_MIN( position, size_t( 0xffffu )));
+}
+
 void Frame::addInputFrame( Frame* frame, const Compound* compound )
 {
+    const uint32_t priority = getInputPriority( frame, compound );
     for( unsigned i = 0; i < NUM_EYES; ++i )
     {
         // eye pass not used && no output frame for eye pass
@@ -166,6 +193,7 @@ void Frame::addInputFrame( Frame* frame, const Compound* compound )
                 co::NodePtr inputNetNode = inputNode->getNode();
                 _getInputNodes( i ).push_back( inputNode->getID( ));
                 _getInputNetNodes( i ).push_back( inputNetNode->getNodeID( ));
+                _getInputPriorities( i ).push_back( priority );
             }
         }
         else
@@ -175,6 +203,59 @@ void Frame::addInputFrame( Frame* frame, const Compound* compound )
     }
 }
 
+void Frame::updateInputRates( const Frames& outputFrames )
+{
+    // sum up the weights of the distinct nodes sending to each node
+    typedef std::pair< const Node*, const Node* > Link;
+    std::set< Link > links;
+    std::map< const Node*, uint64_t > weights;
+
+    for( FramesCIter i = outputFrames.begin(); i != outputFrames.end(); ++i )
+    {
+        const Frame* frame = *i;
+        const Node* node = frame->getNode();
+        for( unsigned j = 0; j < NUM_EYES; ++j )
+        {
+            const Frames& inputFrames = frame->_inputFrames[j];
+            for( FramesCIter k = inputFrames.begin(); k != inputFrames.end();
+                 ++k )
+            {
+                const Node* inputNode = (*k)->getNode();
+                if( inputNode != node &&
+                    links.insert( Link( node, inputNode )).second )
+                {
+                    weights[ inputNode ] += node->getTransmitWeight();
+                }
+            }
+        }
+    }
+
+    for( FramesCIter i = outputFrames.begin(); i != outputFrames.end(); ++i )
+    {
+        Frame* frame = *i;
+        const Node* node = frame->getNode();
+        for( unsigned j = 0; j < NUM_EYES; ++j )
+        {
+            std::vector< uint32_t >& rates = frame->_getInputRates( j );
+            rates.clear();
+
+            const Frames& inputFrames = frame->_inputFrames[j];
+            for( FramesCIter k = inputFrames.begin(); k != inputFrames.end();
+                 ++k )
+            {
+                const Node* inputNode = (*k)->getNode();
+                if( inputNode == node ) // not in input nodes
+                    continue;
+
+                const uint64_t rate = inputNode->getReceiveRate();
+                rates.push_back( uint32_t( rate * node->getTransmitWeight() /
+                                           weights[ inputNode ] ));
+            }
+            LBASSERT( rates.size() == frame->_getInputNodes( j ).size( ));
+        }
+    }
+}
+
 std::ostream& operator << ( std::ostream& os, const Frame& frame )
 {
     os << lunchbox::disableFlush << "frame" << std::endl
@@ -111,6 +111,31 @@ namespace server
          */
         void addInputFrame( Frame* frame, const Compound* compound );
 
+        /**
+         * Compute the transmission priority of an input frame.
+         *
+         * @param frame the input frame.
+         * @param compound the compound holding the input frame.
+         * @return the priority, lower values are assembled first by the
+         *         destination.
+         */
+        EQSERVER_API static uint32_t getInputPriority( const Frame* frame,
+                                                    const Compound* compound );
+
+        /**
+         * Set the transmission rates of output frames to their receiving
+         * nodes.
+         *
+         * The receive rate of each node is shared among all nodes sending
+         * to it, according to their transmit weights. The shares of senders
+         * idle in a frame are used by the other senders, see
+         * eq::detail::TransmitShaper.
+         *
+         * @param outputFrames the output frames of all compounds of a config,
+         *                     after all input frames have been added.
+         */
+        static void updateInputRates( const Frames& outputFrames );
+
         /** @return the vector of current input frames. */
         const Frames& getInputFrames( const Eye eye ) const
             { return _inputFrames[ lunchbox::getIndexOfLastBit( eye ) ]; }
@@ -75,6 +75,9 @@ void Global::_setupDefaults()
 
     _nodeIAttributes[Node::IATTR_LAUNCH_TIMEOUT] = 60000; // ms
     _nodeIAttributes[Node::IATTR_HINT_AFFINITY] = AUTO;
+    _nodeIAttributes[Node::IATTR_HINT_TRANSMIT_THREADS] = AUTO;
+    _nodeIAttributes[Node::IATTR_HINT_RECEIVE_RATE] = AUTO;
+    _nodeIAttributes[Node::IATTR_HINT_TRANSMIT_WEIGHT] = AUTO;
     _nodeSAttributes[Node::SATTR_LAUNCH_COMMAND] =
         "ssh -n %h %c --eq-logfile %q%d/%h.%n.log%q";
 #ifdef WIN32
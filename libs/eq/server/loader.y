@@ -118,6 +118,9 @@
 %token EQTOKEN_NODE_CATTR_LAUNCH_COMMAND_QUOTE
 %token EQTOKEN_NODE_IATTR_THREAD_MODEL
 %token EQTOKEN_NODE_IATTR_HINT_AFFINITY
+%token EQTOKEN_NODE_IATTR_HINT_TRANSMIT_THREADS
+%token EQTOKEN_NODE_IATTR_HINT_RECEIVE_RATE
+%token EQTOKEN_NODE_IATTR_HINT_TRANSMIT_WEIGHT
 %token EQTOKEN_NODE_IATTR_HINT_STATISTICS
 %token EQTOKEN_NODE_IATTR_LAUNCH_TIMEOUT
 %token EQTOKEN_PIPE_IATTR_HINT_CUDA_GL_INTEROP
@@ -156,6 +159,9 @@
 %token EQTOKEN_HINT_DRAWABLE
 %token EQTOKEN_HINT_THREAD
 %token EQTOKEN_HINT_AFFINITY
+%token EQTOKEN_HINT_TRANSMIT_THREADS
+%token EQTOKEN_HINT_RECEIVE_RATE
+%token EQTOKEN_HINT_TRANSMIT_WEIGHT
 %token EQTOKEN_HINT_CUDA_GL_INTEROP
 %token EQTOKEN_HINT_SCREENSAVER
 %token EQTOKEN_HINT_GRAB_POINTER
@@ -282,6 +288,7 @@
 %token EQTOKEN_MODE
 %token EQTOKEN_2D
 %token EQTOKEN_ASSEMBLE_ONLY_LIMIT
+%token EQTOKEN_TRANSFER_WEIGHT
 %token EQTOKEN_DB
 %token EQTOKEN_BOUNDARY
 %token EQTOKEN_ZOOM
@@ -390,6 +397,21 @@ global:
          eq::server::Global::instance()->setNodeIAttribute(
              eq::server::Node::IATTR_HINT_AFFINITY, $2 );
      }
+     | EQTOKEN_NODE_IATTR_HINT_TRANSMIT_THREADS IATTR
+     {
+         eq::server::Global::instance()->setNodeIAttribute(
+             eq::server::Node::IATTR_HINT_TRANSMIT_THREADS, $2 );
+     }
+     | EQTOKEN_NODE_IATTR_HINT_RECEIVE_RATE IATTR
+     {
+         eq::server::Global::instance()->setNodeIAttribute(
+             eq::server::Node::IATTR_HINT_RECEIVE_RATE, $2 );
+     }
+     | EQTOKEN_NODE_IATTR_HINT_TRANSMIT_WEIGHT IATTR
+     {
+         eq::server::Global::instance()->setNodeIAttribute(
+             eq::server::Node::IATTR_HINT_TRANSMIT_WEIGHT, $2 );
+     }
      | EQTOKEN_NODE_IATTR_LAUNCH_TIMEOUT UNSIGNED
      {
          eq::server::Global::instance()->setNodeIAttribute(
@@ -634,6 +656,14 @@ nodeAttribute:
         }
     | EQTOKEN_HINT_AFFINITY IATTR
         { node->setIAttribute( eq::server::Node::IATTR_HINT_AFFINITY, $2 ); }
+    | EQTOKEN_HINT_TRANSMIT_THREADS IATTR
+        { node->setIAttribute( eq::server::Node::IATTR_HINT_TRANSMIT_THREADS,
+                               $2 ); }
+    | EQTOKEN_HINT_RECEIVE_RATE IATTR
+        { node->setIAttribute( eq::server::Node::IATTR_HINT_RECEIVE_RATE, $2 ); }
+    | EQTOKEN_HINT_TRANSMIT_WEIGHT IATTR
+        { node->setIAttribute( eq::server::Node::IATTR_HINT_TRANSMIT_WEIGHT,
+                               $2 ); }
 
 
 pipe: EQTOKEN_PIPE '{' 
@@ -1209,6 +1239,8 @@ loadEqualizerField:
                  { loadEqualizer->setBoundary( eq::Vector2i( $3, $4 )); }
     | EQTOKEN_ASSEMBLE_ONLY_LIMIT FLOAT
                            { loadEqualizer->setAssembleOnlyLimit( $2 ); }
+    | EQTOKEN_TRANSFER_WEIGHT FLOAT
+                           { loadEqualizer->setTransferWeight( $2 ); }
     | EQTOKEN_BOUNDARY FLOAT        { loadEqualizer->setBoundary( $2 ); }
     | EQTOKEN_MODE loadEqualizerMode    { loadEqualizer->setMode( $2 ); }
 
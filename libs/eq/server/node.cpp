@@ -181,6 +181,31 @@ const std::string& Node::getCAttributeString( const CAttribute attr )
     return _cAttributeStrings[attr];
 }
 
+uint32_t Node::getReceiveRate() const
+{
+    const int32_t rate = getIAttribute( IATTR_HINT_RECEIVE_RATE );
+    if( rate > 0 )
+        return uint32_t( rate ) * 1024; // MB/s
+    if( rate != AUTO )
+        return 0;
+
+    // the fastest configured connection bandwidth
+    uint32_t bandwidth = 0;
+    for( co::ConnectionDescriptionsCIter i = _connectionDescriptions.begin();
+         i != _connectionDescriptions.end(); ++i )
+    {
+        if( (*i)->bandwidth > 0 )
+            bandwidth = LB_MAX( bandwidth, uint32_t( (*i)->bandwidth ));
+    }
+    return bandwidth;
+}
+
+uint32_t Node::getTransmitWeight() const
+{
+    const int32_t weight = getIAttribute( IATTR_HINT_TRANSMIT_WEIGHT );
+    return weight > 0 ? uint32_t( weight ) : 1;
+}
+
 //===========================================================================
 // Operations
 //===========================================================================
@@ -466,6 +491,7 @@ void Node::configInit( const uint128_t& initID, const uint32_t frameNumber )
     NodeConfigInitPacket packet;
     packet.initID      = initID;
     packet.frameNumber = frameNumber;
+    packet.receiveRate = getReceiveRate();
 
     _send( packet );
 }
@@ -819,9 +845,15 @@ void Node::output( std::ostream& os ) const
             attrPrinted = true;
         }
         
-        os << ( i== Node::IATTR_LAUNCH_TIMEOUT ? "launch_timeout       " :
-                i== Node::IATTR_THREAD_MODEL   ? "thread_model         " :
-                i== Node::IATTR_HINT_AFFINITY  ? "hint_affinity        " :
+        os << ( i== Node::IATTR_LAUNCH_TIMEOUT ? "launch_timeout        " :
+                i== Node::IATTR_THREAD_MODEL   ? "thread_model          " :
+                i== Node::IATTR_HINT_AFFINITY  ? "hint_affinity         " :
+                i== Node::IATTR_HINT_TRANSMIT_THREADS ?
+                                                 "hint_transmit_threads " :
+                i== Node::IATTR_HINT_RECEIVE_RATE ?
+                                                 "hint_receive_rate     " :
+                i== Node::IATTR_HINT_TRANSMIT_WEIGHT ?
+                                                 "hint_transmit_weight  " :
                 "ERROR" )
            << static_cast< fabric::IAttribute >( value ) << std::endl;
     }
@@ -234,6 +234,16 @@ namespace server
         static const std::string& getSAttributeString( const SAttribute attr );
         /** @internal @return the name of a node character attribute. */
         static const std::string& getCAttributeString( const CAttribute attr );
+
+        /**
+         * @internal
+         * @return the maximum rate of received image data in KB/s, 0 if
+         *         unlimited.
+         */
+        uint32_t getReceiveRate() const;
+
+        /** @internal @return the weight of the node's image transmissions. */
+        uint32_t getTransmitWeight() const;
         //@}
 
         void output( std::ostream& os ) const; //!< @internal
@@ -40,6 +40,7 @@ class Equalizer;
 class Frame;
 class FrameData;
 class Layout;
+class LoadRecorder;
 class Node;
 class NodeFactory;
 class Observer;
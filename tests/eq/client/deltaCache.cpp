@@ -0,0 +1,175 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that delta-encoded images only transmit the compressed changed blocks
+// and are restored by the receiver, and that a lost reference is detected and
+// recovered by a full image.
+
+#include <test.h>
+
+#include <eq/client/deltaCache.h>      // private header
+#include <eq/client/frameData.h>
+#include <eq/client/image.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/nodePackets.h>     // private header
+#include <eq/client/pixelData.h>
+#include <eq/client/pixelDataWriter.h> // private header
+#include <co/plugins/compressor.h>
+
+#include <cstring>
+
+namespace
+{
+static const eq::PixelViewport _pvp( 0, 0, 640, 480 );
+static const eq::uint128_t _node( 0, 42 );
+
+void _setPixels( eq::Image& image, std::vector< uint8_t >& pixels )
+{
+    eq::PixelData data;
+    data.internalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+    data.externalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+    data.pixelSize = 4;
+    data.pvp = _pvp;
+    data.pixels = &pixels.front();
+    image.setPixelViewport( _pvp );
+    image.setPixelData( eq::Frame::BUFFER_COLOR, data );
+}
+
+/** Send the image and receive it into the frame data. @return data size */
+uint64_t _transmit( eq::FrameData& sender, eq::FrameData& receiver,
+                    const eq::Image& image, const uint32_t version,
+                    eq::Image*& received )
+{
+    eq::NodeFrameDataTransmitPacket packet;
+    packet.frameData.version = eq::uint128_t( 0, version );
+    packet.pvp = _pvp;
+    packet.imageIndex = 0;
+    packet.buffers = eq::Frame::BUFFER_COLOR;
+
+    eq::detail::PixelDataWriter writer;
+    eq::detail::DeltaCache& cache = sender.getDeltaCache();
+    if( !cache.encode( _node, 0, &image, writer, packet ))
+    {
+        writer.add( image.getPixelData( eq::Frame::BUFFER_COLOR ), 1.f );
+        cache.setReference( _node, 0, &image, packet );
+    }
+
+    const uint64_t packetSize = sizeof( packet ) - 8 * sizeof( uint8_t );
+    std::vector< uint8_t > buffer( packetSize + writer.getSize( ));
+    ::memcpy( &buffer.front(), &packet, packetSize );
+    writer.copy( &buffer[ packetSize ] );
+
+    received = receiver.addImage(
+        reinterpret_cast< eq::NodeFrameDataTransmitPacket* >(
+            &buffer.front( )));
+    eq::NodeFrameDataDecompressPacket times;
+    receiver.decompressImage( received, times );
+    return writer.getSize();
+}
+
+bool _equals( const eq::Image* image, const std::vector< uint8_t >& pixels )
+{
+    if( !image->hasPixelData( eq::Frame::BUFFER_COLOR ))
+        return false;
+    const eq::PixelData& data = image->getPixelData( eq::Frame::BUFFER_COLOR );
+    return data.pvp == _pvp &&
+           ::memcmp( data.pixels, &pixels.front(), pixels.size( )) == 0;
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+    {
+        eq::FrameData sender;
+        eq::FrameData receiver;
+        eq::Image image;
+        std::vector< uint8_t > pixels( _pvp.getArea() * 4 );
+        for( size_t i = 0; i < pixels.size(); ++i )
+            pixels[i] = uint8_t( i * 7 );
+        _setPixels( image, pixels );
+
+        // the first image is sent in full
+        eq::Image* received = 0;
+        const uint64_t fullSize = _transmit( sender, receiver, image, 1,
+                                             received );
+        TEST( fullSize >= pixels.size( ));
+        TEST( _equals( received, pixels ));
+
+        // an unchanged image only sends the block bitmap
+        uint64_t size = _transmit( sender, receiver, image, 2, received );
+        TESTINFO( size < 1024, size );
+        TEST( _equals( received, pixels ));
+
+        // a small change sends the changed blocks
+        for( int32_t y = 100; y < 120; ++y )
+            for( int32_t x = 200; x < 260; ++x )
+                pixels[ ( y * _pvp.w + x ) * 4 ] ^= 0xFF;
+        _setPixels( image, pixels );
+        size = _transmit( sender, receiver, image, 3, received );
+        TESTINFO( size < fullSize / 20, size );
+        TEST( _equals( received, pixels ));
+
+        // uniform changed blocks are compressed
+        for( int32_t y = 64; y < 128; ++y )
+            for( int32_t x = 64; x < 128; ++x )
+                ::memset( &pixels[ ( y * _pvp.w + x ) * 4 ], 0x80, 4 );
+        _setPixels( image, pixels );
+        size = _transmit( sender, receiver, image, 4, received );
+        TESTINFO( size < 64 * 64 * 4 / 4, size );
+        TEST( _equals( received, pixels ));
+
+        // a full change sends the full image
+        for( size_t i = 0; i < pixels.size(); ++i )
+            pixels[i] = ~pixels[i];
+        _setPixels( image, pixels );
+        size = _transmit( sender, receiver, image, 5, received );
+        TEST( size >= pixels.size( ));
+        TEST( _equals( received, pixels ));
+
+        // a receiver without the reference drops the delta and reports the
+        // lost reference once
+        eq::FrameData other;
+        pixels[0] ^= 0xFF;
+        _setPixels( image, pixels );
+        _transmit( sender, other, image, 6, received );
+        TEST( !received->hasPixelData( eq::Frame::BUFFER_COLOR ));
+        TEST( other.getDeltaCache().isReferenceLost( 0 ));
+        TEST( !other.getDeltaCache().isReferenceLost( 0 ));
+
+        pixels[0] ^= 0xFF;
+        _setPixels( image, pixels );
+        _transmit( sender, other, image, 7, received );
+        TEST( !received->hasPixelData( eq::Frame::BUFFER_COLOR ));
+        TEST( !other.getDeltaCache().isReferenceLost( 0 ));
+
+        // the sender recovers with a full image
+        sender.getDeltaCache().invalidate( _node, 0 );
+        size = _transmit( sender, other, image, 8, received );
+        TEST( size >= pixels.size( ));
+        TEST( _equals( received, pixels ));
+
+        pixels[0] ^= 0xFF;
+        _setPixels( image, pixels );
+        size = _transmit( sender, other, image, 9, received );
+        TESTINFO( size < fullSize / 20, size );
+        TEST( _equals( received, pixels ));
+    }
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
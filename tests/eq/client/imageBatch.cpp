@@ -0,0 +1,128 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that small images batched into one packet are padded and received as
+// separate images.
+
+#include <test.h>
+
+#include <eq/client/frameData.h>
+#include <eq/client/image.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/nodePackets.h>     // private header
+#include <eq/client/pixelData.h>
+#include <eq/client/pixelDataWriter.h> // private header
+#include <co/plugins/compressor.h>
+
+#include <cstring>
+
+namespace
+{
+static const uint64_t _packetSize =
+    sizeof( eq::NodeFrameDataTransmitPacket ) - 8 * sizeof( uint8_t );
+
+eq::PixelData _newPixelData( const eq::PixelViewport& pvp,
+                             std::vector< uint8_t >& pixels )
+{
+    pixels.resize( pvp.getArea() * 4 );
+    for( size_t i = 0; i < pixels.size(); ++i )
+        pixels[i] = uint8_t( i * 3 + pvp.w );
+
+    eq::PixelData data;
+    data.internalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+    data.externalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+    data.pixelSize = 4;
+    data.pvp = pvp;
+    data.pixels = &pixels.front();
+    return data;
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    // odd sizes need padding
+    static const eq::PixelViewport pvps[] = { eq::PixelViewport( 0, 0, 3, 5 ),
+                                              eq::PixelViewport( 3, 0, 1, 1 ),
+                                              eq::PixelViewport( 4, 0, 7, 2 )};
+    const size_t nImages = sizeof( pvps ) / sizeof( pvps[0] );
+    std::vector< uint8_t > pixels[ nImages ];
+
+    eq::NodeFrameDataTransmitPacket packet;
+    packet.frameData.version = eq::uint128_t( 0, 1 );
+    packet.nImages = uint32_t( nImages );
+
+    eq::detail::PixelDataWriter writer;
+    for( size_t i = 0; i < nImages; ++i )
+    {
+        const eq::PixelData data = _newPixelData( pvps[i], pixels[i] );
+        eq::detail::PixelDataWriter imageWriter;
+        imageWriter.add( data, 1.f );
+
+        eq::NodeFrameDataTransmitPacket imagePacket;
+        imagePacket.frameData = packet.frameData;
+        imagePacket.imageIndex = uint32_t( i );
+        imagePacket.buffers = eq::Frame::BUFFER_COLOR;
+        imagePacket.pvp = pvps[i];
+
+        const uint64_t size = writer.getSize();
+        writer.addImage( imagePacket, imageWriter );
+        TEST( imagePacket.size % 8 == 0 );
+        TEST( imagePacket.size >= _packetSize + imageWriter.getSize( ));
+        TEST( imagePacket.size < _packetSize + imageWriter.getSize() + 8 );
+        TEST( writer.getSize() == size + imagePacket.size );
+    }
+
+    // an image without data is only its padded packet
+    {
+        eq::detail::PixelDataWriter emptyWriter;
+        eq::detail::PixelDataWriter batch;
+        eq::NodeFrameDataTransmitPacket imagePacket;
+        batch.addImage( imagePacket, emptyWriter );
+        TEST( imagePacket.size == ( ( _packetSize + 7 ) & ~uint64_t( 7 )));
+        TEST( batch.getSize() == imagePacket.size );
+    }
+
+    packet.size = _packetSize + writer.getSize();
+    std::vector< uint8_t > buffer( packet.size );
+    ::memcpy( &buffer.front(), &packet, _packetSize );
+    writer.copy( &buffer[ _packetSize ] );
+
+    eq::FrameData receiver;
+    eq::Images images;
+    receiver.addImages( reinterpret_cast< eq::NodeFrameDataTransmitPacket* >(
+                            &buffer.front( )), images );
+    TESTINFO( images.size() == nImages, images.size( ));
+
+    for( size_t i = 0; i < images.size(); ++i )
+    {
+        eq::Image* image = images[i];
+        eq::NodeFrameDataDecompressPacket times;
+        receiver.decompressImage( image, times );
+
+        const eq::PixelData& data =
+            image->getPixelData( eq::Frame::BUFFER_COLOR );
+        TESTINFO( data.pvp == pvps[i], data.pvp << " != " << pvps[i] );
+        TESTINFO( ::memcmp( data.pixels, &pixels[i].front(),
+                            pixels[i].size( )) == 0, "image " << i );
+    }
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the size classes, reuse and trimming of the pixel buffer pool.
+
+#include <test.h>
+
+#include <eq/client/pixelBufferPool.h> // private header
+
+using eq::detail::PixelBuffer;
+using eq::detail::PixelBufferPool;
+
+int main( int argc, char **argv )
+{
+    // size classes are at most 25% larger than requested and stable
+    uint64_t last = 0;
+    for( uint64_t size = 1; size < 256 * 1024 * 1024; size += size / 7 + 1 )
+    {
+        const uint64_t capacity = PixelBufferPool::getCapacity( size );
+        TESTINFO( capacity >= size, size );
+        TESTINFO( capacity <= LB_MAX( 4096ull, size + size / 4 ), size );
+        TESTINFO( PixelBufferPool::getCapacity( capacity ) == capacity, size );
+        TEST( capacity >= last );
+        last = capacity;
+    }
+
+    PixelBufferPool& pool = PixelBufferPool::getInstance();
+    pool.trim();
+    const uint64_t hd = 1920 * 1080 * 4;
+    {
+        PixelBuffer buffer;
+        uint8_t* data = buffer.resize( hd );
+        TEST( data );
+        TEST( buffer.getSize() == hd );
+        TEST( buffer.getMaxSize() >= hd );
+        data[ 42 ] = 17;
+
+        // smaller viewports of the same size class keep the memory
+        TEST( buffer.resize( hd - 4096 ) == data );
+        TEST( buffer.resize( hd ) == data );
+
+        // growing retains the content
+        TEST( buffer.resize( 2 * hd )[ 42 ] == 17 );
+        TEST( pool.getStats().used >= 2 * hd );
+    }
+
+    // released memory is reused
+    PixelBufferPool::Stats stats = pool.getStats();
+    TEST( stats.cached >= 2 * hd );
+    {
+        PixelBuffer buffer;
+        buffer.resize( 2 * hd );
+    }
+    TEST( pool.getStats().hits == stats.hits + 1 );
+
+    // memory above the high-water mark is released after the trim window
+    for( size_t i = 0; i < 64; ++i )
+        stats = pool.trim();
+    TEST( stats.cached == 0 );
+    TEST( stats.used == 0 );
+    TEST( stats.highWater == 0 );
+    return EXIT_SUCCESS;
+}
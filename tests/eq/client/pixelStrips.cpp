@@ -0,0 +1,147 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that strip-compressed images are sent strip by strip in the ordinary
+// image wire format and are restored by the receiver.
+
+#include <test.h>
+
+#include <eq/client/frameData.h>
+#include <eq/client/image.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/nodePackets.h>     // private header
+#include <eq/client/pixelData.h>
+#include <eq/client/pixelDataWriter.h> // private header
+#include <eq/client/pixelStrips.h>     // private header
+#include <co/plugins/compressor.h>
+
+#include <cstring>
+
+namespace
+{
+static const eq::PixelViewport _pvp( 0, 0, 1023, 767 );
+static const eq::Frame::Buffer _buffer = eq::Frame::BUFFER_COLOR;
+static const uint32_t _name = EQ_COMPRESSOR_RLE_4_BYTE;
+
+/** Send rows [y, y + h) as a separate image. @return the received image. */
+eq::Image* _transmit( eq::FrameData& receiver, const eq::PixelData& data,
+                      const int32_t y, const int32_t h )
+{
+    eq::NodeFrameDataTransmitPacket packet;
+    packet.frameData.version = eq::uint128_t( 0, 1 );
+    packet.pvp = eq::PixelViewport( _pvp.x, _pvp.y + y, _pvp.w, h );
+    packet.imageIndex = 0;
+    packet.buffers = _buffer;
+
+    eq::detail::PixelDataWriter writer;
+    writer.add( data, 1.f, y, h );
+
+    const uint64_t packetSize = sizeof( packet ) - 8 * sizeof( uint8_t );
+    std::vector< uint8_t > buffer( packetSize + writer.getSize( ));
+    ::memcpy( &buffer.front(), &packet, packetSize );
+    writer.copy( &buffer[ packetSize ] );
+
+    // the strip is an ordinary image buffer on the wire
+    const eq::FrameData::ImageHeader* header =
+        reinterpret_cast< const eq::FrameData::ImageHeader* >(
+            &buffer[ packetSize ] );
+    TEST( !( header->compressorFlags & eq::detail::STRIP_COMPRESSED ));
+    TESTINFO( header->compressorName == _name,
+              std::hex << header->compressorName );
+    TESTINFO( header->pvp.h == h, header->pvp );
+
+    eq::Image* received = receiver.addImage(
+        reinterpret_cast< eq::NodeFrameDataTransmitPacket* >(
+            &buffer.front( )));
+    eq::NodeFrameDataDecompressPacket times;
+    receiver.decompressImage( received, times );
+    return received;
+}
+
+bool _equals( const eq::Image* image, const std::vector< uint8_t >& pixels,
+              const int32_t y, const int32_t h )
+{
+    if( !image->hasPixelData( _buffer ))
+        return false;
+    const eq::PixelData& data = image->getPixelData( _buffer );
+    const size_t rowSize = _pvp.w * 4;
+    return data.pvp.h == h &&
+           ::memcmp( data.pixels, &pixels[ y * rowSize ], h * rowSize ) == 0;
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+    {
+        std::vector< uint8_t > pixels( _pvp.getArea() * 4 );
+        for( size_t i = 0; i < pixels.size(); ++i )
+            pixels[i] = uint8_t(( i / 64 ) * 7 );
+
+        eq::PixelData data;
+        data.internalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        data.externalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        data.pixelSize = 4;
+        data.pvp = _pvp;
+        data.pixels = &pixels.front();
+
+        eq::Image image;
+        image.setPixelViewport( _pvp );
+        image.setPixelData( _buffer, data );
+
+        // the default compression is never strip-compressed
+        const eq::PixelData& whole = image.compressPixelData( _buffer, _name );
+        TEST( whole.isCompressed );
+        TEST( !( whole.compressorFlags & eq::detail::STRIP_COMPRESSED ));
+
+        const eq::PixelData& strips = image.compressPixelData( _buffer, _name,
+                                                               4 );
+        TEST( strips.isCompressed );
+        TEST( strips.compressorFlags & eq::detail::STRIP_COMPRESSED );
+
+        std::vector< const eq::PixelData* > datas( 1, &strips );
+        std::vector< int32_t > rows;
+        TEST( eq::detail::PixelDataWriter::getStripRows( datas, 1024, rows ));
+        TESTINFO( rows.size() == 5, rows.size( ));
+        TESTINFO( rows.back() == _pvp.h, rows.back( ));
+
+        // each strip is received as a separate image with the original rows
+        eq::FrameData receiver;
+        for( size_t i = 0; i + 1 < rows.size(); ++i )
+        {
+            const int32_t h = rows[ i + 1 ] - rows[i];
+            const eq::Image* received = _transmit( receiver, strips, rows[i],
+                                                   h );
+            TESTINFO( _equals( received, pixels, rows[i], h ),
+                      "strip " << i << " at row " << rows[i] );
+        }
+
+        // the strip-compressed data is also restored locally
+        eq::Image restored;
+        restored.setPixelViewport( _pvp );
+        restored.setPixelData( _buffer, strips );
+        TEST( _equals( &restored, pixels, 0, _pvp.h ));
+
+        // back to a single strip
+        const eq::PixelData& single = image.compressPixelData( _buffer, _name,
+                                                               1 );
+        TEST( !( single.compressorFlags & eq::detail::STRIP_COMPRESSED ));
+    }
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
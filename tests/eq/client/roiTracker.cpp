@@ -0,0 +1,107 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the regions of interest of the last frame are reused while the
+// content moves within the motion margin, and searched again when the content
+// crosses the margin or after 16 reused frames.
+
+#include <test.h>
+#include <testImage.h>
+
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/roiFinder.h> // private header
+
+namespace
+{
+// 32x32 blocks of 16 pixels, the margin adds two blocks on each side
+static const eq::PixelViewport _pvp( 0, 0, 512, 512 );
+static const int32_t _size = 64;
+static const int32_t _margin = 32;
+static const uint32_t _maxPredictions = 16;
+
+/** Find the regions of a depth image with a square at the given position. */
+eq::PixelViewports _findRegions( eq::ROIFinder& finder, const int32_t x,
+                                 const int32_t y, const uint32_t frame )
+{
+    Pixels pixels( _pvp.getArea(), 0xffffffffu );
+    for( int32_t i = y; i < y + _size; ++i )
+        for( int32_t j = x; j < x + _size; ++j )
+            pixels[ i * _pvp.w + j ] = 0x40000000u;
+
+    eq::Image image;
+    image.setPixelViewport( _pvp );
+    image.setPixelData( eq::Frame::BUFFER_DEPTH,
+                        newPixelData( eq::Frame::BUFFER_DEPTH, _pvp, pixels ));
+    return finder.findRegions( image, 0, eq::uint128_t( 0, frame ));
+}
+
+/** @return true if the regions are the square, i.e., it was searched. */
+bool _isSearched( const eq::PixelViewports& regions, const int32_t x,
+                  const int32_t y )
+{
+    return regions.size() == 1 &&
+           regions.front() == eq::PixelViewport( x, y, _size, _size );
+}
+
+/** @return true if the regions are the last search dilated by the margin. */
+bool _isPredicted( const eq::PixelViewports& regions, const int32_t x,
+                   const int32_t y )
+{
+    return regions.size() == 1 &&
+           regions.front() == eq::PixelViewport( x - _margin, y - _margin,
+                                                 _size + 2 * _margin,
+                                                 _size + 2 * _margin );
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    eq::ROIFinder finder;
+    uint32_t frame = 0;
+
+    // the first frame is searched
+    eq::PixelViewports regions = _findRegions( finder, 192, 192, ++frame );
+    TESTINFO( _isSearched( regions, 192, 192 ), regions.front( ));
+
+    // content moving inside the margin reuses the regions of the last search
+    regions = _findRegions( finder, 208, 192, ++frame );
+    TESTINFO( _isPredicted( regions, 192, 192 ), regions.front( ));
+
+    // content reaching the edge blocks of the margin is searched again
+    regions = _findRegions( finder, 240, 192, ++frame );
+    TESTINFO( _isSearched( regions, 240, 192 ), regions.front( ));
+
+    // the regions of one search are reused for at most 16 frames ...
+    for( uint32_t i = 0; i < _maxPredictions; ++i )
+    {
+        regions = _findRegions( finder, 240, 192, ++frame );
+        TESTINFO( _isPredicted( regions, 240, 192 ),
+                  "frame " << frame << ": " << regions.front( ));
+    }
+
+    // ... even if the content does not move
+    regions = _findRegions( finder, 240, 192, ++frame );
+    TESTINFO( _isSearched( regions, 240, 192 ), regions.front( ));
+    regions = _findRegions( finder, 240, 192, ++frame );
+    TESTINFO( _isPredicted( regions, 240, 192 ), regions.front( ));
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
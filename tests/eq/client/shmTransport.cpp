@@ -0,0 +1,109 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that images use shared memory only after the destination acknowledged
+// the handshake token, and that a full ring falls back to the connection.
+
+#include <test.h>
+
+#include <eq/client/shmTransport.h> // private header
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+static const uint64_t _size = 1024 * 1024;
+static const uint32_t _maxSlots = 64;
+}
+
+int main( int argc, char **argv )
+{
+    eq::detail::ShmTransport& shm = eq::detail::ShmTransport::getInstance();
+    const eq::uint128_t local( 0, 1 );
+    const eq::uint128_t remote( 0, 2 );
+    const eq::uint128_t unacknowledged( 0, 3 );
+    eq::uint128_t ring;
+    uint32_t slot = 0;
+
+    // no shared memory before the handshake
+    eq::uint128_t token;
+    TEST( !shm.acquire( local, _size, ring, slot ));
+    TEST( shm.probe( local, token ));
+    TEST( !shm.probe( local, token ));
+    TEST( !shm.acquire( local, _size, ring, slot ));
+
+    // the destination maps and acknowledges the token
+    TEST( shm.acknowledge( token ));
+    shm.setAcknowledged( local, token, true );
+    TEST( !shm.probe( local, token ));
+
+    // the ring hands out its slots until it is full
+    std::vector< uint32_t > slots;
+    std::vector< eq::uint128_t > rings;
+    uint8_t* data = shm.acquire( local, _size, ring, slot );
+    TEST( data );
+    while( data && slots.size() < _maxSlots )
+    {
+        ::memset( data, int( slots.size( )), _size );
+        slots.push_back( slot );
+        rings.push_back( ring );
+        data = shm.acquire( local, _size, ring, slot );
+    }
+    TESTINFO( !data, slots.size( ));
+    TEST( slots.size() > 1 );
+
+    // the receiver reads the data written by the sender
+    for( size_t i = 0; i < slots.size(); ++i )
+    {
+        TEST( rings[i] == rings.front( ));
+        const uint8_t* received = shm.getData( rings[i], slots[i] );
+        TEST( received );
+        TESTINFO( received[0] == uint8_t( i ) &&
+                  received[ _size - 1 ] == uint8_t( i ), "slot " << i );
+    }
+
+    // released and canceled slots are reused
+    shm.release( rings.front(), slots.front( ));
+    TEST( shm.acquire( local, _size, ring, slot ));
+    TEST( slot == slots.front( ));
+    shm.cancel( local, slot );
+    TEST( shm.acquire( local, _size, ring, slot ));
+    TEST( slot == slots.front( ));
+
+    // the slots are sized for the first data with some headroom, larger
+    // data uses the connection
+    for( size_t i = 0; i < slots.size(); ++i )
+        shm.release( rings[i], slots[i] );
+    TEST( shm.acquire( local, _size + _size / 8, ring, slot ));
+    shm.cancel( local, slot );
+    TEST( !shm.acquire( local, 1024 * _size, ring, slot ));
+
+    // a destination which can't map the token uses the connection
+    TEST( shm.probe( remote, token ));
+    TEST( !shm.acknowledge( eq::uint128_t( 42, 42 )));
+    shm.setAcknowledged( remote, token, false );
+    TEST( !shm.acquire( remote, _size, ring, slot ));
+    TEST( !shm.probe( remote, token ));
+
+    // ... as does a destination claiming success without writing the token
+    TEST( shm.probe( unacknowledged, token ));
+    shm.setAcknowledged( unacknowledged, token, true );
+    TEST( !shm.acquire( unacknowledged, _size, ring, slot ));
+
+    shm.unlink();
+    return EXIT_SUCCESS;
+}
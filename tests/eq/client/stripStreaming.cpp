@@ -0,0 +1,195 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that an image streamed in strips assembles to the same result as the
+// image sent as a whole, and that the frame data becomes ready only after the
+// last strip is decoded.
+
+#include <test.h>
+#include <testImage.h>
+
+#include <eq/client/compositor.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/nodePackets.h>     // private header
+#include <eq/client/pixelDataWriter.h> // private header
+
+#include <cstring>
+
+namespace
+{
+typedef std::vector< uint8_t > Buffer;
+
+static const eq::PixelViewport _pvp( 0, 0, 1023, 1025 );
+static const uint32_t _buffers = eq::Frame::BUFFER_COLOR |
+                                 eq::Frame::BUFFER_DEPTH;
+static const uint32_t _name = EQ_COMPRESSOR_RLE_4_BYTE;
+static const uint32_t _nStrips = 4;
+
+/** Receive the rows [y, y + h) of the given buffers as one image. */
+eq::Image* _receive( eq::FrameData& receiver,
+                     const std::vector< const eq::PixelData* >& datas,
+                     const int32_t y, const int32_t h, Buffer& buffer )
+{
+    eq::NodeFrameDataTransmitPacket packet;
+    packet.frameData.version = eq::uint128_t( 0, 1 );
+    packet.pvp = eq::PixelViewport( _pvp.x, _pvp.y + y, _pvp.w, h );
+    packet.imageIndex = 0;
+    packet.buffers = _buffers;
+
+    eq::detail::PixelDataWriter writer;
+    for( size_t i = 0; i < datas.size(); ++i )
+    {
+        if( h == _pvp.h )
+            writer.add( *datas[i], 1.f );
+        else
+            writer.add( *datas[i], 1.f, y, h );
+    }
+
+    // uncompressed received data is referenced by the image
+    const uint64_t packetSize = sizeof( packet ) - 8 * sizeof( uint8_t );
+    buffer.resize( packetSize + writer.getSize( ));
+    ::memcpy( &buffer.front(), &packet, packetSize );
+    writer.copy( &buffer[ packetSize ] );
+
+    return receiver.addImage(
+        reinterpret_cast< eq::NodeFrameDataTransmitPacket* >(
+            &buffer.front( )));
+}
+
+void _setReady( eq::FrameDataPtr frameData )
+{
+    eq::NodeFrameDataReadyPacket packet( frameData );
+    // the version committed by the sending node
+    const_cast< co::ObjectVersion& >( packet.frameData ).version =
+        eq::uint128_t( 0, 1 );
+    frameData->setReady( &packet );
+}
+
+/** Merge the frame data and copy the result. */
+void _merge( eq::FrameDataPtr frameData, Pixels& color, Pixels& depth )
+{
+    eq::Frame frame;
+    frame.setFrameData( frameData );
+    const eq::Frames frames( 1, &frame );
+    const eq::Image* result = eq::Compositor::mergeFramesCPU( frames );
+    TEST( result );
+    TESTINFO( result->getPixelViewport() == _pvp, result->getPixelViewport( ));
+
+    const uint32_t* pixels = reinterpret_cast< const uint32_t* >(
+        result->getPixelPointer( eq::Frame::BUFFER_COLOR ));
+    color.assign( pixels, pixels + _pvp.getArea( ));
+    pixels = reinterpret_cast< const uint32_t* >(
+        result->getPixelPointer( eq::Frame::BUFFER_DEPTH ));
+    depth.assign( pixels, pixels + _pvp.getArea( ));
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    Pixels color( _pvp.getArea( ));
+    Pixels depth( _pvp.getArea( ));
+    fillPixels( color, 1, 0xffffffffu, 7 ); // compressible
+    fillPixels( depth, 2, 0x3ffu, 7 );
+
+    const eq::PixelData colorData = newPixelData( eq::Frame::BUFFER_COLOR,
+                                                  _pvp, color );
+    const eq::PixelData depthData = newPixelData( eq::Frame::BUFFER_DEPTH,
+                                                  _pvp, depth );
+
+    eq::Image source;
+    source.setPixelViewport( _pvp );
+    source.setPixelData( eq::Frame::BUFFER_COLOR, colorData );
+
+    std::vector< Buffer > buffers( _nStrips + 1 );
+    Pixels wholeColor, wholeDepth, stripColor, stripDepth;
+
+    // the image sent as a whole
+    eq::FrameDataPtr whole = new eq::FrameData;
+    whole->setBuffers( _buffers );
+    whole->setVersion( 1 );
+    {
+        std::vector< const eq::PixelData* > datas;
+        datas.push_back( &source.compressPixelData( eq::Frame::BUFFER_COLOR,
+                                                    _name ));
+        datas.push_back( &depthData );
+
+        eq::Image* image = _receive( *whole, datas, 0, _pvp.h,
+                                     buffers.back( ));
+        eq::NodeFrameDataDecompressPacket times;
+        whole->decompressImage( image, times );
+        _setReady( whole );
+        TEST( whole->isReady( ));
+        TEST( whole->getImages().size() == 1 );
+    }
+    _merge( whole, wholeColor, wholeDepth );
+    TEST( wholeColor == color );
+    TEST( wholeDepth == depth );
+
+    // the image streamed in strips, the depth is split along the color strips
+    eq::FrameDataPtr streamed = new eq::FrameData;
+    streamed->setBuffers( _buffers );
+    streamed->setVersion( 1 );
+    {
+        std::vector< const eq::PixelData* > datas;
+        datas.push_back( &source.compressPixelData( eq::Frame::BUFFER_COLOR,
+                                                    _name, _nStrips ));
+        datas.push_back( &depthData );
+
+        std::vector< int32_t > rows;
+        TEST( eq::detail::PixelDataWriter::getStripRows( datas, 1024 * 1024,
+                                                         rows ));
+        TESTINFO( rows.size() == _nStrips + 1, rows.size( ));
+
+        eq::Images images;
+        for( size_t i = 0; i + 1 < rows.size(); ++i )
+            images.push_back( _receive( *streamed, datas, rows[i],
+                                        rows[ i + 1 ] - rows[i],
+                                        buffers[i] ));
+
+        // the first strips are decoded before the frame data is ready
+        const size_t nEarly = images.size() / 2;
+        eq::NodeFrameDataDecompressPacket times;
+        for( size_t i = 0; i < nEarly; ++i )
+            streamed->decompressImage( images[i], times );
+
+        eq::Images decoded;
+        streamed->getDecodedImages( decoded );
+        TESTINFO( decoded.size() == nEarly, decoded.size( ));
+
+        // ... and the ready packet waits for the remaining strips
+        _setReady( streamed );
+        for( size_t i = nEarly; i < images.size(); ++i )
+        {
+            TEST( !streamed->isReady( ));
+            streamed->decompressImage( images[i], times );
+        }
+        TEST( streamed->isReady( ));
+        TESTINFO( streamed->getImages().size() == _nStrips,
+                  streamed->getImages().size( ));
+    }
+    _merge( streamed, stripColor, stripDepth );
+    TEST( stripColor == wholeColor );
+    TEST( stripDepth == wholeDepth );
+
+    whole->flush();
+    streamed->flush();
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Benchmarks sending image data over a loopback connection, with one send per
+// header, chunk size table and chunk, and gathered by the PixelDataWriter.
+// Reports the number of sends and the throughput for different chunk counts
+// and sizes, and checks that both variants send the same stream.
+//
+// Usage: eq_client_transmitBenchmark [--full]
+
+#define EQ_TEST_RUNTIME 600 // seconds
+#include <test.h>
+
+#include <eq/client/frameData.h>
+#include <eq/client/pixelData.h>
+#include <eq/client/pixelDataWriter.h> // private header
+
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/init.h>
+#include <co/plugins/compressor.h>
+#include <lunchbox/clock.h>
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+static const uint64_t _headerSize = 64; // stand-in for the transmit packet
+
+/** Synthetic compressed image buffer with separately allocated chunks. */
+class Buffer
+{
+public:
+    Buffer( const uint32_t nChunks, const uint64_t chunkSize )
+    {
+        data.internalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        data.externalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        data.pixelSize = 4;
+        data.pvp = eq::PixelViewport( 0, 0, 1920, 1200 );
+        data.compressorName = EQ_COMPRESSOR_RLE_4_BYTE;
+        data.compressorFlags = 0;
+        data.isCompressed = true;
+
+        chunks.resize( nChunks );
+        for( uint32_t i = 0; i < nChunks; ++i )
+        {
+            // vary sizes so that adjacent chunks are rarely contiguous
+            chunks[i].resize( chunkSize + i * 8, uint8_t( i ));
+            data.compressedData.push_back( &chunks[i].front( ));
+            data.compressedSize.push_back( chunks[i].size( ));
+        }
+    }
+
+    eq::PixelData data;
+    std::vector< std::vector< uint8_t > > chunks;
+};
+
+/** Receives a given number of messages of a given size. */
+class Receiver : public lunchbox::Thread
+{
+public:
+    Receiver( co::ConnectionPtr connection, const uint64_t size,
+              const size_t nMessages )
+        : _connection( connection ), _buffer( size ), _nMessages( nMessages )
+    {}
+
+    virtual void run()
+    {
+        for( size_t i = 0; i < _nMessages; ++i )
+        {
+            _connection->recvNB( &_buffer.front(), _buffer.size( ));
+            TEST( _connection->recvSync( 0, 0 ));
+        }
+    }
+
+    const std::vector< uint8_t >& getLastMessage() const { return _buffer; }
+
+private:
+    co::ConnectionPtr _connection;
+    std::vector< uint8_t > _buffer;
+    const size_t _nMessages;
+};
+
+/**
+ * Send with one send per header, chunk size table and chunk, in the wire
+ * format of PixelDataWriter. @return the number of sends
+ */
+size_t _sendSeparate( co::ConnectionPtr connection, const uint8_t* header,
+                      const std::vector< Buffer* >& buffers )
+{
+    size_t nSends = 1;
+    connection->send( header, _headerSize, true );
+    for( size_t i = 0; i < buffers.size(); ++i )
+    {
+        const eq::PixelData& data = buffers[i]->data;
+        const eq::FrameData::ImageHeader imageHeader =
+            { data.internalFormat, data.externalFormat, data.pixelSize,
+              data.pvp, data.compressorName, data.compressorFlags,
+              uint32_t( data.compressedSize.size( )), 1.f };
+        connection->send( &imageHeader, sizeof( imageHeader ), true );
+        ++nSends;
+
+        connection->send( &data.compressedSize.front(),
+                          data.compressedSize.size() * sizeof( uint64_t ),
+                          true );
+        ++nSends;
+
+        for( size_t j = 0; j < data.compressedSize.size(); ++j )
+        {
+            connection->send( data.compressedData[j], data.compressedSize[j],
+                              true );
+            ++nSends;
+        }
+    }
+    return nSends;
+}
+
+struct Result
+{
+    size_t nSends;
+    float throughput; // MB/s
+};
+
+Result _run( co::ConnectionPtr sender, co::ConnectionPtr reader,
+             const std::vector< Buffer* >& buffers, const bool gather,
+             const size_t nMessages )
+{
+    eq::detail::PixelDataWriter writer;
+    for( size_t i = 0; i < buffers.size(); ++i )
+        writer.add( buffers[i]->data, 1.f );
+
+    std::vector< uint8_t > header( _headerSize, 0xab );
+    const uint64_t size = _headerSize + writer.getSize();
+    Receiver receiver( reader, size, nMessages );
+    TEST( receiver.start( ));
+
+    Result result = { 0, 0.f };
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < nMessages; ++i )
+    {
+        sender->lockSend();
+        if( gather )
+        {
+            TEST( writer.send( sender, &header.front(), _headerSize ));
+            result.nSends = writer.getNItems();
+        }
+        else
+            result.nSends = _sendSeparate( sender, &header.front(), buffers );
+        sender->unlockSend();
+    }
+    TEST( receiver.join( ));
+    const float time = clock.getTimef();
+    result.throughput = float( size * nMessages ) / 1024.f / 1024.f /
+                        time * 1000.f;
+
+    // both send variants produce the same stream
+    std::vector< uint8_t > expected( size );
+    ::memcpy( &expected.front(), &header.front(), _headerSize );
+    writer.copy( &expected[ _headerSize ] );
+    TEST( receiver.getLastMessage() == expected );
+    return result;
+}
+}
+
+int main( int argc, char **argv )
+{
+    const bool full = argc > 1 && ::strcmp( argv[1], "--full" ) == 0;
+    TEST( co::init( argc, argv ));
+
+    co::ConnectionDescriptionPtr description = new co::ConnectionDescription;
+    description->type = co::CONNECTIONTYPE_TCPIP;
+    description->setHostname( "127.0.0.1" );
+    description->port = 0; // listen() chooses a free port
+
+    co::ConnectionPtr listener = co::Connection::create( description );
+    TEST( listener->listen( ));
+    listener->acceptNB();
+
+    co::ConnectionPtr sender = co::Connection::create( description );
+    TEST( sender->connect( ));
+    co::ConnectionPtr reader = listener->acceptSync();
+    TEST( reader );
+
+    const uint32_t chunkCounts[] = { 1, 4, 16, 64 };
+    const uint64_t chunkSizes[] = { 1024, 64 * 1024, 1024 * 1024 };
+    const size_t nMessages = full ? 200 : 10;
+
+    std::cout << " chunks  chunk size  sends separate  sends gathered"
+              << "  MB/s separate  MB/s gathered" << std::endl;
+    for( size_t i = 0; i < sizeof( chunkCounts ) / sizeof( uint32_t ); ++i )
+    {
+        for( size_t j = 0; j < sizeof( chunkSizes ) / sizeof( uint64_t ); ++j)
+        {
+            const uint32_t nChunks = chunkCounts[i];
+            const uint64_t chunkSize = chunkSizes[j];
+            if( !full && nChunks * chunkSize > 16 * 1024 * 1024 )
+                continue;
+
+            // color and depth buffer
+            Buffer color( nChunks, chunkSize );
+            Buffer depth( nChunks, chunkSize );
+            std::vector< Buffer* > buffers;
+            buffers.push_back( &color );
+            buffers.push_back( &depth );
+
+            const Result separate = _run( sender, reader, buffers, false,
+                                          nMessages );
+            const Result gathered = _run( sender, reader, buffers, true,
+                                          nMessages );
+            TEST( gathered.nSends <= separate.nSends );
+
+            std::cout << std::setw( 7 ) << nChunks << std::setw( 12 )
+                      << chunkSize << std::setw( 16 ) << separate.nSends
+                      << std::setw( 16 ) << gathered.nSends << std::setw( 15 )
+                      << std::fixed << std::setprecision( 1 )
+                      << separate.throughput << std::setw( 15 )
+                      << gathered.throughput << std::endl;
+        }
+    }
+
+    sender->close();
+    reader->close();
+    listener->close();
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the decompression speeds reported by a destination node only
+// change the compressor choice for that destination.
+
+#include <test.h>
+
+#include <eq/client/transmitCostModel.h> // private header
+#include <co/compressorInfo.h>           // private header
+#include <co/plugins/compressor.h>
+
+namespace
+{
+static const uint32_t _fast = EQ_COMPRESSOR_RLE_4_BYTE;
+static const uint32_t _small = EQ_COMPRESSOR_RLE_DIFF_BGRA;
+static const uint64_t _size = 1024 * 1024;
+
+static co::CompressorInfo _newInfo( const uint32_t name, const float ratio )
+{
+    co::CompressorInfo info;
+    info.name = name;
+    info.speed = 1.f;
+    info.ratio = ratio;
+    return info;
+}
+}
+
+int main( int argc, char **argv )
+{
+    co::CompressorInfos infos;
+    infos.push_back( _newInfo( _fast, .6f ));
+    infos.push_back( _newInfo( _small, .5f ));
+
+    eq::detail::TransmitCostModel& model =
+        eq::detail::TransmitCostModel::getInstance();
+    const eq::uint128_t slowNode( 0, 1 );
+    const eq::uint128_t fastNode( 0, 2 );
+
+    // same speeds, the better ratio wins for both nodes
+    TEST( model.choose( slowNode, 0, infos, _size ) == _small );
+    TEST( model.choose( fastNode, 0, infos, _size ) == _small );
+
+    // slow decompression on one node moves it to the other compressor
+    model.addDecompress( slowNode, _small, _size, 20.f );
+    TEST( model.choose( slowNode, 0, infos, _size ) == _fast );
+    TEST( model.choose( fastNode, 0, infos, _size ) == _small );
+
+    // unused buffers are ignored
+    model.addDecompress( fastNode, EQ_COMPRESSOR_NONE, _size, 100.f );
+    model.addDecompress( fastNode, _small, 0, 0.f );
+    TEST( model.choose( fastNode, 0, infos, _size ) == _small );
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the images queued to one destination are ordered by frame and
+// priority, and never move past the set ready of a frame.
+
+#include <test.h>
+
+#include <eq/client/transmitQueue.h> // private header
+
+using eq::detail::TransmitQueue;
+
+namespace
+{
+TransmitQueue::Entry _newImage( const uint32_t frameNumber,
+                                const uint32_t priority )
+{
+    TransmitQueue::Entry entry;
+    entry.frameNumber = frameNumber;
+    entry.priority = priority;
+    entry.isImage = true;
+    return entry;
+}
+
+TransmitQueue::Entry _newReady( const uint32_t frameNumber )
+{
+    TransmitQueue::Entry entry;
+    entry.frameNumber = frameNumber;
+    return entry;
+}
+
+bool _isImage( const TransmitQueue::Entry& entry, const uint32_t frameNumber,
+               const uint32_t priority )
+{
+    return entry.isImage && entry.frameNumber == frameNumber &&
+           entry.priority == priority;
+}
+}
+
+int main( int argc, char **argv )
+{
+    // images of one frame are ordered by priority, equal ones stay in order
+    TransmitQueue::Entries entries;
+    TransmitQueue::insert( entries, _newImage( 1, 3 ));
+    TransmitQueue::insert( entries, _newImage( 1, 1 ));
+    TransmitQueue::insert( entries, _newImage( 1, 2 ));
+    TransmitQueue::insert( entries, _newImage( 1, 1 ));
+    TEST( entries.size() == 4 );
+    TEST( _isImage( entries[0], 1, 1 ));
+    TEST( _isImage( entries[1], 1, 1 ));
+    TEST( _isImage( entries[2], 1, 2 ));
+    TEST( _isImage( entries[3], 1, 3 ));
+
+    // earlier frames are sent first, regardless of their priority
+    entries.clear();
+    TransmitQueue::insert( entries, _newImage( 2, 0 ));
+    TransmitQueue::insert( entries, _newImage( 1, 5 ));
+    TransmitQueue::insert( entries, _newImage( 2, 1 ));
+    TEST( _isImage( entries[0], 1, 5 ));
+    TEST( _isImage( entries[1], 2, 0 ));
+    TEST( _isImage( entries[2], 2, 1 ));
+
+    // images never move past a set ready
+    entries.clear();
+    TransmitQueue::insert( entries, _newImage( 1, 2 ));
+    TransmitQueue::insert( entries, _newReady( 1 ));
+    TransmitQueue::insert( entries, _newImage( 2, 3 ));
+    TransmitQueue::insert( entries, _newImage( 1, 1 ));
+    TransmitQueue::insert( entries, _newImage( 2, 0 ));
+    TEST( entries.size() == 5 );
+    TEST( _isImage( entries[0], 1, 2 ));
+    TEST( !entries[1].isImage && entries[1].frameNumber == 1 );
+    TEST( _isImage( entries[2], 1, 1 ));
+    TEST( _isImage( entries[3], 2, 0 ));
+    TEST( _isImage( entries[4], 2, 3 ));
+
+    // a set ready is always queued last
+    TransmitQueue::insert( entries, _newReady( 2 ));
+    TEST( !entries.back().isImage && entries.back().frameNumber == 2 );
+
+    // images of two frames queued out of order around the set ready of the
+    // first frame
+    entries.clear();
+    TransmitQueue::insert( entries, _newImage( 1, 2 ));
+    TransmitQueue::insert( entries, _newImage( 1, 1 ));
+    TransmitQueue::insert( entries, _newImage( 2, 1 ));
+    TransmitQueue::insert( entries, _newImage( 1, 0 ));
+    TransmitQueue::insert( entries, _newReady( 1 ));
+    TransmitQueue::insert( entries, _newImage( 2, 2 ));
+    TransmitQueue::insert( entries, _newImage( 2, 0 ));
+    TransmitQueue::insert( entries, _newReady( 2 ));
+    TEST( entries.size() == 8 );
+    TEST( _isImage( entries[0], 1, 0 ));
+    TEST( _isImage( entries[1], 1, 1 ));
+    TEST( _isImage( entries[2], 1, 2 ));
+    TEST( _isImage( entries[3], 2, 1 ));
+    TEST( !entries[4].isImage && entries[4].frameNumber == 1 );
+    TEST( _isImage( entries[5], 2, 0 ));
+    TEST( _isImage( entries[6], 2, 2 ));
+    TEST( !entries[7].isImage && entries[7].frameNumber == 2 );
+
+    // frame numbers wrap around
+    entries.clear();
+    TransmitQueue::insert( entries, _newImage( 1, 0 ));
+    TransmitQueue::insert( entries, _newImage( 0xffffffffu, 7 ));
+    TEST( _isImage( entries[0], 0xffffffffu, 7 ));
+    TEST( _isImage( entries[1], 1, 0 ));
+
+    return EXIT_SUCCESS;
+}
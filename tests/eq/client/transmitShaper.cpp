@@ -0,0 +1,90 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the transmit shaper paces sends to the share of a sender, uses
+// the rate left unused by other senders and measures the receive rate.
+
+#include <test.h>
+
+#include <eq/client/transmitShaper.h> // private header
+#include <lunchbox/clock.h>
+#include <lunchbox/sleep.h>
+
+namespace
+{
+static const uint32_t _rate = 10240;      // KB/s
+static const uint64_t _size = 100 * 1024; // about 10 ms at _rate
+static const size_t _nSends = 20;
+
+/** @return the time in ms to send _nSends times _size bytes. */
+float _send( const eq::uint128_t& node, const uint32_t rate )
+{
+    eq::detail::TransmitShaper& shaper =
+        eq::detail::TransmitShaper::getInstance();
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < _nSends; ++i )
+        shaper.wait( node, rate, _size );
+    return clock.getTimef();
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::detail::TransmitShaper& shaper =
+        eq::detail::TransmitShaper::getInstance();
+
+    // the receive rate is measured
+    TEST( shaper.getSpareShare() == 0 );
+    shaper.setReceiveRate( 1024 );
+    TESTINFO( shaper.getSpareShare() == 1000, shaper.getSpareShare( ));
+    shaper.addReceived( 10 * 1024 * 1024 );
+    lunchbox::sleep( 150 );
+    TESTINFO( shaper.getSpareShare() == 0, shaper.getSpareShare( ));
+    lunchbox::sleep( 150 );
+    TESTINFO( shaper.getSpareShare() == 1000, shaper.getSpareShare( ));
+
+    // unlimited rates are not paced
+    const eq::uint128_t node( 0, 1 );
+    TEST( _send( node, 0 ) < 10.f );
+
+    // the sends are paced to the share of the sender
+    float time = _send( node, _rate );
+    TESTINFO( time > 160.f && time < 400.f, time );
+
+    // the unused rate of the other senders is used
+    lunchbox::sleep( 100 );
+    shaper.setSpareShare( node, 1000 );
+    time = _send( node, _rate );
+    TESTINFO( time > 75.f && time < 150.f, time );
+
+    // ... but at most all of it
+    lunchbox::sleep( 100 );
+    shaper.setSpareShare( node, 2000 );
+    time = _send( node, _rate );
+    TESTINFO( time > 75.f && time < 150.f, time );
+
+    // outdated reports are ignored
+    lunchbox::sleep( 600 );
+    time = _send( node, _rate );
+    TESTINFO( time > 160.f && time < 400.f, time );
+
+    // other destinations are not affected
+    shaper.setSpareShare( node, 1000 );
+    time = _send( eq::uint128_t( 0, 2 ), _rate );
+    TESTINFO( time > 160.f && time < 400.f, time );
+
+    return EXIT_SUCCESS;
+}
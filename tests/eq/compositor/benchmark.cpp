@@ -0,0 +1,447 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Benchmarks the CPU compositor with synthetic images. Sweeps the image size,
+// the number of inputs, the compositing operation, the overlap of the inputs
+// and the number of threads.
+//
+// Usage: eq_compositor_benchmark [--full] [--repeat n] [--csv file]
+//                                [--json file] [--baseline file]
+//                                [--threshold fraction]
+//
+// --full runs the complete sweep, the default is a short one suitable for a
+// unit test run. Results are written as CSV and/or JSON. A CSV file written
+// by a previous run can be given as baseline: cases slower than the baseline
+// by more than the threshold (default .1, i.e., 10%) fail the benchmark.
+
+#define EQ_TEST_RUNTIME 1200 // seconds
+#include <test.h>
+#include <testImage.h>
+
+#include <eq/client/compositor.h>
+#include <eq/client/compositorKernels.h> // private header
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/omp.h>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace
+{
+enum Operation
+{
+    OP_2D,    //!< color only, last input wins
+    OP_DB,    //!< color and depth, depth test
+    OP_BLEND, //!< color with alpha, blended in order
+    OP_ALL
+};
+
+enum Overlap
+{
+    OVERLAP_FULL,      //!< all inputs cover the destination (sort-last)
+    OVERLAP_TILES,     //!< inputs are disjoint stripes (sort-first)
+    OVERLAP_STAGGERED, //!< inputs partially overlap each other
+    OVERLAP_ALL
+};
+
+static const char* const _operationNames[] = { "2D", "DB", "blend" };
+static const char* const _overlapNames[] = { "full", "tiles", "staggered" };
+
+struct Case
+{
+    Operation operation;
+    Overlap overlap;
+    int32_t width;
+    int32_t height;
+    size_t nInputs;
+    unsigned nThreads;
+
+    /** @return the key identifying the case in the result files. */
+    std::string getKey() const
+    {
+        std::ostringstream os;
+        os << _operationNames[ operation ] << ',' << _overlapNames[ overlap ]
+           << ',' << width << ',' << height << ',' << nInputs << ','
+           << nThreads;
+        return os.str();
+    }
+};
+
+struct Result
+{
+    Case test;
+    float time;     //!< best time of all repetitions, in ms
+    float mPixels;  //!< input pixels merged per second, in millions
+};
+typedef std::vector< Result > Results;
+
+struct Options
+{
+    Options() : full( false ), repeat( 5 ), threshold( .1f ) {}
+
+    bool full;
+    size_t repeat;
+    float threshold;
+    std::string csv;
+    std::string json;
+    std::string baseline;
+};
+
+/** @return the area covered by the given input. */
+eq::PixelViewport _getPVP( const Case& test, const size_t input )
+{
+    const int32_t w = test.width;
+    const int32_t h = test.height;
+    const int32_t n = int32_t( test.nInputs );
+    const int32_t i = int32_t( input );
+
+    switch( test.overlap )
+    {
+      case OVERLAP_TILES:
+      {
+          const int32_t y = h * i / n;
+          return eq::PixelViewport( 0, y, w, h * ( i + 1 ) / n - y );
+      }
+
+      case OVERLAP_STAGGERED:
+      {
+          const int32_t x = n > 1 ? w / 4 * i / ( n - 1 ) : 0;
+          const int32_t y = n > 1 ? h / 4 * i / ( n - 1 ) : 0;
+          return eq::PixelViewport( x, y, w - w / 4, h - h / 4 );
+      }
+
+      case OVERLAP_FULL:
+      default:
+          return eq::PixelViewport( 0, 0, w, h );
+    }
+}
+
+/** Holds the frames of one case, one frame with one image per input. */
+class Inputs
+{
+public:
+    Inputs( const Case& test )
+    {
+        const bool depth = test.operation == OP_DB;
+        for( size_t i = 0; i < test.nInputs; ++i )
+        {
+            eq::FrameDataPtr frameData = new eq::FrameData;
+            frameData->setBuffers( depth ? eq::Frame::BUFFER_COLOR |
+                                           eq::Frame::BUFFER_DEPTH :
+                                           eq::Frame::BUFFER_COLOR );
+            _addImage( frameData.get(), _getPVP( test, i ), depth,
+                       test.operation == OP_BLEND, uint32_t( i ));
+
+            eq::Frame* frame = new eq::Frame;
+            frame->setFrameData( frameData );
+            _frameDatas.push_back( frameData );
+            _frames.push_back( frame );
+        }
+    }
+
+    ~Inputs()
+    {
+        for( size_t i = 0; i < _frames.size(); ++i )
+        {
+            _frameDatas[i]->flush();
+            delete _frames[i];
+        }
+    }
+
+    const eq::Frames& getFrames() const { return _frames; }
+
+private:
+    eq::Frames _frames;
+    std::vector< eq::FrameDataPtr > _frameDatas;
+
+    void _addImage( eq::FrameData* frameData, const eq::PixelViewport& pvp,
+                    const bool depth, const bool alpha, const uint32_t seed )
+    {
+        eq::Image* image = addImage( frameData, pvp );
+        Pixels pixels( pvp.getArea( ));
+
+        // translucent inputs for blending, opaque otherwise
+        fillPixels( pixels, seed * 2 + 1 );
+        if( !alpha )
+            for( size_t i = 0; i < pixels.size(); ++i )
+                pixels[i] |= 0xff000000u;
+        image->setPixelData( eq::Frame::BUFFER_COLOR,
+                             newPixelData( eq::Frame::BUFFER_COLOR, pvp,
+                                           pixels ));
+
+        if( !depth )
+            return;
+
+        // restricted range, each input wins some of the pixels
+        fillPixels( pixels, seed * 2 + 2, 0x00ffffffu );
+        image->setPixelData( eq::Frame::BUFFER_DEPTH,
+                             newPixelData( eq::Frame::BUFFER_DEPTH, pvp,
+                                           pixels ));
+    }
+};
+
+void _setNThreads( const unsigned nThreads )
+{
+#ifdef _OPENMP
+    omp_set_num_threads( int( nThreads ));
+#endif
+}
+
+/** @return the thread counts to test: 1, then doubling up to max. */
+std::vector< unsigned > _getThreadCounts( const Options& options )
+{
+    std::vector< unsigned > counts;
+#ifdef _OPENMP
+    const unsigned max = lunchbox::OMP::getNThreads();
+    if( options.full )
+    {
+        for( unsigned i = 1; i < max; i *= 2 )
+            counts.push_back( i );
+    }
+    else if( max > 1 )
+        counts.push_back( 1 );
+    counts.push_back( max );
+#else
+    counts.push_back( 1 );
+#endif
+    return counts;
+}
+
+Result _run( const Case& test, const Options& options )
+{
+    _setNThreads( test.nThreads );
+    const Inputs inputs( test );
+    const eq::Frames& frames = inputs.getFrames();
+    const bool blend = test.operation == OP_BLEND;
+
+    uint64_t nPixels = 0;
+    for( size_t i = 0; i < test.nInputs; ++i )
+        nPixels += _getPVP( test, i ).getArea();
+
+    // the first run allocates the destination and is not measured
+    TEST( eq::Compositor::mergeFramesCPU( frames, blend ));
+
+    Result result;
+    result.test = test;
+    result.time = std::numeric_limits< float >::max();
+    for( size_t i = 0; i < options.repeat; ++i )
+    {
+        lunchbox::Clock clock;
+        const eq::Image* image = eq::Compositor::mergeFramesCPU( frames,
+                                                                 blend );
+        result.time = LB_MIN( result.time, clock.getTimef( ));
+        TEST( image );
+    }
+
+    result.time = LB_MAX( result.time, std::numeric_limits< float >::min( ));
+    result.mPixels = float( nPixels ) / result.time / 1000.f;
+    return result;
+}
+
+Results _runAll( const Options& options )
+{
+    std::vector< eq::Vector2i > sizes;
+    std::vector< size_t > nInputs;
+    sizes.push_back( eq::Vector2i( 640, 480 ));
+    sizes.push_back( eq::Vector2i( 1920, 1080 ));
+    nInputs.push_back( 2 );
+    nInputs.push_back( 8 );
+    if( options.full )
+    {
+        sizes.push_back( eq::Vector2i( 1280, 720 ));
+        sizes.push_back( eq::Vector2i( 2560, 1600 ));
+        sizes.push_back( eq::Vector2i( 3840, 2160 ));
+        nInputs.push_back( 4 );
+        nInputs.push_back( 16 );
+    }
+    const std::vector< unsigned > nThreads = _getThreadCounts( options );
+
+    Results results;
+    Case test;
+    for( int op = OP_2D; op < OP_ALL; ++op )
+    for( int overlap = OVERLAP_FULL; overlap < OVERLAP_ALL; ++overlap )
+    for( size_t size = 0; size < sizes.size(); ++size )
+    for( size_t inputs = 0; inputs < nInputs.size(); ++inputs )
+    for( size_t threads = 0; threads < nThreads.size(); ++threads )
+    {
+        test.operation = Operation( op );
+        test.overlap = Overlap( overlap );
+        test.width = sizes[ size ].x();
+        test.height = sizes[ size ].y();
+        test.nInputs = nInputs[ inputs ];
+        test.nThreads = nThreads[ threads ];
+
+        const Result result = _run( test, options );
+        std::cout << test.getKey() << ": " << result.time << " ms, "
+                  << result.mPixels << " MPixel/s" << std::endl;
+        results.push_back( result );
+    }
+
+    _setNThreads( lunchbox::OMP::getNThreads( ));
+    return results;
+}
+
+static const char* const _csvHeader =
+    "operation,overlap,width,height,inputs,threads,time,mpixels";
+
+void _writeCSV( const Results& results, const std::string& filename )
+{
+    std::ofstream file( filename.c_str( ));
+    TESTINFO( file.is_open(), "Can't open " << filename );
+
+    file << _csvHeader << std::endl;
+    for( size_t i = 0; i < results.size(); ++i )
+        file << results[i].test.getKey() << ',' << results[i].time << ','
+             << results[i].mPixels << std::endl;
+}
+
+void _writeJSON( const Results& results, const std::string& filename )
+{
+    std::ofstream file( filename.c_str( ));
+    TESTINFO( file.is_open(), "Can't open " << filename );
+
+    file << "{" << std::endl << "  \"simd\": \""
+         << eq::detail::getSIMDName( eq::detail::getSIMDLevel( )) << "\","
+         << std::endl << "  \"results\": [" << std::endl;
+    for( size_t i = 0; i < results.size(); ++i )
+    {
+        const Result& result = results[i];
+        const Case& test = result.test;
+        file << "    { \"operation\": \"" << _operationNames[ test.operation ]
+             << "\", \"overlap\": \"" << _overlapNames[ test.overlap ]
+             << "\", \"width\": " << test.width
+             << ", \"height\": " << test.height
+             << ", \"inputs\": " << test.nInputs
+             << ", \"threads\": " << test.nThreads
+             << ", \"time\": " << result.time
+             << ", \"mpixels\": " << result.mPixels << " }"
+             << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+    }
+    file << "  ]" << std::endl << "}" << std::endl;
+}
+
+/** @return the number of cases slower than the baseline plus threshold. */
+size_t _compare( const Results& results, const Options& options )
+{
+    std::ifstream file( options.baseline.c_str( ));
+    TESTINFO( file.is_open(), "Can't open " << options.baseline );
+
+    // key -> time, the key being the first six columns
+    std::map< std::string, float > baseline;
+    std::string line;
+    while( std::getline( file, line ))
+    {
+        const size_t pos = line.rfind( ',', line.rfind( ',' ) - 1 );
+        if( line == _csvHeader || pos == std::string::npos )
+            continue;
+        baseline[ line.substr( 0, pos ) ] =
+            float( ::atof( line.c_str() + pos + 1 ));
+    }
+
+    size_t nRegressions = 0;
+    size_t nCompared = 0;
+    for( size_t i = 0; i < results.size(); ++i )
+    {
+        const Result& result = results[i];
+        const std::string key = result.test.getKey();
+        std::map< std::string, float >::const_iterator j = baseline.find( key );
+        if( j == baseline.end( ))
+            continue;
+
+        ++nCompared;
+        const float limit = j->second * ( 1.f + options.threshold );
+        if( result.time <= limit )
+            continue;
+
+        ++nRegressions;
+        std::cout << "Regression " << key << ": " << result.time
+                  << " ms, baseline " << j->second << " ms (+"
+                  << int( 100.f * ( result.time / j->second - 1.f )) << "%)"
+                  << std::endl;
+    }
+
+    std::cout << nCompared << " of " << results.size()
+              << " cases compared with " << options.baseline << ", "
+              << nRegressions << " regressions above "
+              << int( 100.f * options.threshold ) << "%" << std::endl;
+    return nRegressions;
+}
+
+bool _parse( const int argc, char** argv, Options& options )
+{
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if( arg == "--full" )
+            options.full = true;
+        else if( arg == "--repeat" && hasValue )
+            options.repeat = LB_MAX( 1, ::atoi( argv[++i] ));
+        else if( arg == "--threshold" && hasValue )
+            options.threshold = float( ::atof( argv[++i] ));
+        else if( arg == "--csv" && hasValue )
+            options.csv = argv[++i];
+        else if( arg == "--json" && hasValue )
+            options.json = argv[++i];
+        else if( arg == "--baseline" && hasValue )
+            options.baseline = argv[++i];
+        else
+        {
+            std::cerr << "Unknown or incomplete argument " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+int main( int argc, char **argv )
+{
+    Options options;
+    TEST( _parse( argc, argv, options ));
+
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( 0, 0, &nodeFactory ));
+
+    std::cout << argv[0] << ": using "
+              << eq::detail::getSIMDName( eq::detail::getSIMDLevel( ))
+              << " compositing kernels" << std::endl;
+
+    const Results results = _runAll( options );
+    if( !options.csv.empty( ))
+        _writeCSV( results, options.csv );
+    if( !options.json.empty( ))
+        _writeJSON( results, options.json );
+
+    const size_t nRegressions = options.baseline.empty() ? 0 :
+                                _compare( results, options );
+
+    TEST( eq::exit( ));
+    TESTINFO( nRegressions == 0, nRegressions << " performance regressions" );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests all CPU compositing kernels against the scalar reference
+// implementation and reports their performance.
+
+#include <test.h>
+#include <testImage.h>
+
+#include <eq/client/compositorKernels.h> // private header
+#include <lunchbox/clock.h>
+
+using namespace eq::detail;
+
+namespace
+{
+static const size_t _nPixels = 1920 * 1080;
+
+void _testMergeDB( const SIMDLevel level, const MergeDBRowFunc func,
+                   const char* name )
+{
+    const MergeDBRowFunc reference = getMergeDBRow( SIMD_NONE );
+    Pixels color( _nPixels ), depth( _nPixels );
+    Pixels destColor( _nPixels ), destDepth( _nPixels );
+    fillPixels( color, 1 );
+    fillPixels( depth, 2 );
+    fillPixels( destColor, 3 );
+    fillPixels( destDepth, 4 );
+
+    // equal depths and the full unsigned range have to match too
+    for( size_t i = 0; i < _nPixels; i += 7 )
+        depth[i] = destDepth[i];
+    depth[0] = 0xffffffffu;
+    destDepth[1] = 0xffffffffu;
+
+    // odd row lengths and unaligned starts exercise the remainder handling
+    for( int32_t length = 0; length < 67; ++length )
+    {
+        for( int32_t start = 0; start < 3; ++start )
+        {
+            Pixels refColor = destColor, refDepth = destDepth;
+            Pixels outColor = destColor, outDepth = destDepth;
+
+            reference( &refColor[start], &refDepth[start],
+                       &color[start], &depth[start], length );
+            func( &outColor[start], &outDepth[start],
+                  &color[start], &depth[start], length );
+            TESTINFO( outColor == refColor && outDepth == refDepth,
+                      getSIMDName( level ) << " " << name << " " << length );
+        }
+    }
+
+    Pixels refColor = destColor, refDepth = destDepth;
+    Pixels outColor = destColor, outDepth = destDepth;
+    reference( &refColor[0], &refDepth[0], &color[0], &depth[0], _nPixels );
+
+    lunchbox::Clock clock;
+    func( &outColor[0], &outDepth[0], &color[0], &depth[0], _nPixels );
+    const float time = clock.getTimef();
+
+    TESTINFO( outColor == refColor && outDepth == refDepth,
+              getSIMDName( level ) << " " << name );
+
+    const float size = _nPixels * 2 * sizeof( uint32_t );
+    std::cout << name << " " << getSIMDName( level ) << ": " << time
+              << " ms (" << 1000.0f * size / time / 1024.0f / 1024.0f
+              << " MB/s)" << std::endl;
+}
+
+void _testMergeBlend( const SIMDLevel level, const MergeBlendRowFunc func,
+                      const char* name )
+{
+    const MergeBlendRowFunc reference = getMergeBlendRow( SIMD_NONE );
+    Pixels color( _nPixels ), dest( _nPixels );
+    fillPixels( color, 5 );
+    fillPixels( dest, 6 );
+
+    // saturation and the alpha extremes
+    color[0] = 0xffffffffu;
+    dest[0] = 0xffffffffu;
+    color[1] = 0x00ffffffu;
+    color[2] = 0xff000000u;
+
+    for( int32_t length = 0; length < 67; ++length )
+    {
+        for( int32_t start = 0; start < 3; ++start )
+        {
+            Pixels refDest = dest, outDest = dest;
+
+            reference( &refDest[start], &color[start], length );
+            func( &outDest[start], &color[start], length );
+            TESTINFO( outDest == refDest,
+                      getSIMDName( level ) << " " << name << " " << length );
+        }
+    }
+
+    Pixels refDest = dest, outDest = dest;
+    reference( &refDest[0], &color[0], _nPixels );
+
+    lunchbox::Clock clock;
+    func( &outDest[0], &color[0], _nPixels );
+    const float time = clock.getTimef();
+
+    TESTINFO( outDest == refDest, getSIMDName( level ) << " " << name );
+
+    const float size = _nPixels * sizeof( uint32_t );
+    std::cout << name << " " << getSIMDName( level ) << ": " << time
+              << " ms (" << 1000.0f * size / time / 1024.0f / 1024.0f
+              << " MB/s)" << std::endl;
+}
+void _testHasForeground( const SIMDLevel level, const HasForegroundFunc func )
+{
+    const HasForegroundFunc reference = getHasForeground( SIMD_NONE );
+    Pixels pixels( 67, 0xffffffffu );
+
+    // a single foreground pixel at each position, inside and outside the mask
+    for( int32_t length = 0; length < 67; ++length )
+    {
+        for( int32_t pos = 0; pos < 67; ++pos )
+        {
+            Pixels row = pixels;
+            row[ pos ] = 0x00ffffffu;
+            const bool expected = reference( &row[0], length, 0xffffffffu,
+                                             0xffffffffu );
+            TESTINFO( expected == ( pos < length ), length << " " << pos );
+            TESTINFO( func( &row[0], length, 0xffffffffu, 0xffffffffu ) ==
+                      expected, getSIMDName( level ) << " " << length );
+            TEST( !func( &row[0], length, 0xffffffffu, 0x00ffffffu ));
+        }
+    }
+
+    Pixels image( _nPixels, 0xffffffffu );
+    lunchbox::Clock clock;
+    const bool found = func( &image[0], int32_t( _nPixels ), 0xffffffffu,
+                             0xffffffffu );
+    const float time = clock.getTimef();
+    TEST( !found );
+
+    const float size = _nPixels * sizeof( uint32_t );
+    std::cout << "ROI " << getSIMDName( level ) << ": " << time
+              << " ms (" << 1000.0f * size / time / 1024.0f / 1024.0f
+              << " MB/s)" << std::endl;
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( hasSIMDLevel( SIMD_NONE ));
+    TEST( hasSIMDLevel( getSIMDLevel( )));
+    TEST( getMergeDBRow( ) == getMergeDBRow( getSIMDLevel( )));
+    TEST( getMergeBlendRow( ) == getMergeBlendRow( getSIMDLevel( )));
+    TEST( getHasForeground( ) == getHasForeground( getSIMDLevel( )));
+    std::cout << "Using " << getSIMDName( getSIMDLevel( )) << " kernels"
+              << std::endl;
+
+    for( int i = SIMD_NONE; i < SIMD_ALL; ++i )
+    {
+        const SIMDLevel level = SIMDLevel( i );
+        if( !hasSIMDLevel( level ))
+        {
+            std::cout << getSIMDName( level ) << ": not available"
+                      << std::endl;
+            continue;
+        }
+
+        _testMergeDB( level, getMergeDBRow( level ), "DB" );
+        _testMergeBlend( level, getMergeBlendRow( level ), "Alpha" );
+        _testHasForeground( level, getHasForeground( level ));
+    }
+
+    return EXIT_SUCCESS;
+}
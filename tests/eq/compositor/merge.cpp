@@ -0,0 +1,244 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the CPU compositor produces the same result as compositing each
+// input image in order with a full pass over the destination.
+
+#include <test.h>
+#include <testImage.h>
+
+#include <eq/client/compositor.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/compressor/compressorSpan.h> // private header
+
+namespace
+{
+// Background in the corners and every other block of rows, like sort-last
+void _sparsify( Pixels& pixels, const eq::PixelViewport& pvp,
+                const uint32_t background )
+{
+    for( int32_t y = 0; y < pvp.h; ++y )
+        for( int32_t x = 0; x < pvp.w; ++x )
+            if(( y / 16 ) % 2 || x < pvp.w / 4 || x > pvp.w - pvp.w / 4 )
+                pixels[ y * pvp.w + x ] = background;
+}
+
+void _setPixelData( eq::Image* image, const eq::Frame::Buffer buffer,
+                    const eq::PixelData& data, const uint32_t compressor )
+{
+    if( compressor == EQ_COMPRESSOR_NONE )
+    {
+        image->setPixelData( buffer, data );
+        return;
+    }
+
+    // set data as received from a remote node
+    eq::Image source;
+    source.setPixelViewport( data.pvp );
+    source.setPixelData( buffer, data );
+    source.useCompressor( buffer, compressor );
+    image->setPixelData( buffer, source.compressPixelData( buffer ));
+    source.flush();
+    TEST( image->hasCompressedPixelData( buffer ));
+}
+
+void _addImage( eq::FrameData* frameData, const eq::PixelViewport& pvp,
+                const bool depth, const uint32_t seed,
+                const bool compress = false )
+{
+    eq::Image* image = addImage( frameData, pvp );
+    Pixels pixels( pvp.getArea( ));
+
+    fillPixels( pixels, seed );
+    if( compress )
+        _sparsify( pixels, pvp, 0xff000000u );
+    _setPixelData( image, eq::Frame::BUFFER_COLOR,
+                   newPixelData( eq::Frame::BUFFER_COLOR, pvp, pixels ),
+                   compress ? EQ_COMPRESSOR_SPAN_RGBA : EQ_COMPRESSOR_NONE );
+
+    if( !depth )
+        return;
+
+    // restricted range to get many equal depth values
+    fillPixels( pixels, seed + 1, 0x3ffu );
+    if( compress )
+        _sparsify( pixels, pvp, 0xffffffffu );
+    _setPixelData( image, eq::Frame::BUFFER_DEPTH,
+                   newPixelData( eq::Frame::BUFFER_DEPTH, pvp, pixels ),
+                   compress ? EQ_COMPRESSOR_SPAN_DEPTH_UNSIGNED_INT :
+                              EQ_COMPRESSOR_NONE );
+}
+
+/** The reference: one full pass per image, in frame and image order. */
+void _merge( const eq::Frames& frames, const bool blendAlpha,
+             const eq::PixelViewport& destPVP, Pixels& color, Pixels& depth )
+{
+    color.assign( destPVP.getArea(), 0xff000000u ); // see clearPixelData
+    depth.assign( destPVP.getArea(), 0xffffffffu );
+
+    for( eq::FramesCIter i = frames.begin(); i != frames.end(); ++i )
+    {
+        const eq::Frame* frame = *i;
+        const eq::Images& images = frame->getImages();
+        for( eq::ImagesCIter j = images.begin(); j != images.end(); ++j )
+        {
+            const eq::Image* image = *j;
+            if( !image->hasPixelData( eq::Frame::BUFFER_COLOR ))
+                continue;
+
+            const eq::PixelViewport& pvp = image->getPixelViewport();
+            const int32_t destX = frame->getOffset().x() + pvp.x - destPVP.x;
+            const int32_t destY = frame->getOffset().y() + pvp.y - destPVP.y;
+            const uint32_t* srcColor = reinterpret_cast< const uint32_t* >(
+                image->getPixelPointer( eq::Frame::BUFFER_COLOR ));
+            const bool hasDepth =
+                image->hasPixelData( eq::Frame::BUFFER_DEPTH );
+            const uint32_t* srcDepth = hasDepth ?
+                reinterpret_cast< const uint32_t* >(
+                    image->getPixelPointer( eq::Frame::BUFFER_DEPTH )) : 0;
+            const bool blend = !hasDepth && blendAlpha && image->hasAlpha();
+
+            for( int32_t y = 0; y < pvp.h; ++y )
+            {
+                for( int32_t x = 0; x < pvp.w; ++x )
+                {
+                    const size_t src = y * pvp.w + x;
+                    const size_t dst = ( destY + y ) * destPVP.w + destX + x;
+
+                    if( hasDepth )
+                    {
+                        if( depth[ dst ] > srcDepth[ src ] )
+                        {
+                            color[ dst ] = srcColor[ src ];
+                            depth[ dst ] = srcDepth[ src ];
+                        }
+                    }
+                    else if( blend )
+                    {
+                        const uint8_t* s =
+                            reinterpret_cast< const uint8_t* >( srcColor+src );
+                        uint8_t* d = reinterpret_cast< uint8_t* >( &color[dst] );
+                        d[0] = LB_MIN( s[0] + (s[3]*d[0] >> 8), 255 );
+                        d[1] = LB_MIN( s[1] + (s[3]*d[1] >> 8), 255 );
+                        d[2] = LB_MIN( s[2] + (s[3]*d[2] >> 8), 255 );
+                        d[3] =                 s[3]*d[3] >> 8;
+                    }
+                    else
+                    {
+                        color[ dst ] = srcColor[ src ];
+                        depth[ dst ] = 0;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void _test( const eq::Frames& frames, const bool blendAlpha, const bool depth )
+{
+    const eq::Image* result = eq::Compositor::mergeFramesCPU( frames,
+                                                              blendAlpha );
+    TEST( result );
+
+    const eq::PixelViewport& pvp = result->getPixelViewport();
+    Pixels color, depthRef;
+    _merge( frames, blendAlpha, pvp, color, depthRef );
+
+    TEST( memcmp( result->getPixelPointer( eq::Frame::BUFFER_COLOR ),
+                  &color.front(), color.size() * 4 ) == 0 );
+    if( depth )
+        TEST( memcmp( result->getPixelPointer( eq::Frame::BUFFER_DEPTH ),
+                      &depthRef.front(), depthRef.size() * 4 ) == 0 );
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( 0, 0, &nodeFactory ));
+
+    // overlapping images of odd sizes, with and without frame offsets
+    eq::FrameDataPtr frameData = new eq::FrameData;
+    frameData->setBuffers( eq::Frame::BUFFER_COLOR | eq::Frame::BUFFER_DEPTH );
+    _addImage( frameData.get(), eq::PixelViewport( 0, 0, 1021, 613 ), true, 1);
+    _addImage( frameData.get(), eq::PixelViewport( 300, 17, 901, 777 ), true,
+               2 );
+    _addImage( frameData.get(), eq::PixelViewport( 5, 400, 1500, 3 ), true, 3 );
+
+    eq::FrameDataPtr colorData = new eq::FrameData;
+    colorData->setBuffers( eq::Frame::BUFFER_COLOR );
+    _addImage( colorData.get(), eq::PixelViewport( 100, 100, 333, 211 ), false,
+               4 );
+    _addImage( colorData.get(), eq::PixelViewport( 200, 150, 517, 99 ), false,
+               5 );
+
+    eq::Frame frame1, frame2, frame3;
+    frame1.setFrameData( frameData );
+    frame2.setFrameData( frameData );
+    frame2.setOffset( eq::Vector2i( 37, 11 ));
+    frame3.setFrameData( colorData );
+    frame3.setOffset( eq::Vector2i( 3, 501 ));
+
+    eq::Frames frames;
+    frames.push_back( &frame1 );
+    frames.push_back( &frame2 );
+    _test( frames, false, true );  // DB
+
+    frames.push_back( &frame3 );
+    _test( frames, false, true );  // DB followed by 2D
+
+    frames.clear();
+    frames.push_back( &frame3 );
+    frames.push_back( &frame3 );
+    _test( frames, true, false );  // blend or 2D, depending on alpha
+
+    // span-compressed images, merged without decompression
+    eq::FrameDataPtr spanData = new eq::FrameData;
+    spanData->setBuffers( eq::Frame::BUFFER_COLOR | eq::Frame::BUFFER_DEPTH );
+    _addImage( spanData.get(), eq::PixelViewport( 0, 0, 1021, 613 ), true, 6,
+               true );
+    _addImage( spanData.get(), eq::PixelViewport( 300, 17, 901, 777 ), true, 7,
+               true );
+
+    eq::FrameDataPtr spanColorData = new eq::FrameData;
+    spanColorData->setBuffers( eq::Frame::BUFFER_COLOR );
+    _addImage( spanColorData.get(), eq::PixelViewport( 100, 100, 333, 211 ),
+               false, 8, true );
+
+    eq::Frame frame4, frame5;
+    frame4.setFrameData( spanData );
+    frame4.setOffset( eq::Vector2i( -17, 5 ));
+    frame5.setFrameData( spanColorData );
+
+    frames.clear();
+    frames.push_back( &frame1 );
+    frames.push_back( &frame4 );
+    frames.push_back( &frame5 );
+    frames.push_back( &frame2 );
+    _test( frames, false, true );  // DB and 2D, mixed with uncompressed
+
+    const eq::Image* spanImage = spanData->getImages().front();
+    TEST( spanImage->hasCompressedPixelData( eq::Frame::BUFFER_DEPTH ));
+    TEST( spanImage->getPixelPointer( eq::Frame::BUFFER_DEPTH ));
+
+    frameData->flush();
+    colorData->flush();
+    spanData->flush();
+    spanColorData->flush();
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -18,6 +18,7 @@
 #include <test.h>
 
 #include <eq/client/compositor.h>
+#include <eq/client/compositorKernels.h> // private header
 #include <eq/client/frame.h>
 #include <eq/client/frameData.h>
 #include <eq/client/image.h>
@@ -51,6 +52,10 @@ int main( int argc, char **argv )
     TEST( image->readImage( "Image_3_color.rgb", eq::Frame::BUFFER_COLOR ));
     TEST( image->hasPixelData( eq::Frame::BUFFER_COLOR ));
     
+    std::cout << argv[0] << ": using "
+              << eq::detail::getSIMDName( eq::detail::getSIMDLevel( ))
+              << " compositing kernels" << std::endl;
+
     eq::Frames frames;
     lunchbox::Clock clock;
     float time;
@@ -0,0 +1,183 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the predictive depth compressor is lossless for 1D and 2D data of
+// odd sizes, in one or several strips, and for strip-compressed images.
+
+#include <test.h>
+
+#include <eq/client/compressor/compressorPredict.h> // private header
+#include <eq/client/frame.h>
+#include <eq/client/image.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/pixelData.h>
+
+#include <co/cpuCompressor.h>
+#include <co/plugins/compressor.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+typedef std::vector< uint32_t > Pixels;
+
+static const uint32_t _name = EQ_COMPRESSOR_PREDICT_DEPTH_UNSIGNED_INT;
+
+/**
+ * Fill a depth buffer like a rendered scene: a sphere in front of a tilted
+ * floor, and the cleared far plane above the floor.
+ */
+void _fill( Pixels& pixels, const int32_t width, const int32_t height )
+{
+    pixels.resize( width * height );
+    const float cx = width * .5f;
+    const float cy = height * .45f;
+    const float r = LB_MAX( 1.f, height * .3f );
+
+    for( int32_t y = 0; y < height; ++y )
+    {
+        for( int32_t x = 0; x < width; ++x )
+        {
+            const float dx = float( x ) - cx;
+            const float dy = float( y ) - cy;
+            const float d2 = r * r - dx * dx - dy * dy;
+            uint32_t& depth = pixels[ y * width + x ];
+
+            if( d2 > 0.f )
+                depth = 0x40000000u -
+                        uint32_t( std::sqrt( d2 ) / r * 0x100000 ) * 256u;
+            else if( y > height * .6f )
+                depth = 0x60000000u + 0x1000u * x + 0x40000u * y;
+            else
+                depth = 0xffffffffu;
+        }
+    }
+}
+
+/** Compress and decompress with the given flags. @return compressed size. */
+uint64_t _test( const Pixels& pixels, const int32_t width,
+                const int32_t height, const uint64_t flags,
+                unsigned& nResults )
+{
+    co::CPUCompressor compressor;
+    TEST( compressor.co::Compressor::initCompressor( _name ));
+
+    const bool is1D = flags & EQ_COMPRESSOR_DATA_1D;
+    const uint64_t inDims[4] = { 0, is1D ? uint64_t( pixels.size( )) :
+                                           uint64_t( width ),
+                                 0, uint64_t( is1D ? 1 : height ) };
+    compressor.compress( const_cast< uint32_t* >( &pixels.front( )), inDims,
+                         flags );
+
+    nResults = compressor.getNumResults();
+    TEST( nResults > 0 );
+    std::vector< void* > data( nResults );
+    std::vector< uint64_t > sizes( nResults );
+    uint64_t size = 0;
+    for( unsigned i = 0; i < nResults; ++i )
+    {
+        compressor.getResult( i, &data[i], &sizes[i] );
+        size += sizes[i];
+    }
+
+    co::CPUCompressor decompressor;
+    TEST( decompressor.initDecompressor( _name ));
+
+    Pixels result( pixels.size(), 0xdeadbeefu );
+    uint64_t outDims[4] = { inDims[0], inDims[1], inDims[2], inDims[3] };
+    decompressor.decompress( &data.front(), &sizes.front(), nResults,
+                             &result.front(), outDims, flags );
+
+    for( size_t i = 0; i < pixels.size(); ++i )
+        TESTINFO( result[i] == pixels[i],
+                  width << "x" << height << ( is1D ? " 1D" : " 2D" )
+                  << ": pixel " << i << " is " << std::hex << result[i]
+                  << " not " << pixels[i] );
+    return size;
+}
+
+/** Round trip of an image compressed in strips by eq::Image. */
+void _testStrips( const Pixels& pixels, const int32_t width,
+                  const int32_t height )
+{
+    const eq::Frame::Buffer buffer = eq::Frame::BUFFER_DEPTH;
+    eq::PixelData data;
+    data.internalFormat = EQ_COMPRESSOR_DATATYPE_DEPTH;
+    data.externalFormat = EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT;
+    data.pixelSize = 4;
+    data.pvp = eq::PixelViewport( 0, 0, width, height );
+    data.pixels = const_cast< uint32_t* >( &pixels.front( ));
+
+    eq::Image image;
+    image.setPixelViewport( data.pvp );
+    image.setPixelData( buffer, data );
+
+    const eq::PixelData& compressed = image.compressPixelData( buffer, _name,
+                                                               4 );
+    TESTINFO( compressed.compressorName == _name,
+              std::hex << compressed.compressorName );
+
+    eq::Image destImage;
+    destImage.setPixelViewport( data.pvp );
+    destImage.setPixelData( buffer, compressed );
+    TESTINFO( ::memcmp( destImage.getPixelPointer( buffer ), &pixels.front(),
+                        pixels.size() * 4 ) == 0,
+              width << "x" << height << " in strips" );
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    // odd sizes, single rows and columns, and sizes with several chunks
+    static const int32_t sizes[][2] = {{ 1, 1 }, { 3, 1 }, { 1, 3 },
+                                       { 257, 131 }, { 1023, 767 },
+                                       { 1921, 1081 }};
+    const size_t nSizes = sizeof( sizes ) / sizeof( sizes[0] );
+
+    for( size_t i = 0; i < nSizes; ++i )
+    {
+        const int32_t width = sizes[i][0];
+        const int32_t height = sizes[i][1];
+        Pixels pixels;
+        _fill( pixels, width, height );
+
+        unsigned nResults = 0;
+        const uint64_t size1D = _test( pixels, width, height,
+                                       EQ_COMPRESSOR_DATA_1D, nResults );
+        TESTINFO( nResults == 1, nResults );
+
+        const uint64_t size2D = _test( pixels, width, height,
+                                       EQ_COMPRESSOR_DATA_2D, nResults );
+        if( pixels.size() >= 2 * 64 * 1024 )
+        {
+            // large images use several chunks, and planar prediction pays
+            TESTINFO( nResults > 1, nResults );
+            TESTINFO( size2D < size1D, size2D << " >= " << size1D );
+            TESTINFO( size2D < pixels.size(), size2D );
+        }
+
+        if( height >= 4 )
+            _testStrips( pixels, width, height );
+    }
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
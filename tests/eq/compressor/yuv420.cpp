@@ -0,0 +1,208 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the YUV 4:2:0 compressors keep the error of each color channel
+// within their advertised quality, for odd image sizes and for patterns of
+// saturated colors which defeat chroma subsampling.
+
+#include <test.h>
+
+#include <co/plugins/compressor.h>
+
+#include <eq/client/compressor/compressorYUV420.h> // private header
+#include <eq/client/frame.h>
+#include <eq/client/image.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/pixelData.h>
+
+#include <co/global.h>
+#include <co/pluginRegistry.h>
+
+#include <co/compressorInfo.h> // private header
+#include <co/plugin.h> // private header
+
+#include <cstdlib>
+
+namespace
+{
+enum Pattern
+{
+    PATTERN_NOISE,    //!< random values in all channels
+    PATTERN_PRIMARY,  //!< neighbouring pixels of different primary colors
+    PATTERN_GRADIENT, //!< smooth ramps
+    PATTERN_ALL
+};
+
+static const uint32_t _names[] = { EQ_COMPRESSOR_YUV420_RGBA_90P,
+                                   EQ_COMPRESSOR_YUV420_RGBA_70P,
+                                   EQ_COMPRESSOR_YUV420_RGBA_50P,
+                                   EQ_COMPRESSOR_YUV420_BGRA_90P,
+                                   EQ_COMPRESSOR_YUV420_BGRA_70P,
+                                   EQ_COMPRESSOR_YUV420_BGRA_50P };
+
+static float _getQuality( const uint32_t name )
+{
+    const co::PluginRegistry& registry = co::Global::getPluginRegistry();
+    const co::Plugins& plugins = registry.getPlugins();
+
+    for( co::PluginsCIter i = plugins.begin(); i != plugins.end(); ++i )
+    {
+        const co::CompressorInfos& infos = (*i)->getInfos();
+        for( co::CompressorInfosCIter j = infos.begin(); j != infos.end(); ++j )
+            if( j->name == name )
+                return j->quality;
+    }
+    return 0.f;
+}
+
+static void _fill( std::vector< uint8_t >& pixels, const int32_t width,
+                   const int32_t height, const Pattern pattern )
+{
+    static const uint8_t primaries[6][3] = {{ 255, 0, 0 }, { 0, 255, 0 },
+                                            { 0, 0, 255 }, { 255, 255, 0 },
+                                            { 0, 255, 255 }, { 255, 0, 255 }};
+    pixels.resize( width * height * 4 );
+    ::srand( pattern );
+
+    for( int32_t y = 0; y < height; ++y )
+    {
+        for( int32_t x = 0; x < width; ++x )
+        {
+            uint8_t* pixel = &pixels[ ( y * width + x ) * 4 ];
+            switch( pattern )
+            {
+              case PATTERN_NOISE:
+                for( size_t i = 0; i < 4; ++i )
+                    pixel[i] = uint8_t( ::rand( ));
+                break;
+
+              case PATTERN_PRIMARY:
+              {
+                const uint8_t* color = primaries[ ( x + 2 * y ) % 6 ];
+                pixel[0] = color[0];
+                pixel[1] = color[1];
+                pixel[2] = color[2];
+                pixel[3] = uint8_t( x ^ y );
+                break;
+              }
+
+              default:
+                pixel[0] = uint8_t( x * 255 / width );
+                pixel[1] = uint8_t( y * 255 / height );
+                pixel[2] = uint8_t( 255 - pixel[0] / 2 - pixel[1] / 2 );
+                pixel[3] = 255;
+                break;
+            }
+        }
+    }
+}
+
+/** @return the compressed size, checking the decompressed image. */
+static uint64_t _test( const uint32_t name, const int32_t width,
+                       const int32_t height, const Pattern pattern,
+                       const bool useAlpha )
+{
+    const eq::Frame::Buffer buffer = eq::Frame::BUFFER_COLOR;
+    const bool isBGRA = name >= EQ_COMPRESSOR_YUV420_BGRA_90P;
+    std::vector< uint8_t > pixels;
+    _fill( pixels, width, height, pattern );
+
+    eq::PixelData data;
+    data.internalFormat = isBGRA ? EQ_COMPRESSOR_DATATYPE_BGRA :
+                                   EQ_COMPRESSOR_DATATYPE_RGBA;
+    data.externalFormat = data.internalFormat;
+    data.pixelSize = 4;
+    data.pvp = eq::PixelViewport( 0, 0, width, height );
+    data.pixels = &pixels[0];
+
+    eq::Image image;
+    image.setAlphaUsage( useAlpha );
+    image.setPixelData( buffer, data );
+    data.pixels = 0;
+    TEST( image.allocCompressor( buffer, name ));
+
+    const eq::PixelData& compressed = image.compressPixelData( buffer );
+    TESTINFO( compressed.compressorName == name,
+              std::hex << compressed.compressorName << " != " << name );
+
+    eq::Image destImage;
+    destImage.setAlphaUsage( useAlpha );
+    destImage.setPixelViewport( image.getPixelViewport( ));
+    destImage.setPixelData( buffer, compressed );
+
+    const uint8_t* result = destImage.getPixelPointer( buffer );
+    const float maxError = ( 1.f - _getQuality( name )) * 255.f;
+    TESTINFO( maxError < 255.f, std::hex << name );
+
+    for( size_t i = 0; i < pixels.size(); ++i )
+    {
+        const int error = std::abs( int( result[i] ) - int( pixels[i] ));
+        if( i % 4 == 3 )
+        {
+            TESTINFO( !useAlpha || error == 0,
+                      std::hex << name << std::dec << " pattern " << pattern
+                      << ": alpha is not lossless" );
+            continue;
+        }
+        TESTINFO( float( error ) <= maxError,
+                  std::hex << name << std::dec << " pattern " << pattern
+                  << " " << width << "x" << height << ": error " << error
+                  << " at pixel " << i / 4 << " exceeds " << maxError );
+    }
+
+    uint64_t size = 0;
+    for( size_t i = 0; i < compressed.compressedSize.size(); ++i )
+        size += compressed.compressedSize[i];
+    return size;
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    // odd sizes, single rows and columns, and sizes with several strips
+    static const int32_t sizes[][2] = {{ 1, 1 }, { 3, 1 }, { 1, 3 },
+                                       { 257, 131 }, { 1023, 767 }};
+    const size_t nSizes = sizeof( sizes ) / sizeof( sizes[0] );
+    const size_t nNames = sizeof( _names ) / sizeof( _names[0] );
+
+    for( size_t i = 0; i < nNames; ++i )
+        for( size_t j = 0; j < nSizes; ++j )
+            for( int pattern = 0; pattern < PATTERN_ALL; ++pattern )
+                for( int alpha = 0; alpha < 2; ++alpha )
+                    _test( _names[i], sizes[j][0], sizes[j][1],
+                           Pattern( pattern ), alpha == 1 );
+
+    // lower qualities produce less data for smooth images
+    for( size_t i = 0; i < nNames; i += 3 )
+    {
+        const uint64_t high = _test( _names[i], 1023, 767, PATTERN_GRADIENT,
+                                     false );
+        const uint64_t medium = _test( _names[i + 1], 1023, 767,
+                                       PATTERN_GRADIENT, false );
+        const uint64_t low = _test( _names[i + 2], 1023, 767,
+                                    PATTERN_GRADIENT, false );
+        TESTINFO( medium < high, medium << " >= " << high );
+        TESTINFO( low < medium, low << " >= " << medium );
+        TESTINFO( high < 1023 * 767 * 4, high );
+    }
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the learning, splitting and motion extrapolation of the cost map used
+// by the load equalizer.
+
+#include <test.h>
+
+#include <eq/server/equalizers/costMap.h> // private header
+
+#include <cmath>
+
+using eq::server::CostMap;
+using eq::Viewport;
+
+namespace
+{
+static bool _equals( const float a, const float b )
+{
+    return std::abs( a - b ) < .02f;
+}
+
+/** Learn a frame of four tiles with all time in the given area. */
+static void _learn( CostMap& map, const uint32_t frame, const Viewport& model,
+                    const float damping )
+{
+    const Viewport tiles[] = { Viewport( 0.f, 0.f, .5f, .5f ),
+                               Viewport( .5f, 0.f, .5f, .5f ),
+                               Viewport( 0.f, .5f, .5f, .5f ),
+                               Viewport( .5f, .5f, .5f, .5f ) };
+    for( size_t i = 0; i < 4; ++i )
+    {
+        Viewport vp = tiles[i];
+        vp.intersect( model ); // ROI of the tile
+        if( vp.hasArea( ))
+            map.addLoad( vp, 100.f * vp.w * vp.h / ( model.w * model.h ));
+    }
+    map.finishFrame( frame, damping );
+}
+}
+
+int main( int argc, char **argv )
+{
+    CostMap map;
+    map.resize( 64, 64 );
+
+    // no data: uniform cost
+    map.predict( 1 );
+    TESTINFO( _equals( map.getCost( Viewport::FULL ), 1.f ),
+              map.getCost( Viewport::FULL ));
+    TEST( _equals( map.findSplitX( Viewport::FULL, .5f ), .5f ));
+    TEST( _equals( map.findSplitY( Viewport( 0.f, .5f, 1.f, .5f ), .25f ),
+                   .75f ));
+
+    // static model in the left half of the screen
+    const Viewport model( .1f, .2f, .3f, .6f );
+    _learn( map, 1, model, .5f );
+    map.predict( 3 );
+    TESTINFO( _equals( map.getCost( Viewport::FULL ), 100.f ),
+              map.getCost( Viewport::FULL ));
+    TESTINFO( _equals( map.findSplitX( Viewport::FULL, 50.f ), .25f ),
+              map.findSplitX( Viewport::FULL, 50.f ));
+    TEST( _equals( map.getMotion().x(), 0.f ));
+
+    // model moving right by .05 per frame, predicted two frames ahead
+    map.clear();
+    for( uint32_t frame = 1; frame <= 3; ++frame )
+    {
+        Viewport moved = model;
+        moved.x += .05f * float( frame );
+        _learn( map, frame, moved, .5f );
+    }
+    TESTINFO( _equals( map.getMotion().x(), .05f ), map.getMotion( ));
+    TESTINFO( _equals( map.getMotion().y(), 0.f ), map.getMotion( ));
+
+    map.predict( 5 );
+    const float split = map.findSplitX( Viewport::FULL,
+                                        map.getCost( Viewport::FULL ) * .5f );
+    TESTINFO( _equals( split, .25f + .05f * 5.f ), split );
+
+    // DB ranges use one row without motion
+    map.resize( 256, 1 );
+    map.addLoad( Viewport( 0.f, 0.f, .5f, 1.f ), 30.f );
+    map.addLoad( Viewport( .5f, 0.f, .5f, 1.f ), 10.f );
+    map.finishFrame( 1, 0.f );
+    map.predict( 2 );
+    TEST( _equals( map.findSplitX( Viewport::FULL, 20.f ), 1.f / 3.f ));
+    TEST( _equals( map.getMotion().x(), 0.f ));
+    return EXIT_SUCCESS;
+}
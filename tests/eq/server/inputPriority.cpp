@@ -0,0 +1,100 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the input frame priorities follow the assembly order of the
+// destination.
+
+#include <test.h>
+
+#include <eq/server/compound.h>
+#include <eq/server/config.h>
+#include <eq/server/frame.h>
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+
+#include <lunchbox/init.h>
+
+namespace
+{
+static const char* const _config =
+    "#Equalizer 1.1 ascii\n"
+    "server { config {\n"
+    "    appNode { pipe {\n"
+    "        window { viewport [ .05 .3 .4 .4 ]\n"
+    "                 channel { name \"channel1\" }}\n"
+    "        window { viewport [ .55 .3 .4 .4 ]\n"
+    "                 channel { name \"channel2\" }}\n"
+    "        window { viewport [ .05 .3 .4 .4 ]\n"
+    "                 channel { name \"channel3\" }}\n"
+    "        window { viewport [ .55 .3 .4 .4 ]\n"
+    "                 channel { name \"channel4\" }}\n"
+    "    }}\n"
+    "    observer {}\n"
+    "    layout { view { observer 0 }}\n"
+    "    canvas { layout 0 wall {} segment { channel \"channel1\" }}\n"
+    "    compound {\n"
+    "        channel ( segment 0 view 0 )\n"
+    "        compound {\n"
+    "            compound { channel \"channel2\"\n"
+    "                       outputframe { name \"deep\" }}\n"
+    "            inputframe { name \"deep\" }\n"
+    "        }\n"
+    "        compound { channel \"channel3\" outputframe { name \"late\" }}\n"
+    "        compound { channel \"channel4\" outputframe { name \"early\" }}\n"
+    "        inputframe { name \"early\" }\n"
+    "        inputframe { name \"late\" }\n"
+    "    }\n"
+    "}}\n";
+
+/** @return the priority of the named input frame of the compound. */
+uint32_t _getPriority( const eq::server::Compound* compound,
+                       const std::string& name )
+{
+    const eq::server::Frames& frames = compound->getInputFrames();
+    for( eq::server::FramesCIter i = frames.begin(); i != frames.end(); ++i )
+        if( (*i)->getName() == name )
+            return eq::server::Frame::getInputPriority( *i, compound );
+
+    TESTINFO( false, "input frame " << name << " not found" );
+    return 0;
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer( _config );
+    TEST( server.isValid( ));
+
+    const eq::server::Configs& configs = server->getConfigs();
+    TESTINFO( configs.size() == 1, configs.size( ));
+    const eq::server::Compound* root = configs.front()->getCompounds().front();
+    const eq::server::Compound* child = root->getChildren().front();
+
+    // deeper compounds are assembled first, then the input frames in order
+    const uint32_t deep = _getPriority( child, "deep" );
+    const uint32_t early = _getPriority( root, "early" );
+    const uint32_t late = _getPriority( root, "late" );
+    TESTINFO( deep < early, deep << " >= " << early );
+    TESTINFO( early < late, early << " >= " << late );
+
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Runs the load, tree, view and DFR equalizers of example configs on synthetic
+// load data, and replays recorded load data without any render clients.
+//
+// Usage: eq_server_loadReplay [config.eqc [nFrames|loadRecordFile]]
+//   Prints the per-frame report of the given config, e.g., for a record
+//   written by a server started with EQ_LOAD_RECORD=loadRecordFile.
+
+#include <test.h>
+
+#include <eq/server/channel.h>
+#include <eq/server/compound.h>
+#include <eq/server/config.h>
+#include <eq/server/equalizers/loadRecorder.h> // private header
+#include <eq/server/equalizers/loadReplay.h>   // private header
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+
+#include <lunchbox/init.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using eq::server::LoadRecorder;
+using eq::server::LoadReplay;
+
+namespace
+{
+static const char* const _treeConfig =
+    "#Equalizer 1.1 ascii\n"
+    "server { config {\n"
+    "    appNode { pipe {\n"
+    "        window { viewport [ .05 .3 .4 .4 ]\n"
+    "                 channel { name \"channel2\" }}\n"
+    "        window { viewport [ .55 .3 .4 .4 ]\n"
+    "                 channel { name \"channel1\" }}\n"
+    "        window { viewport [ .55 .3 .4 .4 ]\n"
+    "                 channel { name \"channel3\" }}\n"
+    "    }}\n"
+    "    observer {}\n"
+    "    layout { view { observer 0 }}\n"
+    "    canvas { layout 0 wall {} segment { channel \"channel1\" }}\n"
+    "    compound {\n"
+    "        channel ( segment 0 view 0 )\n"
+    "        tree_equalizer { mode VERTICAL }\n"
+    "        compound {}\n"
+    "        compound { channel \"channel2\" outputframe {}}\n"
+    "        compound { channel \"channel3\" outputframe {}}\n"
+    "        inputframe { name \"frame.channel2\" }\n"
+    "        inputframe { name \"frame.channel3\" }\n"
+    "    }\n"
+    "}}\n";
+
+static const char* const _transferConfig =
+    "#Equalizer 1.1 ascii\n"
+    "server { config {\n"
+    "    appNode { pipe {\n"
+    "        window { viewport [ .05 .3 .4 .4 ]\n"
+    "                 channel { name \"channel2\" }}\n"
+    "        window { viewport [ .55 .3 .4 .4 ]\n"
+    "                 channel { name \"channel1\" }}\n"
+    "    }}\n"
+    "    observer {}\n"
+    "    layout { view { observer 0 }}\n"
+    "    canvas { layout 0 wall {} segment { channel \"channel1\" }}\n"
+    "    compound {\n"
+    "        channel ( segment 0 view 0 )\n"
+    "        load_equalizer { mode VERTICAL transfer_weight 1.0 }\n"
+    "        compound {}\n"
+    "        compound { channel \"channel2\" outputframe {}}\n"
+    "        inputframe { name \"frame.channel2\" }\n"
+    "    }\n"
+    "}}\n";
+
+static eq::server::ServerPtr _convert( eq::server::ServerPtr server )
+{
+    TEST( server.isValid( ));
+    eq::server::Loader::addOutputCompounds( server );
+    eq::server::Loader::addDestinationViews( server );
+    eq::server::Loader::addDefaultObserver( server );
+    eq::server::Loader::convertTo11( server );
+    eq::server::Loader::convertTo12( server );
+    return server;
+}
+
+static eq::server::Config* _getConfig( eq::server::ServerPtr server )
+{
+    const eq::server::Configs& configs = server->getConfigs();
+    TESTINFO( configs.size() == 1, configs.size( ));
+    return configs.front();
+}
+
+static void _unload( eq::server::ServerPtr server )
+{
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+}
+
+static void _print( const LoadReplay& replay )
+{
+    const LoadReplay::Reports& reports = replay.getReports();
+    for( LoadReplay::Reports::const_iterator i = reports.begin();
+         i != reports.end(); ++i )
+    {
+        OUTPUT << *i << std::endl;
+    }
+    OUTPUT << "Converged in frame " << replay.getConvergenceFrame( .1f )
+           << std::endl;
+}
+
+/** Balance a static model and check that the imbalance settles. */
+static void _testConvergence( eq::server::ServerPtr server,
+                              const std::string& name )
+{
+    LoadReplay replay( _getConfig( server ));
+    replay.run( LoadReplay::Model(), 50 );
+
+    const LoadReplay::Reports& reports = replay.getReports();
+    TESTINFO( reports.size() == 50, reports.size( ));
+    TESTINFO( reports.back().time > 0.f, name );
+
+    const uint32_t frame = replay.getConvergenceFrame( .15f );
+    TESTINFO( frame > 0 && frame < 40,
+              name << " converges in frame " << frame );
+}
+
+/** @return the area assigned to channel2, which transmits to channel1. */
+static float _getSourceArea( eq::server::ServerPtr server )
+{
+    const eq::server::Compounds& children =
+        _getConfig( server )->getCompounds().front()->getChildren();
+    for( eq::server::CompoundsCIter i = children.begin(); i != children.end();
+         ++i )
+    {
+        const eq::server::Channel* channel = (*i)->getChannel();
+        if( channel && channel->getName() == "channel2" )
+            return (*i)->getViewport().getArea();
+    }
+    TESTINFO( false, "channel2 not found" );
+    return 0.f;
+}
+
+/**
+ * Balance a model whose ROI covers half of each tile, with and without the
+ * cost of transmitting the source channel's ROI.
+ */
+static void _testTransferCost( eq::server::Loader& loader )
+{
+    LoadReplay::Model model;
+    model.background = 40.f;
+    model.foreground = 40.f;
+    model.area = eq::Viewport( 0.f, .25f, 1.f, .5f );
+    model.roi = true;
+
+    eq::server::ServerPtr server =
+        _convert( loader.parseServer( _transferConfig ));
+    float area = 0.f;
+    {
+        LoadReplay replay( _getConfig( server ));
+        replay.run( model, 50 );
+        area = _getSourceArea( server );
+        TESTINFO( std::abs( area - .5f ) < .05f, area );
+    }
+    _unload( server );
+
+    model.transfer = 40.f;
+    server = _convert( loader.parseServer( _transferConfig ));
+    {
+        LoadReplay replay( _getConfig( server ));
+        replay.run( model, 50 );
+
+        // The transfer cost is per assigned area, not per transmitted ROI
+        const float transferArea = _getSourceArea( server );
+        TESTINFO( transferArea < area - .03f, transferArea << " >= " << area );
+        TESTINFO( replay.getReports().back().imbalance < .04f,
+                  replay.getReports().back( ));
+    }
+    _unload( server );
+}
+
+static void _run( eq::server::Loader& loader, const char* filename,
+                  const char* argument )
+{
+    eq::server::ServerPtr server = _convert( loader.loadFile( filename ));
+    {
+        LoadReplay replay( _getConfig( server ));
+        char* end = 0;
+        const unsigned long nFrames = argument ?
+                                      ::strtoul( argument, &end, 10 ) : 100;
+
+        if( argument && *end != '\0' )
+        {
+            LoadRecorder::Records records;
+            TEST( LoadRecorder::read( argument, records ));
+            TEST( replay.run( records ));
+        }
+        else
+        {
+            LoadReplay::Model model;
+            model.motion = eq::Vector2f( .5f / float( nFrames ), 0.f );
+            replay.run( model, uint32_t( nFrames ));
+        }
+        _print( replay );
+    }
+    _unload( server );
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+    eq::server::Loader loader;
+
+    if( argc > 1 )
+    {
+        _run( loader, argv[1], argc > 2 ? argv[2] : 0 );
+        TEST( lunchbox::exit( ));
+        return EXIT_SUCCESS;
+    }
+
+    // load_equalizer, sort-first and sort-last
+    eq::server::ServerPtr server =
+        _convert( loader.loadFile( "configs/2-window.2D.lb.eqc" ));
+    _testConvergence( server, "2D load_equalizer" );
+    _unload( server );
+
+    server = _convert( loader.loadFile( "configs/2-window.DB.lb.eqc" ));
+    _testConvergence( server, "DB load_equalizer" );
+    _unload( server );
+
+    // tree_equalizer
+    server = _convert( loader.parseServer( _treeConfig ));
+    _testConvergence( server, "tree_equalizer" );
+    _unload( server );
+
+    // load_equalizer with transfer costs
+    _testTransferCost( loader );
+
+    // view_equalizer
+    server = _convert( loader.loadFile( "configs/2-window.wall.lb.eqc" ));
+    {
+        LoadReplay replay( _getConfig( server ));
+        replay.run( LoadReplay::Model(), 50 );
+        const LoadReplay::Reports& reports = replay.getReports();
+        TESTINFO( reports.size() == 50, reports.size( ));
+        TEST( reports.back().time > 0.f );
+    }
+    _unload( server );
+
+    // DFR_equalizer: the frame time settles at the target frame rate
+    server = _convert( loader.loadFile( "configs/1-window.DFR.eqc" ));
+    {
+        LoadReplay replay( _getConfig( server ));
+        replay.run( LoadReplay::Model(), 50 );
+        const float time = replay.getReports().back().time;
+        TESTINFO( std::abs( time - 1000.f / 15.f ) < 10.f, time );
+    }
+    _unload( server );
+
+    // record a moving model, then replay the record through a fresh config
+    LoadReplay::Reports reports;
+    LoadRecorder::Records records;
+    server = _convert( loader.loadFile( "configs/2-window.2D.lb.eqc" ));
+    {
+        LoadReplay replay( _getConfig( server ));
+        LoadRecorder recorder( "loadReplay.record" );
+        TEST( recorder.isGood( ));
+        recorder.attach( _getConfig( server ));
+
+        LoadReplay::Model model;
+        model.motion = eq::Vector2f( .01f, 0.f );
+        replay.run( model, 30 );
+
+        recorder.detach();
+        TEST( recorder.isGood( ));
+        reports = replay.getReports();
+    }
+    _unload( server );
+
+    TEST( LoadRecorder::read( "loadReplay.record", records ));
+    TEST( !records.empty( ));
+
+    server = _convert( loader.loadFile( "configs/2-window.2D.lb.eqc" ));
+    {
+        LoadReplay replay( _getConfig( server ));
+        TEST( replay.run( records ));
+
+        // same input, same splits
+        const LoadReplay::Reports& replayed = replay.getReports();
+        TESTINFO( replayed.back().frameNumber == records.back().frameNumber,
+                  replayed.back() );
+        for( size_t i = 0; i < replayed.size(); ++i )
+        {
+            TESTINFO( replayed[i].frameNumber == reports[i].frameNumber,
+                      replayed[i] << " != " << reports[i] );
+            TESTINFO( std::abs( replayed[i].movement - reports[i].movement )
+                      < .001f, replayed[i] << " != " << reports[i] );
+        }
+    }
+    _unload( server );
+    ::remove( "loadReplay.record" );
+
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
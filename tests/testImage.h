@@ -0,0 +1,87 @@
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQTEST_TESTIMAGE_H
+#define EQTEST_TESTIMAGE_H
+
+#include <eq/client/frame.h>
+#include <eq/client/frameData.h>
+#include <eq/client/image.h>
+#include <eq/client/pixelData.h>
+#include <eq/fabric/drawableConfig.h>
+#include <co/plugins/compressor.h>
+
+#include <vector>
+
+// Synthetic pixel data for the image, compositing and transport tests.
+namespace
+{
+typedef std::vector< uint32_t > Pixels;
+
+/**
+ * Fill pixels with reproducible pseudo-random values.
+ *
+ * @param pixels the pixels to fill.
+ * @param seed the seed of the values.
+ * @param mask the bits to keep of each value.
+ * @param runLength the number of consecutive equal pixels, for compressible
+ *                  data.
+ */
+inline void fillPixels( Pixels& pixels, uint32_t seed,
+                        const uint32_t mask = 0xffffffffu,
+                        const size_t runLength = 1 )
+{
+    for( size_t i = 0; i < pixels.size(); ++i )
+    {
+        seed = seed * 1664525u + 1013904223u; // LCG
+        pixels[i] = ( i % runLength ) ? pixels[ i - 1 ] : seed & mask;
+    }
+}
+
+/** @return 32 bit RGBA color or unsigned depth pixel data of the pixels. */
+inline eq::PixelData newPixelData( const eq::Frame::Buffer buffer,
+                                   const eq::PixelViewport& pvp,
+                                   Pixels& pixels )
+{
+    eq::PixelData data;
+    if( buffer == eq::Frame::BUFFER_DEPTH )
+    {
+        data.internalFormat = EQ_COMPRESSOR_DATATYPE_DEPTH;
+        data.externalFormat = EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT;
+    }
+    else
+    {
+        data.internalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+        data.externalFormat = EQ_COMPRESSOR_DATATYPE_RGBA;
+    }
+    data.pixelSize = 4;
+    data.pvp = pvp;
+    data.pixels = &pixels.front();
+    return data;
+}
+
+/** @return a new image of the frame data covering the given area. */
+inline eq::Image* addImage( eq::FrameData* frameData,
+                            const eq::PixelViewport& pvp )
+{
+    eq::Image* image = frameData->newImage( eq::Frame::TYPE_MEMORY,
+                                            eq::DrawableConfig( ));
+    image->setPixelViewport( pvp );
+    return image;
+}
+}
+
+#endif // EQTEST_TESTIMAGE_H